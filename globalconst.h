@@ -69,8 +69,8 @@
  */
 #define LARGE_VALUE		(COORD_MAX / 2 - 1) /* maximum extent of board and elements */
  
-#define	MAX_LAYER		16	/* max number of layer, check source */
-					/* code for more changes, a *lot* more changes */
+#define	MAX_LAYER		64	/* max number of copper layers; loops and */
+					/* layer groups scale with the layers used */
 #define DEF_LAYER		8	/* default number of layers for new boards */
 #define NUM_STYLES		4
 #define	MIN_LINESIZE		MIL_TO_COORD(0.01)	/* thickness of lines */
@@ -1567,7 +1567,7 @@ NotifyMode (void)
 		    memcpy (estr, e->Name,
 			    MAX_ELEMENTNAMES * sizeof (TextType));
 		    for (i = 0; i < MAX_ELEMENTNAMES; ++i)
-		      estr[i].TextString = estr[i].TextString ? strdup(estr[i].TextString) : NULL;
+		      estr[i].TextString = StringIntern (estr[i].TextString);
 		    RemoveElement (e);
 		  }
 	      }
@@ -1592,6 +1592,7 @@ NotifyMode (void)
 		      EraseElementName (e);
 		    r_delete_entry (PCB->Data->name_tree[i],
 				    (BoxType *) & (e->Name[i]));
+		    StringRelease (e->Name[i].TextString);
 		    memcpy (&(e->Name[i]), &(estr[i]), sizeof (TextType));
 		    e->Name[i].Element = e;
 		    SetTextBoundingBox (&PCB->Font, &(e->Name[i]));
@@ -1600,6 +1601,7 @@ NotifyMode (void)
 		    if (i == save_n)
 		      DrawElementName (e);
 		  }
+		ElementNameIndexUpdate (PCB->Data, e);
 	      }
 	  }
 	break;
@@ -1841,9 +1843,44 @@ ActionAtomic (int argc, char **argv, Coord x, Coord y)
   return 0;
 }
 
+/* --------------------------------------------------------------------------- */
+
+static const char bulkedit_syntax[] = "BulkEdit(Begin|End)";
+
+static const char bulkedit_help[] = "Group many edits for speed.";
+
+/* %start-doc actions BulkEdit
+
+Between @code{BulkEdit(Begin)} and @code{BulkEdit(End)}, polygons are
+not re-clipped after every object that is moved, copied, removed or
+changed, and the screen is not updated.  Instead, each affected polygon
+is re-clipped once at the end.  This makes scripts that touch many
+objects, such as panelizing, much faster.  Polygon shapes are not up
+to date in between, so don't look for connections or run the DRC
+inside a bulk edit.  Bulk edits nest, and @code{ExecuteFile} ends any
+that a script leaves open.
+
+%end-doc */
+
+static int
+ActionBulkEdit (int argc, char **argv, Coord x, Coord y)
+{
+  if (argc != 1)
+    AFAIL (bulkedit);
+
+  if (strcasecmp (argv[0], "Begin") == 0)
+    BeginBulkEdit ();
+  else if (strcasecmp (argv[0], "End") == 0)
+    EndBulkEdit ();
+  else
+    AFAIL (bulkedit);
+  return 0;
+}
+
 /* -------------------------------------------------------------------------- */
 
-static const char drc_syntax[] = "DRC()";
+static const char drc_syntax[] = "DRC()\n"
+  "DRC(Incremental)";
 
 static const char drc_help[] = "Invoke the DRC check.";
 
@@ -1852,6 +1889,18 @@ static const char drc_help[] = "Invoke the DRC check.";
 Note that the design rule check uses the current board rule settings,
 not the current style settings.
 
+@table @code
+
+@item Incremental
+Only re-checks the objects changed since the last incremental check,
+and whatever they come close to, and lists all violations known so
+far.  The first such check, and one after loading a board, changing
+the rules or the layer stack, checks the whole board.  Nothing on the
+board is selected or flagged, which makes it cheap enough to run after
+every edit.  The minimum overlap rule is not checked.
+
+@end table
+
 %end-doc */
 
 static int
@@ -1859,6 +1908,21 @@ ActionDRCheck (int argc, char **argv, Coord x, Coord y)
 {
   int count;
 
+  if (argc > 0)
+    {
+      if (strcasecmp (argv[0], "Incremental") != 0)
+        AFAIL (drc);
+      count = DRCIncremental ();
+      if (gui->drc_gui == NULL || gui->drc_gui->log_drc_overview)
+        {
+          if (count == 0)
+            Message (_("No DRC problems found.\n"));
+          else
+            Message (_("Found %d design rule errors.\n"), count);
+        }
+      return 0;
+    }
+
   if (gui->drc_gui == NULL || gui->drc_gui->log_drc_overview)
     {
       Message (_("%m+Rules are minspace %$mS, minoverlap %$mS "
@@ -3263,6 +3327,7 @@ ActionRenumber (int argc, char **argv, Coord x, Coord y)
   size_t sz;
   char *tmps;
   char *name;
+  char *old;
   FILE *out;
   static char * default_file = NULL;
   size_t cnt_list_sz = 100;
@@ -3507,16 +3572,20 @@ ActionRenumber (int argc, char **argv, Coord x, Coord y)
 	      is[c_cnt] = strdup (tmps);
 	      c_cnt++;
 
-	      AddObjectToChangeNameUndoList (ELEMENT_TYPE, NULL, NULL,
-					     element_list[i],
-					     NAMEONPCB_NAME (element_list
-							     [i]));
-
-	      ChangeObjectName (ELEMENT_TYPE, element_list[i], NULL, NULL,
-				tmps);
-	      changed = true;
-
-	      /* we don't free tmps in this case because it is used */
+	      /* unless it refuses with -1, ChangeObjectName takes tmps and
+	       * hands back a copy of the pooled old name, possibly NULL,
+	       * which the undo list keeps
+	       */
+	      old = (char *) ChangeObjectName (ELEMENT_TYPE, element_list[i],
+					       NULL, NULL, tmps);
+	      if (old != (char *) -1)
+		{
+		  AddObjectToChangeNameUndoList (ELEMENT_TYPE, NULL, NULL,
+						 element_list[i], old);
+		  changed = true;
+		}
+	      else
+		free (tmps);
 	    }
 	  else
 	    free (tmps);
@@ -4498,13 +4567,11 @@ ActionChangePinName (int argc, char **argv, Coord x, Coord y)
 	{
 	  if (NSTRCMP (pinnum, pin->Number) == 0)
 	    {
+	      /* the name is pooled; the undo list keeps a copy of its own */
 	      AddObjectToChangeNameUndoList (PIN_TYPE, NULL, NULL,
-					     pin, pin->Name);
-	      /*
-	       * Note:  we can't free() pin->Name first because 
-	       * it is used in the undo list
-	       */
-	      pin->Name = strdup (pinname);
+					     pin, STRDUP (pin->Name));
+	      StringRelease (pin->Name);
+	      pin->Name = StringIntern (pinname);
 	      SetChangedFlag (true);
 	      changed = 1;
 	    }
@@ -4515,13 +4582,11 @@ ActionChangePinName (int argc, char **argv, Coord x, Coord y)
 	{
 	  if (NSTRCMP (pinnum, pad->Number) == 0)
 	    {
+	      /* the name is pooled; the undo list keeps a copy of its own */
 	      AddObjectToChangeNameUndoList (PAD_TYPE, NULL, NULL,
-					     pad, pad->Name);
-	      /* 
-	       * Note:  we can't free() pad->Name first because 
-	       * it is used in the undo list
-	       */
-	      pad->Name = strdup (pinname);
+					     pad, STRDUP (pad->Name));
+	      StringRelease (pad->Name);
+	      pad->Name = StringIntern (pinname);
 	      SetChangedFlag (true);
 	      changed = 1;
 	    }
@@ -6460,7 +6525,7 @@ ActionRouteStyle (int argc, char **argv, Coord x, Coord y)
 
 /* --------------------------------------------------------------------------- */
 
-static const char moveobject_syntax[] = "MoveObject(X,Y,dim)";
+static const char moveobject_syntax[] = "MoveObject(X,Y,dim[,AtX,AtY])";
 
 static const char moveobject_help[] = "Moves the object under the crosshair.";
 
@@ -6472,6 +6537,10 @@ then that amount is relative.  Otherwise, it's absolute.  Units can be
 @code{mil} or @code{mm}; if unspecified, units are PCB's internal
 units, currently 1/100 mil.
 
+If @code{AtX} and @code{AtY} are given, the object at that absolute
+location, in the same units, is moved instead of the one under the
+crosshair.  This lets scripts move objects without a pointer.
+
 %end-doc */
 
 static int
@@ -6485,6 +6554,14 @@ ActionMoveObject (int argc, char **argv, Coord x, Coord y)
   void *ptr1, *ptr2, *ptr3;
   int type;
 
+  if (argc > 4)
+    {
+      x = GetValue (ARG (3), units, NULL);
+      y = GetValue (ARG (4), units, NULL);
+    }
+  else
+    gui->get_coords (_("Select an Object"), &x, &y);
+
   ny = GetValue (y_str, units, &absolute1);
   nx = GetValue (x_str, units, &absolute2);
 
@@ -6836,6 +6913,7 @@ ActionExecuteFile (int argc, char **argv, Coord x, Coord y)
   char line[256];
   int n = 0;
   char *sp;
+  bool bulk;
 
   if (argc != 1)
     AFAIL (executefile);
@@ -6850,6 +6928,7 @@ ActionExecuteFile (int argc, char **argv, Coord x, Coord y)
 
   defer_updates = 1;
   defer_needs_update = 0;
+  bulk = InBulkEdit ();
   while (fgets (line, sizeof (line), fp) != NULL)
     {
       n++;
@@ -6877,6 +6956,11 @@ ActionExecuteFile (int argc, char **argv, Coord x, Coord y)
 	}
     }
 
+  /* don't leave the board with stale polygons */
+  if (!bulk)
+    while (InBulkEdit ())
+      EndBulkEdit ();
+
   defer_updates = 0;
   if (defer_needs_update)
     {
@@ -6938,6 +7022,8 @@ delete_attr (AttributeListType *list, AttributeType *attr)
   int idx = attr - list->List;
   if (idx < 0 || idx >= list->Number)
     return;
+  StringRelease (attr->name);
+  StringRelease (attr->value);
   if (list->Number - idx > 1)
     memmove (attr, attr+1, (list->Number - idx - 1) * sizeof(AttributeType));
   list->Number --;
@@ -7023,6 +7109,7 @@ ActionElementList (int argc, char **argv, Coord x, Coord y)
 	  }
       }
       END_LOOP;
+      InvalidateSelectionIndex ();
       if (number_of_footprints_not_found > 0)
 	gui->confirm_dialog ("Not all requested footprints were found.\n"
 			     "See the message log for details",
@@ -7208,8 +7295,8 @@ ActionElementSetAttr (int argc, char **argv, Coord x, Coord y)
 
   if (attr && value)
     {
-      free (attr->value);
-      attr->value = strdup (value);
+      StringRelease (attr->value);
+      attr->value = StringIntern (value);
     }
   if (attr && ! value)
     {
@@ -8007,6 +8094,9 @@ HID_Action action_action_list[] = {
   {"AutoRoute", 0, ActionAutoRoute,
    autoroute_help, autoroute_syntax}
   ,
+  {"BulkEdit", 0, ActionBulkEdit,
+   bulkedit_help, bulkedit_syntax}
+  ,
   {"ChangeClearSize", 0, ActionChangeClearSize,
    changeclearsize_help, changeclearsize_syntax}
   ,
@@ -8157,7 +8247,7 @@ HID_Action action_action_list[] = {
   {"RouteStyle", 0, ActionRouteStyle,
    routestyle_help, routestyle_syntax}
   ,
-  {"MoveObject", N_("Select an Object"), ActionMoveObject,
+  {"MoveObject", 0, ActionMoveObject,
    moveobject_help, moveobject_syntax}
   ,
   {"MoveToCurrentLayer", 0, ActionMoveToCurrentLayer,
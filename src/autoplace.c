@@ -74,7 +74,7 @@
 /* ---------------------------------------------------------------------------
  * some local prototypes
  */
-static double ComputeCost (NetListType *Nets, double T0, double T);
+static double ComputeCost (double T0, double T);
 
 /* ---------------------------------------------------------------------------
  * some local types
@@ -146,41 +146,37 @@ PerturbationType;
  */
 
 /* ---------------------------------------------------------------------------
- * Update the X, Y and group position information stored in the NetList after
- * elements have possibly been moved, rotated, flipped, etc.
+ * Update the X, Y and group position information stored in a net of the
+ * NetList after elements have possibly been moved, rotated, flipped, etc.
  */
 static void
-UpdateXY (NetListType *Nets)
+UpdateNetXY (NetType *Net)
 {
   Cardinal SLayer, CLayer;
-  Cardinal i, j;
+  Cardinal j;
   /* find layer groups of the component side and solder side */
   SLayer = GetLayerGroupNumberByNumber (solder_silk_layer);
   CLayer = GetLayerGroupNumberByNumber (component_silk_layer);
-  /* update all nets */
-  for (i = 0; i < Nets->NetN; i++)
+  for (j = 0; j < Net->ConnectionN; j++)
     {
-      for (j = 0; j < Nets->Net[i].ConnectionN; j++)
+      ConnectionType *c = &(Net->Connection[j]);
+      switch (c->type)
 	{
-	  ConnectionType *c = &(Nets->Net[i].Connection[j]);
-	  switch (c->type)
-	    {
-	    case PAD_TYPE:
-	      c->group = TEST_FLAG (ONSOLDERFLAG,
-				    (ElementType *) c->ptr1)
-		? SLayer : CLayer;
-	      c->X = ((PadType *) c->ptr2)->Point1.X;
-	      c->Y = ((PadType *) c->ptr2)->Point1.Y;
-	      break;
-	    case PIN_TYPE:
-	      c->group = SLayer;	/* any layer will do */
-	      c->X = ((PinType *) c->ptr2)->X;
-	      c->Y = ((PinType *) c->ptr2)->Y;
-	      break;
-	    default:
-	      Message ("Odd connection type encountered in " "UpdateXY");
-	      break;
-	    }
+	case PAD_TYPE:
+	  c->group = TEST_FLAG (ONSOLDERFLAG,
+				(ElementType *) c->ptr1)
+	    ? SLayer : CLayer;
+	  c->X = ((PadType *) c->ptr2)->Point1.X;
+	  c->Y = ((PadType *) c->ptr2)->Point1.Y;
+	  break;
+	case PIN_TYPE:
+	  c->group = SLayer;	/* any layer will do */
+	  c->X = ((PinType *) c->ptr2)->X;
+	  c->Y = ((PinType *) c->ptr2)->Y;
+	  break;
+	default:
+	  Message ("Odd connection type encountered in " "UpdateNetXY");
+	  break;
 	}
     }
 }
@@ -314,285 +310,604 @@ r_find_neighbor (rtree_t * rtree, const BoxType * box,
 }
 
 /* ---------------------------------------------------------------------------
- * Compute cost function.
- *  note that area overlap cost is correct for SMD devices: SMD devices on
- *  opposite sides of the board don't overlap.
+ * Placement state.
  *
- * Algorithms follow those described in sections 4.1 of
- *  "Placement and Routing of Electronic Modules" edited by Michael Pecht
- *  Marcel Dekker, Inc. 1993.  ISBN: 0-8247-8916-4 TK7868.P7.P57 1993
+ * Every term of the cost function is kept per net or per element, so
+ * that after a perturbation only the moved elements, their nets and
+ * the elements that see them as a neighbor are recomputed.  The box
+ * coverages keep the congestion and overlap areas up to date, and the
+ * r-trees answer the neighbor queries.  The cached sums drift a little
+ * with every update, so the state is rebuilt at the end of each stage.
  */
-static double
-ComputeCost (NetListType *Nets, double T0, double T)
+typedef struct PlacedElement
 {
-  double W = 0;			/* wire cost */
-  double delta1 = 0;		/* wire congestion penalty function */
-  double delta2 = 0;		/* module overlap penalty function */
-  double delta3 = 0;		/* out of bounds penalty */
-  double delta4 = 0;		/* alignment bonus */
-  double delta5 = 0;		/* total area penalty */
-  Cardinal i, j;
+  BoxType box;			/* VBox when last placed; the r-tree entry */
+  ElementType *element;
+  int side;			/* 1 on the solder side, 0 otherwise */
+  const BoxType *module;	/* module box on its own side, or NULL */
+  const BoxType **pins;		/* pin boxes on the other side */
+  Cardinal pinN;
+  GArray *nets;			/* indices of the nets it is on */
+  bool oob;			/* outside the board */
+  struct PlacedElement *nb[4];	/* closest neighbor in each direction */
+  double bonus[4];		/* alignment bonus for each neighbor */
+}
+PlacedElementType;
+
+typedef struct
+{
+  NetListType *Nets;
+  double W;			/* wire cost, the sum of NetW */
+  double *NetW;			/* wire cost per net */
+  const BoxType **NetBox;	/* bounding box per net, or NULL */
+  BoxCoverageType *Bounds;	/* the net bounding boxes */
+  BoxCoverageType *Modules[2];	/* the module boxes per side */
+  GHashTable *Placed;		/* ElementType * -> PlacedElementType * */
+  rtree_t *Neighbors[2];	/* the placed elements per side */
+  GHashTable *Open[2][4];	/* placed elements without a neighbor */
+  Coord MaxGap[2][4];		/* no neighbor has been further away */
+  int OutOfBounds;		/* number of elements off the board */
+  double Bonus;			/* sum of the alignment bonuses */
+  BoxType Extent;		/* bounds of all elements */
+}
+PlacementType;
+
+static PlacementType Placement;
+
+static const direction_t Directions[4] = { NORTH, EAST, SOUTH, WEST };
+
+#define PLACED_SIDE(element) (TEST_FLAG (ONSOLDERFLAG, (element)) ? 1 : 0)
+
+/* ---------------------------------------------------------------------------
+ * Computes the module box of an element (bounding rect of pins/pads)
+ * and the boxes its pins block on the other side.  Returns false for
+ * elements without pins and pads.
+ */
+static bool
+ElementModuleBoxes (ElementType *element, BoxType *box,
+		    BoxListType *otherside)
+{
+  BoxType *lastbox = NULL;
+  Coord thickness;
+  Coord clearance;
+
+  /* protect against elements with no pins/pads */
+  if (element->PinN == 0 && element->PadN == 0)
+    return false;
+  /* initialize box so that it will take the dimensions of
+   * the first pin/pad */
+  box->X1 = MAX_COORD;
+  box->Y1 = MAX_COORD;
+  box->X2 = -MAX_COORD;
+  box->Y2 = -MAX_COORD;
+  PIN_LOOP (element);
+  {
+    thickness = pin->Thickness / 2;
+    clearance = pin->Clearance * 2;
+  EXPANDRECTXY (box,
+		  pin->X - (thickness + clearance),
+		  pin->Y - (thickness + clearance),
+		  pin->X + (thickness + clearance),
+		  pin->Y + (thickness + clearance))}
+  END_LOOP;
+  PAD_LOOP (element);
+  {
+    thickness = pad->Thickness / 2;
+    clearance = pad->Clearance * 2;
+  EXPANDRECTXY (box,
+		  MIN (pad->Point1.X,
+		       pad->Point2.X) - (thickness +
+					 clearance),
+		  MIN (pad->Point1.Y,
+		       pad->Point2.Y) - (thickness +
+					 clearance),
+		  MAX (pad->Point1.X,
+		       pad->Point2.X) + (thickness +
+					 clearance),
+		  MAX (pad->Point1.Y,
+		       pad->Point2.Y) + (thickness + clearance))}
+  END_LOOP;
+  /* add a box for each pin to the "opposite side":
+   * surface mount components can't sit on top of pins */
+  if (!CostParameter.fast)
+    PIN_LOOP (element);
+  {
+    BoxType *pbox = GetBoxMemory (otherside);
+    thickness = pin->Thickness / 2;
+    clearance = pin->Clearance * 2;
+    /* we ignore clearance here */
+    /* (otherwise pins don't fit next to each other) */
+    pbox->X1 = pin->X - thickness;
+    pbox->Y1 = pin->Y - thickness;
+    pbox->X2 = pin->X + thickness;
+    pbox->Y2 = pin->Y + thickness;
+    /* speed hack! coalesce with last box if we can */
+    if (lastbox != NULL &&
+	((lastbox->X1 == pbox->X1 &&
+	  lastbox->X2 == pbox->X2 &&
+	  MIN (abs (lastbox->Y1 - pbox->Y2),
+	       abs (pbox->Y1 - lastbox->Y2)) <
+	  clearance) || (lastbox->Y1 == pbox->Y1
+			 && lastbox->Y2 == pbox->Y2
+			 &&
+			 MIN (abs
+			      (lastbox->X1 -
+			       pbox->X2),
+			      abs (pbox->X1 - lastbox->X2)) < clearance)))
+      {
+	EXPANDRECT (lastbox, pbox);
+	otherside->BoxN--;
+      }
+    else
+      lastbox = pbox;
+  }
+  END_LOOP;
+  return true;
+}
+
+/* adds the module boxes of an element to the overlap coverages */
+static void
+placeModules (PlacedElementType *pe)
+{
+  BoxListType pins = { 0, 0, NULL };
+  BoxType box;
+  ElementType *element = pe->element;
+  Cardinal i;
+
+  if (!ElementModuleBoxes (element, &box, &pins))
+    return;
+  pe->module = BoxCoverageInsert (Placement.Modules[pe->side], &box);
+  pe->pins = (const BoxType **) malloc (pins.BoxN * sizeof (*pe->pins));
+  for (i = 0; i < pins.BoxN; i++)
+    pe->pins[i] = BoxCoverageInsert (Placement.Modules[!pe->side],
+				     &pins.Box[i]);
+  pe->pinN = pins.BoxN;
+  FreeBoxListMemory (&pins);
+  /* assess out of bounds penalty */
+  pe->oob = (element->VBox.X1 < 0 ||
+	     element->VBox.Y1 < 0 ||
+	     element->VBox.X2 > PCB->MaxWidth ||
+	     element->VBox.Y2 > PCB->MaxHeight);
+  if (pe->oob)
+    Placement.OutOfBounds++;
+}
+
+static void
+unplaceModules (PlacedElementType *pe)
+{
+  Cardinal i;
+
+  if (pe->module == NULL)
+    return;
+  BoxCoverageRemove (Placement.Modules[pe->side], pe->module);
+  for (i = 0; i < pe->pinN; i++)
+    BoxCoverageRemove (Placement.Modules[!pe->side], pe->pins[i]);
+  free (pe->pins);
+  pe->module = NULL;
+  pe->pins = NULL;
+  pe->pinN = 0;
+  if (pe->oob)
+    Placement.OutOfBounds--;
+  pe->oob = false;
+}
+
+/* ---------------------------------------------------------------------------
+ * wire length term of a net.  approximated by half-perimeter of minimum
+ * rectangle enclosing the net.  Note that we penalize vias in all-SMD
+ * nets by making the rectangle a cube and weighting the "layer height"
+ * of the net.  The rectangle also goes into the congestion coverage.
+ */
+static void
+placeNet (Cardinal i)
+{
+  NetType *n = &Placement.Nets->Net[i];
   Coord minx, maxx, miny, maxy;
   bool allpads, allsameside;
   Cardinal thegroup;
-  BoxListType bounds = { 0, 0, NULL };	/* save bounding rectangles here */
-  BoxListType solderside = { 0, 0, NULL };	/* solder side component bounds */
-  BoxListType componentside = { 0, 0, NULL };	/* component side bounds */
-  /* make sure the NetList have the proper updated X and Y coords */
-  UpdateXY (Nets);
-  /* wire length term.  approximated by half-perimeter of minimum
-   * rectangle enclosing the net.  Note that we penalize vias in
-   * all-SMD nets by making the rectangle a cube and weighting
-   * the "layer height" of the net. */
-  for (i = 0; i < Nets->NetN; i++)
+  BoxType box;
+  Cardinal j;
+
+  if (n->ConnectionN < 2)
+    return;			/* no cost to go nowhere */
+  UpdateNetXY (n);
+  minx = maxx = n->Connection[0].X;
+  miny = maxy = n->Connection[0].Y;
+  thegroup = n->Connection[0].group;
+  allpads = (n->Connection[0].type == PAD_TYPE);
+  allsameside = true;
+  for (j = 1; j < n->ConnectionN; j++)
     {
-      NetType *n = &Nets->Net[i];
-      if (n->ConnectionN < 2)
-	continue;		/* no cost to go nowhere */
-      minx = maxx = n->Connection[0].X;
-      miny = maxy = n->Connection[0].Y;
-      thegroup = n->Connection[0].group;
-      allpads = (n->Connection[0].type == PAD_TYPE);
-      allsameside = true;
-      for (j = 1; j < n->ConnectionN; j++)
-	{
-	  ConnectionType *c = &(n->Connection[j]);
-	  MAKEMIN (minx, c->X);
-	  MAKEMAX (maxx, c->X);
-	  MAKEMIN (miny, c->Y);
-	  MAKEMAX (maxy, c->Y);
-	  if (c->type != PAD_TYPE)
-	    allpads = false;
-	  if (c->group != thegroup)
-	    allsameside = false;
-	}
-      /* save bounding rectangle */
-      {
-	BoxType *box = GetBoxMemory (&bounds);
-	box->X1 = minx;
-	box->Y1 = miny;
-	box->X2 = maxx;
-	box->Y2 = maxy;
-      }
-      /* okay, add half-perimeter to cost! */
-      W += COORD_TO_MIL(maxx - minx) + COORD_TO_MIL(maxy - miny) +
-	((allpads && !allsameside) ? CostParameter.via_cost : 0);
+      ConnectionType *c = &(n->Connection[j]);
+      MAKEMIN (minx, c->X);
+      MAKEMAX (maxx, c->X);
+      MAKEMIN (miny, c->Y);
+      MAKEMAX (maxy, c->Y);
+      if (c->type != PAD_TYPE)
+	allpads = false;
+      if (c->group != thegroup)
+	allsameside = false;
     }
-  /* now compute penalty function Wc which is proportional to
-   * amount of overlap and congestion. */
-  /* delta1 is congestion penalty function */
-  delta1 = CostParameter.congestion_penalty *
-    sqrt (fabs (ComputeIntersectionArea (&bounds)));
-#if 0
-  printf ("Wire Congestion Area: %f\n", ComputeIntersectionArea (&bounds));
-#endif
-  /* free bounding rectangles */
-  FreeBoxListMemory (&bounds);
-  /* now collect module areas (bounding rect of pins/pads) */
-  /* two lists for solder side / component side. */
+  box.X1 = minx;
+  box.Y1 = miny;
+  box.X2 = maxx;
+  box.Y2 = maxy;
+  if (Placement.NetBox[i])
+    BoxCoverageRemove (Placement.Bounds, Placement.NetBox[i]);
+  Placement.NetBox[i] = BoxCoverageInsert (Placement.Bounds, &box);
+  /* okay, add half-perimeter to cost! */
+  Placement.W -= Placement.NetW[i];
+  Placement.NetW[i] = COORD_TO_MIL (maxx - minx) + COORD_TO_MIL (maxy - miny) +
+    ((allpads && !allsameside) ? CostParameter.via_cost : 0);
+  Placement.W += Placement.NetW[i];
+}
 
-  ELEMENT_LOOP (PCB->Data);
-  {
-    BoxListType *thisside;
-    BoxListType *otherside;
-    BoxType *box;
-    BoxType *lastbox = NULL;
-    Coord thickness;
-    Coord clearance;
-    if (TEST_FLAG (ONSOLDERFLAG, element))
-      {
-	thisside = &solderside;
-	otherside = &componentside;
-      }
-    else
-      {
-	thisside = &componentside;
-	otherside = &solderside;
-      }
-    box = GetBoxMemory (thisside);
-    /* protect against elements with no pins/pads */
-    if (element->PinN == 0 && element->PadN == 0)
-      continue;
-    /* initialize box so that it will take the dimensions of
-     * the first pin/pad */
-    box->X1 = MAX_COORD;
-    box->Y1 = MAX_COORD;
-    box->X2 = -MAX_COORD;
-    box->Y2 = -MAX_COORD;
-    PIN_LOOP (element);
+/* ---------------------------------------------------------------------------
+ * reward pin/pad x/y alignment
+ * score higher if pins/pads belong to same *type* of component
+ * XXX: subkey should be *distance* from thing aligned with, so that
+ * aligning to something far away isn't profitable
+ */
+static double
+neighborBonus (PlacedElementType *pe, PlacedElementType *nb)
+{
+  ElementType *element = pe->element;
+  double bonus = 0;
+  int factor = 1;
+
+  if (element->Name[0].TextString &&
+      nb->element->Name[0].TextString &&
+      0 == NSTRCMP (element->Name[0].TextString,
+		    nb->element->Name[0].TextString))
     {
-      thickness = pin->Thickness / 2;
-      clearance = pin->Clearance * 2;
-    EXPANDRECTXY (box,
-		    pin->X - (thickness + clearance),
-		    pin->Y - (thickness + clearance),
-		    pin->X + (thickness + clearance),
-		    pin->Y + (thickness + clearance))}
-    END_LOOP;
-    PAD_LOOP (element);
+      bonus += CostParameter.matching_neighbor_bonus;
+      factor++;
+    }
+  if (element->Name[0].Direction == nb->element->Name[0].Direction)
+    bonus += factor * CostParameter.oriented_neighbor_bonus;
+  if (pe->box.X1 == nb->box.X1 ||
+      pe->box.X1 == nb->box.X2 ||
+      pe->box.X2 == nb->box.X1 ||
+      pe->box.X2 == nb->box.X2 ||
+      pe->box.Y1 == nb->box.Y1 ||
+      pe->box.Y1 == nb->box.Y2 ||
+      pe->box.Y2 == nb->box.Y1 ||
+      pe->box.Y2 == nb->box.Y2)
+    bonus += factor * CostParameter.aligned_neighbor_bonus;
+  return bonus;
+}
+
+/* finds the neighbor of a placed element in one direction again */
+static void
+placeNeighbor (PlacedElementType *pe, int d)
+{
+  PlacedElementType *nb = (PlacedElementType *)
+    r_find_neighbor (Placement.Neighbors[pe->side], &pe->box, Directions[d]);
+
+  Placement.Bonus -= pe->bonus[d];
+  pe->nb[d] = nb;
+  pe->bonus[d] = 0;
+  if (nb)
     {
-      thickness = pad->Thickness / 2;
-      clearance = pad->Clearance * 2;
-    EXPANDRECTXY (box,
-		    MIN (pad->Point1.X,
-			   pad->Point2.X) - (thickness +
-					       clearance),
-		    MIN (pad->Point1.Y,
-			   pad->Point2.Y) - (thickness +
-					       clearance),
-		    MAX (pad->Point1.X,
-			   pad->Point2.X) + (thickness +
-					       clearance),
-		    MAX (pad->Point1.Y,
-			   pad->Point2.Y) + (thickness + clearance))}
-    END_LOOP;
-    /* add a box for each pin to the "opposite side":
-     * surface mount components can't sit on top of pins */
-    if (!CostParameter.fast)
-      PIN_LOOP (element);
+      BoxType a = pe->box, b = nb->box;
+      ROTATEBOX_TO_NORTH (a, Directions[d]);
+      ROTATEBOX_TO_NORTH (b, Directions[d]);
+      MAKEMAX (Placement.MaxGap[pe->side][d], a.Y1 - b.Y2);
+      g_hash_table_remove (Placement.Open[pe->side][d], pe);
+      pe->bonus[d] = neighborBonus (pe, nb);
+    }
+  else
+    g_hash_table_insert (Placement.Open[pe->side][d], pe, pe);
+  Placement.Bonus += pe->bonus[d];
+}
+
+/* ---------------------------------------------------------------------------
+ * Finds the elements whose neighbor in one direction may be a moved
+ * element: those with the moved box in their search trapezoid (see
+ * r_find_neighbor).  Looking at it from the moved box, that is a cone
+ * opening the other way, which is cut off where elements further away
+ * than any neighbor has ever been start.  The test runs in the frame
+ * rotated to the 'north' case.
+ */
+struct dependent_info
+{
+  BoxType query;		/* the moved box */
+  Coord top;			/* top of the board */
+  Coord limit;			/* no dependent starts below this */
+  direction_t search_dir;
+  GPtrArray *found;
+};
+
+static int
+__dependent_reg_in_sea (const BoxType * region, void *cl)
+{
+  struct dependent_info *di = (struct dependent_info *) cl;
+  BoxType r = *region;
+  ROTATEBOX_TO_NORTH (r, di->search_dir);
+  return (r.Y2 >= di->query.Y2) && (r.Y2 > di->query.Y1) &&
+    (r.Y1 <= di->limit) &&
+    (r.X1 - r.Y2 < di->query.X2 - di->query.Y1) &&
+    (r.X2 + r.Y2 > di->query.X1 + di->query.Y1);
+}
+
+/* true if query is in the trapezoid searched from box */
+static bool
+in_trapezoid (const BoxType * box, const BoxType * query, Coord top)
+{
+  return (query->Y2 > top) && (query->Y1 < box->Y1) &&
+    (query->X2 + box->Y1 > box->X1 + query->Y1) &&
+    (query->X1 + query->Y1 < box->X2 + box->Y1) &&
+    (query->Y2 <= box->Y1);
+}
+
+static int
+__dependent_rect_in_reg (const BoxType * box, void *cl)
+{
+  struct dependent_info *di = (struct dependent_info *) cl;
+  BoxType b = *box;
+  ROTATEBOX_TO_NORTH (b, di->search_dir);
+  if (b.Y1 > di->limit || !in_trapezoid (&b, &di->query, di->top))
+    return 0;
+  g_ptr_array_add (di->found, (gpointer) box);
+  return 1;
+}
+
+/* ---------------------------------------------------------------------------
+ * Finds the neighbors again of the elements that may have had pe as
+ * their neighbor, at box, or that may have it now.
+ */
+static void
+placeDependents (PlacedElementType *pe, const BoxType *box, int side,
+		 bool removed)
+{
+  struct dependent_info di;
+  BoxType bbox;
+  int d;
+  guint i;
+
+  di.found = g_ptr_array_new ();
+  for (d = 0; d < 4; d++)
     {
-      box = GetBoxMemory (otherside);
-      thickness = pin->Thickness / 2;
-      clearance = pin->Clearance * 2;
-      /* we ignore clearance here */
-      /* (otherwise pins don't fit next to each other) */
-      box->X1 = pin->X - thickness;
-      box->Y1 = pin->Y - thickness;
-      box->X2 = pin->X + thickness;
-      box->Y2 = pin->Y + thickness;
-      /* speed hack! coalesce with last box if we can */
-      if (lastbox != NULL &&
-	  ((lastbox->X1 == box->X1 &&
-	    lastbox->X2 == box->X2 &&
-	    MIN (abs (lastbox->Y1 - box->Y2),
-		 abs (box->Y1 - lastbox->Y2)) <
-	    clearance) || (lastbox->Y1 == box->Y1
-			   && lastbox->Y2 == box->Y2
-			   &&
-			   MIN (abs
-				(lastbox->X1 -
-				 box->X2),
-				abs (box->X1 - lastbox->X2)) < clearance)))
+      GHashTableIter iter;
+      gpointer key;
+
+      di.search_dir = Directions[d];
+      di.query = *box;
+      ROTATEBOX_TO_NORTH (di.query, di.search_dir);
+      bbox.X1 = bbox.Y1 = 0;
+      bbox.X2 = PCB->MaxWidth;
+      bbox.Y2 = PCB->MaxHeight;
+      ROTATEBOX_TO_NORTH (bbox, di.search_dir);
+      di.top = bbox.Y1;
+      di.limit = di.query.Y2 + Placement.MaxGap[side][d];
+      g_ptr_array_set_size (di.found, 0);
+      r_search (Placement.Neighbors[side], NULL,
+		__dependent_reg_in_sea, __dependent_rect_in_reg, &di);
+      /* elements without a neighbor may get one from any distance */
+      if (!removed)
 	{
-	  EXPANDRECT (lastbox, box);
-	  otherside->BoxN--;
+	  g_hash_table_iter_init (&iter, Placement.Open[side][d]);
+	  while (g_hash_table_iter_next (&iter, &key, NULL))
+	    {
+	      BoxType b = ((PlacedElementType *) key)->box;
+	      ROTATEBOX_TO_NORTH (b, di.search_dir);
+	      if (b.Y1 > di.limit && in_trapezoid (&b, &di.query, di.top))
+		g_ptr_array_add (di.found, key);
+	    }
+	}
+      for (i = 0; i < di.found->len; i++)
+	{
+	  PlacedElementType *x =
+	    (PlacedElementType *) g_ptr_array_index (di.found, i);
+	  if (x == pe)
+	    continue;
+	  if (removed)
+	    {
+	      if (x->nb[d] != pe)
+		continue;
+	    }
+	  else if (x->nb[d] != NULL)
+	    {
+	      /* only if pe is at least as close as the old neighbor */
+	      BoxType b = x->nb[d]->box;
+	      ROTATEBOX_TO_NORTH (b, di.search_dir);
+	      if (b.Y2 > di.query.Y2)
+		continue;
+	    }
+	  placeNeighbor (x, d);
 	}
-      else
-	lastbox = box;
     }
-    END_LOOP;
-    /* assess out of bounds penalty */
-    if (element->VBox.X1 < 0 ||
-	element->VBox.Y1 < 0 ||
-	element->VBox.X2 > PCB->MaxWidth || element->VBox.Y2 > PCB->MaxHeight)
-      delta3 += CostParameter.out_of_bounds_penalty;
+  g_ptr_array_free (di.found, TRUE);
+}
+
+/* recomputes the bounds of all elements */
+static void
+placeExtent (void)
+{
+  Placement.Extent.X1 = Placement.Extent.Y1 = MAX_COORD;
+  Placement.Extent.X2 = Placement.Extent.Y2 = -MAX_COORD;
+  ELEMENT_LOOP (PCB->Data);
+  {
+    EXPANDRECT ((&Placement.Extent), (&element->VBox));
   }
   END_LOOP;
-  /* compute intersection area of module areas box list */
-  delta2 = sqrt (fabs (ComputeIntersectionArea (&solderside) +
-		       ComputeIntersectionArea (&componentside))) *
-    (CostParameter.overlap_penalty_min +
-     (1 - (T / T0)) * CostParameter.overlap_penalty_max);
-#if 0
-  printf ("Module Overlap Area (solder): %f\n",
-	  ComputeIntersectionArea (&solderside));
-  printf ("Module Overlap Area (component): %f\n",
-	  ComputeIntersectionArea (&componentside));
-#endif
-  FreeBoxListMemory (&solderside);
-  FreeBoxListMemory (&componentside);
-  /* reward pin/pad x/y alignment */
-  /* score higher if pins/pads belong to same *type* of component */
-  /* XXX: subkey should be *distance* from thing aligned with, so that
-   * aligning to something far away isn't profitable */
-  {
-    /* create r tree */
-    PointerListType seboxes = { 0, 0, NULL }
-    , ceboxes =
-    {
-    0, 0, NULL};
-    struct ebox
+}
+
+/* ---------------------------------------------------------------------------
+ * Builds the placement state for the current positions of all elements.
+ */
+static void
+PlacementBegin (NetListType *Nets)
+{
+  Cardinal i;
+  int side, d;
+
+  memset (&Placement, 0, sizeof (Placement));
+  Placement.Nets = Nets;
+  Placement.NetW = (double *) calloc (Nets->NetN + 1, sizeof (double));
+  Placement.NetBox = (const BoxType **)
+    calloc (Nets->NetN + 1, sizeof (*Placement.NetBox));
+  Placement.Bounds = CreateBoxCoverage ();
+  Placement.Placed = g_hash_table_new (NULL, NULL);
+  for (side = 0; side < 2; side++)
     {
-      BoxType box;
-      ElementType *element;
-    };
-    direction_t dir[4] = { NORTH, EAST, SOUTH, WEST };
-    struct ebox **boxpp, *boxp;
-    rtree_t *rt_s, *rt_c;
-    int factor;
-    ELEMENT_LOOP (PCB->Data);
+      Placement.Modules[side] = CreateBoxCoverage ();
+      Placement.Neighbors[side] = r_create_tree (NULL, 0, 0);
+      for (d = 0; d < 4; d++)
+	Placement.Open[side][d] = g_hash_table_new (NULL, NULL);
+    }
+
+  ELEMENT_LOOP (PCB->Data);
+  {
+    PlacedElementType *pe = g_new0 (PlacedElementType, 1);
+    pe->box = element->VBox;
+    pe->element = element;
+    pe->side = PLACED_SIDE (element);
+    pe->nets = g_array_new (FALSE, FALSE, sizeof (Cardinal));
+    g_hash_table_insert (Placement.Placed, element, pe);
+    r_insert_entry (Placement.Neighbors[pe->side], &pe->box, 0);
+    placeModules (pe);
+  }
+  END_LOOP;
+
+  /* file the nets with the elements on them */
+  for (i = 0; i < Nets->NetN; i++)
     {
-      boxpp = (struct ebox **)
-	GetPointerMemory (TEST_FLAG (ONSOLDERFLAG, element) ?
-			  &seboxes : &ceboxes);
-      *boxpp = (struct ebox *)malloc (sizeof (**boxpp));
-      if (*boxpp == NULL ) 
+      NetType *n = &Nets->Net[i];
+      Cardinal j;
+
+      for (j = 0; j < n->ConnectionN; j++)
 	{
-	  fprintf (stderr, "malloc() failed in %s\n", __FUNCTION__);
-	  exit (1);
+	  PlacedElementType *pe = (PlacedElementType *)
+	    g_hash_table_lookup (Placement.Placed, n->Connection[j].ptr1);
+	  if (pe == NULL || (pe->nets->len > 0 &&
+			     g_array_index (pe->nets, Cardinal,
+					    pe->nets->len - 1) == i))
+	    continue;
+	  g_array_append_val (pe->nets, i);
 	}
+      placeNet (i);
+    }
+
+  ELEMENT_LOOP (PCB->Data);
+  {
+    PlacedElementType *pe = (PlacedElementType *)
+      g_hash_table_lookup (Placement.Placed, element);
+    for (d = 0; d < 4; d++)
+      placeNeighbor (pe, d);
+  }
+  END_LOOP;
+  placeExtent ();
+}
+
+/* ---------------------------------------------------------------------------
+ * Updates the placement state after an element was moved, rotated or
+ * flipped.  Costs depend on the size of its nets and the number of
+ * elements near it, not on the size of the board.
+ */
+static void
+PlacementMoved (ElementType *element)
+{
+  PlacedElementType *pe = (PlacedElementType *)
+    g_hash_table_lookup (Placement.Placed, element);
+  BoxType old = pe->box;
+  int oldside = pe->side;
+  guint i;
+  int d;
 
-      (*boxpp)->box = element->VBox;
-      (*boxpp)->element = element;
+  unplaceModules (pe);
+  r_delete_entry (Placement.Neighbors[oldside], &pe->box);
+  for (d = 0; d < 4; d++)
+    {
+      g_hash_table_remove (Placement.Open[oldside][d], pe);
+      Placement.Bonus -= pe->bonus[d];
+      pe->bonus[d] = 0;
+      pe->nb[d] = NULL;
     }
-    END_LOOP;
-    rt_s = r_create_tree ((const BoxType **) seboxes.Ptr, seboxes.PtrN, 1);
-    rt_c = r_create_tree ((const BoxType **) ceboxes.Ptr, ceboxes.PtrN, 1);
-    FreePointerListMemory (&seboxes);
-    FreePointerListMemory (&ceboxes);
-    /* now, for each element, find its neighbor on all four sides */
-    delta4 = 0;
-    for (i = 0; i < 4; i++)
-      ELEMENT_LOOP (PCB->Data);
+  placeDependents (pe, &old, oldside, true);
+
+  pe->box = element->VBox;
+  pe->side = PLACED_SIDE (element);
+  r_insert_entry (Placement.Neighbors[pe->side], &pe->box, 0);
+  placeDependents (pe, &pe->box, pe->side, false);
+  for (d = 0; d < 4; d++)
+    placeNeighbor (pe, d);
+  placeModules (pe);
+
+  for (i = 0; i < pe->nets->len; i++)
+    placeNet (g_array_index (pe->nets, Cardinal, i));
+
+  if (old.X1 == Placement.Extent.X1 || old.Y1 == Placement.Extent.Y1 ||
+      old.X2 == Placement.Extent.X2 || old.Y2 == Placement.Extent.Y2)
+    placeExtent ();
+  else
+    EXPANDRECT ((&Placement.Extent), (&pe->box));
+}
+
+static void
+PlacementEnd (void)
+{
+  GHashTableIter iter;
+  gpointer value;
+  int side, d;
+
+  g_hash_table_iter_init (&iter, Placement.Placed);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
     {
-      boxp = (struct ebox *)
-	r_find_neighbor (TEST_FLAG (ONSOLDERFLAG, element) ?
-			 rt_s : rt_c, &element->VBox, dir[i]);
-      /* score bounding box alignments */
-      if (!boxp)
-	continue;
-      factor = 1;
-      if (element->Name[0].TextString &&
-	  boxp->element->Name[0].TextString &&
-	  0 == NSTRCMP (element->Name[0].TextString,
-			boxp->element->Name[0].TextString))
-	{
-	  delta4 += CostParameter.matching_neighbor_bonus;
-	  factor++;
-	}
-      if (element->Name[0].Direction == boxp->element->Name[0].Direction)
-	delta4 += factor * CostParameter.oriented_neighbor_bonus;
-      if (element->VBox.X1 == boxp->element->VBox.X1 ||
-	  element->VBox.X1 == boxp->element->VBox.X2 ||
-	  element->VBox.X2 == boxp->element->VBox.X1 ||
-	  element->VBox.X2 == boxp->element->VBox.X2 ||
-	  element->VBox.Y1 == boxp->element->VBox.Y1 ||
-	  element->VBox.Y1 == boxp->element->VBox.Y2 ||
-	  element->VBox.Y2 == boxp->element->VBox.Y1 ||
-	  element->VBox.Y2 == boxp->element->VBox.Y2)
-	delta4 += factor * CostParameter.aligned_neighbor_bonus;
+      PlacedElementType *pe = (PlacedElementType *) value;
+      free (pe->pins);
+      g_array_free (pe->nets, TRUE);
+      g_free (pe);
     }
-    END_LOOP;
-    /* free k-d tree memory */
-    r_destroy_tree (&rt_s);
-    r_destroy_tree (&rt_c);
-  }
-  /* penalize total area used by this layout */
-  {
-    Coord minX = MAX_COORD, minY = MAX_COORD;
-    Coord maxX = -MAX_COORD, maxY = -MAX_COORD;
-    ELEMENT_LOOP (PCB->Data);
+  g_hash_table_destroy (Placement.Placed);
+  for (side = 0; side < 2; side++)
     {
-      MAKEMIN (minX, element->VBox.X1);
-      MAKEMIN (minY, element->VBox.Y1);
-      MAKEMAX (maxX, element->VBox.X2);
-      MAKEMAX (maxY, element->VBox.Y2);
+      DestroyBoxCoverage (&Placement.Modules[side]);
+      r_destroy_tree (&Placement.Neighbors[side]);
+      for (d = 0; d < 4; d++)
+	g_hash_table_destroy (Placement.Open[side][d]);
     }
-    END_LOOP;
-    if (minX < maxX && minY < maxY)
-      delta5 = CostParameter.overall_area_penalty *
-	sqrt (COORD_TO_MIL (maxX - minX) * COORD_TO_MIL (maxY - minY));
-  }
+  DestroyBoxCoverage (&Placement.Bounds);
+  free (Placement.NetW);
+  free (Placement.NetBox);
+  memset (&Placement, 0, sizeof (Placement));
+}
+
+/* ---------------------------------------------------------------------------
+ * Compute cost function.
+ *  note that area overlap cost is correct for SMD devices: SMD devices on
+ *  opposite sides of the board don't overlap.
+ *
+ * Algorithms follow those described in sections 4.1 of
+ *  "Placement and Routing of Electronic Modules" edited by Michael Pecht
+ *  Marcel Dekker, Inc. 1993.  ISBN: 0-8247-8916-4 TK7868.P7.P57 1993
+ */
+static double
+ComputeCost (double T0, double T)
+{
+  double W = Placement.W;	/* wire cost */
+  double delta1 = 0;		/* wire congestion penalty function */
+  double delta2 = 0;		/* module overlap penalty function */
+  double delta3 = 0;		/* out of bounds penalty */
+  double delta4 = 0;		/* alignment bonus */
+  double delta5 = 0;		/* total area penalty */
+  const BoxType *e = &Placement.Extent;
+
+  /* now compute penalty function Wc which is proportional to
+   * amount of overlap and congestion. */
+  /* delta1 is congestion penalty function */
+  delta1 = CostParameter.congestion_penalty *
+    sqrt (fabs (BoxCoverageIntersectionArea (Placement.Bounds)));
+  /* intersection area of module areas, solder side and component side */
+  delta2 = sqrt (fabs (BoxCoverageIntersectionArea (Placement.Modules[1]) +
+		       BoxCoverageIntersectionArea (Placement.Modules[0]))) *
+    (CostParameter.overlap_penalty_min +
+     (1 - (T / T0)) * CostParameter.overlap_penalty_max);
+  delta3 = Placement.OutOfBounds * CostParameter.out_of_bounds_penalty;
+  delta4 = Placement.Bonus;
+  /* penalize total area used by this layout */
+  if (e->X1 < e->X2 && e->Y1 < e->Y2)
+    delta5 = CostParameter.overall_area_penalty *
+      sqrt (COORD_TO_MIL (e->X2 - e->X1) * COORD_TO_MIL (e->Y2 - e->Y1));
   if (T == 5)
     {
       T = W + delta1 + delta2 + delta3 - delta4 + delta5;
@@ -742,6 +1057,88 @@ doPerturb (PerturbationType * pt, bool undo)
     }
 }
 
+#ifndef NDEBUG
+/* ---------------------------------------------------------------------------
+ * Debug builds check the placement state after every perturbation
+ * against one built from scratch, term by term as ComputeCost reads
+ * it.  The sums may differ by rounding only.  Neighbors at the same
+ * distance are found in r-tree order, so for them the check asks for
+ * a closest neighbor and its bonus rather than the same one.
+ */
+static bool
+placementClose (double a, double b, double scale)
+{
+  return fabs (a - b) <= 1e-9 * MAX (scale, MAX (fabs (a), fabs (b)));
+}
+
+static void
+PlacementCheck (void)
+{
+  PlacementType moved = Placement;
+  double board = (double) PCB->MaxWidth * PCB->MaxHeight * 0.0001;
+  double bonus = 0;
+  int side, d;
+
+  PlacementBegin (moved.Nets);
+  assert (Placement.OutOfBounds == moved.OutOfBounds);
+  assert (Placement.Extent.X1 == moved.Extent.X1 &&
+	  Placement.Extent.Y1 == moved.Extent.Y1 &&
+	  Placement.Extent.X2 == moved.Extent.X2 &&
+	  Placement.Extent.Y2 == moved.Extent.Y2);
+  assert (placementClose (Placement.W, moved.W, 1));
+  assert (placementClose (BoxCoverageIntersectionArea (Placement.Bounds),
+			  BoxCoverageIntersectionArea (moved.Bounds), board));
+  for (side = 0; side < 2; side++)
+    assert (placementClose
+	    (BoxCoverageIntersectionArea (Placement.Modules[side]),
+	     BoxCoverageIntersectionArea (moved.Modules[side]), board));
+  PlacementEnd ();
+  Placement = moved;
+
+  ELEMENT_LOOP (PCB->Data);
+  {
+    PlacedElementType *pe = (PlacedElementType *)
+      g_hash_table_lookup (Placement.Placed, element);
+    assert (pe->box.X1 == element->VBox.X1 && pe->box.Y1 == element->VBox.Y1
+	    && pe->box.X2 == element->VBox.X2
+	    && pe->box.Y2 == element->VBox.Y2);
+    for (d = 0; d < 4; d++)
+      {
+	PlacedElementType *nb = (PlacedElementType *)
+	  r_find_neighbor (Placement.Neighbors[pe->side], &pe->box,
+			   Directions[d]);
+	assert ((nb == NULL) == (pe->nb[d] == NULL));
+	if (nb)
+	  {
+	    BoxType a = nb->box, b = pe->nb[d]->box;
+	    ROTATEBOX_TO_NORTH (a, Directions[d]);
+	    ROTATEBOX_TO_NORTH (b, Directions[d]);
+	    assert (a.Y2 == b.Y2);
+	    assert (pe->bonus[d] == neighborBonus (pe, pe->nb[d]));
+	  }
+	else
+	  assert (pe->bonus[d] == 0);
+	bonus += pe->bonus[d];
+      }
+  }
+  END_LOOP;
+  assert (placementClose (bonus, Placement.Bonus, 1));
+}
+#endif
+
+/* perturbs and updates the placement state for the moved elements */
+static void
+placePerturb (PerturbationType * pt, bool undo)
+{
+  doPerturb (pt, undo);
+  PlacementMoved (pt->element);
+  if (pt->which == EXCHANGE)
+    PlacementMoved (pt->other);
+#ifndef NDEBUG
+  PlacementCheck ();
+#endif
+}
+
 /* ---------------------------------------------------------------------------
  * Auto-place selected components.
  */
@@ -774,19 +1171,21 @@ AutoPlaceSelected (void)
       goto done;
     }
 
+  PlacementBegin (Nets);
+
   /* simulated annealing */
   {				/* compute T0 by doing a random series of moves. */
     const int TRIALS = 10;
     const double Tx = MIL_TO_COORD (300), P = 0.95;
     double Cs = 0.0;
     int i;
-    C0 = ComputeCost (Nets, Tx, Tx);
+    C0 = ComputeCost (Tx, Tx);
     for (i = 0; i < TRIALS; i++)
       {
 	pt = createPerturbation (&Selected, INCH_TO_COORD (1));
-	doPerturb (&pt, false);
-	Cs += fabs (ComputeCost (Nets, Tx, Tx) - C0);
-	doPerturb (&pt, true);
+	placePerturb (&pt, false);
+	Cs += fabs (ComputeCost (Tx, Tx) - C0);
+	placePerturb (&pt, true);
       }
     T0 = -(Cs / TRIALS) / log (P);
     printf ("Initial T: %f\n", T0);
@@ -798,14 +1197,14 @@ AutoPlaceSelected (void)
     int good_moves = 0, moves = 0;
     const int good_move_cutoff = CostParameter.m * Selected.PtrN;
     const int move_cutoff = 2 * good_move_cutoff;
-    printf ("Starting cost is %.0f\n", ComputeCost (Nets, T0, 5));
-    C0 = ComputeCost (Nets, T0, T);
+    printf ("Starting cost is %.0f\n", ComputeCost (T0, 5));
+    C0 = ComputeCost (T0, T);
     while (1)
       {
 	double Cprime;
 	pt = createPerturbation (&Selected, T);
-	doPerturb (&pt, false);
-	Cprime = ComputeCost (Nets, T0, T);
+	placePerturb (&pt, false);
+	Cprime = ComputeCost (T0, T);
 	if (Cprime < C0)
 	  {			/* good move! */
 	    C0 = Cprime;
@@ -820,7 +1219,7 @@ AutoPlaceSelected (void)
 	    steps++;
 	  }
 	else
-	  doPerturb (&pt, true);	/* undo last change */
+	  placePerturb (&pt, true);	/* undo last change */
 	moves++;
 	/* are we at the end of a stage? */
 	if (good_moves >= good_move_cutoff || moves >= move_cutoff)
@@ -834,12 +1233,16 @@ AutoPlaceSelected (void)
 	    /* nope, adjust T and continue */
 	    moves = good_moves = 0;
 	    T *= CostParameter.gamma;
-	    /* cost is T dependent, so recompute */
-	    C0 = ComputeCost (Nets, T0, T);
+	    /* cost is T dependent, so recompute.  Rebuild the placement
+	     * state first to drop the drift of the incremental updates. */
+	    PlacementEnd ();
+	    PlacementBegin (Nets);
+	    C0 = ComputeCost (T0, T);
 	  }
       }
     changed = (steps > 0);
   }
+  PlacementEnd ();
 done:
   if (changed)
     {
@@ -947,8 +947,8 @@ CreateRouteData ()
     {
       for (i = 0; i < PCB->LayerGroups.Number[group]; i++)
 	/* layer must be 1) not silk (ie, < max_copper_layer) and 2) on */
-	if ((PCB->LayerGroups.Entries[group][i] < max_copper_layer) &&
-	    PCB->Data->Layer[PCB->LayerGroups.Entries[group][i]].On)
+	if ((GROUP_ENTRY (&PCB->LayerGroups, group, i) < max_copper_layer) &&
+	    PCB->Data->Layer[GROUP_ENTRY (&PCB->LayerGroups, group, i)].On)
 	  {
 	    routing_layers++;
 	    is_layer_group_active[group] = true;
@@ -3343,7 +3343,7 @@ RD_DrawLine (routedata_t * rd,
 
   if (TEST_FLAG (LIVEROUTEFLAG, PCB))
     {
-      LayerType *layer = LAYER_PTR (PCB->LayerGroups.Entries[rb->group][0]);
+      LayerType *layer = LAYER_PTR (GROUP_ENTRY (&PCB->LayerGroups, rb->group, 0));
       LineType *line = CreateNewLineOnLayer (layer, qX1, qY1, qX2, qY2,
 					     2 * qhthick, 0, MakeFlags (0));
       rb->livedraw_obj.line = line;
@@ -4609,7 +4609,7 @@ ripout_livedraw_obj (routebox_t *rb)
 {
   if (rb->type == LINE && rb->livedraw_obj.line)
     {
-      LayerType *layer = LAYER_PTR (PCB->LayerGroups.Entries[rb->group][0]);
+      LayerType *layer = LAYER_PTR (GROUP_ENTRY (&PCB->LayerGroups, rb->group, 0));
       EraseLine (rb->livedraw_obj.line);
       DestroyObject (PCB->Data, LINE_TYPE, layer, rb->livedraw_obj.line, NULL);
       rb->livedraw_obj.line = NULL;
@@ -5029,7 +5029,7 @@ IronDownAllUnfixedPaths (routedata_t * rd)
 	  for (i = 0, layer = NULL; i < PCB->LayerGroups.Number[p->group];
 	       i++)
 	    {
-	      layer = LAYER_PTR (PCB->LayerGroups.Entries[p->group][i]);
+	      layer = LAYER_PTR (GROUP_ENTRY (&PCB->LayerGroups, p->group, i));
 	      if (layer->On)
 		break;
 	    }
@@ -389,10 +389,12 @@ MoveElementToBuffer (ElementType *element)
    */
   r_delete_element (Source, element);
 
+  ElementNameIndexDelete (Source, element);
   Source->Element = g_list_remove (Source->Element, element);
   Source->ElementN --;
   Dest->Element = g_list_append (Dest->Element, element);
   Dest->ElementN ++;
+  ElementNameIndexInsert (Dest, element);
 
   PIN_LOOP (element);
   {
@@ -464,7 +466,7 @@ AddSelectedToBuffer (BufferType *Buffer, Coord X, Coord Y, bool LeaveSelected)
   notify_crosshair_change (false);
   Source = PCB->Data;
   Dest = Buffer->Data;
-  SelectedOperation (&AddBufferFunctions, false, ALL_TYPES);
+  SelectedOperationInPlace (&AddBufferFunctions, ALL_TYPES);
 
   /* set origin to passed or current position */
   if (X || Y)
@@ -566,7 +568,7 @@ static FootprintHashEntry *footprint_hash = 0;
 int footprint_hash_size = 0;
 
 void
-clear_footprint_hash ()
+clear_footprint_hash (void)
 {
   int i;
   if (!footprint_hash)
@@ -598,7 +600,7 @@ footprint_hash_cmp (const void *va, const void *vb)
 }
 
 void
-make_footprint_hash ()
+make_footprint_hash (void)
 {
   int i, j;
   char *fp;
@@ -837,17 +839,15 @@ LoadFootprint (int argc, char **argv, Coord x, Coord y)
 
   e = PASTEBUFFER->Data->Element->data;
 
-  if (e->Name[0].TextString)
-    free (e->Name[0].TextString);
-  e->Name[0].TextString = strdup (name);
+  StringRelease (e->Name[0].TextString);
+  e->Name[0].TextString = StringIntern (name);
 
-  if (e->Name[1].TextString)
-    free (e->Name[1].TextString);
-  e->Name[1].TextString = refdes ? strdup (refdes) : 0;
+  StringRelease (e->Name[1].TextString);
+  e->Name[1].TextString = StringIntern (refdes);
+  ElementNameIndexUpdate (PASTEBUFFER->Data, e);
 
-  if (e->Name[2].TextString)
-    free (e->Name[2].TextString);
-  e->Name[2].TextString = value ? strdup (value) : 0;
+  StringRelease (e->Name[2].TextString);
+  e->Name[2].TextString = StringIntern (value);
 
   return 0;
 }
@@ -913,11 +913,11 @@ SmashBufferElement (BufferType *Buffer)
   group =
     GetLayerGroupNumberByNumber (SWAP_IDENT ? solder_silk_layer :
 					      component_silk_layer);
-  clayer = &Buffer->Data->Layer[PCB->LayerGroups.Entries[group][0]];
+  clayer = &Buffer->Data->Layer[GROUP_ENTRY (&PCB->LayerGroups, group, 0)];
   group =
     GetLayerGroupNumberByNumber (SWAP_IDENT ? component_silk_layer :
 					      solder_silk_layer);
-  slayer = &Buffer->Data->Layer[PCB->LayerGroups.Entries[group][0]];
+  slayer = &Buffer->Data->Layer[GROUP_ENTRY (&PCB->LayerGroups, group, 0)];
   PAD_LOOP (element);
   {
     LineType *line;
@@ -1101,7 +1101,10 @@ ConvertBufferToElement (BufferType *Buffer)
   LINE_LOOP (&Buffer->Data->SILKLAYER);
   {
     if (line->Number && !NAMEONPCB_NAME (Element))
-      NAMEONPCB_NAME (Element) = strdup (line->Number);
+      {
+	NAMEONPCB_NAME (Element) = strdup (line->Number);
+	ElementNameIndexUpdate (PCB->Data, Element);
+      }
     CreateNewLineInElement (Element, line->Point1.X,
 			    line->Point1.Y, line->Point2.X,
 			    line->Point2.Y, line->Thickness);
@@ -1569,8 +1572,8 @@ SwapBuffer (BufferType *Buffer)
       for (j = k = 0; j < PCB->LayerGroups.Number[sgroup]; j++)
 	{
 	  int t1, t2;
-	  Cardinal cnumber = PCB->LayerGroups.Entries[cgroup][k];
-	  Cardinal snumber = PCB->LayerGroups.Entries[sgroup][j];
+	  Cardinal cnumber = GROUP_ENTRY (&PCB->LayerGroups, cgroup, k);
+	  Cardinal snumber = GROUP_ENTRY (&PCB->LayerGroups, sgroup, j);
 
 	  if (snumber >= max_copper_layer)
 	    continue;
@@ -1579,7 +1582,7 @@ SwapBuffer (BufferType *Buffer)
 	  while (cnumber >= max_copper_layer)
 	    {
 	      k++;
-	      cnumber = PCB->LayerGroups.Entries[cgroup][k];
+	      cnumber = GROUP_ENTRY (&PCB->LayerGroups, cgroup, k);
 	    }
 	  Buffer->Data->Layer[snumber] = Buffer->Data->Layer[cnumber];
 	  Buffer->Data->Layer[cnumber] = swap;
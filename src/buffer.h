@@ -54,4 +54,7 @@ void *CopyObjectToBuffer (DataType *, DataType *, int,
 /* This action is called from ActionElementAddIf() */
 int LoadFootprint (int argc, char **argv, Coord x, Coord y);
 
+void make_footprint_hash (void);
+void clear_footprint_hash (void);
+
 #endif
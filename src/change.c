@@ -960,17 +960,17 @@ ChangeViaName (PinType *Via)
 static void *
 ChangePinName (ElementType *Element, PinType *Pin)
 {
-  char *old = Pin->Name;
+  /* the name is pooled; the undo list keeps a copy of its own */
+  char *old = STRDUP (Pin->Name);
 
   (void) Element;		/* get rid of 'unused...' warnings */
   if (TEST_FLAG (DISPLAYNAMEFLAG, Pin))
-    {
-      ErasePinName (Pin);
-      Pin->Name = NewName;
-      DrawPinName (Pin);
-    }
-  else
-    Pin->Name = NewName;
+    ErasePinName (Pin);
+  StringRelease (Pin->Name);
+  Pin->Name = StringIntern (NewName);
+  free (NewName);
+  if (TEST_FLAG (DISPLAYNAMEFLAG, Pin))
+    DrawPinName (Pin);
   return (old);
 }
 
@@ -980,17 +980,17 @@ ChangePinName (ElementType *Element, PinType *Pin)
 static void *
 ChangePadName (ElementType *Element, PadType *Pad)
 {
-  char *old = Pad->Name;
+  /* the name is pooled; the undo list keeps a copy of its own */
+  char *old = STRDUP (Pad->Name);
 
   (void) Element;		/* get rid of 'unused...' warnings */
   if (TEST_FLAG (DISPLAYNAMEFLAG, Pad))
-    {
-      ErasePadName (Pad);
-      Pad->Name = NewName;
-      DrawPadName (Pad);
-    }
-  else
-    Pad->Name = NewName;
+    ErasePadName (Pad);
+  StringRelease (Pad->Name);
+  Pad->Name = StringIntern (NewName);
+  free (NewName);
+  if (TEST_FLAG (DISPLAYNAMEFLAG, Pad))
+    DrawPadName (Pad);
   return (old);
 }
 
@@ -1014,7 +1014,8 @@ ChangeLineName (LayerType *Layer, LineType *Line)
 char *
 ChangeElementText (PCBType *pcb, DataType *data, ElementType *Element, int which, char *new_name)
 {
-  char *old = Element->Name[which].TextString;
+  /* the name is pooled; callers get a copy of their own */
+  char *old = STRDUP (Element->Name[which].TextString);
 
 #ifdef DEBUG
   printf("In ChangeElementText, updating old TextString %s to %s\n", old, new_name);
@@ -1026,7 +1027,11 @@ ChangeElementText (PCBType *pcb, DataType *data, ElementType *Element, int which
   r_delete_entry (data->name_tree[which],
 		  & Element->Name[which].BoundingBox);
 
-  Element->Name[which].TextString = new_name;
+  StringRelease (Element->Name[which].TextString);
+  Element->Name[which].TextString = StringIntern (new_name);
+  free (new_name);
+  if (which == NAMEONPCB_INDEX)
+    ElementNameIndexUpdate (data, Element);
   SetTextBoundingBox (&PCB->Font, &Element->Name[which]);
 
   r_insert_entry (data->name_tree[which],
@@ -1038,11 +1043,15 @@ ChangeElementText (PCBType *pcb, DataType *data, ElementType *Element, int which
   return old;
 }
 
+/* Returns -1, leaving NewName to the caller, if the name is locked or
+ * not unique.  Otherwise NewName is taken and the old name, which may
+ * be NULL, is returned.
+ */
 static void *
 ChangeElementName (ElementType *Element)
 {
   if (TEST_FLAG (LOCKFLAG, &Element->Name[0]))
-    return (NULL);
+    return ((char *) -1);
   if (NAME_INDEX (PCB) == NAMEONPCB_INDEX)
     {
       if (TEST_FLAG (UNIQUENAMEFLAG, PCB) &&
@@ -1675,7 +1684,7 @@ ChangeSelectedThermals (int types, int therm_style)
   bool change = false;
 
   Delta = therm_style;
-  change = SelectedOperation (&ChangeThermalFunctions, false, types);
+  change = SelectedOperationInPlace (&ChangeThermalFunctions, types);
   if (change)
     {
       Draw ();
@@ -1697,7 +1706,7 @@ ChangeSelectedSize (int types, Coord Difference, bool fixIt)
   Absolute = (fixIt) ? Difference : 0;
   Delta = Difference;
 
-  change = SelectedOperation (&ChangeSizeFunctions, false, types);
+  change = SelectedOperationInPlace (&ChangeSizeFunctions, types);
   if (change)
     {
       Draw ();
@@ -1719,9 +1728,9 @@ ChangeSelectedClearSize (int types, Coord Difference, bool fixIt)
   Absolute = (fixIt) ? Difference : 0;
   Delta = Difference;
   if (TEST_FLAG (SHOWMASKFLAG, PCB))
-    change = SelectedOperation (&ChangeMaskSizeFunctions, false, types);
+    change = SelectedOperationInPlace (&ChangeMaskSizeFunctions, types);
   else
-    change = SelectedOperation (&ChangeClearSizeFunctions, false, types);
+    change = SelectedOperationInPlace (&ChangeClearSizeFunctions, types);
   if (change)
     {
       Draw ();
@@ -1742,7 +1751,7 @@ ChangeSelected2ndSize (int types, Coord Difference, bool fixIt)
   /* setup identifiers */
   Absolute = (fixIt) ? Difference : 0;
   Delta = Difference;
-  change = SelectedOperation (&Change2ndSizeFunctions, false, types);
+  change = SelectedOperationInPlace (&Change2ndSizeFunctions, types);
   if (change)
     {
       Draw ();
@@ -1760,7 +1769,7 @@ ChangeSelectedJoin (int types)
 {
   bool change = false;
 
-  change = SelectedOperation (&ChangeJoinFunctions, false, types);
+  change = SelectedOperationInPlace (&ChangeJoinFunctions, types);
   if (change)
     {
       Draw ();
@@ -1778,7 +1787,7 @@ SetSelectedJoin (int types)
 {
   bool change = false;
 
-  change = SelectedOperation (&SetJoinFunctions, false, types);
+  change = SelectedOperationInPlace (&SetJoinFunctions, types);
   if (change)
     {
       Draw ();
@@ -1796,7 +1805,7 @@ ClrSelectedJoin (int types)
 {
   bool change = false;
 
-  change = SelectedOperation (&ClrJoinFunctions, false, types);
+  change = SelectedOperationInPlace (&ClrJoinFunctions, types);
   if (change)
     {
       Draw ();
@@ -1814,7 +1823,7 @@ ChangeSelectedSquare (int types)
 {
   bool change = false;
 
-  change = SelectedOperation (&ChangeSquareFunctions, false, types);
+  change = SelectedOperationInPlace (&ChangeSquareFunctions, types);
   if (change)
     {
       Draw ();
@@ -1832,7 +1841,7 @@ SetSelectedSquare (int types)
 {
   bool change = false;
 
-  change = SelectedOperation (&SetSquareFunctions, false, types);
+  change = SelectedOperationInPlace (&SetSquareFunctions, types);
   if (change)
     {
       Draw ();
@@ -1850,7 +1859,7 @@ ClrSelectedSquare (int types)
 {
   bool change = false;
 
-  change = SelectedOperation (&ClrSquareFunctions, false, types);
+  change = SelectedOperationInPlace (&ClrSquareFunctions, types);
   if (change)
     {
       Draw ();
@@ -1868,7 +1877,7 @@ ChangeSelectedOctagon (int types)
 {
   bool change = false;
 
-  change = SelectedOperation (&ChangeOctagonFunctions, false, types);
+  change = SelectedOperationInPlace (&ChangeOctagonFunctions, types);
   if (change)
     {
       Draw ();
@@ -1886,7 +1895,7 @@ SetSelectedOctagon (int types)
 {
   bool change = false;
 
-  change = SelectedOperation (&SetOctagonFunctions, false, types);
+  change = SelectedOperationInPlace (&SetOctagonFunctions, types);
   if (change)
     {
       Draw ();
@@ -1904,7 +1913,7 @@ ClrSelectedOctagon (int types)
 {
   bool change = false;
 
-  change = SelectedOperation (&ClrOctagonFunctions, false, types);
+  change = SelectedOperationInPlace (&ClrOctagonFunctions, types);
   if (change)
     {
       Draw ();
@@ -2310,6 +2319,8 @@ QueryInputAndChangeObjectName (int Type, void *Ptr1, void *Ptr2, void *Ptr3)
 	  AddObjectToChangeNameUndoList (Type, Ptr1, Ptr2, Ptr3, old);
 	  IncrementUndoSerialNumber ();
 	}
+      else
+	free (name);
       Draw ();
       return (Ptr3);
     }
@@ -686,6 +686,7 @@ CreateNewElement (DataType *Data, ElementType *Element,
     NameOnPCB = UniqueElementName (Data, NameOnPCB);
   AddTextToElement (&NAMEONPCB_TEXT (Element), PCBFont, TextX, TextY,
 		    Direction, NameOnPCB, TextScale, TextFlags);
+  ElementNameIndexUpdate (Data, Element);
   AddTextToElement (&VALUE_TEXT (Element), PCBFont, TextX, TextY,
 		    Direction, Value, TextScale, TextFlags);
   DESCRIPTION_TEXT (Element).Element = Element;
@@ -786,8 +787,8 @@ CreateNewPin (ElementType *Element,
   pin->Thickness = Thickness;
   pin->Clearance = Clearance;
   pin->Mask = Mask;
-  pin->Name = STRDUP (Name);
-  pin->Number = STRDUP (Number);
+  pin->Name = StringIntern (Name);
+  pin->Number = StringIntern (Number);
   pin->Flags = Flags;
   CLEAR_FLAG (WARNFLAG, pin);
   SET_FLAG (PINFLAG, pin);
@@ -866,8 +867,8 @@ CreateNewPad (ElementType *Element,
   pad->Thickness = Thickness;
   pad->Clearance = Clearance;
   pad->Mask = Mask;
-  pad->Name = STRDUP (Name);
-  pad->Number = STRDUP (Number);
+  pad->Name = StringIntern (Name);
+  pad->Number = StringIntern (Number);
   pad->Flags = Flags;
   CLEAR_FLAG (WARNFLAG, pad);
   pad->ID = ID++;
@@ -884,8 +885,9 @@ AddTextToElement (TextType *Text, FontType *PCBFont,
 		  Coord X, Coord Y,
 		  unsigned Direction, char *TextString, int Scale, FlagType Flags)
 {
-  free (Text->TextString);
-  Text->TextString = (TextString && *TextString) ? strdup (TextString) : NULL;
+  StringRelease (Text->TextString);
+  Text->TextString = (TextString && *TextString) ?
+    StringIntern (TextString) : NULL;
   Text->X = X;
   Text->Y = Y;
   Text->Direction = Direction;
@@ -1000,8 +1002,8 @@ CreateNewAttribute (AttributeListType *list, char *name, char *value)
       list->Max += 10;
       list->List = (AttributeType *)realloc (list->List, list->Max * sizeof (AttributeType));
     }
-  list->List[list->Number].name = STRDUP (name);
-  list->List[list->Number].value = STRDUP (value);
+  list->List[list->Number].name = StringIntern (name);
+  list->List[list->Number].value = StringIntern (value);
   list->Number++;
   return &list->List[list->Number - 1];
 }
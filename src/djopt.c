@@ -80,7 +80,9 @@ struct line_s;
 typedef struct corner_s
 {
   int layer;
-  struct corner_s *next;
+  struct corner_s *next, *prev;
+  struct corner_s *hnext;	/* corner_hash chain, or dead_corners list */
+  unsigned long seq;
   int x, y;
   int net;
   PinType *via;
@@ -111,6 +113,17 @@ typedef struct rect_s
 static corner_s *corners, *next_corner = 0;
 static line_s *lines;
 
+/* Live corners are also hashed by location, so that find_corner
+   doesn't have to walk the whole corners list.  The layer test is
+   still done per candidate, since corners on different layers of the
+   same group match each other.  Corners removed during a pass are
+   parked on dead_corners until the pass returns, because the passes
+   keep walking c->next from corners they have just removed.  */
+static corner_s **corner_hash = 0;
+static unsigned int corner_hash_size = 0, corner_hash_count = 0;
+static corner_s *dead_corners = 0;
+static unsigned long corner_seq = 0;
+
 static int layer_groupings[MAX_LAYER];
 static char layer_type[MAX_LAYER];
 #define LT_COMPONENT 1
@@ -465,40 +478,96 @@ other_corner (line_s * l, corner_s * c)
   return NULL;
 }
 
+static unsigned int
+corner_hash_index (int x, int y)
+{
+  unsigned int h = (unsigned int) x * 0x9e3779b1U;
+  h ^= (unsigned int) y * 0x85ebca77U;
+  h ^= h >> 15;
+  return h & (corner_hash_size - 1);
+}
+
+static void
+corner_hash_add (corner_s * c)
+{
+  unsigned int i;
+
+  if (corner_hash_count >= corner_hash_size)
+    {
+      corner_s **old = corner_hash, *cc, *nc;
+      unsigned int old_size = corner_hash_size;
+
+      corner_hash_size = old_size ? old_size * 2 : 1024;
+      corner_hash = (corner_s **) calloc (corner_hash_size, sizeof (corner_s *));
+      for (i = 0; i < old_size; i++)
+	for (cc = old[i]; cc; cc = nc)
+	  {
+	    unsigned int j = corner_hash_index (cc->x, cc->y);
+	    nc = cc->hnext;
+	    cc->hnext = corner_hash[j];
+	    corner_hash[j] = cc;
+	  }
+      free (old);
+    }
+
+  i = corner_hash_index (c->x, c->y);
+  c->hnext = corner_hash[i];
+  corner_hash[i] = c;
+  corner_hash_count++;
+}
+
+static void
+corner_hash_remove (corner_s * c)
+{
+  corner_s **cp;
+
+  for (cp = &corner_hash[corner_hash_index (c->x, c->y)]; *cp; cp = &(*cp)->hnext)
+    if (*cp == c)
+      {
+	*cp = c->hnext;
+	c->hnext = 0;
+	corner_hash_count--;
+	return;
+      }
+  dj_abort ("corner_hash_remove: corner not in hash\n");
+}
+
 static corner_s *
 find_corner_if (int x, int y, int l)
 {
-  corner_s *c;
-  for (c = corners; c; c = c->next)
+  corner_s *c, *best = 0;
+
+  if (corner_hash_count == 0)
+    return 0;
+  /* The corners list is newest-first, so prefer the newest match to
+     give the same answer a walk of that list would.  */
+  for (c = corner_hash[corner_hash_index (x, y)]; c; c = c->hnext)
     {
-      if (DELETED (c))
-	continue;
       if (c->x != x || c->y != y)
 	continue;
       if (!(c->layer == -1 || intersecting_layers (c->layer, l)))
 	continue;
-      return c;
+      if (!best || c->seq > best->seq)
+	best = c;
     }
-  return 0;
+  return best;
 }
 
 static corner_s *
 find_corner (int x, int y, int l)
 {
   corner_s *c;
-  for (c = corners; c; c = c->next)
-    {
-      if (DELETED (c))
-	continue;
-      if (c->x != x || c->y != y)
-	continue;
-      if (!(c->layer == -1 || intersecting_layers (c->layer, l)))
-	continue;
-      return c;
-    }
+
+  c = find_corner_if (x, y, l);
+  if (c)
+    return c;
   c = (corner_s *) malloc (sizeof (corner_s));
   c->next = corners;
+  c->prev = 0;
+  if (corners)
+    corners->prev = c;
   corners = c;
+  c->seq = ++corner_seq;
   c->x = x;
   c->y = y;
   c->net = 0;
@@ -508,9 +577,63 @@ find_corner (int x, int y, int l)
   c->layer = l;
   c->n_lines = 0;
   c->lines = (line_s **) malloc (INC * sizeof (line_s *));
+  corner_hash_add (c);
   return c;
 }
 
+/* Free the corners and lines deleted by the pass that just returned.
+   Nothing outside a pass holds on to them.  */
+static void
+reclaim_dead ()
+{
+  corner_s *c;
+  line_s *l, **lp;
+
+  while (dead_corners)
+    {
+      c = dead_corners;
+      dead_corners = c->hnext;
+      free (c);
+    }
+  for (lp = &lines; *lp;)
+    {
+      l = *lp;
+      if (DELETED (l))
+	{
+	  *lp = l->next;
+	  free (l);
+	}
+      else
+	lp = &l->next;
+    }
+}
+
+static void
+free_corners_and_lines ()
+{
+  corner_s *c;
+  line_s *l;
+
+  reclaim_dead ();
+  while (corners)
+    {
+      c = corners;
+      corners = c->next;
+      free (c->lines);
+      free (c);
+    }
+  while (lines)
+    {
+      l = lines;
+      lines = l->next;
+      free (l);
+    }
+  free (corner_hash);
+  corner_hash = 0;
+  corner_hash_size = corner_hash_count = 0;
+  next_corner = 0;
+}
+
 static void
 add_line_to_corner (line_s * l, corner_s * c)
 {
@@ -799,22 +922,23 @@ remove_via_at (corner_s * c)
 static void
 remove_corner (corner_s * c2)
 {
-  corner_s *c;
   dprintf ("remove corner %s\n", corner_name (c2));
-  if (corners == c2)
+  corner_hash_remove (c2);
+  /* c2->next is left alone so that a pass walking the list can still
+     step past c2.  */
+  if (c2->prev)
+    c2->prev->next = c2->next;
+  else
     corners = c2->next;
-  for (c = corners; c; c = c->next)
-    {
-      if (DELETED (c))
-	continue;
-      if (c->next == c2)
-	c->next = c2->next;
-    }
+  if (c2->next)
+    c2->next->prev = c2->prev;
   if (next_corner == c2)
     next_corner = c2->next;
   free (c2->lines);
   c2->lines = 0;
   DELETE (c2);
+  c2->hnext = dead_corners;
+  dead_corners = c2;
 }
 
 static void
@@ -858,8 +982,10 @@ move_corner (corner_s * c, int x, int y)
     dj_abort ("move_corner: has pin or pad\n");
   dprintf ("move_corner %p from %#mD to %#mD\n", (void *) c, c->x, c->y, x, y);
   pad = find_corner_if (x, y, c->layer);
+  corner_hash_remove (c);
   c->x = x;
   c->y = y;
+  corner_hash_add (c);
   via = c->via;
   if (via)
     {
@@ -2175,10 +2301,15 @@ automagic ()
     {
       oldmore = more;
       more += debumpify ();
+      reclaim_dead ();
       more += unjaggy ();
+      reclaim_dead ();
       more += orthopull ();
+      reclaim_dead ();
       more += vianudge ();
+      reclaim_dead ();
       more += viatrim ();
+      reclaim_dead ();
     }
   return more - 1;
 }
@@ -2833,21 +2964,21 @@ grok_layer_groups ()
       f = 0;
       for (j = 0; j < l->Number[i]; j++)
 	{
-	  if (l->Entries[i][j] == solder_silk_layer)
+	  if (GROUP_ENTRY (l, i, j) == solder_silk_layer)
 	    f |= LT_SOLDER;
-	  if (l->Entries[i][j] == component_silk_layer)
+	  if (GROUP_ENTRY (l, i, j) == component_silk_layer)
 	    f |= LT_COMPONENT;
 	}
       for (j = 0; j < l->Number[i]; j++)
 	{
-	  if (l->Entries[i][j] < max_copper_layer)
+	  if (GROUP_ENTRY (l, i, j) < max_copper_layer)
 	    {
-	      layer_type[l->Entries[i][j]] |= f;
-	      layer_groupings[l->Entries[i][j]] = i;
+	      layer_type[GROUP_ENTRY (l, i, j)] |= f;
+	      layer_groupings[GROUP_ENTRY (l, i, j)] = i;
 	      if (solder_layer == -1 && f == LT_SOLDER)
-		solder_layer = l->Entries[i][j];
+		solder_layer = GROUP_ENTRY (l, i, j);
 	      if (component_layer == -1 && f == LT_COMPONENT)
-		component_layer = l->Entries[i][j];
+		component_layer = GROUP_ENTRY (l, i, j);
 	    }
 	}
     }
@@ -2973,6 +3104,7 @@ ActionDJopt (int argc, char **argv, Coord x, Coord y)
     {
       if (canonicalize_lines ())
 	IncrementUndoSerialNumber ();
+      free_corners_and_lines ();
       return 0;
     }
 
@@ -3039,12 +3171,14 @@ ActionDJopt (int argc, char **argv, Coord x, Coord y)
   else
     {
       printf ("unknown command: %s\n", arg);
+      free_corners_and_lines ();
       return 1;
     }
 
   padcleaner ();
 
   check (0, 0);
+  free_corners_and_lines ();
   if (saved)
     IncrementUndoSerialNumber ();
   return 0;
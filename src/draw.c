@@ -146,6 +146,10 @@ AddPart (void *b)
 void
 Draw (void)
 {
+  /* EndBulkEdit() draws the accumulated block */
+  if (InBulkEdit ())
+    return;
+
   if (Block.X1 <= Block.X2 && Block.Y1 <= Block.Y2)
     gui->invalidate_lr (Block.X1, Block.X2, Block.Y1, Block.Y2);
 
@@ -1110,7 +1114,7 @@ DrawLayerGroup (int group, const BoxType *drawn_area)
   int layernum;
   LayerType *Layer;
   int n_entries = PCB->LayerGroups.Number[group];
-  Cardinal *layers = PCB->LayerGroups.Entries[group];
+  Cardinal *layers = &GROUP_ENTRY (&PCB->LayerGroups, group, 0);
 
   for (i = n_entries - 1; i >= 0; i--)
     {
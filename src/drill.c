@@ -32,8 +32,10 @@
 #endif
 
 #include "data.h"
+#include "drill.h"
 #include "error.h"
 #include "mymem.h"
+#include "undo.h"
 
 #ifdef HAVE_LIBDMALLOC
 #include <dmalloc.h>
@@ -42,170 +44,174 @@
 /*
  * some local prototypes
  */
-static void FillDrill (DrillType *, ElementType *, PinType *);
-static void InitializeDrill (DrillType *, PinType *, ElementType *);
+static DrillType *FindDrill (DrillInfoType *, Coord, bool);
+static DrillInfoType *BuildDrillInfo (DataType *);
+static DrillInfoType *CopyDrillInfo (DrillInfoType *);
 
+/* the last drill table built for the layout, see GetDrillInfo() */
+static DrillInfoType *CachedDrills = NULL;
+static PCBType *CachedDrillsPCB = NULL;
+static unsigned long CachedDrillsGeneration;
 
-static void
-FillDrill (DrillType *Drill, ElementType *Element, PinType *Pin)
-{
-  Cardinal n;
-  ElementType **ptr;
-  PinType **pin;
-
-  pin = GetDrillPinMemory (Drill);
-  *pin = Pin;
-  if (Element)
-    {
-      Drill->PinCount++;
-      for (n = Drill->ElementN - 1; n != -1; n--)
-	if (Drill->Element[n] == Element)
-	  break;
-      if (n == -1)
-	{
-	  ptr = GetDrillElementMemory (Drill);
-	  *ptr = Element;
-	}
-    }
-  else
-    Drill->ViaCount++;
-  if (TEST_FLAG (HOLEFLAG, Pin))
-    Drill->UnplatedCount++;
-}
-
-static void
-InitializeDrill (DrillType *drill, PinType *pin, ElementType *element)
+/* ---------------------------------------------------------------------------
+ * finds the drill of the given size in the sorted table, optionally
+ * inserting an empty one where it belongs
+ */
+static DrillType *
+FindDrill (DrillInfoType *AllDrills, Coord size, bool create)
 {
-  void *ptr;
+  Cardinal lo = 0, hi = AllDrills->DrillN, mid;
+  DrillType *drill;
 
-  drill->DrillSize = pin->DrillingHole;
-  drill->ElementN = 0;
-  drill->ViaCount = 0;
-  drill->PinCount = 0;
-  drill->UnplatedCount = 0;
-  drill->ElementMax = 0;
-  drill->Element = NULL;
-  drill->PinN = 0;
-  drill->Pin = NULL;
-  drill->PinMax = 0;
-  ptr = (void *) GetDrillPinMemory (drill);
-  *((PinType **) ptr) = pin;
-  if (element)
+  while (lo < hi)
     {
-      ptr = (void *) GetDrillElementMemory (drill);
-      *((ElementType **) ptr) = element;
-      drill->PinCount = 1;
+      mid = (lo + hi) / 2;
+      if (AllDrills->Drill[mid].DrillSize == size)
+	return (&AllDrills->Drill[mid]);
+      if (AllDrills->Drill[mid].DrillSize < size)
+	lo = mid + 1;
+      else
+	hi = mid;
     }
-  else
-    drill->ViaCount = 1;
-  if (TEST_FLAG (HOLEFLAG, pin))
-    drill->UnplatedCount = 1;
-}
+  if (!create)
+    return (NULL);
 
-static int
-DrillQSort (const void *va, const void *vb)
-{
-  DrillType *a = (DrillType *) va;
-  DrillType *b = (DrillType *) vb;
-  return a->DrillSize - b->DrillSize;
+  GetDrillInfoDrillMemory (AllDrills);
+  drill = &AllDrills->Drill[lo];
+  memmove (drill + 1, drill,
+	   (AllDrills->DrillN - 1 - lo) * sizeof (DrillType));
+  memset (drill, 0, sizeof (DrillType));
+  drill->DrillSize = size;
+  return (drill);
 }
 
-DrillInfoType *
-GetDrillInfo (DataType *top)
+/* ---------------------------------------------------------------------------
+ * builds the drill table in two passes: the first one finds the drill
+ * sizes and how many holes each has, the second one fills in the lists,
+ * which can then be allocated at their final size
+ */
+static DrillInfoType *
+BuildDrillInfo (DataType *top)
 {
   DrillInfoType *AllDrills;
-  DrillType *Drill = NULL;
-  DrillType savedrill, swapdrill;
-  bool DrillFound = false;
-  bool NewDrill;
+  DrillType *drill = NULL;
 
   AllDrills = (DrillInfoType *)calloc (1, sizeof (DrillInfoType));
+
+  /* pass 1: PinMax counts the holes, ElementMax those in elements */
   ALLPIN_LOOP (top);
   {
-    if (!DrillFound)
-      {
-	DrillFound = true;
-	Drill = GetDrillInfoDrillMemory (AllDrills);
-	InitializeDrill (Drill, pin, element);
-      }
-    else
-      {
-	if (Drill->DrillSize == pin->DrillingHole)
-	  FillDrill (Drill, element, pin);
-	else
-	  {
-	    NewDrill = false;
-	    DRILL_LOOP (AllDrills);
-	    {
-	      if (drill->DrillSize == pin->DrillingHole)
-		{
-		  Drill = drill;
-		  FillDrill (Drill, element, pin);
-		  break;
-		}
-	      else if (drill->DrillSize > pin->DrillingHole)
-		{
-		  if (!NewDrill)
-		    {
-		      NewDrill = true;
-		      InitializeDrill (&swapdrill, pin, element);
-		      Drill = GetDrillInfoDrillMemory (AllDrills);
-		      Drill->DrillSize = pin->DrillingHole + 1;
-		      Drill = drill;
-		    }
-		  savedrill = *drill;
-		  *drill = swapdrill;
-		  swapdrill = savedrill;
-		}
-	    }
-	    END_LOOP;
-	    if (AllDrills->Drill[AllDrills->DrillN - 1].DrillSize <
-		pin->DrillingHole)
-	      {
-		Drill = GetDrillInfoDrillMemory (AllDrills);
-		InitializeDrill (Drill, pin, element);
-	      }
-	  }
-      }
+    if (drill == NULL || drill->DrillSize != pin->DrillingHole)
+      drill = FindDrill (AllDrills, pin->DrillingHole, true);
+    drill->PinMax++;
+    drill->ElementMax++;
   }
   ENDALL_LOOP;
+  drill = NULL;
   VIA_LOOP (top);
   {
-    if (!DrillFound)
-      {
-	DrillFound = true;
-	Drill = GetDrillInfoDrillMemory (AllDrills);
-	Drill->DrillSize = via->DrillingHole;
-	FillDrill (Drill, NULL, via);
-      }
-    else
+    if (drill == NULL || drill->DrillSize != via->DrillingHole)
+      drill = FindDrill (AllDrills, via->DrillingHole, true);
+    drill->PinMax++;
+  }
+  END_LOOP;
+
+  DRILL_LOOP (AllDrills);
+  {
+    drill->Pin = (PinType **)malloc (drill->PinMax * sizeof (PinType *));
+    if (drill->ElementMax)
+      drill->Element = (ElementType **)malloc (drill->ElementMax *
+					       sizeof (ElementType *));
+  }
+  END_LOOP;
+
+  /* pass 2: the pins of an element come one after the other, so it is
+   * already listed for a drill if it is the last one listed there
+   */
+  drill = NULL;
+  ALLPIN_LOOP (top);
+  {
+    if (drill == NULL || drill->DrillSize != pin->DrillingHole)
+      drill = FindDrill (AllDrills, pin->DrillingHole, false);
+    drill->Pin[drill->PinN++] = pin;
+    drill->PinCount++;
+    if (drill->ElementN == 0
+	|| drill->Element[drill->ElementN - 1] != element)
+      drill->Element[drill->ElementN++] = element;
+    if (TEST_FLAG (HOLEFLAG, pin))
+      drill->UnplatedCount++;
+  }
+  ENDALL_LOOP;
+  drill = NULL;
+  VIA_LOOP (top);
+  {
+    if (drill == NULL || drill->DrillSize != via->DrillingHole)
+      drill = FindDrill (AllDrills, via->DrillingHole, false);
+    drill->Pin[drill->PinN++] = via;
+    drill->ViaCount++;
+    if (TEST_FLAG (HOLEFLAG, via))
+      drill->UnplatedCount++;
+  }
+  END_LOOP;
+  return (AllDrills);
+}
+
+/* ---------------------------------------------------------------------------
+ * returns a copy of a drill table that can be rounded and freed
+ */
+static DrillInfoType *
+CopyDrillInfo (DrillInfoType *Drills)
+{
+  DrillInfoType *copy;
+
+  copy = (DrillInfoType *)calloc (1, sizeof (DrillInfoType));
+  copy->DrillN = copy->DrillMax = Drills->DrillN;
+  if (Drills->DrillN == 0)
+    return (copy);
+  copy->Drill = (DrillType *)malloc (Drills->DrillN * sizeof (DrillType));
+  memcpy (copy->Drill, Drills->Drill, Drills->DrillN * sizeof (DrillType));
+  DRILL_LOOP (copy);
+  {
+    drill->PinMax = drill->PinN;
+    drill->Pin = (PinType **)malloc (drill->PinN * sizeof (PinType *));
+    memcpy (drill->Pin, Drills->Drill[n].Pin,
+	    drill->PinN * sizeof (PinType *));
+    drill->ElementMax = drill->ElementN;
+    drill->Element = NULL;
+    if (drill->ElementN)
       {
-	if (Drill->DrillSize != via->DrillingHole)
-	  {
-	    DRILL_LOOP (AllDrills);
-	    {
-	      if (drill->DrillSize == via->DrillingHole)
-		{
-		  Drill = drill;
-		  FillDrill (Drill, NULL, via);
-		  break;
-		}
-	    }
-	    END_LOOP;
-	    if (Drill->DrillSize != via->DrillingHole)
-	      {
-		Drill = GetDrillInfoDrillMemory (AllDrills);
-		Drill->DrillSize = via->DrillingHole;
-		FillDrill (Drill, NULL, via);
-	      }
-	  }
-	else
-	  FillDrill (Drill, NULL, via);
+	drill->Element = (ElementType **)malloc (drill->ElementN *
+						 sizeof (ElementType *));
+	memcpy (drill->Element, Drills->Drill[n].Element,
+		drill->ElementN * sizeof (ElementType *));
       }
   }
   END_LOOP;
-  qsort (AllDrills->Drill, AllDrills->DrillN, sizeof (DrillType), DrillQSort);
-  return (AllDrills);
+  return (copy);
+}
+
+/* ---------------------------------------------------------------------------
+ * returns the drill sizes used in top, in increasing order, with the pins
+ * and vias of each size and the elements they belong to.
+ * The table of the layout is only built again once the layout has
+ * changed; everyone gets their own copy to round and free.
+ */
+DrillInfoType *
+GetDrillInfo (DataType *top)
+{
+  if (top != PCB->Data || Undoing ())
+    return (BuildDrillInfo (top));
+
+  if (CachedDrills == NULL || CachedDrillsPCB != PCB
+      || CachedDrillsGeneration != UndoGeneration ())
+    {
+      if (CachedDrills)
+	FreeDrillInfo (CachedDrills);
+      CachedDrills = BuildDrillInfo (top);
+      CachedDrillsPCB = PCB;
+      CachedDrillsGeneration = UndoGeneration ();
+    }
+  return (CopyDrillInfo (CachedDrills));
 }
 
 #define ROUND(x,n) ((int)(((x)+(n)/2)/(n))*(n))
@@ -83,6 +83,7 @@
 #include "error.h"
 #include "file.h"
 #include "hid.h"
+#include "libindex.h"
 #include "misc.h"
 #include "move.h"
 #include "mymem.h"
@@ -243,6 +244,8 @@ sort_netlist ()
   netlist_sort_offset = 2;
   sort_library (&(PCB->NetlistLib));
   netlist_sort_offset = 0;
+  /* the nets moved */
+  NetlistIndexForget ();
 }
 
 /* ---------------------------------------------------------------------------
@@ -1162,6 +1165,264 @@ pcb_basename (char *p)
   return p;
 }
 
+/* ---------------------------------------------------------------------------
+ * Newlib directory index.  Walking a footprint tree costs a readdir and
+ * a stat per file on every start-up, which adds up on large or network
+ * mounted libraries.  For every directory visited we remember its
+ * device, inode and mtime together with the footprint files and
+ * subdirectories found in it.  Adding, removing or renaming an entry
+ * bumps the directory mtime, so while the stat of a directory still
+ * matches its record the cached listing is used as-is.  The index is
+ * kept in ~/.pcb/newlib-index and only directories visited during the
+ * current scan are written back.
+ */
+
+#define NEWLIB_INDEX_MAGIC "PCB-newlib-index 1"
+
+typedef struct
+{
+  char *path;
+  dev_t dev;
+  ino_t ino;
+  time_t mtime;
+  GPtrArray *files;		/* footprint file names */
+  GPtrArray *subdirs;		/* candidate library subdirectories */
+  bool used;			/* visited during this scan */
+  bool stable;			/* safe to write out */
+} NewlibDirType;
+
+static GHashTable *newlib_index = NULL;
+static bool newlib_index_dirty;
+
+static void
+newlib_dir_free (gpointer data)
+{
+  NewlibDirType *dir = (NewlibDirType *) data;
+
+  g_ptr_array_foreach (dir->files, (GFunc) free, NULL);
+  g_ptr_array_foreach (dir->subdirs, (GFunc) free, NULL);
+  g_ptr_array_free (dir->files, TRUE);
+  g_ptr_array_free (dir->subdirs, TRUE);
+  free (dir->path);
+  free (dir);
+}
+
+static NewlibDirType *
+newlib_dir_new (const char *path)
+{
+  NewlibDirType *dir = (NewlibDirType *)calloc (1, sizeof (NewlibDirType));
+
+  dir->path = strdup (path);
+  dir->files = g_ptr_array_new ();
+  dir->subdirs = g_ptr_array_new ();
+  return dir;
+}
+
+static char *
+newlib_index_filename (void)
+{
+  if (homedir == NULL)
+    return NULL;
+  return Concat (homedir, PCB_DIR_SEPARATOR_S, ".pcb",
+		 PCB_DIR_SEPARATOR_S, "newlib-index", NULL);
+}
+
+/* Reads the on-disk index.  A missing or malformed file simply leaves
+ * the index empty; everything is then rescanned.
+ */
+static void
+newlib_index_load (void)
+{
+  char line[MAXPATHLEN + 64];
+  char *fname;
+  FILE *f;
+  NewlibDirType *dir = NULL;
+  unsigned long dev, ino;
+  long mtime;
+  int n;
+
+  newlib_index = g_hash_table_new_full (g_str_hash, g_str_equal,
+					NULL, newlib_dir_free);
+  newlib_index_dirty = false;
+
+  if ((fname = newlib_index_filename ()) == NULL)
+    return;
+  f = fopen (fname, "r");
+  free (fname);
+  if (f == NULL)
+    return;
+
+  if (fgets (line, sizeof (line), f) == NULL
+      || strncmp (line, NEWLIB_INDEX_MAGIC, strlen (NEWLIB_INDEX_MAGIC)) != 0)
+    {
+      fclose (f);
+      return;
+    }
+
+  while (fgets (line, sizeof (line), f) != NULL)
+    {
+      size_t len = strlen (line);
+
+      if (len == 0 || line[len - 1] != '\n')
+	break;
+      line[len - 1] = '\0';
+
+      if (line[0] == 'D'
+	  && sscanf (line, "D %lu %lu %ld %n", &dev, &ino, &mtime, &n) == 3
+	  && line[n] == '/')
+	{
+	  dir = newlib_dir_new (line + n);
+	  dir->dev = (dev_t) dev;
+	  dir->ino = (ino_t) ino;
+	  dir->mtime = (time_t) mtime;
+	  dir->stable = true;
+	  g_hash_table_replace (newlib_index, dir->path, dir);
+	}
+      else if (dir != NULL && line[0] == 'F' && line[1] == ' ')
+	g_ptr_array_add (dir->files, strdup (line + 2));
+      else if (dir != NULL && line[0] == 'S' && line[1] == ' ')
+	g_ptr_array_add (dir->subdirs, strdup (line + 2));
+      else
+	break;
+    }
+  fclose (f);
+}
+
+static void
+newlib_index_write_dir (gpointer key, gpointer value, gpointer data)
+{
+  NewlibDirType *dir = (NewlibDirType *) value;
+  FILE *f = (FILE *) data;
+  guint i;
+
+  if (!dir->used || !dir->stable)
+    return;
+  fprintf (f, "D %lu %lu %ld %s\n", (unsigned long) dir->dev,
+	   (unsigned long) dir->ino, (long) dir->mtime, dir->path);
+  for (i = 0; i < dir->files->len; i++)
+    fprintf (f, "F %s\n", (char *) g_ptr_array_index (dir->files, i));
+  for (i = 0; i < dir->subdirs->len; i++)
+    fprintf (f, "S %s\n", (char *) g_ptr_array_index (dir->subdirs, i));
+}
+
+/* Writes the index back if anything changed, then drops it.  The new
+ * file is written under a temporary name and renamed into place so a
+ * concurrent pcb never reads a half-written index.
+ */
+static void
+newlib_index_save (void)
+{
+  char *fname, *tmpname, *dirname;
+  struct stat st;
+  FILE *f;
+
+  if (newlib_index == NULL)
+    return;
+
+  if (newlib_index_dirty && (fname = newlib_index_filename ()) != NULL)
+    {
+      dirname = Concat (homedir, PCB_DIR_SEPARATOR_S, ".pcb", NULL);
+      if (stat (dirname, &st))
+	MKDIR (dirname, 0777);
+      free (dirname);
+
+      tmpname = Concat (fname, ".tmp", NULL);
+      if ((f = fopen (tmpname, "w")) != NULL)
+	{
+	  fprintf (f, "%s\n", NEWLIB_INDEX_MAGIC);
+	  g_hash_table_foreach (newlib_index, newlib_index_write_dir, f);
+	  if (fclose (f) == 0)
+	    rename (tmpname, fname);
+	  else
+	    unlink (tmpname);
+	}
+      free (tmpname);
+      free (fname);
+    }
+
+  g_hash_table_destroy (newlib_index);
+  newlib_index = NULL;
+}
+
+/* Ignore non-footprint files found in a library directory.  We're
+ * skipping .png and .html because those may exist in a library tree to
+ * provide an html browsable index of the library.
+ */
+static bool
+newlib_is_footprint (const char *name)
+{
+  size_t l = strlen (name);
+
+  return name[0] != '.'
+    && NSTRCMP (name, "CVS") != 0
+    && NSTRCMP (name, "Makefile") != 0
+    && NSTRCMP (name, "Makefile.am") != 0
+    && NSTRCMP (name, "Makefile.in") != 0
+    && (l < 4 || NSTRCMP (name + (l - 4), ".png") != 0)
+    && (l < 5 || NSTRCMP (name + (l - 5), ".html") != 0)
+    && (l < 4 || NSTRCMP (name + (l - 4), ".pcb") != 0);
+}
+
+/* Returns the listing of the current working directory, whose absolute
+ * path is given, either from the index or by reading the directory.
+ * Returns NULL if the directory cannot be read.  Must be called between
+ * newlib_index_load and newlib_index_save.
+ */
+static NewlibDirType *
+newlib_scan_dir (const char *path)
+{
+  NewlibDirType *dir;
+  DIR *dirobj;
+  struct dirent *direntry;
+  struct stat st, buffer;
+
+  if (stat (".", &st))
+    return NULL;
+
+  dir = (NewlibDirType *)g_hash_table_lookup (newlib_index, path);
+  if (dir != NULL && dir->dev == st.st_dev && dir->ino == st.st_ino
+      && dir->mtime == st.st_mtime)
+    {
+      dir->used = true;
+      return dir;
+    }
+
+  if ((dirobj = opendir (path)) == NULL)
+    {
+      OpendirErrorMessage ((char *)path);
+      return NULL;
+    }
+
+  dir = newlib_dir_new (path);
+  dir->dev = st.st_dev;
+  dir->ino = st.st_ino;
+  dir->mtime = st.st_mtime;
+  dir->used = true;
+  /* A directory modified within the last second may change again
+   * without its mtime moving, so don't trust its listing next time.
+   */
+  dir->stable = st.st_mtime < time (NULL) - 1;
+
+  while ((direntry = readdir (dirobj)) != NULL)
+    {
+      if (strchr (direntry->d_name, '\n') != NULL)
+	dir->stable = false;
+      if (stat (direntry->d_name, &buffer))
+	continue;
+      if (S_ISREG (buffer.st_mode) && newlib_is_footprint (direntry->d_name))
+	g_ptr_array_add (dir->files, strdup (direntry->d_name));
+      else if (S_ISDIR (buffer.st_mode)
+	       && direntry->d_name[0] != '.'
+	       && NSTRCMP (direntry->d_name, "CVS") != 0)
+	g_ptr_array_add (dir->subdirs, strdup (direntry->d_name));
+    }
+  closedir (dirobj);
+
+  g_hash_table_replace (newlib_index, dir->path, dir);
+  newlib_index_dirty = true;
+  return dir;
+}
+
 /* This is a helper function for ParseLibrary Tree.   Given a char *path,
  * it finds all newlib footprints in that dir and sticks them into the
  * library menu structure named entry.
@@ -1171,12 +1432,10 @@ LoadNewlibFootprintsFromDir(char *libpath, char *toppath)
 {
   char olddir[MAXPATHLEN + 1];    /* The directory we start out in (cwd) */
   char subdir[MAXPATHLEN + 1];    /* The directory holding footprints to load */
-  DIR *subdirobj;                 /* Interable object holding all subdir entries */
-  struct dirent *subdirentry;     /* Individual subdir entry */
-  struct stat buffer;             /* Buffer used in stat */
+  NewlibDirType *dir;             /* Listing of subdir */
   LibraryMenuType *menu = NULL; /* Pointer to PCB's library menu structure */
   LibraryEntryType *entry;      /* Pointer to individual menu entry */
-  size_t l;
+  guint i;
   size_t len;
   int n_footprints = 0;           /* Running count of footprints found in this subdir */
 
@@ -1209,10 +1468,9 @@ LoadNewlibFootprintsFromDir(char *libpath, char *toppath)
       return 0;
     }
 
-  /* First try opening the directory specified by path */
-  if ( (subdirobj = opendir (subdir)) == NULL )
+  /* Get the footprint files in this directory, from the index if possible */
+  if ((dir = newlib_scan_dir (subdir)) == NULL)
     {
-      OpendirErrorMessage (subdir);
       if (chdir (olddir))
         ChdirErrorMessage (olddir);
       return 0;
@@ -1224,59 +1482,33 @@ LoadNewlibFootprintsFromDir(char *libpath, char *toppath)
   menu->Name = strdup (pcb_basename(subdir));
   menu->directory = strdup (pcb_basename(toppath));
 
-  /* Now loop over files in this directory looking for files.
-   * We ignore certain files which are not footprints.
-   */
-  while ((subdirentry = readdir (subdirobj)) != NULL)
-  {
-#ifdef DEBUG
-/*    printf("...  Examining file %s ... \n", subdirentry->d_name); */
-#endif
+  for (i = 0; i < dir->files->len; i++)
+    {
+      char *name = (char *) g_ptr_array_index (dir->files, i);
 
-    /* Ignore non-footprint files found in this directory
-     * We're skipping .png and .html because those
-     * may exist in a library tree to provide an html browsable
-     * index of the library.
-     */
-    l = strlen (subdirentry->d_name);
-    if (!stat (subdirentry->d_name, &buffer) && S_ISREG (buffer.st_mode)
-      && subdirentry->d_name[0] != '.'
-      && NSTRCMP (subdirentry->d_name, "CVS") != 0
-      && NSTRCMP (subdirentry->d_name, "Makefile") != 0
-      && NSTRCMP (subdirentry->d_name, "Makefile.am") != 0
-      && NSTRCMP (subdirentry->d_name, "Makefile.in") != 0
-      && (l < 4 || NSTRCMP(subdirentry->d_name + (l - 4), ".png") != 0) 
-      && (l < 5 || NSTRCMP(subdirentry->d_name + (l - 5), ".html") != 0)
-      && (l < 4 || NSTRCMP(subdirentry->d_name + (l - 4), ".pcb") != 0) )
-      {
-#ifdef DEBUG
-/*	printf("...  Found a footprint %s ... \n", subdirentry->d_name); */
-#endif
-	n_footprints++;
-	entry = GetLibraryEntryMemory (menu);
-
-	/* 
-	 * entry->AllocatedMemory points to abs path to the footprint.
-	 * entry->ListEntry points to fp name itself.
-	 */
-	len = strlen(subdir) + strlen("/") + strlen(subdirentry->d_name) + 1;
-	entry->AllocatedMemory = (char *)calloc (1, len);
-	strcat (entry->AllocatedMemory, subdir);
-	strcat (entry->AllocatedMemory, PCB_DIR_SEPARATOR_S);
-
-	/* store pointer to start of footprint name */
-	entry->ListEntry = entry->AllocatedMemory
-	    + strlen (entry->AllocatedMemory);
-
-	/* Now place footprint name into AllocatedMemory */
-	strcat (entry->AllocatedMemory, subdirentry->d_name);
-
-	/* mark as directory tree (newlib) library */
-	entry->Template = (char *) -1;
-      }
-  }
+      n_footprints++;
+      entry = GetLibraryEntryMemory (menu);
+
+      /* 
+       * entry->AllocatedMemory points to abs path to the footprint.
+       * entry->ListEntry points to fp name itself.
+       */
+      len = strlen(subdir) + strlen("/") + strlen(name) + 1;
+      entry->AllocatedMemory = (char *)calloc (1, len);
+      strcat (entry->AllocatedMemory, subdir);
+      strcat (entry->AllocatedMemory, PCB_DIR_SEPARATOR_S);
+
+      /* store pointer to start of footprint name */
+      entry->ListEntry = entry->AllocatedMemory
+          + strlen (entry->AllocatedMemory);
+
+      /* Now place footprint name into AllocatedMemory */
+      strcat (entry->AllocatedMemory, name);
+
+      /* mark as directory tree (newlib) library */
+      entry->Template = (char *) -1;
+    }
   /* Done.  Clean up, cd back into old dir, and return */
-  closedir (subdirobj);
   if (chdir (olddir))
     ChdirErrorMessage (olddir);
   return n_footprints;
@@ -1297,9 +1529,8 @@ ParseLibraryTree (void)
   char working[MAXPATHLEN + 1];    /* String holding abs path to working dir */
   char *libpaths;                  /* String holding list of library paths to search */
   char *p;                         /* Helper string used in iteration */
-  DIR *dirobj;                     /* Iterable directory object */
-  struct dirent *direntry = NULL;  /* Object holding individual directory entries */
-  struct stat buffer;              /* buffer used in stat */
+  NewlibDirType *dir;              /* Listing of the top level dir */
+  guint i;
   int n_footprints = 0;            /* Running count of footprints found */
 
   /* Initialize path, working by writing 0 into every byte. */
@@ -1315,6 +1546,8 @@ ParseLibraryTree (void)
       return 0;
     }
 
+  newlib_index_load ();
+
   /* Additional loop to allow for multiple 'newlib' style library directories 
    * called out in Settings.LibraryTree
    */
@@ -1330,6 +1563,7 @@ ParseLibraryTree (void)
       if (chdir (working))
         {
           ChdirErrorMessage (working);
+          newlib_index_save ();
           free (libpaths);
           return 0;
         }
@@ -1358,36 +1592,21 @@ ParseLibraryTree (void)
       /* Next read in any footprints in the top level dir */
       n_footprints += LoadNewlibFootprintsFromDir("(local)", toppath);
 
-      /* Then open this dir so we can loop over its contents. */
-      if ((dirobj = opendir (toppath)) == NULL)
-	{
-	  OpendirErrorMessage (toppath);
-	  continue;
-	}
-
-      /* Now loop over files in this directory looking for subdirs.
-       * For each direntry which is a valid subdirectory,
-       * try to load newlib footprints inside it.
+      /* Then get the subdirectories of this dir, which the call above
+       * has just indexed.  For each valid subdirectory, try to load
+       * newlib footprints inside it.
        */
-      while ((direntry = readdir (dirobj)) != NULL)
+      if ((dir = newlib_scan_dir (toppath)) == NULL)
+	continue;
+
+      for (i = 0; i < dir->subdirs->len; i++)
 	{
+	  char *name = (char *) g_ptr_array_index (dir->subdirs, i);
 #ifdef DEBUG
-	  printf("In ParseLibraryTree loop examining 2nd level direntry %s ... \n", direntry->d_name);
+	  printf("In ParseLibraryTree loop examining 2nd level direntry %s ... \n", name);
 #endif
-	  /* Find subdirectories.  Ignore entries beginning with "." and CVS
-	   * directories.
-	   */
-	  if (!stat (direntry->d_name, &buffer)
-	      && S_ISDIR (buffer.st_mode) 
-	      && direntry->d_name[0] != '.'
-	      && NSTRCMP (direntry->d_name, "CVS") != 0)
-	    {
-	      /* Found a valid subdirectory.  Try to load footprints from it.
-	       */
-	      n_footprints += LoadNewlibFootprintsFromDir(direntry->d_name, toppath);
-	    }
+	  n_footprints += LoadNewlibFootprintsFromDir(name, toppath);
 	}
-      closedir (dirobj);
     }
 
   /* restore the original working directory */
@@ -1398,6 +1617,7 @@ ParseLibraryTree (void)
   printf("Leaving ParseLibraryTree, found %d footprints.\n", n_footprints);
 #endif
 
+  newlib_index_save ();
   free (libpaths);
   return n_footprints;
 }
@@ -1508,6 +1728,11 @@ ReadLibraryContents (void)
   if (ParseLibraryTree () > 0 || resultFP != NULL)
     {
       sort_library (&Library);
+      /* the entries moved; the search index is rebuilt when needed */
+      LibraryIndexForget (&Library);
+      /* Build the footprint lookup table now rather than on the first
+       * LoadFootprintByName.  */
+      make_footprint_hash ();
       return 0;
     }
   
@@ -90,6 +90,7 @@
 #include "polygon.h"
 #include "pcb-printf.h"
 #include "search.h"
+#include "select.h"
 #include "set.h"
 #include "undo.h"
 #include "rats.h"
@@ -892,7 +893,7 @@ LookupLOConnectionsToLOList (bool AndRats)
 
           for (entry = 0; entry < PCB->LayerGroups.Number[group]; entry++)
             {
-              layer = PCB->LayerGroups.Entries[group][entry];
+              layer = GROUP_ENTRY (&PCB->LayerGroups, group, entry);
 
               /* be aware that the layer number equal max_copper_layer
                * and max_copper_layer+1 have a special meaning for pads
@@ -1800,7 +1801,7 @@ LookupLOConnectionsToArc (ArcType *Arc, Cardinal LayerGroup)
       Cardinal layer;
       GList *i;
 
-      layer = PCB->LayerGroups.Entries[LayerGroup][entry];
+      layer = GROUP_ENTRY (&PCB->LayerGroups, LayerGroup, entry);
 
       /* handle normal layers */
       if (layer < max_copper_layer)
@@ -1938,7 +1939,7 @@ LookupLOConnectionsToLine (LineType *Line, Cardinal LayerGroup,
     {
       Cardinal layer;
 
-      layer = PCB->LayerGroups.Entries[LayerGroup][entry];
+      layer = GROUP_ENTRY (&PCB->LayerGroups, LayerGroup, entry);
 
       /* handle normal layers */
       if (layer < max_copper_layer)
@@ -2037,7 +2038,7 @@ LOTouchesLine (LineType *Line, Cardinal LayerGroup)
   /* loop over all layers of the group */
   for (entry = 0; entry < PCB->LayerGroups.Number[LayerGroup]; entry++)
     {
-      Cardinal layer = PCB->LayerGroups.Entries[LayerGroup][entry];
+      Cardinal layer = GROUP_ENTRY (&PCB->LayerGroups, LayerGroup, entry);
 
       /* handle normal layers */
       if (layer < max_copper_layer)
@@ -2156,7 +2157,7 @@ LookupLOConnectionsToRatEnd (PointType *Point, Cardinal LayerGroup)
     {
       Cardinal layer;
 
-      layer = PCB->LayerGroups.Entries[LayerGroup][entry];
+      layer = GROUP_ENTRY (&PCB->LayerGroups, LayerGroup, entry);
       /* handle normal layers 
          rats don't ever touch
          arcs by definition
@@ -2306,7 +2307,7 @@ LookupLOConnectionsToPad (PadType *Pad, Cardinal LayerGroup)
     {
       Cardinal layer;
 
-      layer = PCB->LayerGroups.Entries[LayerGroup][entry];
+      layer = GROUP_ENTRY (&PCB->LayerGroups, LayerGroup, entry);
       /* handle normal layers */
       if (layer < max_copper_layer)
         {
@@ -2438,7 +2439,7 @@ LookupLOConnectionsToPolygon (PolygonType *Polygon, Cardinal LayerGroup)
     {
       Cardinal layer;
 
-      layer = PCB->LayerGroups.Entries[LayerGroup][entry];
+      layer = GROUP_ENTRY (&PCB->LayerGroups, LayerGroup, entry);
 
       /* handle normal layers */
       if (layer < max_copper_layer)
@@ -3273,6 +3274,142 @@ LookupConnection (Coord X, Coord Y, bool AndDraw, Coord Range, int which_flag)
   FreeConnectionLookupMemory ();
 }
 
+/* ---------------------------------------------------------------------------
+ * clears the scratch flag used by MeasureConnections on all copper
+ * objects and rats, without drawing, undo entries or marking the layout
+ * as changed
+ */
+static void
+ClearScratchFlag (int flag)
+{
+  VIA_LOOP (PCB->Data);
+  {
+    CLEAR_FLAG (flag, via);
+  }
+  END_LOOP;
+  ELEMENT_LOOP (PCB->Data);
+  {
+    PIN_LOOP (element);
+    {
+      CLEAR_FLAG (flag, pin);
+    }
+    END_LOOP;
+    PAD_LOOP (element);
+    {
+      CLEAR_FLAG (flag, pad);
+    }
+    END_LOOP;
+  }
+  END_LOOP;
+  RAT_LOOP (PCB->Data);
+  {
+    CLEAR_FLAG (flag, line);
+  }
+  END_LOOP;
+  COPPERLINE_LOOP (PCB->Data);
+  {
+    CLEAR_FLAG (flag, line);
+  }
+  ENDALL_LOOP;
+  COPPERARC_LOOP (PCB->Data);
+  {
+    CLEAR_FLAG (flag, arc);
+  }
+  ENDALL_LOOP;
+  COPPERPOLYGON_LOOP (PCB->Data);
+  {
+    CLEAR_FLAG (flag, polygon);
+  }
+  ENDALL_LOOP;
+}
+
+/* ---------------------------------------------------------------------------
+ * measures the copper connected to each of the N pins or pads in Seeds
+ * (of the matching type in Types, NULL entries are skipped) and stores
+ * the result in Stats.
+ * All seeds share a single sweep: every object is visited at most once,
+ * and a seed reached from an earlier one gets that seed's result.  The
+ * objects are marked with DRCFLAG, which is cleared again before
+ * returning, so neither the visible flags nor the undo list change.
+ */
+void
+MeasureConnections (Cardinal N, int *Types, void **Seeds,
+                    ConnectionStatsType *Stats)
+{
+  GHashTable *reached = g_hash_table_new (NULL, NULL);
+  int old_flag = TheFlag;
+  Cardinal i, j, layer;
+
+  TheFlag = DRCFLAG;
+  User = false;
+  reassign_no_drc_flags ();
+  InitConnectionLookup ();
+
+  for (i = 0; i < N; i++)
+    {
+      ConnectionStatsType *s = &Stats[i];
+      AnyObjectType *seed = (AnyObjectType *) Seeds[i];
+      ElementType *element;
+
+      memset (s, 0, sizeof (*s));
+      if (seed == NULL)
+        continue;
+
+      if (TEST_FLAG (DRCFLAG, seed))
+        {
+          gpointer first = g_hash_table_lookup (reached, seed);
+          if (first != NULL)
+            *s = Stats[GPOINTER_TO_UINT (first) - 1];
+          continue;
+        }
+
+      element = Types[i] == PAD_TYPE ? (ElementType *) ((PadType *) seed)->Element
+                                     : (ElementType *) ((PinType *) seed)->Element;
+      ListStart (Types[i], element, seed, seed);
+      DoIt (true, false);
+
+      for (layer = 0; layer < max_copper_layer; layer++)
+        {
+          for (j = 0; j < LineList[layer].Number; j++)
+            {
+              LineType *line = LINELIST_ENTRY (layer, j);
+              double dx = line->Point1.X - line->Point2.X;
+              double dy = line->Point1.Y - line->Point2.Y;
+
+              s->length += sqrt (dx * dx + dy * dy);
+              s->segments++;
+              s->found = true;
+            }
+          for (j = 0; j < ArcList[layer].Number; j++)
+            {
+              ArcType *arc = ARCLIST_ENTRY (layer, j);
+
+              /* FIXME: we assume width==height here */
+              s->length += M_PI * 2 * arc->Width * abs (arc->Delta) / 360.0;
+              s->segments++;
+              s->found = true;
+            }
+        }
+      for (j = 0; j < PVList.Number; j++)
+        {
+          PinType *pv = PVLIST_ENTRY (j);
+
+          if (pv->Element == NULL)
+            s->vias++;
+          g_hash_table_insert (reached, pv, GUINT_TO_POINTER (i + 1));
+        }
+      for (layer = 0; layer < 2; layer++)
+        for (j = 0; j < PadList[layer].Number; j++)
+          g_hash_table_insert (reached, PADLIST_ENTRY (layer, j),
+                               GUINT_TO_POINTER (i + 1));
+    }
+
+  FreeConnectionLookupMemory ();
+  ClearScratchFlag (DRCFLAG);
+  TheFlag = old_flag;
+  g_hash_table_destroy (reached);
+}
+
 /* ---------------------------------------------------------------------------
  * find connections for rats nesting
  * assumes InitConnectionLookup() has already been done
@@ -3314,6 +3451,8 @@ LookupUnusedPins (FILE * FP)
   FreeConnectionLookupMemory ();
   IncrementUndoSerialNumber ();
   User = false;
+  /* the unused pins were selected without undo entries */
+  InvalidateSelectionIndex ();
   Draw ();
 }
 
@@ -4237,9 +4376,1360 @@ DRCAll (void)
 	       nopastecnt,
 	       nopastecnt > 1 ? "s have" : " has");
     }
+  /* offending objects were selected without undo entries */
+  InvalidateSelectionIndex ();
   return IsBad ? -drcerr_count : drcerr_count;
 }
 
+/* ---------------------------------------------------------------------------
+ * incremental DRC
+ *
+ * DRCIncremental() keeps the violations it finds between calls and, on
+ * the next call, re-checks only the objects the undo journal reports
+ * as changed plus whatever they come close to.  Each violation is
+ * filed under the IDs of the objects involved, so dropping the marks
+ * of a changed object also drops its pair violations.  It checks the
+ * same rules as DRCAll() except the minimum overlap (Shrink) test, and
+ * flags nothing on the board.
+ *
+ * Whether two close objects violate the clearance depends on their
+ * being on different nets, so every copper object also carries the
+ * label of its net.  A run relabels the nets its changes were and are
+ * on; when that joins nets or splits one, every object of the nets
+ * involved is re-checked as if it had changed itself.
+ */
+typedef struct
+{
+  DrcViolationType *violation;
+  long int id1, id2;		/* objects involved, id2 is 0 for a single one */
+  bool is_new;			/* found by the current run */
+} DrcMarkType;
+
+typedef struct
+{
+  int type;
+  void *ptr1, *ptr2;
+} DrcQueueType;
+
+typedef struct
+{
+  long int id;
+  int type;
+  void *ptr1, *ptr2;
+  gint was;			/* its label before it was last labelled */
+} DrcNetMemberType;
+
+struct drc_pair_info
+{
+  int type;			/* the object being checked */
+  void *ptr1, *ptr2;
+  bool net_done;		/* its net carries DRCFLAG */
+};
+
+static GHashTable *drc_marks = NULL;	/* set of all DrcMarkType */
+static GHashTable *drc_marks_by_id = NULL;	/* ID -> GSList of DrcMarkType */
+static PCBType *drc_marks_pcb = NULL;	/* board the marks belong to */
+static Coord drc_marks_rules[5];	/* rules the marks were found with */
+static GHashTable *drc_net_of = NULL;	/* ID -> label of its net */
+static GHashTable *drc_net_members = NULL;	/* label -> GArray of DrcNetMemberType */
+static GHashTable *drc_element_parts = NULL;	/* element ID -> GArray of pin and pad IDs */
+static gint drc_net_last = 0;	/* last label handed out */
+static PolygonType *drc_plow_only = NULL;
+static LayerType *drc_search_layer;	/* set by drc_search_group() */
+static int drc_search_side;
+
+static void
+drc_mark_free (DrcMarkType *mark)
+{
+  free (mark->violation->object_id_list);
+  free (mark->violation->object_type_list);
+  pcb_drc_violation_free (mark->violation);
+  free (mark);
+}
+
+static void
+drc_mark_file (long int id, DrcMarkType *mark)
+{
+  gpointer key = GINT_TO_POINTER ((gint) id);
+  GSList *list = g_hash_table_lookup (drc_marks_by_id, key);
+
+  g_hash_table_insert (drc_marks_by_id, key, g_slist_prepend (list, mark));
+}
+
+/* drops all marks involving the object with the given ID */
+static void
+drc_mark_forget (long int id)
+{
+  gpointer key = GINT_TO_POINTER ((gint) id);
+  GSList *list = g_hash_table_lookup (drc_marks_by_id, key);
+  GSList *i;
+
+  if (list == NULL)
+    return;
+  g_hash_table_remove (drc_marks_by_id, key);
+  for (i = list; i != NULL; i = g_slist_next (i))
+    {
+      DrcMarkType *mark = i->data;
+      long int other = mark->id1 == id ? mark->id2 : mark->id1;
+
+      if (other != 0 && other != id)
+        {
+          gpointer okey = GINT_TO_POINTER ((gint) other);
+          GSList *olist = g_hash_table_lookup (drc_marks_by_id, okey);
+
+          olist = g_slist_remove (olist, mark);
+          if (olist == NULL)
+            g_hash_table_remove (drc_marks_by_id, okey);
+          else
+            g_hash_table_insert (drc_marks_by_id, okey, olist);
+        }
+      g_hash_table_remove (drc_marks, mark);
+      drc_mark_free (mark);
+    }
+  g_slist_free (list);
+}
+
+static void
+drc_array_free (gpointer array)
+{
+  g_array_free ((GArray *) array, TRUE);
+}
+
+static void
+drc_marks_reset (void)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+
+  if (drc_marks != NULL)
+    {
+      g_hash_table_iter_init (&iter, drc_marks);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        drc_mark_free ((DrcMarkType *) key);
+      g_hash_table_destroy (drc_marks);
+    }
+  if (drc_marks_by_id != NULL)
+    {
+      g_hash_table_iter_init (&iter, drc_marks_by_id);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        g_slist_free ((GSList *) value);
+      g_hash_table_destroy (drc_marks_by_id);
+    }
+  drc_marks = g_hash_table_new (NULL, NULL);
+  drc_marks_by_id = g_hash_table_new (NULL, NULL);
+
+  if (drc_net_of != NULL)
+    {
+      g_hash_table_destroy (drc_net_of);
+      g_hash_table_destroy (drc_net_members);
+      g_hash_table_destroy (drc_element_parts);
+    }
+  drc_net_of = g_hash_table_new (NULL, NULL);
+  drc_net_members = g_hash_table_new_full (NULL, NULL, NULL, drc_array_free);
+  drc_element_parts = g_hash_table_new_full (NULL, NULL, NULL, drc_array_free);
+}
+
+/* ---------------------------------------------------------------------------
+ * records a violation of the object (type, ptr1, ptr2), located at that
+ * object, optionally together with a second object.  A pair that is
+ * already marked with the same title is not added twice.
+ */
+static void
+drc_mark_add (const char *title, const char *explanation,
+              int type, void *ptr1, void *ptr2, int type2, void *ptr2b,
+              bool have_measured, Coord measured, Coord required)
+{
+  DrcMarkType *mark;
+  long int id1 = ((AnyObjectType *) ptr2)->ID;
+  long int id2 = ptr2b ? ((AnyObjectType *) ptr2b)->ID : 0;
+  long int *ids;
+  int *types, count = ptr2b ? 2 : 1;
+  Coord x, y;
+  GSList *i;
+
+  for (i = g_hash_table_lookup (drc_marks_by_id, GINT_TO_POINTER ((gint) id1));
+       i != NULL; i = g_slist_next (i))
+    {
+      DrcMarkType *old = i->data;
+
+      if (((old->id1 == id1 && old->id2 == id2)
+           || (old->id1 == id2 && old->id2 == id1))
+          && strcmp (old->violation->title, title) == 0)
+        return;
+    }
+
+  SetThing (type, ptr1, ptr2, ptr2);
+  LocateError (&x, &y);
+  ids = (long int *) malloc (count * sizeof (long int));
+  types = (int *) malloc (count * sizeof (int));
+  ids[0] = id1;
+  types[0] = thing_type;
+  if (ptr2b)
+    {
+      ids[1] = id2;
+      types[1] = type2;
+    }
+
+  mark = (DrcMarkType *) malloc (sizeof (DrcMarkType));
+  mark->violation = pcb_drc_violation_new (title, explanation, x, y,
+                                           0,    /* ANGLE OF ERROR UNKNOWN */
+                                           have_measured, measured, required,
+                                           count, ids, types);
+  mark->id1 = id1;
+  mark->id2 = id2;
+  mark->is_new = true;
+  g_hash_table_insert (drc_marks, mark, mark);
+  drc_mark_file (id1, mark);
+  if (id2 != 0 && id2 != id1)
+    drc_mark_file (id2, mark);
+}
+
+/* ---------------------------------------------------------------------------
+ * read-only version of drc_callback(), restricted to drc_plow_only if
+ * that is set
+ */
+static int
+drc_plow_callback (DataType *data, LayerType *layer, PolygonType *polygon,
+                   int type, void *ptr1, void *ptr2)
+{
+  const char *message = NULL;
+  LineType *line = (LineType *) ptr2;
+  ArcType *arc = (ArcType *) ptr2;
+  PinType *pin = (PinType *) ptr2;
+  PadType *pad = (PadType *) ptr2;
+
+  if (drc_plow_only != NULL && polygon != drc_plow_only)
+    return 0;
+  switch (type)
+    {
+    case LINE_TYPE:
+      if (line->Clearance < 2 * PCB->Bloat)
+        message = _("Line with insufficient clearance inside polygon\n");
+      break;
+    case ARC_TYPE:
+      if (arc->Clearance < 2 * PCB->Bloat)
+        message = _("Arc with insufficient clearance inside polygon\n");
+      break;
+    case PAD_TYPE:
+      Bloat = PCB->Bloat;
+      if (pad->Clearance && pad->Clearance < 2 * PCB->Bloat
+          && IsPadInPolygon (pad, polygon))
+        message = _("Pad with insufficient clearance inside polygon\n");
+      break;
+    case PIN_TYPE:
+      if (pin->Clearance && pin->Clearance < 2 * PCB->Bloat)
+        message = _("Pin with insufficient clearance inside polygon\n");
+      break;
+    case VIA_TYPE:
+      if (pin->Clearance && pin->Clearance < 2 * PCB->Bloat)
+        message = _("Via with insufficient clearance inside polygon\n");
+      break;
+    }
+  if (message != NULL)
+    drc_mark_add (message,
+                  _("Circuits that are too close may bridge during imaging, etching,\n"
+                    "plating, or soldering processes resulting in a direct short."),
+                  type, ptr1, ptr2, POLYGON_TYPE, polygon,
+                  FALSE, 0, PCB->Bloat);
+  return 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * whether two copper objects touch at the current Bloat
+ */
+static int
+drc_touch_rank (int type)
+{
+  switch (type)
+    {
+    case PIN_TYPE:
+    case VIA_TYPE:
+      return 0;
+    case LINE_TYPE:
+    case PAD_TYPE:
+      return 1;
+    default:
+      return 2;
+    }
+}
+
+static bool
+drc_touch (int t1, void *o1, int t2, void *o2)
+{
+  if (drc_touch_rank (t1) > drc_touch_rank (t2))
+    {
+      int t = t1;
+      void *o = o1;
+
+      t1 = t2;
+      o1 = o2;
+      t2 = t;
+      o2 = o;
+    }
+  switch (t1)
+    {
+    case PIN_TYPE:
+    case VIA_TYPE:
+      switch (t2)
+        {
+        case PIN_TYPE:
+        case VIA_TYPE:
+          return PV_TOUCH_PV ((PinType *) o1, (PinType *) o2);
+        case LINE_TYPE:
+          return PinLineIntersect ((PinType *) o1, (LineType *) o2);
+        case PAD_TYPE:
+          return IS_PV_ON_PAD ((PinType *) o1, (PadType *) o2);
+        default:
+          return IS_PV_ON_ARC ((PinType *) o1, (ArcType *) o2);
+        }
+    case LINE_TYPE:
+    case PAD_TYPE:
+      if (t2 == ARC_TYPE)
+        return LineArcIntersect ((LineType *) o1, (ArcType *) o2);
+      return LineLineIntersect ((LineType *) o1, (LineType *) o2);
+    default:
+      return ArcArcIntersect ((ArcType *) o1, (ArcType *) o2);
+    }
+}
+
+/* clears DRCFLAG from whatever the last lookup found */
+static void
+drc_net_clear (void)
+{
+  Cardinal layer, i;
+
+  for (layer = 0; layer < max_copper_layer; layer++)
+    {
+      for (i = 0; i < LineList[layer].Number; i++)
+        CLEAR_FLAG (DRCFLAG, LINELIST_ENTRY (layer, i));
+      for (i = 0; i < ArcList[layer].Number; i++)
+        CLEAR_FLAG (DRCFLAG, ARCLIST_ENTRY (layer, i));
+      for (i = 0; i < PolygonList[layer].Number; i++)
+        CLEAR_FLAG (DRCFLAG, POLYGONLIST_ENTRY (layer, i));
+    }
+  for (layer = 0; layer < 2; layer++)
+    for (i = 0; i < PadList[layer].Number; i++)
+      CLEAR_FLAG (DRCFLAG, PADLIST_ENTRY (layer, i));
+  for (i = 0; i < PVList.Number; i++)
+    CLEAR_FLAG (DRCFLAG, PVLIST_ENTRY (i));
+  for (i = 0; i < RatList.Number; i++)
+    CLEAR_FLAG (DRCFLAG, RATLIST_ENTRY (i));
+  DumpList ();
+}
+
+/* ---------------------------------------------------------------------------
+ * net labels
+ */
+#define DRC_NET_OF(id) \
+  GPOINTER_TO_INT (g_hash_table_lookup (drc_net_of, GINT_TO_POINTER ((gint) (id))))
+
+static void
+drc_net_take (gint label, GArray *members, int type, void *ptr1, void *ptr2)
+{
+  DrcNetMemberType m;
+
+  m.id = ((AnyObjectType *) ptr2)->ID;
+  m.type = type;
+  m.ptr1 = ptr1;
+  m.ptr2 = ptr2;
+  m.was = DRC_NET_OF (m.id);
+  g_array_append_val (members, m);
+  g_hash_table_insert (drc_net_of, GINT_TO_POINTER ((gint) m.id),
+                       GINT_TO_POINTER (label));
+}
+
+/* ---------------------------------------------------------------------------
+ * gives the net of the copper object (type, ptr1, ptr2) a new label and
+ * returns its members
+ */
+static GArray *
+drc_net_label (int type, void *ptr1, void *ptr2)
+{
+  GArray *members = g_array_new (FALSE, FALSE, sizeof (DrcNetMemberType));
+  gint label = ++drc_net_last;
+  Cardinal layer, i;
+
+  Bloat = 0;
+  ListStart (type, ptr1, ptr2, ptr2);
+  DoIt (true, false);
+  for (layer = 0; layer < max_copper_layer; layer++)
+    {
+      LayerType *l = LAYER_PTR (layer);
+
+      for (i = 0; i < LineList[layer].Number; i++)
+        drc_net_take (label, members, LINE_TYPE, l, LINELIST_ENTRY (layer, i));
+      for (i = 0; i < ArcList[layer].Number; i++)
+        drc_net_take (label, members, ARC_TYPE, l, ARCLIST_ENTRY (layer, i));
+      for (i = 0; i < PolygonList[layer].Number; i++)
+        drc_net_take (label, members, POLYGON_TYPE, l,
+                      POLYGONLIST_ENTRY (layer, i));
+    }
+  for (layer = 0; layer < 2; layer++)
+    for (i = 0; i < PadList[layer].Number; i++)
+      {
+        PadType *pad = PADLIST_ENTRY (layer, i);
+
+        drc_net_take (label, members, PAD_TYPE, pad->Element, pad);
+      }
+  for (i = 0; i < PVList.Number; i++)
+    {
+      PinType *pv = PVLIST_ENTRY (i);
+
+      if (pv->Element)
+        drc_net_take (label, members, PIN_TYPE, pv->Element, pv);
+      else
+        drc_net_take (label, members, VIA_TYPE, pv, pv);
+    }
+  for (i = 0; i < RatList.Number; i++)
+    {
+      RatType *rat = RATLIST_ENTRY (i);
+
+      drc_net_take (label, members, RATLINE_TYPE, rat, rat);
+    }
+  drc_net_clear ();
+  g_hash_table_insert (drc_net_members, GINT_TO_POINTER (label), members);
+  return members;
+}
+
+static void
+drc_net_ensure (int type, void *ptr1, void *ptr2)
+{
+  if (DRC_NET_OF (((AnyObjectType *) ptr2)->ID) == 0)
+    drc_net_label (type, ptr1, ptr2);
+}
+
+/* labels the nets of all copper on the board */
+static void
+drc_net_label_all (void)
+{
+  VIA_LOOP (PCB->Data);
+  {
+    drc_net_ensure (VIA_TYPE, via, via);
+  }
+  END_LOOP;
+  ELEMENT_LOOP (PCB->Data);
+  {
+    PIN_LOOP (element);
+    {
+      drc_net_ensure (PIN_TYPE, element, pin);
+    }
+    END_LOOP;
+    PAD_LOOP (element);
+    {
+      drc_net_ensure (PAD_TYPE, element, pad);
+    }
+    END_LOOP;
+  }
+  END_LOOP;
+  COPPERLINE_LOOP (PCB->Data);
+  {
+    drc_net_ensure (LINE_TYPE, layer, line);
+  }
+  ENDALL_LOOP;
+  COPPERARC_LOOP (PCB->Data);
+  {
+    drc_net_ensure (ARC_TYPE, layer, arc);
+  }
+  ENDALL_LOOP;
+  COPPERPOLYGON_LOOP (PCB->Data);
+  {
+    drc_net_ensure (POLYGON_TYPE, layer, polygon);
+  }
+  ENDALL_LOOP;
+  RAT_LOOP (PCB->Data);
+  {
+    drc_net_ensure (RATLINE_TYPE, line, line);
+  }
+  END_LOOP;
+}
+
+/* ---------------------------------------------------------------------------
+ * checks the object in info against a neighbour: it is too close if it
+ * touches when bloated but not as drawn, unless both are on one net
+ */
+static void
+drc_check_pair (struct drc_pair_info *info, int type, void *ptr1, void *ptr2)
+{
+  if (ptr2 == info->ptr2)
+    return;
+  Bloat = PCB->Bloat;
+  if (!drc_touch (info->type, info->ptr2, type, ptr2))
+    return;
+  Bloat = 0;
+  if (drc_touch (info->type, info->ptr2, type, ptr2))
+    return;
+
+  if (!info->net_done)
+    {
+      ListStart (info->type, info->ptr1, info->ptr2, info->ptr2);
+      DoIt (true, false);
+      info->net_done = true;
+    }
+  if (TEST_FLAG (DRCFLAG, (AnyObjectType *) ptr2))
+    return;
+
+  drc_mark_add (_("Copper areas too close"),
+                _("Circuits that are too close may bridge during imaging, etching,\n"
+                  "plating, or soldering processes resulting in a direct short."),
+                info->type, info->ptr1, info->ptr2, type, ptr2,
+                FALSE, 0, PCB->Bloat);
+}
+
+static int
+drc_pair_pv_callback (const BoxType *b, void *cl)
+{
+  PinType *pv = (PinType *) b;
+
+  if (!TEST_FLAG (HOLEFLAG, pv))
+    drc_check_pair ((struct drc_pair_info *) cl,
+                    pv->Element ? PIN_TYPE : VIA_TYPE,
+                    pv->Element ? pv->Element : pv, pv);
+  return 0;
+}
+
+static int
+drc_pair_pad_callback (const BoxType *b, void *cl)
+{
+  PadType *pad = (PadType *) b;
+  int side = TEST_FLAG (ONSOLDERFLAG, pad) ? SOLDER_LAYER : COMPONENT_LAYER;
+
+  if (side == drc_search_side)
+    drc_check_pair ((struct drc_pair_info *) cl, PAD_TYPE, pad->Element, pad);
+  return 0;
+}
+
+static int
+drc_pair_line_callback (const BoxType *b, void *cl)
+{
+  LineType *line = (LineType *) b;
+
+  if (line->Thickness)
+    drc_check_pair ((struct drc_pair_info *) cl, LINE_TYPE,
+                    drc_search_layer, line);
+  return 0;
+}
+
+static int
+drc_pair_arc_callback (const BoxType *b, void *cl)
+{
+  ArcType *arc = (ArcType *) b;
+
+  if (arc->Thickness)
+    drc_check_pair ((struct drc_pair_info *) cl, ARC_TYPE,
+                    drc_search_layer, arc);
+  return 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * searches the lines, arcs and pads of one layer group within box
+ */
+static void
+drc_search_group (Cardinal group, const BoxType *box,
+                  int (*line_cb) (const BoxType *, void *),
+                  int (*arc_cb) (const BoxType *, void *),
+                  int (*pad_cb) (const BoxType *, void *), void *cl)
+{
+  Cardinal entry;
+
+  for (entry = 0; entry < PCB->LayerGroups.Number[group]; entry++)
+    {
+      Cardinal layer = GROUP_ENTRY (&PCB->LayerGroups, group, entry);
+
+      if (layer < max_copper_layer)
+        {
+          if (LAYER_PTR (layer)->no_drc)
+            continue;
+          drc_search_layer = LAYER_PTR (layer);
+          r_search (drc_search_layer->line_tree, box, NULL, line_cb, cl);
+          r_search (drc_search_layer->arc_tree, box, NULL, arc_cb, cl);
+        }
+      else
+        {
+          drc_search_side = layer - max_copper_layer;
+          r_search (PCB->Data->pad_tree, box, NULL, pad_cb, cl);
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * checks a copper object against everything within PCB->Bloat of it
+ */
+static void
+drc_check_neighbours (int type, void *ptr1, void *ptr2)
+{
+  struct drc_pair_info info;
+  BoxType box = ((AnyObjectType *) ptr2)->BoundingBox;
+  Cardinal group;
+
+  info.type = type;
+  info.ptr1 = ptr1;
+  info.ptr2 = ptr2;
+  info.net_done = false;
+  box.X1 -= PCB->Bloat + 1;
+  box.Y1 -= PCB->Bloat + 1;
+  box.X2 += PCB->Bloat + 1;
+  box.Y2 += PCB->Bloat + 1;
+
+  r_search (PCB->Data->pin_tree, &box, NULL, drc_pair_pv_callback, &info);
+  r_search (PCB->Data->via_tree, &box, NULL, drc_pair_pv_callback, &info);
+  switch (type)
+    {
+    case PIN_TYPE:
+    case VIA_TYPE:
+      for (group = 0; group < max_group; group++)
+        drc_search_group (group, &box, drc_pair_line_callback,
+                          drc_pair_arc_callback, drc_pair_pad_callback, &info);
+      break;
+    case PAD_TYPE:
+      group = GetLayerGroupNumberByNumber (max_copper_layer +
+        (TEST_FLAG (ONSOLDERFLAG, (PadType *) ptr2) ? SOLDER_LAYER : COMPONENT_LAYER));
+      drc_search_group (group, &box, drc_pair_line_callback,
+                        drc_pair_arc_callback, drc_pair_pad_callback, &info);
+      break;
+    default:
+      group = GetLayerGroupNumberByPointer ((LayerType *) ptr1);
+      drc_search_group (group, &box, drc_pair_line_callback,
+                        drc_pair_arc_callback, drc_pair_pad_callback, &info);
+      break;
+    }
+  if (info.net_done)
+    drc_net_clear ();
+}
+
+/* ---------------------------------------------------------------------------
+ * re-checks the clearance of everything a changed polygon may plow into
+ */
+static int
+drc_plow_pv_callback (const BoxType *b, void *cl)
+{
+  PinType *pv = (PinType *) b;
+
+  if (pv->Element)
+    PlowsPolygon (PCB->Data, PIN_TYPE, pv->Element, pv, drc_plow_callback);
+  else
+    PlowsPolygon (PCB->Data, VIA_TYPE, pv, pv, drc_plow_callback);
+  return 0;
+}
+
+static int
+drc_plow_pad_callback (const BoxType *b, void *cl)
+{
+  PadType *pad = (PadType *) b;
+
+  PlowsPolygon (PCB->Data, PAD_TYPE, pad->Element, pad, drc_plow_callback);
+  return 0;
+}
+
+static int
+drc_plow_line_callback (const BoxType *b, void *cl)
+{
+  PlowsPolygon (PCB->Data, LINE_TYPE, drc_search_layer, (LineType *) b,
+                drc_plow_callback);
+  return 0;
+}
+
+static int
+drc_plow_arc_callback (const BoxType *b, void *cl)
+{
+  PlowsPolygon (PCB->Data, ARC_TYPE, drc_search_layer, (ArcType *) b,
+                drc_plow_callback);
+  return 0;
+}
+
+static void
+drc_check_polygon (LayerType *layer, PolygonType *polygon)
+{
+  if (!TEST_FLAG (CLEARPOLYFLAG, polygon))
+    return;
+  drc_plow_only = polygon;
+  r_search (PCB->Data->pin_tree, &polygon->BoundingBox, NULL,
+            drc_plow_pv_callback, NULL);
+  r_search (PCB->Data->via_tree, &polygon->BoundingBox, NULL,
+            drc_plow_pv_callback, NULL);
+  drc_search_group (GetLayerGroupNumberByPointer (layer),
+                    &polygon->BoundingBox, drc_plow_line_callback,
+                    drc_plow_arc_callback, drc_plow_pad_callback, NULL);
+  drc_plow_only = NULL;
+}
+
+/* ---------------------------------------------------------------------------
+ * runs every single-object rule on one object and checks it against
+ * its neighbours
+ */
+static void
+drc_check_object (int type, void *ptr1, void *ptr2)
+{
+  LayerType *layer = (LayerType *) ptr1;
+  LineType *line = (LineType *) ptr2;
+  ArcType *arc = (ArcType *) ptr2;
+  PinType *pin = (PinType *) ptr2;
+  PadType *pad = (PadType *) ptr2;
+  ElementType *element = (ElementType *) ptr2;
+
+  switch (type)
+    {
+    case LINE_TYPE:
+      if (TEST_SILK_LAYER (layer))
+        {
+          if (line->Thickness < PCB->minSlk)
+            drc_mark_add (_("Silk line is too thin"),
+                          _("Process specifications dictate a minimum silkscreen feature-width\n"
+                            "that can reliably be reproduced"),
+                          type, ptr1, ptr2, NO_TYPE, NULL,
+                          TRUE, line->Thickness, PCB->minSlk);
+          break;
+        }
+      PlowsPolygon (PCB->Data, type, ptr1, ptr2, drc_plow_callback);
+      if (line->Thickness < PCB->minWid)
+        drc_mark_add (_("Line width is too thin"),
+                      _("Process specifications dictate a minimum feature-width\n"
+                        "that can reliably be reproduced"),
+                      type, ptr1, ptr2, NO_TYPE, NULL,
+                      TRUE, line->Thickness, PCB->minWid);
+      if (line->Thickness && !layer->no_drc)
+        drc_check_neighbours (type, ptr1, ptr2);
+      break;
+
+    case ARC_TYPE:
+      PlowsPolygon (PCB->Data, type, ptr1, ptr2, drc_plow_callback);
+      if (arc->Thickness < PCB->minWid)
+        drc_mark_add (_("Arc width is too thin"),
+                      _("Process specifications dictate a minimum feature-width\n"
+                        "that can reliably be reproduced"),
+                      type, ptr1, ptr2, NO_TYPE, NULL,
+                      TRUE, arc->Thickness, PCB->minWid);
+      if (arc->Thickness && !layer->no_drc)
+        drc_check_neighbours (type, ptr1, ptr2);
+      break;
+
+    case PAD_TYPE:
+      PlowsPolygon (PCB->Data, type, ptr1, ptr2, drc_plow_callback);
+      if (pad->Thickness < PCB->minWid)
+        drc_mark_add (_("Pad is too thin"),
+                      _("Pads which are too thin may erode during etching,\n"
+                        "resulting in a broken or unreliable connection"),
+                      type, ptr1, ptr2, NO_TYPE, NULL,
+                      TRUE, pad->Thickness, PCB->minWid);
+      drc_check_neighbours (type, ptr1, ptr2);
+      break;
+
+    case PIN_TYPE:
+    case VIA_TYPE:
+      PlowsPolygon (PCB->Data, type, ptr1, ptr2, drc_plow_callback);
+      if (!TEST_FLAG (HOLEFLAG, pin) &&
+          pin->Thickness - pin->DrillingHole < 2 * PCB->minRing)
+        drc_mark_add (type == PIN_TYPE ? _("Pin annular ring too small")
+                                       : _("Via annular ring too small"),
+                      _("Annular rings that are too small may erode during etching,\n"
+                        "resulting in a broken connection"),
+                      type, ptr1, ptr2, NO_TYPE, NULL,
+                      TRUE, (pin->Thickness - pin->DrillingHole) / 2,
+                      PCB->minRing);
+      if (pin->DrillingHole < PCB->minDrill)
+        drc_mark_add (type == PIN_TYPE ? _("Pin drill size is too small")
+                                       : _("Via drill size is too small"),
+                      _("Process rules dictate the minimum drill size which can be used"),
+                      type, ptr1, ptr2, NO_TYPE, NULL,
+                      TRUE, pin->DrillingHole, PCB->minDrill);
+      if (!TEST_FLAG (HOLEFLAG, pin))
+        drc_check_neighbours (type, ptr1, ptr2);
+      break;
+
+    case ELEMENT_TYPE:
+      {
+        int tmpcnt = 0;
+
+        ELEMENTLINE_LOOP (element);
+        {
+          if (line->Thickness < PCB->minSlk)
+            tmpcnt++;
+        }
+        END_LOOP;
+        if (tmpcnt > 0)
+          {
+            char *title;
+
+            title = g_strdup_printf (_("Element %s has %i silk lines which are too thin"),
+                                     UNKNOWN (NAMEONPCB_NAME (element)), tmpcnt);
+            drc_mark_add (title,
+                          _("Process specifications dictate a minimum silkscreen\n"
+                            "feature-width that can reliably be reproduced"),
+                          type, ptr1, ptr2, NO_TYPE, NULL,
+                          TRUE, 0, PCB->minSlk);
+            g_free (title);
+          }
+      }
+      break;
+
+    case POLYGON_TYPE:
+      drc_check_polygon (layer, (PolygonType *) ptr2);
+      break;
+    }
+}
+
+static void
+drc_queue (GArray *queue, int type, void *ptr1, void *ptr2)
+{
+  DrcQueueType q;
+
+  q.type = type;
+  q.ptr1 = ptr1;
+  q.ptr2 = ptr2;
+  g_array_append_val (queue, q);
+}
+
+/* records which pins and pads an element has, for when it is deleted */
+static void
+drc_element_note (ElementType *element)
+{
+  GArray *parts = g_array_new (FALSE, FALSE, sizeof (long int));
+
+  PIN_LOOP (element);
+  {
+    g_array_append_val (parts, pin->ID);
+  }
+  END_LOOP;
+  PAD_LOOP (element);
+  {
+    g_array_append_val (parts, pad->ID);
+  }
+  END_LOOP;
+  g_hash_table_insert (drc_element_parts, GINT_TO_POINTER ((gint) element->ID),
+                       parts);
+}
+
+/* queues every object on the board */
+static void
+drc_collect_all (GArray *queue)
+{
+  VIA_LOOP (PCB->Data);
+  {
+    drc_queue (queue, VIA_TYPE, via, via);
+  }
+  END_LOOP;
+  ELEMENT_LOOP (PCB->Data);
+  {
+    drc_element_note (element);
+    drc_queue (queue, ELEMENT_TYPE, element, element);
+    PIN_LOOP (element);
+    {
+      drc_queue (queue, PIN_TYPE, element, pin);
+    }
+    END_LOOP;
+    PAD_LOOP (element);
+    {
+      drc_queue (queue, PAD_TYPE, element, pad);
+    }
+    END_LOOP;
+  }
+  END_LOOP;
+  ALLLINE_LOOP (PCB->Data);
+  {
+    drc_queue (queue, LINE_TYPE, layer, line);
+  }
+  ENDALL_LOOP;
+  COPPERARC_LOOP (PCB->Data);
+  {
+    drc_queue (queue, ARC_TYPE, layer, arc);
+  }
+  ENDALL_LOOP;
+  /* polygons are reached through the objects plowing them */
+}
+
+/* ---------------------------------------------------------------------------
+ * the state of an incremental run
+ */
+struct drc_changes
+{
+  GArray *queue;		/* DrcQueueType, objects to check */
+  GHashTable *changed;		/* set of ptr2 of the changed objects */
+  GHashTable *queued;		/* set of ptr2 already queued */
+  GArray *seeds;		/* DrcQueueType, copper to relabel from */
+  GHashTable *old_nets;		/* set of labels the changes were on */
+};
+
+/* past this many changes, one walk over the board is cheaper than a
+ * search for each of them
+ */
+#define DRC_SEARCH_MAX 32
+
+static void
+drc_note_old_net (struct drc_changes *c, long int id)
+{
+  gint label = DRC_NET_OF (id);
+
+  if (label != 0)
+    g_hash_table_insert (c->old_nets, GINT_TO_POINTER (label),
+                         GINT_TO_POINTER (label));
+}
+
+/* forgets the marks of an object and queues it, once */
+static void
+drc_recheck (struct drc_changes *c, int type, void *ptr1, void *ptr2)
+{
+  if (g_hash_table_lookup (c->queued, ptr2) != NULL)
+    return;
+  g_hash_table_insert (c->queued, ptr2, ptr2);
+  drc_mark_forget (((AnyObjectType *) ptr2)->ID);
+  if (type != RATLINE_TYPE)
+    drc_queue (c->queue, type, ptr1, ptr2);
+}
+
+static void
+drc_change (struct drc_changes *c, int type, void *ptr1, void *ptr2,
+            bool copper)
+{
+  if (g_hash_table_lookup (c->changed, ptr2) != NULL)
+    return;
+  g_hash_table_insert (c->changed, ptr2, ptr2);
+  drc_note_old_net (c, ((AnyObjectType *) ptr2)->ID);
+  drc_recheck (c, type, ptr1, ptr2);
+  if (copper)
+    drc_queue (c->seeds, type, ptr1, ptr2);
+}
+
+/* ---------------------------------------------------------------------------
+ * takes in an object the journal names, as found by LookupObjectByID().
+ * A point stands for its line, rat line or polygon, and the pins and
+ * pads of an element change with it.
+ */
+static void
+drc_change_found (struct drc_changes *c, int type, void *ptr1, void *ptr2)
+{
+  ElementType *element;
+  GArray *parts;
+  guint i;
+
+  switch (type)
+    {
+    case LINEPOINT_TYPE:
+      if (ptr1 == NULL)
+        {
+          drc_change (c, RATLINE_TYPE, ptr2, ptr2, true);
+          break;
+        }
+      /* fall through */
+    case LINE_TYPE:
+      drc_change (c, LINE_TYPE, ptr1, ptr2,
+                  !TEST_SILK_LAYER ((LayerType *) ptr1));
+      break;
+    case ARC_TYPE:
+      if (!TEST_SILK_LAYER ((LayerType *) ptr1))
+        drc_change (c, ARC_TYPE, ptr1, ptr2, true);
+      break;
+    case POLYGONPOINT_TYPE:
+    case POLYGON_TYPE:
+      if (!TEST_SILK_LAYER ((LayerType *) ptr1))
+        drc_change (c, POLYGON_TYPE, ptr1, ptr2, true);
+      break;
+    case VIA_TYPE:
+    case PIN_TYPE:
+    case PAD_TYPE:
+    case RATLINE_TYPE:
+      drc_change (c, type, ptr1, ptr2, true);
+      break;
+    case ELEMENT_TYPE:
+      element = (ElementType *) ptr2;
+      /* its pins and pads are relabelled from what they are now */
+      parts = g_hash_table_lookup (drc_element_parts,
+                                   GINT_TO_POINTER ((gint) element->ID));
+      for (i = 0; parts != NULL && i < parts->len; i++)
+        {
+          long int part = g_array_index (parts, long int, i);
+
+          drc_note_old_net (c, part);
+          g_hash_table_remove (drc_net_of, GINT_TO_POINTER ((gint) part));
+        }
+      drc_element_note (element);
+      drc_change (c, ELEMENT_TYPE, element, element, false);
+      PIN_LOOP (element);
+      {
+        drc_change (c, PIN_TYPE, element, pin, true);
+      }
+      END_LOOP;
+      PAD_LOOP (element);
+      {
+        drc_change (c, PAD_TYPE, element, pad, true);
+      }
+      END_LOOP;
+      break;
+    }
+}
+
+/* takes in an object that is no longer on the board */
+static void
+drc_change_gone (struct drc_changes *c, long int id)
+{
+  gpointer key = GINT_TO_POINTER ((gint) id);
+  GArray *parts = g_hash_table_lookup (drc_element_parts, key);
+  guint i;
+
+  drc_mark_forget (id);
+  drc_note_old_net (c, id);
+  g_hash_table_remove (drc_net_of, key);
+  if (parts == NULL)
+    return;
+  for (i = 0; i < parts->len; i++)
+    {
+      long int part = g_array_index (parts, long int, i);
+
+      drc_mark_forget (part);
+      drc_note_old_net (c, part);
+      g_hash_table_remove (drc_net_of, GINT_TO_POINTER ((gint) part));
+    }
+  g_hash_table_remove (drc_element_parts, key);
+}
+
+#define DRC_WANTED(p) \
+  g_hash_table_remove (want, GINT_TO_POINTER ((gint) (p)->ID))
+
+/* ---------------------------------------------------------------------------
+ * takes in the objects whose IDs are in want with a single walk over
+ * the board; the IDs left over are gone
+ */
+static void
+drc_change_walk (struct drc_changes *c, GHashTable *want)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+
+  VIA_LOOP (PCB->Data);
+  {
+    if (DRC_WANTED (via))
+      drc_change_found (c, VIA_TYPE, via, via);
+  }
+  END_LOOP;
+  ELEMENT_LOOP (PCB->Data);
+  {
+    if (DRC_WANTED (element))
+      drc_change_found (c, ELEMENT_TYPE, element, element);
+    PIN_LOOP (element);
+    {
+      if (DRC_WANTED (pin))
+        drc_change_found (c, PIN_TYPE, element, pin);
+    }
+    END_LOOP;
+    PAD_LOOP (element);
+    {
+      if (DRC_WANTED (pad))
+        drc_change_found (c, PAD_TYPE, element, pad);
+    }
+    END_LOOP;
+  }
+  END_LOOP;
+  ALLLINE_LOOP (PCB->Data);
+  {
+    /* no short cut: each ID must leave want */
+    bool hit = DRC_WANTED (line);
+
+    hit = DRC_WANTED (&line->Point1) || hit;
+    hit = DRC_WANTED (&line->Point2) || hit;
+    if (hit)
+      drc_change_found (c, LINE_TYPE, layer, line);
+  }
+  ENDALL_LOOP;
+  ALLARC_LOOP (PCB->Data);
+  {
+    if (DRC_WANTED (arc))
+      drc_change_found (c, ARC_TYPE, layer, arc);
+  }
+  ENDALL_LOOP;
+  ALLPOLYGON_LOOP (PCB->Data);
+  {
+    bool hit = DRC_WANTED (polygon);
+    Cardinal i;
+
+    for (i = 0; i < polygon->PointN; i++)
+      hit = DRC_WANTED (&polygon->Points[i]) || hit;
+    if (hit)
+      drc_change_found (c, POLYGON_TYPE, layer, polygon);
+  }
+  ENDALL_LOOP;
+  RAT_LOOP (PCB->Data);
+  {
+    if (DRC_WANTED (line))
+      drc_change_found (c, RATLINE_TYPE, line, line);
+  }
+  END_LOOP;
+
+  g_hash_table_iter_init (&iter, want);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    drc_change_gone (c, GPOINTER_TO_INT (key));
+}
+
+/* ---------------------------------------------------------------------------
+ * relabels the nets the changes were and are on.  A new net whose
+ * unchanged members come from more than one old net joined them; an
+ * old net whose unchanged members end up on more than one new net was
+ * split.  Either way all their members are re-checked.
+ */
+static void
+drc_relabel (struct drc_changes *c)
+{
+  GHashTable *landed = g_hash_table_new (NULL, NULL);	/* old label -> new label, -1 if several */
+  GHashTable *joined = g_hash_table_new (NULL, NULL);	/* set of new labels */
+  GHashTableIter iter;
+  gpointer key, value;
+  gint first = drc_net_last + 1;	/* labels from here on are new */
+  guint i, j;
+
+  /* what is still on an old net is relabelled along with the changes */
+  g_hash_table_iter_init (&iter, c->old_nets);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      GArray *members = g_hash_table_lookup (drc_net_members, key);
+
+      if (members == NULL)
+        continue;
+      for (i = 0; i < members->len; i++)
+        {
+          DrcNetMemberType *m = &g_array_index (members, DrcNetMemberType, i);
+
+          if (DRC_NET_OF (m->id) == GPOINTER_TO_INT (key))
+            drc_queue (c->seeds, m->type, m->ptr1, m->ptr2);
+        }
+    }
+
+  for (i = 0; i < c->seeds->len; i++)
+    {
+      DrcQueueType *s = &g_array_index (c->seeds, DrcQueueType, i);
+      GArray *members;
+      gint label, from = -1;
+
+      if (DRC_NET_OF (((AnyObjectType *) s->ptr2)->ID) >= first)
+        continue;
+      members = drc_net_label (s->type, s->ptr1, s->ptr2);
+      label = drc_net_last;
+      for (j = 0; j < members->len; j++)
+        {
+          DrcNetMemberType *m = &g_array_index (members, DrcNetMemberType, j);
+          gint to;
+
+          if (m->was != 0)
+            g_hash_table_insert (c->old_nets, GINT_TO_POINTER (m->was),
+                                 GINT_TO_POINTER (m->was));
+          if (g_hash_table_lookup (c->changed, m->ptr2) != NULL)
+            continue;
+          if (from == -1)
+            from = m->was;
+          else if (from != m->was)
+            g_hash_table_insert (joined, GINT_TO_POINTER (label),
+                                 GINT_TO_POINTER (label));
+          if (m->was == 0)
+            continue;
+          to = GPOINTER_TO_INT (g_hash_table_lookup (landed,
+                                                     GINT_TO_POINTER (m->was)));
+          if (to == 0)
+            g_hash_table_insert (landed, GINT_TO_POINTER (m->was),
+                                 GINT_TO_POINTER (label));
+          else if (to != label)
+            g_hash_table_insert (landed, GINT_TO_POINTER (m->was),
+                                 GINT_TO_POINTER (-1));
+        }
+    }
+
+  g_hash_table_iter_init (&iter, joined);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      GArray *members = g_hash_table_lookup (drc_net_members, key);
+
+      for (i = 0; i < members->len; i++)
+        {
+          DrcNetMemberType *m = &g_array_index (members, DrcNetMemberType, i);
+
+          drc_recheck (c, m->type, m->ptr1, m->ptr2);
+        }
+    }
+  g_hash_table_iter_init (&iter, landed);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      GArray *members;
+
+      if (GPOINTER_TO_INT (value) != -1)
+        continue;
+      members = g_hash_table_lookup (drc_net_members, key);
+      for (i = 0; members != NULL && i < members->len; i++)
+        {
+          DrcNetMemberType *m = &g_array_index (members, DrcNetMemberType, i);
+
+          /* the old list may name objects that are gone since */
+          if (DRC_NET_OF (m->id) >= first)
+            drc_recheck (c, m->type, m->ptr1, m->ptr2);
+        }
+    }
+
+  /* every member of an old net has been relabelled by now */
+  g_hash_table_iter_init (&iter, c->old_nets);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    g_hash_table_remove (drc_net_members, key);
+
+  g_hash_table_destroy (landed);
+  g_hash_table_destroy (joined);
+}
+
+/* ---------------------------------------------------------------------------
+ * queues the objects the journal names, and whatever a change of
+ * their nets makes worth checking again
+ */
+static void
+drc_collect_changes (GArray *queue, GArray *journal)
+{
+  struct drc_changes c;
+  guint i;
+
+  c.queue = queue;
+  c.changed = g_hash_table_new (NULL, NULL);
+  c.queued = g_hash_table_new (NULL, NULL);
+  c.seeds = g_array_new (FALSE, FALSE, sizeof (DrcQueueType));
+  c.old_nets = g_hash_table_new (NULL, NULL);
+
+  if (journal->len > DRC_SEARCH_MAX)
+    {
+      GHashTable *want = g_hash_table_new (NULL, NULL);
+
+      for (i = 0; i < journal->len; i++)
+        {
+          gint id = g_array_index (journal, UndoChangeType, i).ID;
+
+          g_hash_table_insert (want, GINT_TO_POINTER (id), GINT_TO_POINTER (1));
+        }
+      drc_change_walk (&c, want);
+      g_hash_table_destroy (want);
+    }
+  else
+    for (i = 0; i < journal->len; i++)
+      {
+        UndoChangeType *change = &g_array_index (journal, UndoChangeType, i);
+        void *ptr1, *ptr2, *ptr3;
+        int type;
+
+        type = LookupObjectByID (PCB->Data, &ptr1, &ptr2, &ptr3,
+                                 change->ID, change->Kind);
+        if (type == NO_TYPE)
+          drc_change_gone (&c, change->ID);
+        else
+          drc_change_found (&c, type, ptr1, ptr2);
+      }
+
+  drc_relabel (&c);
+
+  g_hash_table_destroy (c.changed);
+  g_hash_table_destroy (c.queued);
+  g_array_free (c.seeds, TRUE);
+  g_hash_table_destroy (c.old_nets);
+}
+
+/* ---------------------------------------------------------------------------
+ * hands all current marks to the DRC window and logs the new ones
+ */
+static void
+drc_report_marks (void)
+{
+  GHashTableIter iter;
+  gpointer key, value;
+  int fresh = 0;
+
+  if (gui->drc_gui != NULL)
+    gui->drc_gui->reset_drc_dialog_message ();
+  g_hash_table_iter_init (&iter, drc_marks);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    {
+      DrcMarkType *mark = (DrcMarkType *) key;
+      DrcViolationType *violation = mark->violation;
+
+      if (gui->drc_gui != NULL)
+        gui->drc_gui->append_drc_violation (violation);
+      if (!mark->is_new)
+        continue;
+      fresh++;
+      if (gui->drc_gui == NULL || gui->drc_gui->log_drc_violations)
+        {
+          Message (_("WARNING!  Design Rule error - %s\n"), violation->title);
+          Message (_("%m+near location %$mD\n"),
+                   Settings.grid_unit->allow,
+                   violation->x, violation->y);
+        }
+    }
+  if (gui->drc_gui != NULL && fresh > 0)
+    gui->drc_gui->throw_drc_dialog ();
+}
+
+/*-----------------------------------------------------------------------------
+ * Check for DRC violations near the objects changed since the last call.
+ * The first call, or one after the undo list was cleared, a layer
+ * change or a change of the rules, checks the whole board.
+ * Returns the number of violations on the board.
+ */
+int
+DRCIncremental (void)
+{
+  Coord rules[5];
+  UndoChangeType *changes;
+  GArray *journal = NULL;
+  GArray *queue;
+  GHashTableIter iter;
+  gpointer key, value;
+  int n, i;
+  int old_flag = TheFlag;
+
+  rules[0] = PCB->Bloat;
+  rules[1] = PCB->minWid;
+  rules[2] = PCB->minSlk;
+  rules[3] = PCB->minDrill;
+  rules[4] = PCB->minRing;
+
+  changes = UndoChanges (&n);
+  if (drc_marks == NULL || drc_marks_pcb != PCB || changes == NULL
+      || memcmp (rules, drc_marks_rules, sizeof (rules)) != 0)
+    {
+      drc_marks_reset ();
+      ClearScratchFlag (DRCFLAG);
+      drc_marks_pcb = PCB;
+      memcpy (drc_marks_rules, rules, sizeof (rules));
+    }
+  else
+    {
+      journal = g_array_sized_new (FALSE, FALSE, sizeof (UndoChangeType), n);
+      g_array_append_vals (journal, changes, n);
+    }
+  UndoForgetChanges ();
+
+  g_hash_table_iter_init (&iter, drc_marks);
+  while (g_hash_table_iter_next (&iter, &key, &value))
+    ((DrcMarkType *) key)->is_new = false;
+
+  TheFlag = DRCFLAG;
+  User = false;
+  drc = false;
+  reassign_no_drc_flags ();
+  InitConnectionLookup ();
+  queue = g_array_new (FALSE, FALSE, sizeof (DrcQueueType));
+  if (journal == NULL)
+    {
+      drc_collect_all (queue);
+      drc_net_label_all ();
+    }
+  else
+    {
+      drc_collect_changes (queue, journal);
+      g_array_free (journal, TRUE);
+    }
+  for (i = 0; i < queue->len; i++)
+    {
+      DrcQueueType *q = &g_array_index (queue, DrcQueueType, i);
+
+      drc_check_object (q->type, q->ptr1, q->ptr2);
+    }
+  FreeConnectionLookupMemory ();
+  Bloat = 0;
+  TheFlag = old_flag;
+
+  g_array_free (queue, TRUE);
+
+  drc_report_marks ();
+  return g_hash_table_size (drc_marks);
+}
+
 /*----------------------------------------------------------------------------
  * Locate the coordinatates of offending item (thing)
  */
@@ -43,6 +43,14 @@
 #define SILK_TYPE	\
 	(LINE_TYPE | ARC_TYPE | POLYGON_TYPE)
 
+typedef struct			/* copper connected to a pin or pad */
+{
+  double length;		/* total length of lines and arcs */
+  Cardinal segments;		/* number of lines and arcs */
+  Cardinal vias;
+  bool found;			/* any lines or arcs at all */
+} ConnectionStatsType;
+
 bool LineLineIntersect (LineType *, LineType *);
 bool LineArcIntersect (LineType *, ArcType *);
 bool PinLineIntersect (PinType *, LineType *);
@@ -52,6 +60,7 @@ bool IsPolygonInPolygon (PolygonType *, PolygonType *);
 void LookupElementConnections (ElementType *, FILE *);
 void LookupConnectionsToAllElements (FILE *);
 void LookupConnection (Coord, Coord, bool, Coord, int);
+void MeasureConnections (Cardinal, int *, void **, ConnectionStatsType *);
 void LookupUnusedPins (FILE *);
 bool ResetFoundLinesAndPolygons (bool);
 bool ResetFoundPinsViasAndPads (bool);
@@ -66,6 +75,7 @@ void RatFindHook (int, void *, void *, void *, bool, bool);
 void SaveFindFlag (int);
 void RestoreFindFlag (void);
 int DRCAll (void);
+int DRCIncremental (void);
 bool lineClear (LineType *, Cardinal);
 bool IsLineInPolygon (LineType *, PolygonType *);
 bool IsArcInPolygon (ArcType *, PolygonType *);
@@ -116,10 +116,13 @@ typedef unsigned char BYTE;
    for now.  */
 typedef struct
 {
-  unsigned long f;		/* generic flags */
-  unsigned char t[(MAX_LAYER + 1) / 2];	/* thermals */
+  unsigned int f;		/* generic flags */
+  unsigned int t;		/* thermal pattern, see GetFlagThermal() */
 } FlagType;
 
+int GetFlagThermal (const FlagType *, int);
+void SetFlagThermal (FlagType *, int, int);
+
 #ifndef __GNUC__
 #define __FUNCTION1(a,b) a ":" #b
 #define __FUNCTION2(a,b) __FUNCTION1(a,b)
@@ -169,7 +172,7 @@ typedef struct
    first fields, either directly or through ANYLINEFIELDS.  */
 #define ANYOBJECTFIELDS			\
 	BoxType		BoundingBox;	\
-	long int	ID;		\
+	int		ID;		\
 	FlagType	Flags;		\
 	//	struct LibraryEntryType *net
 
@@ -194,14 +197,21 @@ OutputType;
 
 /* ----------------------------------------------------------------------
  * layer group. A layer group identifies layers which are always switched
- * on/off together.
+ * on/off together.  Every layer belongs to at most one group, so the
+ * members of all groups are kept in one list, group after group; First
+ * is where a group's members start.  Use GROUP_ENTRY() to read them and
+ * the functions in misc.c to change them.
  */
 typedef struct
 {
   Cardinal Number[MAX_LAYER],	/* number of entries per groups */
-    Entries[MAX_LAYER][MAX_LAYER + 2];
+    First[MAX_LAYER],		/* index of a group's first entry */
+    Entries[MAX_LAYER + 2];	/* the layers of all groups */
 } LayerGroupType;
 
+#define GROUP_ENTRY(lg, group, entry) \
+	((lg)->Entries[(lg)->First[(group)] + (entry)])
+
 struct BoxType		/* a bounding box */
 {
   Coord X1, Y1;		/* upper left */
@@ -239,7 +249,7 @@ typedef struct {
 typedef struct			/* a line/polygon point */
 {
   Coord X, Y, X2, Y2;	/* so Point type can be cast as BoxType */
-  long int ID;
+  int ID;
 } PointType;
 
 /* Lines, rats, pads, etc.  */
@@ -484,7 +494,7 @@ typedef struct
    */
 typedef struct PCBType
 {
-  long ID;			/* see macro.h */
+  int ID;			/* see macro.h */
   FlagType Flags;
   char *Name,			/* name of board */
    *Filename,			/* name of file (from load) */
@@ -652,6 +662,7 @@ typedef struct			/* some resources... */
     Mode,			/* currently active mode */
     BufferNumber;		/* number of the current buffer */
   int BackupInterval;		/* time between two backups in seconds */
+  int UndoMemory;		/* undo memory budget in kB, 0 for no limit */
   char *DefaultLayerName[MAX_LAYER], *FontCommand,	/* commands for file loading... */
    *FileCommand, *ElementCommand, *PrintFile, *LibraryCommandDir, *LibraryCommand, *LibraryContentsCommand, *LibraryTree,	/* path to library tree */
    *SaveCommand, *LibraryFilename, *FontFile,	/* name of default font file */
@@ -804,6 +815,7 @@ struct drc_violation_st
 #define	UNDO_LAYERCHANGE	       0x20000	/* layer new/delete/move */
 #define	UNDO_CLEAR		       0x40000	/* clear/restore to polygons */
 #define	UNDO_NETLISTCHANGE	       0x80000	/* netlist change */
+#define	UNDO_BULK		      0x100000	/* one of the above on many objects */
 
 
 /* ---------------------------------------------------------------------------
@@ -7,6 +7,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/types.h>
+#ifndef WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
 
 #include "global.h"
 #include "hid.h"
@@ -33,6 +41,34 @@ typedef struct hid_gc_struct
   int nothing_interesting_here;
 } hid_gc_struct;
 
+static char *socket_path = NULL;
+
+HID_Attribute batch_attribute_list[] = {
+/* %start-doc options "23 batch GUI Options"
+@ftable @code
+@item --socket <string>
+Instead of reading actions from standard input, listen on the named
+UNIX-domain socket and serve requests until a @code{Quit} action is
+received.  Each request is a single line holding an action string.
+For each request the server replies with a line @samp{@var{status}
+@var{length}}, followed by @var{length} bytes of output produced by the
+actions.  @var{status} is zero on success.  A request line longer than
+4095 bytes, not counting its newline, is not run; its reply has status
+1 and an error message.  @code{Quit} is answered before the server
+exits and removes the socket.  The socket is only accessible to its
+owner.  An existing socket at the path is replaced, but anything else
+there makes the server refuse to start.  The loaded board, the footprint library and all settings stay
+resident between requests and between connections.
+@end ftable
+%end-doc
+*/
+  {"socket", "Serve actions on this UNIX-domain socket",
+   HID_String, 0, 0, {0, 0, 0}, 0, &socket_path},
+#define HA_socket 0
+};
+
+REGISTER_ATTRIBUTES (batch_attribute_list)
+
 static HID_Attribute *
 batch_get_export_options (int *n_ret)
 {
@@ -88,11 +124,11 @@ info (int argc, char **argv, Coord x, Coord y)
 	 PCB->MaxWidth, PCB->MaxHeight);
   cg = GetLayerGroupNumberByNumber (component_silk_layer);
   sg = GetLayerGroupNumberByNumber (solder_silk_layer);
-  for (i=0; i<MAX_LAYER; i++)
+  for (i=0; i<max_copper_layer + 2; i++)
     {
       
       int lg = GetLayerGroupNumberByNumber (i);
-      for (j=0; j<MAX_LAYER; j++)
+      for (j=0; j<max_group; j++)
 	putchar(j==lg ? '#' : '-');
       printf(" %c %s\n", lg==cg ? 'c' : lg==sg ? 's' : '-',
 	     PCB->Data->Layer[i].Name);
@@ -117,12 +153,216 @@ REGISTER_ACTIONS (batch_action_list)
 
 /* ----------------------------------------------------------------------------- */
 
+#ifndef WIN32
+/* Writes all of BUF to FD.  Returns zero on success.  */
+static int
+write_all (int fd, const char *buf, size_t len)
+{
+  ssize_t n;
+
+  while (len > 0)
+    {
+      n = write (fd, buf, len);
+      if (n < 0 && errno == EINTR)
+	continue;
+      if (n <= 0)
+	return -1;
+      buf += n;
+      len -= n;
+    }
+  return 0;
+}
+
+/* State of the request being served, kept where batch_serve_exit()
+   can find it.  */
+static const char *serve_path = NULL;
+static int serve_client = -1;	/* client whose request is running */
+static FILE *serve_out = NULL;	/* the request's captured output */
+static int serve_stdout = -1;	/* the real standard output */
+
+/* Sends STATUS and the output captured in serve_out to the client, and
+   puts standard output back.  Returns zero if the reply was sent.  */
+static int
+finish_request (int status)
+{
+  char reply[64], buf[4096];
+  FILE *out = serve_out;
+  long len;
+  size_t n;
+  int rc = 0;
+
+  fflush (stdout);
+  dup2 (serve_stdout, 1);
+  close (serve_stdout);
+  serve_out = NULL;
+
+  len = ftell (out);
+  rewind (out);
+  sprintf (reply, "%d %ld\n", status, len < 0 ? 0 : len);
+  if (write_all (serve_client, reply, strlen (reply)))
+    rc = -1;
+  while (rc == 0 && (n = fread (buf, 1, sizeof (buf), out)) > 0)
+    if (write_all (serve_client, buf, n))
+      rc = -1;
+  fclose (out);
+  return rc;
+}
+
+/* Runs one request line with standard output redirected into a
+   temporary file, then sends the status line and the captured output
+   to the client.  Returns zero if the reply was sent.  */
+static int
+serve_request (int client, const char *line)
+{
+  int status;
+
+  if ((serve_out = tmpfile ()) == NULL)
+    return -1;
+
+  fflush (stdout);
+  serve_stdout = dup (1);
+  dup2 (fileno (serve_out), 1);
+  serve_client = client;
+  status = hid_parse_command (line);
+  return finish_request (status);
+}
+
+/* Answers a request without running it.  */
+static int
+refuse_request (int client, const char *why)
+{
+  char reply[64];
+
+  sprintf (reply, "1 %ld\n", (long) strlen (why));
+  if (write_all (client, reply, strlen (reply))
+      || write_all (client, why, strlen (why)))
+    return -1;
+  return 0;
+}
+
+/* Registered with atexit().  Quit, and any other action that exits,
+   does so in the middle of a request: answer it, with status zero,
+   before the connection goes away, and remove the socket.  */
+static void
+batch_serve_exit (void)
+{
+  if (serve_out != NULL)
+    {
+      finish_request (0);
+      close (serve_client);
+    }
+  unlink (serve_path);
+}
+
+/* Serves clients on the --socket path, one connection at a time, until
+   an action exits the program.  */
+static void
+batch_serve (const char *path)
+{
+  struct sockaddr_un addr;
+  struct stat st;
+  char line[4095 + 2];		/* the longest request, newline and NUL */
+  FILE *in;
+  mode_t mask;
+  int sock, client, c, rc;
+
+  if (strlen (path) >= sizeof (addr.sun_path))
+    {
+      fprintf (stderr, "batch: socket path %s is too long\n", path);
+      exit (1);
+    }
+
+  if ((sock = socket (AF_UNIX, SOCK_STREAM, 0)) < 0)
+    {
+      perror ("batch: socket");
+      exit (1);
+    }
+
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, path);
+
+  /* only a stale socket is ours to remove */
+  if (lstat (path, &st) == 0)
+    {
+      if (!S_ISSOCK (st.st_mode))
+	{
+	  fprintf (stderr, "batch: %s exists and is not a socket\n", path);
+	  exit (1);
+	}
+      unlink (path);
+    }
+
+  mask = umask (077);
+  rc = bind (sock, (struct sockaddr *) &addr, sizeof (addr));
+  umask (mask);
+  if (rc < 0 || listen (sock, 5) < 0)
+    {
+      fprintf (stderr, "batch: can't listen on %s: %s\n", path,
+	       strerror (errno));
+      exit (1);
+    }
+  serve_path = path;
+  atexit (batch_serve_exit);
+
+  /* A client going away mid-reply must not take the server down.  */
+  signal (SIGPIPE, SIG_IGN);
+
+  while (1)
+    {
+      if ((client = accept (sock, NULL, NULL)) < 0)
+	{
+	  if (errno == EINTR)
+	    continue;
+	  perror ("batch: accept");
+	  break;
+	}
+      if ((in = fdopen (client, "r")) == NULL)
+	{
+	  close (client);
+	  continue;
+	}
+      while (fgets (line, sizeof (line), in) != NULL)
+	{
+	  /* a request that does not fit is refused whole, not run in
+	     pieces; only the last line may lack its newline */
+	  if (strchr (line, '\n') == NULL && !feof (in))
+	    {
+	      while ((c = getc (in)) != EOF && c != '\n')
+		;
+	      if (refuse_request (client, "batch: request line too long\n"))
+		break;
+	      continue;
+	    }
+	  if (serve_request (client, line))
+	    break;
+	}
+      fclose (in);
+    }
+
+  close (sock);
+}
+#else
+static void
+batch_serve (const char *path)
+{
+  fprintf (stderr, "batch: --socket is not supported on this platform\n");
+  exit (1);
+}
+#endif
+
 static void
 batch_do_export (HID_Attr_Val * options)
 {
   int interactive;
   char line[1000];
 
+  if (socket_path && *socket_path)
+    {
+      batch_serve (socket_path);
+      return;
+    }
+
   if (isatty (0))
     interactive = 1;
   else
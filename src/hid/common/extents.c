@@ -35,7 +35,7 @@ extents_set_layer (const char *name, int group, int empty)
   int idx = group;
   if (idx >= 0 && idx < max_group)
     {
-      idx = PCB->LayerGroups.Entries[idx][0];
+      idx = GROUP_ENTRY (&PCB->LayerGroups, idx, 0);
     }
   if (idx >= 0 && idx < max_copper_layer + 2)
     return 1;
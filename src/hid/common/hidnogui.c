@@ -45,16 +45,16 @@ nogui_parse_arguments (int *argc, char ***argv)
   CRASH;
 }
 
+/* Actions run from --action-string redraw what they change, but
+   there is no screen to update.  */
 static void
 nogui_invalidate_lr (int l, int r, int t, int b)
 {
-  CRASH;
 }
 
 static void
 nogui_invalidate_all (void)
 {
-  CRASH;
 }
 
 static int
@@ -499,7 +499,11 @@ gcode_do_export (HID_Attr_Val * options)
       snprintf (variable_drilldepth, 20, "%f", gcode_drilldepth);
     }
 
-  for (i = 0; i < MAX_LAYER; i++)
+  /* Unlike the Gerber exporter, this loop stays in one process: every
+     group is rendered into a full-board bitmap at gcode_dpi and copied
+     again for potrace, so a worker per group would multiply the
+     largest allocation of the export by the number of workers.  */
+  for (i = 0; i < max_group; i++)
     {
       if (gcode_export_group[i])
         {
@@ -507,7 +511,7 @@ gcode_do_export (HID_Attr_Val * options)
 
           /* magic */
           idx = (i >= 0 && i < max_group) ?
-            PCB->LayerGroups.Entries[i][0] : i;
+            GROUP_ENTRY (&PCB->LayerGroups, i, 0) : i;
           is_solder =
             (GetLayerGroupNumberByNumber (idx) ==
              GetLayerGroupNumberByNumber (solder_silk_layer)) ? 1 : 0;
@@ -732,7 +736,7 @@ static int
 gcode_set_layer (const char *name, int group, int empty)
 {
   int idx = (group >= 0 && group < max_group) ?
-    PCB->LayerGroups.Entries[group][0] : group;
+    GROUP_ENTRY (&PCB->LayerGroups, group, 0) : group;
 
   if (name == 0)
     {
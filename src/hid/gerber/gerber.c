@@ -16,6 +16,10 @@
 #include <pwd.h>
 #endif
 
+#ifdef HAVE_SYS_WAIT_H
+#include <sys/wait.h>
+#endif
+
 #include <time.h>
 
 #include "config.h"
@@ -90,6 +94,15 @@ static int copy_outline_mode;
 static int name_style;
 static LayerType *outline_layer;
 
+/* Files are written by export_jobs processes; this one is number
+   export_worker.  If fewer could be started, worker 0 also writes
+   the share of the ones that are missing.  */
+static int export_jobs = 1;
+static int export_worker = 0;
+static int export_running = 1;
+static int export_failed;
+static int skip_group;
+
 enum ApertureShape
 {
   ROUND,			/* Shaped like a circle */
@@ -118,6 +131,7 @@ typedef struct
 {
   Aperture *data;
   int count;
+  GHashTable *table;		/* the same apertures, keyed by width/shape */
 } ApertureList;
 
 static ApertureList *layer_aptr_list;
@@ -143,12 +157,28 @@ int n_pending_drills = 0, max_pending_drills = 0;
 /* Aperture Routines                                                          */
 /*----------------------------------------------------------------------------*/
 
+static guint
+aperture_hash (gconstpointer key)
+{
+  const Aperture *app = (const Aperture *) key;
+  return (guint) app->width * 7 + (guint) app->shape;
+}
+
+static gboolean
+aperture_equal (gconstpointer a, gconstpointer b)
+{
+  const Aperture *pa = (const Aperture *) a;
+  const Aperture *pb = (const Aperture *) b;
+  return pa->width == pb->width && pa->shape == pb->shape;
+}
+
 /* Initialize aperture list */
 static void
 initApertureList (ApertureList *list)
 {
   list->data = NULL;
   list->count = 0;
+  list->table = NULL;
 }
 
 static void
@@ -162,6 +192,8 @@ deinitApertureList (ApertureList *list)
       free(search);
       search = next;
     }
+  if (list->table)
+    g_hash_table_destroy (list->table);
   initApertureList (list);
 }
 
@@ -192,8 +224,13 @@ addAperture (ApertureList *list, Coord width, ApertureShape shape)
   app->dCode = DCODE_BASE + aperture_count++;
   app->next  = list->data;
 
+  /* The list keeps the order the apertures are written out in,
+     the table finds them again while drawing.  */
   list->data = app;
   ++list->count;
+  if (list->table == NULL)
+    list->table = g_hash_table_new (aperture_hash, aperture_equal);
+  g_hash_table_insert (list->table, app, app);
 
   return app;
 }
@@ -203,16 +240,21 @@ addAperture (ApertureList *list, Coord width, ApertureShape shape)
 static Aperture *
 findAperture (ApertureList *list, Coord width, ApertureShape shape)
 {
-  Aperture *search;
+  Aperture key, *search;
 
   /* we never draw zero-width lines */
   if (width == 0)
     return NULL;
 
   /* Search for an appropriate aperture. */
-  for (search = list->data; search; search = search->next)
-    if (search->width == width && search->shape == shape)
-      return search;
+  if (list->table != NULL)
+    {
+      key.width = width;
+      key.shape = shape;
+      search = (Aperture *) g_hash_table_lookup (list->table, &key);
+      if (search != NULL)
+        return search;
+    }
 
   /* Failing that, create a new one */
   return addAperture (list, width, shape);
@@ -304,6 +346,73 @@ static int print_group[MAX_LAYER];
 static int print_layer[MAX_LAYER];
 static int lastX, lastY;	/* the last X and Y coordinate */
 
+/* Drawing output is collected here and handed to stdio in large
+   pieces, formatted by hand; going through pcb_fprintf for every
+   coordinate costs more than the rest of the export.  */
+static char out_buf[8192];
+static int out_len = 0;
+
+static void
+out_flush (void)
+{
+  if (out_len > 0 && f)
+    fwrite (out_buf, 1, out_len, f);
+  out_len = 0;
+}
+
+static void
+out_string (const char *str)
+{
+  while (*str)
+    {
+      if (out_len == sizeof (out_buf))
+	out_flush ();
+      out_buf[out_len++] = *str++;
+    }
+}
+
+static void
+out_int (long long value)
+{
+  char digits[24];
+  int n = 0;
+  unsigned long long u = value < 0 ? - (unsigned long long) value : value;
+
+  if (out_len + (int) sizeof (digits) > (int) sizeof (out_buf))
+    out_flush ();
+  if (value < 0)
+    out_buf[out_len++] = '-';
+  do
+    {
+      digits[n++] = '0' + u % 10;
+      u /= 10;
+    }
+  while (u);
+  while (n)
+    out_buf[out_len++] = digits[--n];
+}
+
+/* Writes AXIS followed by VALUE in centimils, exactly as
+   pcb_fprintf's "%.0mc" would: the same double is rounded the way
+   printf rounds it, including the "-0" it prints for small negative
+   values.  */
+static void
+out_coord (char axis, Coord value)
+{
+  double cmil = rint (COORD_TO_MIL (value) * 100);
+  char prefix[3];
+
+  prefix[0] = axis;
+  prefix[1] = prefix[2] = 0;
+  if (signbit (cmil))
+    {
+      prefix[1] = '-';
+      cmil = -cmil;
+    }
+  out_string (prefix);
+  out_int ((long long) cmil);
+}
+
 static const char *copy_outline_names[] = {
 #define COPY_OUTLINE_NONE 0
   "none",
@@ -355,7 +464,8 @@ Output contains all layers, even empty ones.
 /* %start-doc options "90 Gerber Export"
 @ftable @code
 @item --verbose
-Print file names and aperture counts on stdout.
+Print file names and aperture counts on stdout, once each file is
+open.  With several @code{--jobs} the lines may come out of order.
 @end ftable
 %end-doc
 */
@@ -368,6 +478,19 @@ Print file names and aperture counts on stdout.
   {"name-style", "Naming style for individual gerber files",
    HID_Enum, 0, 0, {0, 0, 0}, name_style_names, 0},
 #define HA_name_style 4
+
+/* %start-doc options "90 Gerber Export"
+@ftable @code
+@item --jobs <num>
+Number of processes writing layer files at the same time.  The
+default, 0, uses one per processor when exporting from the command
+line; exports started from the GUI always use one.
+@end ftable
+%end-doc
+*/
+  {"jobs", "Number of processes writing files (0 = one per processor)",
+   HID_Integer, 0, 64, {0, 0, 0}, 0, 0},
+#define HA_jobs 5
 };
 
 #define NUM_OPTIONS (sizeof(gerber_options)/sizeof(gerber_options[0]))
@@ -410,11 +533,16 @@ maybe_close_f (FILE *f)
 {
   if (f)
     {
+      out_flush ();
       if (was_drill)
 	fprintf (f, "M30\r\n");
       else
 	fprintf (f, "M02*\r\n");
-      fclose (f);
+      if (fclose (f) != 0)
+	{
+	  Message ("Error:  Could not write %s.\n", filename);
+	  export_failed = 1;
+	}
     }
 }
 
@@ -504,6 +632,88 @@ assign_file_suffix (char *dest, int idx)
   strcat (dest, sext);
 }
 
+/* Whether this process writes the file numbered PAGE.  Files are
+   dealt out to the workers in turn.  */
+static int
+owns_page (int page)
+{
+  int w = page % export_jobs;
+  if (export_worker == 0)
+    return w == 0 || w >= export_running;
+  return w == export_worker;
+}
+
+static int
+jobs_wanted (int jobs)
+{
+  /* The GUI may have threads of its own, which do not survive
+     fork() well.  */
+  if (gui != &gerber_hid)
+    return 1;
+#if defined(HAVE_SYS_WAIT_H) && defined(_SC_NPROCESSORS_ONLN)
+  if (jobs <= 0)
+    jobs = sysconf (_SC_NPROCESSORS_ONLN);
+#endif
+  return jobs < 1 ? 1 : jobs;
+}
+
+/* Splits the export into worker processes, once the apertures are
+   known everywhere.  Every worker walks the whole board and keeps
+   the same counters, but only opens the files it owns, so the
+   output is the same as when one process writes them all.  Returns
+   in every process.  */
+static void
+start_workers (int jobs)
+{
+  export_jobs = jobs;
+  export_worker = 0;
+  export_running = 1;
+  export_failed = 0;
+#ifdef HAVE_SYS_WAIT_H
+  fflush (NULL);
+  for (; export_running < export_jobs; export_running++)
+    {
+      pid_t pid = fork ();
+      if (pid < 0)
+	break;
+      if (pid == 0)
+	{
+	  export_worker = export_running;
+	  return;
+	}
+    }
+#else
+  export_jobs = 1;
+#endif
+}
+
+/* Called by every worker when its part is done.  Workers other than
+   0 exit here, with status 1 if a file of theirs could not be written;
+   worker 0 waits for them and reports those that failed.  */
+static void
+finish_workers (void)
+{
+#ifdef HAVE_SYS_WAIT_H
+  int status;
+
+  if (export_worker != 0)
+    {
+      maybe_close_f (f);
+      fflush (NULL);
+      _exit (export_failed ? 1 : 0);
+    }
+  while (export_running > 1)
+    {
+      if (wait (&status) < 0)
+	break;
+      if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+	Message ("Error:  a Gerber export process failed.\n");
+      export_running--;
+    }
+#endif
+  export_jobs = export_running = 1;
+}
+
 static void
 gerber_do_export (HID_Attr_Val * options)
 {
@@ -599,7 +809,9 @@ gerber_do_export (HID_Attr_Val * options)
 
   layer_list_idx = 0;
   finding_apertures = 0;
+  start_workers (jobs_wanted (options[HA_jobs].int_value));
   hid_expose_callback (&gerber_hid, &region, 0);
+  finish_workers ();
 
   memcpy (LayerStack, saved_layer_stack, sizeof (LayerStack));
 
@@ -635,7 +847,9 @@ gerber_set_layer (const char *name, int group, int empty)
   char *cp;
   int idx = (group >= 0
 	     && group <
-	     max_group) ? PCB->LayerGroups.Entries[group][0] : group;
+	     max_group) ? GROUP_ENTRY (&PCB->LayerGroups, group, 0) : group;
+
+  out_flush ();
 
   if (name == NULL)
     name = PCB->Data->Layer[idx].Name;
@@ -696,6 +910,7 @@ gerber_set_layer (const char *name, int group, int empty)
       Aperture *search;
 
       lastgroup = group;
+      skip_group = 0;
       lastX = -1;
       lastY = -1;
       linewidth = -1;
@@ -714,22 +929,34 @@ gerber_set_layer (const char *name, int group, int empty)
 
       pagecount++;
       assign_file_suffix (filesuff, idx);
+
+      if (!owns_page (pagecount))
+	{
+	  skip_group = 1;
+	  return 0;
+	}
+
       f = fopen (filename, "wb");   /* Binary needed to force CR-LF */
       if (f == NULL) 
 	{
 	  Message ( "Error:  Could not open %s for writing.\n", filename);
-	  return 1;
+	  export_failed = 1;
+	  skip_group = 1;
+	  return 0;
 	}
 
-      was_drill = is_drill;
-
+      /* Each worker reports the files it writes, a whole line at a
+	 time, so with several workers the lines may come out of order.  */
       if (verbose)
 	{
 	  int c = aptr_list->count;
 	  printf ("Gerber: %d aperture%s in %s\n", c,
 		  c == 1 ? "" : "s", filename);
+	  fflush (stdout);
 	}
 
+      was_drill = is_drill;
+
       if (is_drill)
 	{
 	  /* We omit the ,TZ here because we are not omitting trailing zeros.  Our format is
@@ -801,6 +1028,9 @@ gerber_set_layer (const char *name, int group, int empty)
     }
 
  emit_outline:
+  if (skip_group)
+    return 0;
+
   /* If we're printing a copper layer other than the outline layer,
      and we want to "print outlines", and we have an outline layer,
      print the outline layer on this layer also.  */
@@ -920,7 +1150,11 @@ use_gc (hidGC gc, int radius)
 	  if (aptr == NULL)
 	    pcb_fprintf (stderr, "error: aperture for radius %$mS type ROUND is null\n", radius);
 	  else if (f && !is_drill)
-	    fprintf (f, "G54D%d*", aptr->dCode);
+	    {
+	      out_string ("G54D");
+	      out_int (aptr->dCode);
+	      out_string ("*");
+	    }
 	  linewidth = radius;
 	  lastcap = Round_Cap;
 	}
@@ -948,7 +1182,11 @@ use_gc (hidGC gc, int radius)
         pcb_fprintf (stderr, "error: aperture for width %$mS type %s is null\n",
                  linewidth, shape == ROUND ? "ROUND" : "SQUARE");
       else if (f)
-	fprintf (f, "G54D%d*", aptr->dCode);
+	{
+	  out_string ("G54D");
+	  out_int (aptr->dCode);
+	  out_string ("*");
+	}
     }
 }
 
@@ -996,32 +1234,32 @@ gerber_draw_line (hidGC gc, Coord x1, Coord y1, Coord x2, Coord y2)
     {
       m = true;
       lastX = x1;
-      pcb_fprintf (f, "X%.0mc", gerberX (PCB, lastX));
+      out_coord ('X', gerberX (PCB, lastX));
     }
   if (y1 != lastY)
     {
       m = true;
       lastY = y1;
-      pcb_fprintf (f, "Y%.0mc", gerberY (PCB, lastY));
+      out_coord ('Y', gerberY (PCB, lastY));
     }
   if ((x1 == x2) && (y1 == y2))
-    fprintf (f, "D03*\r\n");
+    out_string ("D03*\r\n");
   else
     {
       if (m)
-	fprintf (f, "D02*");
+	out_string ("D02*");
       if (x2 != lastX)
 	{
 	  lastX = x2;
-	  pcb_fprintf (f, "X%.0mc", gerberX (PCB, lastX));
+	  out_coord ('X', gerberX (PCB, lastX));
 	}
       if (y2 != lastY)
 	{
 	  lastY = y2;
-	  pcb_fprintf (f, "Y%.0mc", gerberY (PCB, lastY));
+	  out_coord ('Y', gerberY (PCB, lastY));
 
 	}
-      fprintf (f, "D01*\r\n");
+      out_string ("D01*\r\n");
     }
 
 }
@@ -1087,22 +1325,22 @@ gerber_draw_arc (hidGC gc, Coord cx, Coord cy, Coord width, Coord height,
     {
       m = true;
       lastX = arcStartX;
-      pcb_fprintf (f, "X%.0mc", gerberX (PCB, lastX));
+      out_coord ('X', gerberX (PCB, lastX));
     }
   if (arcStartY != lastY)
     {
       m = true;
       lastY = arcStartY;
-      pcb_fprintf (f, "Y%.0mc", gerberY (PCB, lastY));
+      out_coord ('Y', gerberY (PCB, lastY));
     }
   if (m)
-    fprintf (f, "D02*");
-  pcb_fprintf (f,
-	   "G75*G0%1dX%.0mcY%.0mcI%.0mcJ%.0mcD01*G01*\r\n",
-	   (delta_angle < 0) ? 2 : 3,
-	   gerberX (PCB, arcStopX), gerberY (PCB, arcStopY),
-	   gerberXOffset (PCB, cx - arcStartX),
-	   gerberYOffset (PCB, cy - arcStartY));
+    out_string ("D02*");
+  out_string ((delta_angle < 0) ? "G75*G02" : "G75*G03");
+  out_coord ('X', gerberX (PCB, arcStopX));
+  out_coord ('Y', gerberY (PCB, arcStopY));
+  out_coord ('I', gerberXOffset (PCB, cx - arcStartX));
+  out_coord ('J', gerberYOffset (PCB, cy - arcStartY));
+  out_string ("D01*G01*\r\n");
   lastX = arcStopX;
   lastY = arcStopY;
 }
@@ -1137,14 +1375,14 @@ gerber_fill_circle (hidGC gc, Coord cx, Coord cy, Coord radius)
   if (cx != lastX)
     {
       lastX = cx;
-      pcb_fprintf (f, "X%.0mc", gerberX (PCB, lastX));
+      out_coord ('X', gerberX (PCB, lastX));
     }
   if (cy != lastY)
     {
       lastY = cy;
-      pcb_fprintf (f, "Y%.0mc", gerberY (PCB, lastY));
+      out_coord ('Y', gerberY (PCB, lastY));
     }
-  fprintf (f, "D03*\r\n");
+  out_string ("D03*\r\n");
 }
 
 static void
@@ -1161,20 +1399,20 @@ gerber_fill_polygon (hidGC gc, int n_coords, Coord *x, Coord *y)
   use_gc (gc, 10 * 100);
   if (!f)
     return;
-  fprintf (f, "G36*\r\n");
+  out_string ("G36*\r\n");
   for (i = 0; i < n_coords; i++)
     {
       if (x[i] != lastX)
 	{
 	  m = true;
 	  lastX = x[i];
-	  pcb_fprintf (f, "X%.0mc", gerberX (PCB, lastX));
+	  out_coord ('X', gerberX (PCB, lastX));
 	}
       if (y[i] != lastY)
 	{
 	  m = true;
 	  lastY = y[i];
-	  pcb_fprintf (f, "Y%.0mc", gerberY (PCB, lastY));
+	  out_coord ('Y', gerberY (PCB, lastY));
 	}
       if (firstTime)
 	{
@@ -1182,27 +1420,27 @@ gerber_fill_polygon (hidGC gc, int n_coords, Coord *x, Coord *y)
 	  startX = x[i];
 	  startY = y[i];
 	  if (m)
-	    fprintf (f, "D02*");
+	    out_string ("D02*");
 	}
       else if (m)
-	fprintf (f, "D01*\r\n");
+	out_string ("D01*\r\n");
       m = false;
     }
   if (startX != lastX)
     {
       m = true;
       lastX = startX;
-      pcb_fprintf (f, "X%.0mc", gerberX (PCB, startX));
+      out_coord ('X', gerberX (PCB, startX));
     }
   if (startY != lastY)
     {
       m = true;
       lastY = startY;
-      pcb_fprintf (f, "Y%.0mc", gerberY (PCB, lastY));
+      out_coord ('Y', gerberY (PCB, lastY));
     }
   if (m)
-    fprintf (f, "D01*\r\n");
-  fprintf (f, "G37*\r\n");
+    out_string ("D01*\r\n");
+  out_string ("G37*\r\n");
 }
 
 static void
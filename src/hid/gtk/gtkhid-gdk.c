@@ -71,12 +71,12 @@ ghid_set_layer (const char *name, int group, int empty)
       int n = PCB->LayerGroups.Number[group];
       for (idx = 0; idx < n-1; idx ++)
 	{
-	  int ni = PCB->LayerGroups.Entries[group][idx];
+	  int ni = GROUP_ENTRY (&PCB->LayerGroups, group, idx);
 	  if (ni >= 0 && ni < max_copper_layer + 2
 	      && PCB->Data->Layer[ni].On)
 	    break;
 	}
-      idx = PCB->LayerGroups.Entries[group][idx];
+      idx = GROUP_ENTRY (&PCB->LayerGroups, group, idx);
     }
 
   if (idx >= 0 && idx < max_copper_layer + 2)
@@ -14,6 +14,7 @@
 #include "action.h"
 #include "crosshair.h"
 #include "error.h"
+#include "mymem.h"
 #include "../hidint.h"
 #include "gui.h"
 #include "hid/common/hidnogui.h"
@@ -1016,10 +1017,8 @@ ghid_attributes (char *owner, AttributeListType *attrs)
 	  /* Copy the values back */
 	  for (i=0; i<attributes_list->Number; i++)
 	    {
-	      if (attributes_list->List[i].name)
-		free (attributes_list->List[i].name);
-	      if (attributes_list->List[i].value)
-		free (attributes_list->List[i].value);
+	      StringRelease (attributes_list->List[i].name);
+	      StringRelease (attributes_list->List[i].value);
 	    }
 	  if (attributes_list->Max < attr_num_rows)
 	    {
@@ -1032,8 +1031,8 @@ ghid_attributes (char *owner, AttributeListType *attrs)
 	    }
 	  for (i=0; i<attr_num_rows; i++)
 	    {
-	      attributes_list->List[i].name = strdup (gtk_entry_get_text (GTK_ENTRY (attr_row[i].w_name)));
-	      attributes_list->List[i].value = strdup (gtk_entry_get_text (GTK_ENTRY (attr_row[i].w_value)));
+	      attributes_list->List[i].name = StringIntern (gtk_entry_get_text (GTK_ENTRY (attr_row[i].w_name)));
+	      attributes_list->List[i].value = StringIntern (gtk_entry_get_text (GTK_ENTRY (attr_row[i].w_value)));
 	      attributes_list->Number = attr_num_rows;
 	    }
 
@@ -1391,8 +1390,8 @@ SwapSides (int argc, char **argv, Coord x, Coord y)
   int active_group = GetLayerGroupNumberByNumber (LayerStack[0]);
   int comp_group = GetLayerGroupNumberByNumber (component_silk_layer);
   int solder_group = GetLayerGroupNumberByNumber (solder_silk_layer);
-  bool comp_on = LAYER_PTR (PCB->LayerGroups.Entries[comp_group][0])->On;
-  bool solder_on = LAYER_PTR (PCB->LayerGroups.Entries[solder_group][0])->On;
+  bool comp_on = LAYER_PTR (GROUP_ENTRY (&PCB->LayerGroups, comp_group, 0))->On;
+  bool solder_on = LAYER_PTR (GROUP_ENTRY (&PCB->LayerGroups, solder_group, 0))->On;
 
   if (argc > 0)
     {
@@ -1422,9 +1421,9 @@ SwapSides (int argc, char **argv, Coord x, Coord y)
     {
       bool new_solder_vis = Settings.ShowSolderSide;
 
-      ChangeGroupVisibility (PCB->LayerGroups.Entries[comp_group][0],
+      ChangeGroupVisibility (GROUP_ENTRY (&PCB->LayerGroups, comp_group, 0),
                              !new_solder_vis, !new_solder_vis);
-      ChangeGroupVisibility (PCB->LayerGroups.Entries[solder_group][0],
+      ChangeGroupVisibility (GROUP_ENTRY (&PCB->LayerGroups, solder_group, 0),
                              new_solder_vis, new_solder_vis);
     }
 
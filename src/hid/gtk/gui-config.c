@@ -1365,7 +1365,7 @@ make_layer_group_string (LayerGroupType * lg)
 	continue;
       for (entry = 0; entry < lg->Number[group]; entry++)
 	{
-	  layer = lg->Entries[group][entry];
+	  layer = GROUP_ENTRY (lg, group, entry);
 	  if (layer == component_silk_layer)
 	    string = g_string_append (string, "c");
 	  else if (layer == solder_silk_layer)
@@ -1388,6 +1388,7 @@ config_layers_apply (void)
   LayerType *layer;
   gchar *s;
   gint group, i;
+  gint group_of_layer[MAX_LAYER + 2];
   gint componentgroup = 0, soldergroup = 0;
   gboolean use_as_default = FALSE, layers_modified = FALSE;
 
@@ -1421,21 +1422,18 @@ config_layers_apply (void)
 
   if (groups_modified)		/* If any group radio buttons were toggled. */
     {
-      /* clear all entries and read layer by layer
+      /* rebuild the groups from the group of each layer
        */
-      for (group = 0; group < max_group; group++)
-	layer_groups.Number[group] = 0;
-
       for (i = 0; i < max_copper_layer + 2; i++)
 	{
-	  group = config_layer_group[i] - 1;
-	  layer_groups.Entries[group][layer_groups.Number[group]++] = i;
+	  group = group_of_layer[i] = config_layer_group[i] - 1;
 
 	  if (i == component_silk_layer)
 	    componentgroup = group;
 	  else if (i == solder_silk_layer)
 	    soldergroup = group;
 	}
+      SetLayerGroups (&layer_groups, group_of_layer, max_copper_layer + 2);
 
       /* do some cross-checking
          |  top-side and bottom-side must be in different groups
@@ -1483,11 +1481,11 @@ config_layer_group_button_state_update (void)
   for (g = 0; g < max_group; g++)
     for (i = 0; i < layer_groups.Number[g]; i++)
       {
-/*			printf("layer %d in group %d\n", layer_groups.Entries[g][i], g +1); */
-	config_layer_group[layer_groups.Entries[g][i]] = g + 1;
+/*			printf("layer %d in group %d\n", GROUP_ENTRY (&layer_groups, g, i), g +1); */
+	config_layer_group[GROUP_ENTRY (&layer_groups, g, i)] = g + 1;
 	gtk_toggle_button_set_active (GTK_TOGGLE_BUTTON
 				      (group_button
-				       [layer_groups.Entries[g][i]][g]),
+				       [GROUP_ENTRY (&layer_groups, g, i)][g]),
 				      TRUE);
       }
   groups_holdoff = FALSE;
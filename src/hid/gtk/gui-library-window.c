@@ -59,6 +59,7 @@
 #include "global.h"
 #include "buffer.h"
 #include "data.h"
+#include "libindex.h"
 #include "set.h"
 
 #include <gdk/gdkkeysyms.h>
@@ -213,7 +214,8 @@ static GObjectClass *library_window_parent_class = NULL;
 /*! \brief Determines visibility of items of the library treeview.
  *  \par Function Description
  *  This is the function used to filter entries of the footprint
- *  selection tree.
+ *  selection tree.  The matches are looked up in the sets
+ *  library_window_filter_timeout() got from the library index.
  *
  *  \param [in] model The current selection in the treeview.
  *  \param [in] iter  An iterator on a footprint or folder in the tree.
@@ -225,27 +227,32 @@ lib_model_filter_visible_func (GtkTreeModel * model,
 			       GtkTreeIter * iter, gpointer data)
 {
   GhidLibraryWindow *library_window = (GhidLibraryWindow *) data;
-  const gchar *compname;
-  gchar *compname_upper, *text_upper, *pattern;
-  const gchar *text;
+  LibraryMenuType *menu;
+  LibraryEntryType *entry;
   gboolean ret;
 
   g_assert (GHID_IS_LIBRARY_WINDOW (data));
 
-  text = gtk_entry_get_text (library_window->entry_filter);
-  if (g_ascii_strcasecmp (text, "") == 0)
+  if (library_window->filter_entries == NULL)
     {
       return TRUE;
     }
 
-  /* If this is a source, only display it if it has children that
+  gtk_tree_model_get (model, iter, MENU_LIBRARY_COLUMN, &menu,
+		      MENU_ENTRY_COLUMN, &entry, -1);
+  if (entry != NULL)
+    return g_hash_table_lookup (library_window->filter_entries, entry) != NULL;
+  if (menu != NULL)
+    return g_hash_table_lookup (library_window->filter_menus, menu) != NULL;
+
+  /* This is a source, only display it if it has children that
    * match */
+  ret = FALSE;
   if (gtk_tree_model_iter_has_child (model, iter))
     {
       GtkTreeIter iter2;
 
       gtk_tree_model_iter_children (model, &iter2, iter);
-      ret = FALSE;
       do
 	{
 	  if (lib_model_filter_visible_func (model, &iter2, data))
@@ -256,21 +263,51 @@ lib_model_filter_visible_func (GtkTreeModel * model,
 	}
       while (gtk_tree_model_iter_next (model, &iter2));
     }
-  else
+
+  return ret;
+}
+
+/*! \brief Forgets the matches of the last filter text. */
+static void
+library_window_filter_clear (GhidLibraryWindow * library_window)
+{
+  if (library_window->filter_entries != NULL)
     {
-      gtk_tree_model_get (model, iter, MENU_NAME_COLUMN, &compname, -1);
-      /* Do a case insensitive comparison, converting the strings
-         to uppercase */
-      compname_upper = g_ascii_strup (compname, -1);
-      text_upper = g_ascii_strup (text, -1);
-      pattern = g_strconcat ("*", text_upper, "*", NULL);
-      ret = g_pattern_match_simple (pattern, compname_upper);
-      g_free (compname_upper);
-      g_free (text_upper);
-      g_free (pattern);
+      g_hash_table_destroy (library_window->filter_entries);
+      g_hash_table_destroy (library_window->filter_menus);
+      library_window->filter_entries = NULL;
+      library_window->filter_menus = NULL;
     }
+}
 
-  return ret;
+/*! \brief Looks the filter text up in the library index.
+ *  \par Function Description
+ *  Collects the matching footprints and the menus holding them for
+ *  lib_model_filter_visible_func(); an empty text matches everything.
+ *  If no footprint contains the text, approximate matches are shown.
+ */
+static void
+library_window_filter_update (GhidLibraryWindow * library_window,
+			      const gchar * text)
+{
+  GArray *matches;
+  guint i;
+
+  library_window_filter_clear (library_window);
+  if (strcmp (text, "") == 0)
+    return;
+
+  library_window->filter_entries = g_hash_table_new (NULL, NULL);
+  library_window->filter_menus = g_hash_table_new (NULL, NULL);
+  matches = LibrarySearch (&Library, text, LIBRARY_MATCH_FUZZY);
+  for (i = 0; i < matches->len; i++)
+    {
+      LibraryMatchType *m = &g_array_index (matches, LibraryMatchType, i);
+
+      g_hash_table_insert (library_window->filter_entries, m->Entry, m);
+      g_hash_table_insert (library_window->filter_menus, m->Menu, m);
+    }
+  g_array_free (matches, TRUE);
 }
 
 
@@ -439,6 +476,7 @@ library_window_filter_timeout (gpointer data)
   if (model != NULL)
     {
       const gchar *text = gtk_entry_get_text (library_window->entry_filter);
+      library_window_filter_update (library_window, text);
       gtk_tree_model_filter_refilter ((GtkTreeModelFilter *) model);
       if (strcmp (text, "") != 0)
         {
@@ -732,6 +770,8 @@ create_lib_treeview (GhidLibraryWindow * library_window)
   library_window->entry_filter = GTK_ENTRY (entry);
   /* and init the event source for footprint filter */
   library_window->filter_timeout = 0;
+  library_window->filter_entries = NULL;
+  library_window->filter_menus = NULL;
 
   /* create the erase button for filter entry */
   button = GTK_WIDGET (g_object_new (GTK_TYPE_BUTTON,
@@ -879,6 +919,7 @@ library_window_finalize (GObject * object)
       g_source_remove (library_window->filter_timeout);
       library_window->filter_timeout = 0;
     }
+  library_window_filter_clear (library_window);
 
   G_OBJECT_CLASS (library_window_parent_class)->finalize (object);
 }
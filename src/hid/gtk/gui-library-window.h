@@ -52,6 +52,8 @@ struct _GhidLibraryWindow
   GtkEntry *entry_filter;
   GtkButton *button_clear;
   guint filter_timeout;
+  GHashTable *filter_menus;	/* menus and entries matching the filter */
+  GHashTable *filter_entries;
 };
 
 
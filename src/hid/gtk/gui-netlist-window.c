@@ -90,8 +90,8 @@ static LibraryMenuType *node_selected_net;
    |  code can control the net and node treeviews:
    |
    |	ghid_get_net_from_node_name gchar *node_name, gboolean enabled_only)
-   |		Given a node name (eg C101-1), walk through the nets in the net
-   |		data model and search each net for the given node_name.  If found
+   |		Given a node name (eg C101-1), look up its net in the core's
+   |		netlist index (NetlistFindNode() in netlist.c).  If found
    |		and enabled_only is true, make the net treeview scroll to and
    |		highlight (select) the found net.  Return the found net.
    |
@@ -320,6 +320,12 @@ enum
 static GtkTreeModel *net_model = NULL;
 static GtkTreeView *net_treeview;
 
+/* The row of each net (LibraryMenuType) in net_model, so a net found in
+   |  the netlist index can be selected without walking the model.  Tree
+   |  store iters stay valid while their rows exist.
+*/
+static GHashTable *net_iters = NULL;
+
 static gboolean		loading_new_netlist;
 
 static GtkTreeModel *
@@ -343,6 +349,11 @@ net_model_create (void)
   store = gtk_tree_store_new (N_NET_COLUMNS,
 			      G_TYPE_STRING, G_TYPE_STRING, G_TYPE_POINTER);
 
+  if (net_iters)
+    g_hash_table_destroy (net_iters);
+  net_iters = g_hash_table_new_full (NULL, NULL, NULL,
+                                     (GDestroyNotify) gtk_tree_iter_free);
+
   model = GTK_TREE_MODEL (store);
 
   /* Hash table stores GtkTreeRowReference for given path prefixes */
@@ -421,6 +432,7 @@ net_model_create (void)
 			NET_ENABLED_COLUMN, menu->flag ? "" : "*",
 			NET_NAME_COLUMN, path_segments[path_depth - 1],
 			NET_LIBRARY_COLUMN, menu, -1);
+    g_hash_table_insert (net_iters, menu, gtk_tree_iter_copy (&new_iter));
     g_strfreev (path_segments);
   }
   END_LOOP;
@@ -595,65 +607,17 @@ netlist_rip_up_cb (GtkWidget * widget, gpointer data)
 }
 
 /**/
-typedef struct {
-  LibraryEntryType *ret_val;
-  LibraryMenuType *node_net;
-  const gchar *node_name;
-  bool found;
-} node_get_node_from_name_state;
-
-static gboolean
-node_get_node_from_name_helper (GtkTreeModel *model, GtkTreePath *path,
-                                GtkTreeIter *iter, gpointer data)
-{
-  LibraryMenuType *net;
-  LibraryEntryType *node;
-  node_get_node_from_name_state *state = data;
-
-  gtk_tree_model_get (net_model, iter, NET_LIBRARY_COLUMN, &net, -1);
-  /* Ignore non-nets (category headers) */
-  if (net == NULL)
-    return FALSE;
-
-  /* Look for the node name in this net. */
-  for (node = net->Entry; node - net->Entry < net->EntryN; node++)
-    if (node->ListEntry && !strcmp (state->node_name, node->ListEntry))
-      {
-        state->node_net = net;
-        state->ret_val = node;
-        /* stop iterating */
-        state->found = TRUE;
-	return TRUE;
-      }
-  return FALSE;
-}
-
 LibraryEntryType *
 node_get_node_from_name (gchar * node_name, LibraryMenuType ** node_net)
 {
-  node_get_node_from_name_state state;
+  LibraryEntryType *node;
+  LibraryMenuType *net;
 
-  if (!node_name)
+  if ((net = NetlistFindNode (node_name, &node)) == NULL)
     return NULL;
-
-  /* Have to force the netlist window created because we need the treeview
-     |  models constructed to do the search.
-   */
-  ghid_netlist_window_create (gport);
-
-  /* Now walk through node entries of each net in the net model looking for
-     |  the node_name.
-   */
-  state.found = 0;
-  state.node_name = node_name;
-  gtk_tree_model_foreach (net_model, node_get_node_from_name_helper, &state);
-  if (state.found)
-    {
-      if (node_net)
-        *node_net = state.node_net;
-      return state.ret_val;
-    }
-  return NULL;
+  if (node_net)
+    *node_net = net;
+  return node;
 }
 /**/
 
@@ -840,61 +804,18 @@ ghid_netlist_window_show (GHidPort * out, gboolean raise)
     gtk_window_present(GTK_WINDOW(netlist_window));
 }
 
-struct ggnfnn_task {
-  gboolean enabled_only;
-  gchar *node_name;
-  LibraryMenuType *found_net;
-  GtkTreeIter iter;
-};
-
-static gboolean
-hunt_named_node (GtkTreeModel *model, GtkTreePath *path,
-                 GtkTreeIter *iter, gpointer data)
-{
-  struct ggnfnn_task *task = (struct ggnfnn_task *)data;
-  LibraryMenuType *net;
-  LibraryEntryType *node;
-  gchar *str;
-  gint j;
-  gboolean is_disabled;
-
-  /* We only want to inspect leaf nodes in the tree */
-  if (gtk_tree_model_iter_has_child (model, iter))
-    return FALSE;
-
-  gtk_tree_model_get (model, iter, NET_LIBRARY_COLUMN, &net, -1);
-  gtk_tree_model_get (model, iter, NET_ENABLED_COLUMN, &str, -1);
-  is_disabled = !strcmp (str, "*");
-  g_free (str);
-
-  /* Don't check net nodes of disabled nets. */
-  if (task->enabled_only && is_disabled)
-    return FALSE;
-
-  /* Look for the node name in this net. */
-  for (j = net->EntryN, node = net->Entry; j; j--, node++)
-    if (node->ListEntry && !strcmp (task->node_name, node->ListEntry))
-      {
-        task->found_net = net;
-        task->iter = *iter;
-        return TRUE;
-      }
-
-  return FALSE;
-}
-
 LibraryMenuType *
 ghid_get_net_from_node_name (gchar * node_name, gboolean enabled_only)
 {
   GtkTreePath *path;
-  struct ggnfnn_task task;
+  GtkTreeIter *iter;
+  LibraryMenuType *net;
 
   if (!node_name)
     return NULL;
 
   /* Have to force the netlist window created because we need the treeview
-     |  models constructed so we can find the LibraryMenuType pointer the
-     |  caller wants.
+     |  models constructed so we can highlight the net the caller wants.
    */
   ghid_netlist_window_create (gport);
 
@@ -902,30 +823,29 @@ ghid_get_net_from_node_name (gchar * node_name, gboolean enabled_only)
   if (netlist_window == NULL)
     return NULL;
 
-  task.enabled_only = enabled_only;
-  task.node_name = node_name;
-  task.found_net = NULL;
+  net = NetlistFindNode (node_name, NULL);
 
-  /* Now walk through node entries of each net in the net model looking for
-     |  the node_name.
-   */
-  gtk_tree_model_foreach (net_model, hunt_named_node, &task);
+  /* Don't report nets which are disabled. */
+  if (net == NULL || (enabled_only && !net->flag))
+    return NULL;
 
   /* We are asked to highlight the found net if enabled_only is TRUE.
      |  Set holdoff TRUE since this is just a highlight and user is not
      |  expecting normal select action to happen?  Or should the node
      |  treeview also get updated?  Original PCB code just tries to highlight.
    */
-  if (task.found_net && enabled_only)
+  if (enabled_only
+      && (iter = g_hash_table_lookup (net_iters, net)) != NULL)
     {
       selection_holdoff = TRUE;
-      path = gtk_tree_model_get_path (net_model, &task.iter);
+      path = gtk_tree_model_get_path (net_model, iter);
       gtk_tree_view_scroll_to_cell (net_treeview, path, NULL, TRUE, 0.5, 0.5);
       gtk_tree_selection_select_path (gtk_tree_view_get_selection
 				      (net_treeview), path);
+      gtk_tree_path_free (path);
       selection_holdoff = FALSE;
     }
-  return task.found_net;
+  return net;
 }
 
 /* PCB LookupConnection code in find.c calls this if it wants a node
@@ -14,6 +14,7 @@
 #include "data.h"
 #include "crosshair.h"
 #include "misc.h"
+#include "mymem.h"
 #include "pcb-printf.h"
 
 #include "hid.h"
@@ -1462,8 +1463,8 @@ lesstif_update_layer_groups ()
   for (i = 0; i < max_group; i++)
     for (j = 0; j < l->Number[i]; j++)
       {
-	sets[l->Entries[i][j]][i] = 1;
-	lg_setcol[l->Entries[i][j]] = i;
+	sets[GROUP_ENTRY (l, i, j)][i] = 1;
+	lg_setcol[GROUP_ENTRY (l, i, j)] = i;
       }
 
   lg_label_width = 0;
@@ -1960,10 +1961,8 @@ lesstif_attributes_dialog (char *owner, AttributeListType *attrs_list)
       /* Copy the values back */
       for (i=0; i<attributes_list->Number; i++)
 	{
-	  if (attributes_list->List[i].name)
-	    free (attributes_list->List[i].name);
-	  if (attributes_list->List[i].value)
-	    free (attributes_list->List[i].value);
+	  StringRelease (attributes_list->List[i].name);
+	  StringRelease (attributes_list->List[i].value);
 	}
       if (attributes_list->Max < attr_num_rows)
 	{
@@ -1976,8 +1975,8 @@ lesstif_attributes_dialog (char *owner, AttributeListType *attrs_list)
 	}
       for (i=0; i<attr_num_rows; i++)
 	{
-	  attributes_list->List[i].name = strdup (XmTextFieldGetString (attr_row[i].w_name));
-	  attributes_list->List[i].value = strdup (XmTextFieldGetString (attr_row[i].w_value));
+	  attributes_list->List[i].name = StringIntern (XmTextFieldGetString (attr_row[i].w_name));
+	  attributes_list->List[i].value = StringIntern (XmTextFieldGetString (attr_row[i].w_value));
 	  attributes_list->Number = attr_num_rows;
 	}
     }
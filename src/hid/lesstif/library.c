@@ -15,6 +15,7 @@
 #include "misc.h"
 #include "set.h"
 #include "buffer.h"
+#include "libindex.h"
 
 #include "hid.h"
 #include "../hidint.h"
@@ -29,45 +30,67 @@ static int n;
 #define stdarg(t,v) XtSetArg(args[n], t, v); n++
 
 static Widget library_dialog = 0;
-static Widget library_list, libnode_list;
+static Widget library_filter, library_list, libnode_list;
 
 static XmString *library_strings = 0;
 static XmString *libnode_strings = 0;
 static int last_pick = -1;
 
+/* What the lists show: all of the library, or the menus and entries
+   matching the filter text, best first.  */
+static GArray *filter_matches = 0;
+static int *shown_menus = 0;
+static LibraryEntryType **shown_entries = 0;
+
 static void
 pick_net (int pick)
 {
   LibraryMenuType *menu = Library.Menu + pick;
-  int i;
+  int i, count = 0;
 
   if (pick == last_pick)
     return;
   last_pick = pick;
 
+  if (shown_entries)
+    free (shown_entries);
+  shown_entries =
+    (LibraryEntryType **) malloc ((menu->EntryN + 1) * sizeof (LibraryEntryType *));
+  if (filter_matches)
+    {
+      for (i = 0; i < filter_matches->len; i++)
+	{
+	  LibraryMatchType *m = &g_array_index (filter_matches, LibraryMatchType, i);
+	  if (m->Menu == menu)
+	    shown_entries[count++] = m->Entry;
+	}
+    }
+  else
+    for (i = 0; i < menu->EntryN; i++)
+      shown_entries[count++] = menu->Entry + i;
+
   if (libnode_strings)
     free (libnode_strings);
-  libnode_strings = (XmString *) malloc (menu->EntryN * sizeof (XmString));
-  for (i = 0; i < menu->EntryN; i++)
-    libnode_strings[i] = XmStringCreatePCB (menu->Entry[i].ListEntry);
+  libnode_strings = (XmString *) malloc ((count + 1) * sizeof (XmString));
+  for (i = 0; i < count; i++)
+    libnode_strings[i] = XmStringCreatePCB (shown_entries[i]->ListEntry);
   n = 0;
   stdarg (XmNitems, libnode_strings);
-  stdarg (XmNitemCount, menu->EntryN);
+  stdarg (XmNitemCount, count);
   XtSetValues (libnode_list, args, n);
 }
 
 static void
 library_browse (Widget w, void *v, XmListCallbackStruct * cbs)
 {
-  pick_net (cbs->item_position - 1);
+  pick_net (shown_menus[cbs->item_position - 1]);
 }
 
 static void
 libnode_select (Widget w, void *v, XmListCallbackStruct * cbs)
 {
   char *args;
-  LibraryEntryType *e =
-    Library.Menu[last_pick].Entry + cbs->item_position - 1;
+  LibraryEntryType *e = shown_entries[cbs->item_position - 1];
 
   if (e->Template == (char *) -1)
     {
@@ -81,6 +104,71 @@ libnode_select (Widget w, void *v, XmListCallbackStruct * cbs)
     SetMode (PASTEBUFFER_MODE);
 }
 
+/* Fills the menu list from the filter matches, in the order of their
+   best entry, and shows the entries of the first menu.  */
+static void
+show_menus (void)
+{
+  int i, count = 0;
+
+  if (shown_menus)
+    free (shown_menus);
+  shown_menus = (int *) malloc ((Library.MenuN + 1) * sizeof (int));
+  if (filter_matches)
+    {
+      char *seen = (char *) calloc (Library.MenuN + 1, 1);
+
+      for (i = 0; i < filter_matches->len; i++)
+	{
+	  int pick = g_array_index (filter_matches, LibraryMatchType, i).Menu
+	    - Library.Menu;
+	  if (!seen[pick])
+	    {
+	      seen[pick] = 1;
+	      shown_menus[count++] = pick;
+	    }
+	}
+      free (seen);
+    }
+  else
+    for (i = 0; i < Library.MenuN; i++)
+      shown_menus[count++] = i;
+
+  last_pick = -1;
+  if (library_strings)
+    free (library_strings);
+  library_strings = (XmString *) malloc ((count + 1) * sizeof (XmString));
+  for (i = 0; i < count; i++)
+    library_strings[i] = XmStringCreatePCB (Library.Menu[shown_menus[i]].Name);
+  n = 0;
+  stdarg (XmNitems, library_strings);
+  stdarg (XmNitemCount, count);
+  XtSetValues (library_list, args, n);
+
+  if (count)
+    pick_net (shown_menus[0]);
+  else
+    {
+      n = 0;
+      stdarg (XmNitemCount, 0);
+      XtSetValues (libnode_list, args, n);
+    }
+}
+
+static void
+library_filter_changed (Widget w, void *v, void *cbs)
+{
+  char *text = XmTextFieldGetString (library_filter);
+
+  if (filter_matches)
+    g_array_free (filter_matches, TRUE);
+  filter_matches = 0;
+  if (text && *text)
+    filter_matches = LibrarySearch (&Library, text, LIBRARY_MATCH_FUZZY);
+  XtFree (text);
+  show_menus ();
+}
+
 static int
 build_library_dialog ()
 {
@@ -96,6 +184,16 @@ build_library_dialog ()
 
   n = 0;
   stdarg (XmNtopAttachment, XmATTACH_FORM);
+  stdarg (XmNleftAttachment, XmATTACH_FORM);
+  stdarg (XmNrightAttachment, XmATTACH_FORM);
+  library_filter = XmCreateTextField (library_dialog, "filter", args, n);
+  XtManageChild (library_filter);
+  XtAddCallback (library_filter, XmNvalueChangedCallback,
+		 (XtCallbackProc) library_filter_changed, 0);
+
+  n = 0;
+  stdarg (XmNtopAttachment, XmATTACH_WIDGET);
+  stdarg (XmNtopWidget, library_filter);
   stdarg (XmNbottomAttachment, XmATTACH_FORM);
   stdarg (XmNleftAttachment, XmATTACH_FORM);
   stdarg (XmNvisibleItemCount, 10);
@@ -105,7 +203,8 @@ build_library_dialog ()
 		 (XtCallbackProc) library_browse, 0);
 
   n = 0;
-  stdarg (XmNtopAttachment, XmATTACH_FORM);
+  stdarg (XmNtopAttachment, XmATTACH_WIDGET);
+  stdarg (XmNtopWidget, library_filter);
   stdarg (XmNbottomAttachment, XmATTACH_FORM);
   stdarg (XmNrightAttachment, XmATTACH_FORM);
   stdarg (XmNleftAttachment, XmATTACH_WIDGET);
@@ -121,22 +220,12 @@ build_library_dialog ()
 static int
 LibraryChanged (int argc, char **argv, Coord x, Coord y)
 {
-  int i;
   if (!Library.MenuN)
     return 0;
   if (build_library_dialog ())
     return 0;
-  last_pick = -1;
-  if (library_strings)
-    free (library_strings);
-  library_strings = (XmString *) malloc (Library.MenuN * sizeof (XmString));
-  for (i = 0; i < Library.MenuN; i++)
-    library_strings[i] = XmStringCreatePCB (Library.Menu[i].Name);
-  n = 0;
-  stdarg (XmNitems, library_strings);
-  stdarg (XmNitemCount, Library.MenuN);
-  XtSetValues (library_list, args, n);
-  pick_net (0);
+  /* the old matches point into the old library; search again */
+  library_filter_changed (library_filter, 0, 0);
   return 0;
 }
 
@@ -594,10 +594,10 @@ static int
 group_showing (int g, int *c)
 {
   int i, l;
-  *c = PCB->LayerGroups.Entries[g][0];
+  *c = GROUP_ENTRY (&PCB->LayerGroups, g, 0);
   for (i=0; i<PCB->LayerGroups.Number[g]; i++)
     {
-      l = PCB->LayerGroups.Entries[g][i];
+      l = GROUP_ENTRY (&PCB->LayerGroups, g, i);
       if (l >= 0 && l < max_copper_layer)
 	{
 	  *c = l;
@@ -3001,12 +3001,12 @@ lesstif_set_layer (const char *name, int group, int empty)
       int n = PCB->LayerGroups.Number[group];
       for (idx = 0; idx < n-1; idx ++)
 	{
-	  int ni = PCB->LayerGroups.Entries[group][idx];
+	  int ni = GROUP_ENTRY (&PCB->LayerGroups, group, idx);
 	  if (ni >= 0 && ni < max_copper_layer + 2
 	      && PCB->Data->Layer[ni].On)
 	    break;
 	}
-      idx = PCB->LayerGroups.Entries[group][idx];
+      idx = GROUP_ENTRY (&PCB->LayerGroups, group, idx);
 #if 0
       if (idx == LayerStack[0]
 	  || GetLayerGroupNumberByNumber (idx) ==
@@ -367,7 +367,7 @@ layer_button_callback (Widget w, int layer, XmPushButtonCallbackStruct * pbcs)
       int group = GetLayerGroupNumberByNumber (layer);
       for (i = 0; i < PCB->LayerGroups.Number[group]; i++)
 	{
-	  l = PCB->LayerGroups.Entries[group][i];
+	  l = GROUP_ENTRY (&PCB->LayerGroups, group, i);
 	  if (l != layer && l < max_copper_layer)
 	    {
 	      show_one_layer_button (l, set);
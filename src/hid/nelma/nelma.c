@@ -278,10 +278,10 @@ nelma_write_space(FILE * out)
 	fprintf(out, "\t\t\"air-bottom\"");
 
 	z = 10;
-	for (i = 0; i < MAX_LAYER; i++)
+	for (i = 0; i < max_group; i++)
 		if (nelma_export_group[i]) {
 			idx = (i >= 0 && i < max_group) ?
-				PCB->LayerGroups.Entries[i][0] : i;
+				GROUP_ENTRY (&PCB->LayerGroups, i, 0) : i;
 			ext = layer_type_to_file_name(idx, FNS_fixed);
 
 			if (z != 10) {
@@ -348,10 +348,10 @@ nelma_write_nets(FILE * out)
 
 			/* pin_name_to_xy(pin, &x, &y); */
 
-			for (i = 0; i < MAX_LAYER; i++)
+			for (i = 0; i < max_group; i++)
 				if (nelma_export_group[i]) {
 					idx = (i >= 0 && i < max_group) ?
-						PCB->LayerGroups.Entries[i][0] : i;
+						GROUP_ENTRY (&PCB->LayerGroups, i, 0) : i;
 					ext = layer_type_to_file_name(idx, FNS_fixed);
 
 					if (m != 0 || i != 0)
@@ -426,10 +426,10 @@ nelma_write_layers(FILE * out)
 	nelma_write_layer(out, 1000, 2 * subh, "air-bottom", 0, "air");
 
 	z = 10;
-	for (i = 0; i < MAX_LAYER; i++)
+	for (i = 0; i < max_group; i++)
 		if (nelma_export_group[i]) {
 			idx = (i >= 0 && i < max_group) ?
-				PCB->LayerGroups.Entries[i][0] : i;
+				GROUP_ENTRY (&PCB->LayerGroups, i, 0) : i;
 			ext = layer_type_to_file_name(idx, FNS_fixed);
 
 			if (z != 10) {
@@ -467,10 +467,10 @@ nelma_write_object(FILE * out, LibraryEntryType *pin)
 	x = pcb_to_nelma (px);
 	y = pcb_to_nelma (py);
 
-	for (i = 0; i < MAX_LAYER; i++)
+	for (i = 0; i < max_group; i++)
 		if (nelma_export_group[i]) {
 			idx = (i >= 0 && i < max_group) ?
-				PCB->LayerGroups.Entries[i][0] : i;
+				GROUP_ENTRY (&PCB->LayerGroups, i, 0) : i;
 			ext = layer_type_to_file_name(idx, FNS_fixed);
 
 			fprintf(out, "object %s-%s {\n", pin->ListEntry, ext);
@@ -681,14 +681,14 @@ nelma_do_export(HID_Attr_Val * options)
 
 	nelma_choose_groups();
 
-	for (i = 0; i < MAX_LAYER; i++) {
+	for (i = 0; i < max_group; i++) {
 		if (nelma_export_group[i]) {
 
 			nelma_cur_group = i;
 
 			/* magic */
 			idx = (i >= 0 && i < max_group) ?
-				PCB->LayerGroups.Entries[i][0] : i;
+				GROUP_ENTRY (&PCB->LayerGroups, i, 0) : i;
 
 			nelma_start_png(nelma_basename,
 					layer_type_to_file_name(idx, FNS_fixed));
@@ -728,7 +728,7 @@ static int
 nelma_set_layer(const char *name, int group, int empty)
 {
 	int             idx = (group >= 0 && group < max_group) ?
-	PCB->LayerGroups.Entries[group][0] : group;
+	GROUP_ENTRY (&PCB->LayerGroups, group, 0) : group;
 
 	if (name == 0) {
 		name = PCB->Data->Layer[idx].Name;
@@ -1024,7 +1024,7 @@ png_set_layer (const char *name, int group, int empty)
 {
   int idx = (group >= 0
 	     && group <
-	     max_group) ? PCB->LayerGroups.Entries[group][0] : group;
+	     max_group) ? GROUP_ENTRY (&PCB->LayerGroups, group, 0) : group;
   if (name == 0)
     name = PCB->Data->Layer[idx].Name;
 
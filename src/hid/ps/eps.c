@@ -343,6 +343,7 @@ eps_do_export (HID_Attr_Val * options)
       perror (filename);
       return;
     }
+  setvbuf (f, NULL, _IOFBF, 1024 * 1024);
 
   if (!options[HA_as_shown].int_value)
     hid_save_and_show_layer_ons (save_ons);
@@ -371,7 +372,7 @@ eps_set_layer (const char *name, int group, int empty)
 {
   int idx = (group >= 0
 	     && group <
-	     max_group) ? PCB->LayerGroups.Entries[group][0] : group;
+	     max_group) ? GROUP_ENTRY (&PCB->LayerGroups, group, 0) : group;
   if (name == 0)
     name = PCB->Data->Layer[idx].Name;
 
@@ -32,6 +32,8 @@
 
 static int ps_set_layer (const char *name, int group, int empty);
 static void use_gc (hidGC gc);
+static void flush_path (void);
+static void reset_shapes (void);
 
 typedef struct hid_gc_struct
 {
@@ -397,8 +399,34 @@ static struct {
   bool is_assy;
   bool is_copper;
   bool is_paste;
+
+  /* Lines waiting to be stroked together, and where the last ends. */
+  int path_len;
+  Coord path_x, path_y;
+
+  /* Small polygons seen on this page, by shape.  */
+  GHashTable *shapes;
+  int shape_count;
 } global;
 
+/* stdio buffer for the output files.  */
+#define PS_BUFFER_SIZE (1024 * 1024)
+
+/* Longest path stroked at once; level 1 interpreters stop at 1500
+   points.  */
+#define PS_MAX_PATH 500
+
+/* Polygons with up to this many corners (pads, octagonal pins,
+   thermal fingers) are drawn through a procedure once they repeat.  */
+#define PS_MAX_SHAPE 16
+
+typedef struct
+{
+  int n;
+  int id;			/* procedure number, 0 if not defined yet */
+  Coord d[2 * PS_MAX_SHAPE];	/* corners relative to the first one */
+} ShapeType;
+
 static HID_Attribute *
 ps_get_export_options (int *n)
 {
@@ -564,7 +592,12 @@ psopen (const char *base, const char *which)
   char *buf, *suff, *buf2;
 
   if (!global.multi_file)
-    return fopen (base, "w");
+    {
+      ps_open_file = fopen (base, "w");
+      if (ps_open_file)
+	setvbuf (ps_open_file, NULL, _IOFBF, PS_BUFFER_SIZE);
+      return ps_open_file;
+    }
 
   buf = (char *)malloc (strlen (base) + strlen (which) + 5);
 
@@ -582,6 +615,8 @@ psopen (const char *base, const char *which)
   printf("PS: open %s\n", buf);
   ps_open_file = fopen(buf, "w");
   free (buf);
+  if (ps_open_file)
+    setvbuf (ps_open_file, NULL, _IOFBF, PS_BUFFER_SIZE);
   return ps_open_file;
 }
 
@@ -697,8 +732,12 @@ ps_hid_export_to_file (FILE * the_file, HID_Attr_Val * options)
   ps_set_layer (NULL, 0, -1);  /* reset static vars */
   hid_expose_callback (&ps_hid, &global.region, 0);
 
-  if (the_file)
-    fprintf (the_file, "showpage\n");
+  if (global.f)
+    {
+      flush_path ();
+      fprintf (global.f, "showpage\n");
+    }
+  reset_shapes ();
 
   memcpy (LayerStack, saved_layer_stack, sizeof (LayerStack));
   PCB->Flags = save_thindraw;
@@ -741,6 +780,14 @@ ps_do_export (HID_Attr_Val * options)
   ps_hid_export_to_file (fh, options);
   hid_restore_layer_ons (save_ons);
 
+  /* The last page of a multi-file export is still open.  */
+  if (global.multi_file && global.f)
+    {
+      ps_end_file (global.f);
+      fclose (global.f);
+    }
+  global.f = NULL;
+
   global.multi_file = 0;
   if (fh)
     {
@@ -786,11 +833,13 @@ ps_set_layer (const char *name, int group, int empty)
   static int lastgroup = -1;
   time_t currenttime;
   int idx = (group >= 0 && group < max_group)
-            ? PCB->LayerGroups.Entries[group][0]
+            ? GROUP_ENTRY (&PCB->LayerGroups, group, 0)
             : group;
   if (name == 0)
     name = PCB->Data->Layer[idx].Name;
 
+  flush_path ();
+
   if (empty == -1)
     lastgroup = -1;
   if (empty)
@@ -965,8 +1014,10 @@ ps_set_layer (const char *name, int group, int empty)
 
       global.linewidth = -1;
       use_gc (NULL);  /* reset static vars */
+      reset_shapes ();
 
       fprintf (global.f,
+              "/m { moveto } bind def /l { lineto } bind def\n"
               "/ts 1 def\n"
               "/ty ts neg def /tx 0 def /Helvetica findfont ts scalefont setfont\n"
               "/t { moveto lineto stroke } bind def\n"
@@ -1077,6 +1128,104 @@ ps_set_draw_faded (hidGC gc, int faded)
   gc->faded = faded;
 }
 
+/* Writes C like pcb_fprintf's "%mi" does, followed by a space, but
+   without the allocations pcb_fprintf makes for every call.  */
+static void
+put_coord (Coord c)
+{
+  fprintf (global.f, "%.5f ", COORD_TO_MIL (c) * 0.001);
+}
+
+/* Lines drawn one after the other with the same GC are collected
+   into a single path and stroked once.  */
+static void
+flush_path (void)
+{
+  if (global.path_len > 0 && global.f)
+    fprintf (global.f, "stroke\n");
+  global.path_len = 0;
+}
+
+static guint
+shape_hash (gconstpointer key)
+{
+  const ShapeType *shape = (const ShapeType *) key;
+  guint h = shape->n;
+  int i;
+
+  for (i = 0; i < 2 * shape->n; i++)
+    h = h * 31 + (guint) shape->d[i];
+  return h;
+}
+
+static gboolean
+shape_equal (gconstpointer a, gconstpointer b)
+{
+  const ShapeType *sa = (const ShapeType *) a;
+  const ShapeType *sb = (const ShapeType *) b;
+
+  return sa->n == sb->n
+    && memcmp (sa->d, sb->d, 2 * sa->n * sizeof (Coord)) == 0;
+}
+
+/* Procedures are defined per page, like the rest of the prolog, so
+   that pages stay independent of each other.  */
+static void
+reset_shapes (void)
+{
+  if (global.shapes)
+    g_hash_table_destroy (global.shapes);
+  global.shapes = NULL;
+  global.shape_count = 0;
+}
+
+/* Returns the procedure that draws the polygon X,Y with its first
+   corner at the origin, defining it when the shape is seen the second
+   time.  Returns 0 when the polygon should be written out in full.  */
+static int
+polygon_shape (int n_coords, Coord *x, Coord *y)
+{
+  ShapeType key, *shape;
+  int i;
+
+  if (n_coords > PS_MAX_SHAPE)
+    return 0;
+
+  key.n = n_coords;
+  for (i = 0; i < n_coords; i++)
+    {
+      key.d[2 * i] = x[i] - x[0];
+      key.d[2 * i + 1] = y[i] - y[0];
+    }
+
+  if (global.shapes == NULL)
+    global.shapes = g_hash_table_new_full (shape_hash, shape_equal,
+                                           g_free, NULL);
+  shape = (ShapeType *) g_hash_table_lookup (global.shapes, &key);
+  if (shape == NULL)
+    {
+      key.id = 0;
+      shape = g_new (ShapeType, 1);
+      *shape = key;
+      g_hash_table_insert (global.shapes, shape, shape);
+      return 0;
+    }
+
+  if (shape->id == 0)
+    {
+      shape->id = ++global.shape_count;
+      fprintf (global.f, "/P%d { gsave translate 0 0 m\n", shape->id);
+      for (i = 1; i < n_coords; i++)
+	{
+	  put_coord (shape->d[2 * i]);
+	  put_coord (shape->d[2 * i + 1]);
+	  fprintf (global.f, "l\n");
+	}
+      fprintf (global.f, "fill grestore } bind def\n");
+    }
+  return shape->id;
+}
+
 static void
 use_gc (hidGC gc)
 {
@@ -1095,6 +1244,7 @@ use_gc (hidGC gc)
     }
   if (global.linewidth != gc->width)
     {
+      flush_path ();
       pcb_fprintf (global.f, "%mi setlinewidth\n",
                    gc->width + (gc->erase ? -2 : 2) * global.bloat);
       global.linewidth = gc->width;
@@ -1113,12 +1263,14 @@ use_gc (hidGC gc)
 	  c = 2;
 	  break;
 	}
+      flush_path ();
       fprintf (global.f, "%d setlinecap %d setlinejoin\n", c, c);
       lastcap = gc->cap;
     }
 #define CBLEND(gc) (((gc->r)<<24)|((gc->g)<<16)|((gc->b)<<8)|(gc->faded))
   if (lastcolor != CBLEND (gc))
     {
+      flush_path ();
       if (global.is_drill || global.is_mask)
 	{
 	  fprintf (global.f, "%d gray\n", gc->erase ? 0 : 1);
@@ -1148,6 +1300,7 @@ use_gc (hidGC gc)
 static void
 ps_draw_rect (hidGC gc, Coord x1, Coord y1, Coord x2, Coord y2)
 {
+  flush_path ();
   use_gc (gc);
   pcb_fprintf (global.f, "%mi %mi %mi %mi dr\n", x1, y1, x2, y2);
 }
@@ -1185,7 +1338,45 @@ ps_draw_line (hidGC gc, Coord x1, Coord y1, Coord x2, Coord y2)
       return;
     }
   use_gc (gc);
-  pcb_fprintf (global.f, "%mi %mi %mi %mi t\n", x1, y1, x2, y2);
+
+  /* Round caps meet in round joins, so a line that starts where the
+     last one ended simply continues the path.  */
+  if (global.path_len > 0 && global.path_len < PS_MAX_PATH
+      && gc->cap != Square_Cap)
+    {
+      if (x1 == global.path_x && y1 == global.path_y)
+	{
+	  put_coord (x2);
+	  put_coord (y2);
+	  fprintf (global.f, "l\n");
+	  global.path_x = x2;
+	  global.path_y = y2;
+	  global.path_len++;
+	  return;
+	}
+      if (x2 == global.path_x && y2 == global.path_y)
+	{
+	  put_coord (x1);
+	  put_coord (y1);
+	  fprintf (global.f, "l\n");
+	  global.path_x = x1;
+	  global.path_y = y1;
+	  global.path_len++;
+	  return;
+	}
+    }
+  if (global.path_len >= PS_MAX_PATH)
+    flush_path ();
+
+  put_coord (x1);
+  put_coord (y1);
+  fprintf (global.f, "m ");
+  put_coord (x2);
+  put_coord (y2);
+  fprintf (global.f, "l\n");
+  global.path_x = x2;
+  global.path_y = y2;
+  global.path_len++;
 }
 
 static void
@@ -1207,6 +1398,7 @@ ps_draw_arc (hidGC gc, Coord cx, Coord cy, Coord width, Coord height,
   printf ("draw_arc %d,%d %dx%d %d..%d %d..%d\n",
 	  cx, cy, width, height, start_angle, delta_angle, sa, ea);
 #endif
+  flush_path ();
   use_gc (gc);
   pcb_fprintf (global.f, "%ma %ma %mi %mi %mi %mi %g a\n",
                sa, ea, -width, height, cx, cy,
@@ -1216,27 +1408,44 @@ ps_draw_arc (hidGC gc, Coord cx, Coord cy, Coord width, Coord height,
 static void
 ps_fill_circle (hidGC gc, Coord cx, Coord cy, Coord radius)
 {
+  flush_path ();
   use_gc (gc);
   if (!gc->erase || !global.is_copper || global.drillcopper)
     {
       if (gc->erase && global.is_copper && global.drill_helper
 	  && radius >= PCB->minDrill / 4)
 	radius = PCB->minDrill / 4;
-      pcb_fprintf (global.f, "%mi %mi %mi c\n",
-                   cx, cy, radius + (gc->erase ? -1 : 1) * global.bloat);
+      put_coord (cx);
+      put_coord (cy);
+      put_coord (radius + (gc->erase ? -1 : 1) * global.bloat);
+      fprintf (global.f, "c\n");
     }
 }
 
 static void
 ps_fill_polygon (hidGC gc, int n_coords, Coord *x, Coord *y)
 {
-  int i;
-  char *op = "moveto";
+  int i, shape;
+  char *op = "m";
+
+  flush_path ();
   use_gc (gc);
+
+  shape = polygon_shape (n_coords, x, y);
+  if (shape)
+    {
+      put_coord (x[0]);
+      put_coord (y[0]);
+      fprintf (global.f, "P%d\n", shape);
+      return;
+    }
+
   for (i = 0; i < n_coords; i++)
     {
-      pcb_fprintf (global.f, "%mi %mi %s\n", x[i], y[i], op);
-      op = "lineto";
+      put_coord (x[i]);
+      put_coord (y[i]);
+      fprintf (global.f, "%s\n", op);
+      op = "l";
     }
   fprintf (global.f, "fill\n");
 }
@@ -1250,6 +1459,7 @@ ps_fill_pcb_polygon (hidGC gc, PolygonType * poly, const BoxType * clip_box)
   PLINE *pl;
   char *op;
 
+  flush_path ();
   use_gc (gc);
 
   pl = poly->Clipped->contours;
@@ -1257,11 +1467,13 @@ ps_fill_pcb_polygon (hidGC gc, PolygonType * poly, const BoxType * clip_box)
   do
     {
       v = pl->head.next;
-      op = "moveto";
+      op = "m";
       do
 	{
-	  pcb_fprintf (global.f, "%mi %mi %s\n", v->point[0], v->point[1], op);
-	  op = "lineto";
+	  put_coord (v->point[0]);
+	  put_coord (v->point[1]);
+	  fprintf (global.f, "%s\n", op);
+	  op = "l";
 	}
       while ((v = v->next) != pl->head.next);
     }
@@ -1273,6 +1485,7 @@ ps_fill_pcb_polygon (hidGC gc, PolygonType * poly, const BoxType * clip_box)
 static void
 ps_fill_rect (hidGC gc, Coord x1, Coord y1, Coord x2, Coord y2)
 {
+  flush_path ();
   use_gc (gc);
   if (x1 > x2)
     {
@@ -1301,9 +1514,11 @@ ps_fill_rect (hidGC gc, Coord x1, Coord y1, Coord x2, Coord y2)
       return;
     }
 #endif
-  pcb_fprintf (global.f, "%mi %mi %mi %mi r\n",
-               x1 - global.bloat, y1 - global.bloat,
-               x2 + global.bloat, y2 + global.bloat);
+  put_coord (x1 - global.bloat);
+  put_coord (y1 - global.bloat);
+  put_coord (x2 + global.bloat);
+  put_coord (y2 + global.bloat);
+  fprintf (global.f, "r\n");
 }
 
 HID_Attribute ps_calib_attribute_list[] = {
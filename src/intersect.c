@@ -43,6 +43,7 @@
 #include "data.h"
 #include "intersect.h"
 #include "mymem.h"
+#include "rtree.h"
 
 #ifdef HAVE_LIBDMALLOC
 #include <dmalloc.h>
@@ -280,6 +281,122 @@ ComputeUnionArea (BoxListType *boxlist)
   free (segtree.nodes);
   return area * 0.0001;
 }
+
+/* ---------------------------------------------------------------------------
+ * A box coverage keeps ComputeIntersectionArea() of a changing set of
+ * boxes up to date.  Adding a box B raises the intersection area by the
+ * part of B the other boxes already cover, and removing it lowers the
+ * area by the same amount.  That part is the union of the other boxes
+ * clipped to B, which the sweep above computes from just the boxes an
+ * r-tree finds overlapping B.  So an update costs O(log N + k log k),
+ * k being the number of boxes B overlaps, instead of O(N log N) for the
+ * whole set.
+ */
+struct BoxCoverage
+{
+  rtree_t *tree;
+  double area;			/* intersection area, scaled like the above */
+};
+
+struct coverage_info
+{
+  const BoxType *box;
+  BoxListType clipped;
+};
+
+static int
+coverage_clip_callback (const BoxType * b, void *cl)
+{
+  struct coverage_info *i = (struct coverage_info *) cl;
+  BoxType c;
+
+  c.X1 = MAX (b->X1, i->box->X1);
+  c.Y1 = MAX (b->Y1, i->box->Y1);
+  c.X2 = MIN (b->X2, i->box->X2);
+  c.Y2 = MIN (b->Y2, i->box->Y2);
+  if (b == i->box || c.X1 >= c.X2 || c.Y1 >= c.Y2)
+    return 0;
+  *GetBoxMemory (&i->clipped) = c;
+  return 1;
+}
+
+/* area of box covered by the boxes of the coverage */
+static double
+coverage_covered (BoxCoverageType *cov, const BoxType *box)
+{
+  struct coverage_info info;
+  double area = 0.0;
+
+  info.box = box;
+  info.clipped.BoxN = info.clipped.BoxMax = 0;
+  info.clipped.Box = NULL;
+  if (r_search (cov->tree, box, NULL, coverage_clip_callback, &info))
+    area = ComputeUnionArea (&info.clipped);
+  FreeBoxListMemory (&info.clipped);
+  return area;
+}
+
+BoxCoverageType *
+CreateBoxCoverage (void)
+{
+  BoxCoverageType *cov = (BoxCoverageType *) calloc (1, sizeof (*cov));
+
+  cov->tree = r_create_tree (NULL, 0, 0);
+  return cov;
+}
+
+void
+DestroyBoxCoverage (BoxCoverageType **cov)
+{
+  r_destroy_tree (&(*cov)->tree);
+  free (*cov);
+  *cov = NULL;
+}
+
+/* boxes without area don't change the intersection area */
+#define EMPTY_BOX(b) ((b)->X1 >= (b)->X2 || (b)->Y1 >= (b)->Y2)
+
+/* ---------------------------------------------------------------------------
+ * adds a copy of box; the returned pointer identifies it for removal
+ */
+const BoxType *
+BoxCoverageInsert (BoxCoverageType *cov, const BoxType *box)
+{
+  BoxType *copy = (BoxType *) malloc (sizeof (*copy));
+
+  assert (box->X1 <= box->X2);
+  assert (box->Y1 <= box->Y2);
+  *copy = *box;
+  if (!EMPTY_BOX (copy))
+    cov->area += coverage_covered (cov, copy);
+  r_insert_entry (cov->tree, copy, 1);
+  return copy;
+}
+
+/* ---------------------------------------------------------------------------
+ * removes a box returned by BoxCoverageInsert()
+ */
+void
+BoxCoverageRemove (BoxCoverageType *cov, const BoxType *box)
+{
+  BoxType copy = *box;
+
+  r_delete_entry (cov->tree, box);
+  if (!EMPTY_BOX (&copy))
+    cov->area -= coverage_covered (cov, &copy);
+}
+
+/* ---------------------------------------------------------------------------
+ * the ComputeIntersectionArea() of the boxes in the coverage.  Updates
+ * accumulate rounding errors, so long running users should rebuild the
+ * coverage now and then.
+ */
+double
+BoxCoverageIntersectionArea (BoxCoverageType *cov)
+{
+  return cov->area;
+}
+
 static int
 compareleft (const void *ptr1, const void *ptr2)
 {
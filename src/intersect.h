@@ -40,4 +40,14 @@
 double ComputeIntersectionArea (BoxListType *boxlist);	/* will sort boxlist */
 double ComputeUnionArea (BoxListType *boxlist);
 
+/* the intersection area of a set of boxes, kept up to date as boxes
+ * are added and removed */
+typedef struct BoxCoverage BoxCoverageType;
+
+BoxCoverageType *CreateBoxCoverage (void);
+void DestroyBoxCoverage (BoxCoverageType **);
+const BoxType *BoxCoverageInsert (BoxCoverageType *, const BoxType *);
+void BoxCoverageRemove (BoxCoverageType *, const BoxType *);
+double BoxCoverageIntersectionArea (BoxCoverageType *);
+
 #endif
@@ -0,0 +1,424 @@
+/*
+ *                            COPYRIGHT
+ *
+ *  PCB, interactive printed circuit board design
+ *  Copyright (C) 1994,1995,1996 Thomas Nau
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ *  Contact addresses for paper mail and Email:
+ *  Thomas Nau, Schlehenweg 15, 88471 Baustetten, Germany
+ *  Thomas.Nau@rz.uni-ulm.de
+ *
+ */
+
+
+/* search index over the footprint library, shared by the library
+ * dialogs of all GUIs
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "global.h"
+
+#include "libindex.h"
+
+#ifdef HAVE_LIBDMALLOC
+#include <dmalloc.h>
+#endif
+
+/* ---------------------------------------------------------------------------
+ * The index keeps the lower case name (ListEntry) and description of
+ * every library entry and, for each trigram (three consecutive bytes)
+ * occurring in them, the ascending list of entries it occurs in.  A
+ * search for a text of three or more characters only has to look at
+ * the entries having all of the text's trigrams, which is usually a
+ * handful out of tens of thousands.  Shorter texts scan the lower
+ * case strings directly.
+ *
+ * The index is built on the first search and dropped when the library
+ * is reloaded.
+ */
+typedef struct
+{
+  Cardinal menu, entry;		/* where the entry is in the library */
+  char *name, *description;	/* lower case; description may be NULL */
+} IndexEntryType;
+
+static struct
+{
+  LibraryType *Library;		/* the library indexed */
+  Cardinal MenuN, EntryN;	/* its size when indexed */
+  GArray *Entries;		/* IndexEntryType */
+  GHashTable *Trigrams;		/* trigram -> GArray of entry numbers */
+} Index;
+
+/* scores of the kinds of matches; see match_score() */
+#define	SCORE_EXACT		1000
+#define	SCORE_PREFIX		800
+#define	SCORE_WORD		600
+#define	SCORE_NAME		400
+#define	SCORE_DESCRIPTION	200
+#define	SCORE_FUZZY		100
+
+/* a trigram packed into a hash key; never 0 as strings hold no NULs */
+#define	TRIGRAM(s)	GUINT_TO_POINTER (((guint) (guchar) (s)[0] << 16) \
+				  | ((guint) (guchar) (s)[1] << 8) \
+				  | (guint) (guchar) (s)[2])
+
+static void
+free_posting (gpointer list)
+{
+  g_array_free ((GArray *) list, TRUE);
+}
+
+static void
+index_text (const char *text, guint number)
+{
+  GArray *list;
+  size_t len = strlen (text), i;
+
+  for (i = 0; i + 3 <= len; i++)
+    {
+      list = g_hash_table_lookup (Index.Trigrams, TRIGRAM (text + i));
+      if (list == NULL)
+	{
+	  list = g_array_new (FALSE, FALSE, sizeof (guint));
+	  g_hash_table_insert (Index.Trigrams, TRIGRAM (text + i), list);
+	}
+      /* entries are indexed in order, so a repeat is always the last */
+      if (list->len == 0
+	  || g_array_index (list, guint, list->len - 1) != number)
+	g_array_append_val (list, number);
+    }
+}
+
+void
+LibraryIndexForget (LibraryType *lib)
+{
+  guint i;
+
+  if (lib != Index.Library || Index.Entries == NULL)
+    return;
+  for (i = 0; i < Index.Entries->len; i++)
+    {
+      IndexEntryType *e = &g_array_index (Index.Entries, IndexEntryType, i);
+
+      g_free (e->name);
+      g_free (e->description);
+    }
+  g_array_free (Index.Entries, TRUE);
+  g_hash_table_destroy (Index.Trigrams);
+  Index.Entries = NULL;
+  Index.Trigrams = NULL;
+  Index.Library = NULL;
+}
+
+static Cardinal
+library_entries (LibraryType *lib)
+{
+  Cardinal n = 0;
+
+  MENU_LOOP (lib);
+  {
+    n += menu->EntryN;
+  }
+  END_LOOP;
+  return n;
+}
+
+static void
+index_build (LibraryType *lib)
+{
+  Cardinal m, e;
+
+  if (Index.Library == lib && Index.MenuN == lib->MenuN
+      && Index.EntryN == library_entries (lib))
+    return;
+  LibraryIndexForget (Index.Library);
+
+  Index.Library = lib;
+  Index.MenuN = lib->MenuN;
+  Index.EntryN = library_entries (lib);
+  Index.Entries = g_array_sized_new (FALSE, FALSE, sizeof (IndexEntryType),
+				     Index.EntryN);
+  Index.Trigrams = g_hash_table_new_full (NULL, NULL, NULL, free_posting);
+  for (m = 0; m < lib->MenuN; m++)
+    for (e = 0; e < lib->Menu[m].EntryN; e++)
+      {
+	LibraryEntryType *entry = &lib->Menu[m].Entry[e];
+	IndexEntryType ie;
+
+	ie.menu = m;
+	ie.entry = e;
+	ie.name = g_ascii_strdown (EMPTY (entry->ListEntry), -1);
+	ie.description = NULL;
+	if (entry->Description && *entry->Description
+	    && NSTRCMP (entry->Description, entry->ListEntry) != 0)
+	  ie.description = g_ascii_strdown (entry->Description, -1);
+	index_text (ie.name, Index.Entries->len);
+	if (ie.description)
+	  index_text (ie.description, Index.Entries->len);
+	g_array_append_val (Index.Entries, ie);
+      }
+}
+
+/* ---------------------------------------------------------------------------
+ * returns how well the entry matches the lower case text, 0 if it
+ * doesn't contain it; wildcards ('*' and '?') are matched by pattern
+ */
+static int
+match_score (IndexEntryType *e, const char *text, GPatternSpec *pattern)
+{
+  const char *s;
+
+  if (pattern)
+    {
+      if (g_pattern_match_string (pattern, e->name))
+	return SCORE_NAME;
+      if (e->description && g_pattern_match_string (pattern, e->description))
+	return SCORE_DESCRIPTION;
+      return 0;
+    }
+  if ((s = strstr (e->name, text)) != NULL)
+    {
+      if (s == e->name)
+	return s[strlen (text)] == '\0' ? SCORE_EXACT : SCORE_PREFIX;
+      /* prefer the start of a word, e.g. "0805" in "smd_0805" */
+      for (; s != NULL; s = strstr (s + 1, text))
+	if (!g_ascii_isalnum (s[-1]))
+	  return SCORE_WORD;
+      return SCORE_NAME;
+    }
+  if (e->description && strstr (e->description, text))
+    return SCORE_DESCRIPTION;
+  return 0;
+}
+
+static void
+add_match (GArray *matches, guint number, int score)
+{
+  IndexEntryType *e = &g_array_index (Index.Entries, IndexEntryType, number);
+  LibraryMatchType match;
+
+  match.Menu = &Index.Library->Menu[e->menu];
+  match.Entry = &match.Menu->Entry[e->entry];
+  match.Score = score;
+  g_array_append_val (matches, match);
+}
+
+static gint
+compare_match (gconstpointer va, gconstpointer vb)
+{
+  const LibraryMatchType *a = va, *b = vb;
+  size_t la, lb;
+
+  if (a->Score != b->Score)
+    return b->Score - a->Score;
+  /* among equals the shorter name is the closer one */
+  la = strlen (EMPTY (a->Entry->ListEntry));
+  lb = strlen (EMPTY (b->Entry->ListEntry));
+  if (la != lb)
+    return la < lb ? -1 : 1;
+  /* keep library order */
+  if (a->Menu != b->Menu)
+    return a->Menu < b->Menu ? -1 : 1;
+  return a->Entry < b->Entry ? -1 : a->Entry > b->Entry;
+}
+
+static gint
+compare_posting_length (gconstpointer va, gconstpointer vb)
+{
+  const GArray *a = *(GArray * const *) va, *b = *(GArray * const *) vb;
+
+  return a->len < b->len ? -1 : a->len > b->len;
+}
+
+/* ---------------------------------------------------------------------------
+ * the longest run of text without wildcards
+ */
+static char *
+literal_run (const char *text)
+{
+  const char *best = text, *s = text;
+  size_t best_len = 0, len;
+
+  while (*s)
+    {
+      len = strcspn (s, "*?");
+      if (len > best_len)
+	{
+	  best = s;
+	  best_len = len;
+	}
+      s += len;
+      if (*s)
+	s++;
+    }
+  return g_strndup (best, best_len);
+}
+
+/* ---------------------------------------------------------------------------
+ * returns the entries of the library whose name or description
+ * contains text, ignoring case, best matches first; '*' and '?' in
+ * the text are wildcards.  If nothing matches and LIBRARY_MATCH_FUZZY
+ * is given, entries sharing most of the text's trigrams are returned
+ * instead, so a typo still finds something.  The caller frees the
+ * array with g_array_free().
+ */
+GArray *
+LibrarySearch (LibraryType *lib, const char *text, int flags)
+{
+  GArray *matches, *candidates = NULL;
+  GPtrArray *postings;
+  GPatternSpec *pattern = NULL;
+  char *lower, *literal;
+  size_t len, i;
+  guint j, k, n;
+  int score;
+
+  matches = g_array_new (FALSE, FALSE, sizeof (LibraryMatchType));
+  if (text == NULL || *text == '\0')
+    return matches;
+  index_build (lib);
+
+  lower = g_ascii_strdown (text, -1);
+  if (strpbrk (lower, "*?"))
+    {
+      char *glob = g_strconcat ("*", lower, "*", NULL);
+
+      pattern = g_pattern_spec_new (glob);
+      g_free (glob);
+    }
+  literal = literal_run (lower);
+  len = strlen (literal);
+
+  /* the posting lists of the literal's trigrams, shortest first */
+  postings = g_ptr_array_new ();
+  for (i = 0; i + 3 <= len; i++)
+    {
+      GArray *list = g_hash_table_lookup (Index.Trigrams,
+					  TRIGRAM (literal + i));
+
+      if (list == NULL)
+	break;
+      for (j = 0; j < postings->len; j++)
+	if (g_ptr_array_index (postings, j) == list)
+	  break;
+      if (j == postings->len)
+	g_ptr_array_add (postings, list);
+    }
+  g_ptr_array_sort (postings, compare_posting_length);
+
+  if (len < 3)
+    {
+      /* too short for trigrams: every entry is a candidate */
+      for (n = 0; n < Index.Entries->len; n++)
+	if ((score = match_score (&g_array_index (Index.Entries,
+						  IndexEntryType, n),
+				  lower, pattern)) > 0)
+	  add_match (matches, n, score);
+    }
+  else if (i + 3 > len)
+    {
+      /* all trigrams are present; intersect their lists */
+      GArray *first = g_ptr_array_index (postings, 0);
+
+      candidates = g_array_sized_new (FALSE, FALSE, sizeof (guint),
+				      first->len);
+      g_array_append_vals (candidates, first->data, first->len);
+      for (j = 1; j < postings->len && candidates->len; j++)
+	{
+	  GArray *list = g_ptr_array_index (postings, j);
+	  guint out = 0, p = 0;
+
+	  for (k = 0; k < candidates->len; k++)
+	    {
+	      guint c = g_array_index (candidates, guint, k);
+
+	      while (p < list->len && g_array_index (list, guint, p) < c)
+		p++;
+	      if (p == list->len)
+		break;
+	      if (g_array_index (list, guint, p) == c)
+		g_array_index (candidates, guint, out++) = c;
+	    }
+	  g_array_set_size (candidates, out);
+	}
+      /* trigrams may come from the name and the description, or be
+       * out of order: check the real thing */
+      for (k = 0; k < candidates->len; k++)
+	{
+	  n = g_array_index (candidates, guint, k);
+	  if ((score = match_score (&g_array_index (Index.Entries,
+						    IndexEntryType, n),
+				    lower, pattern)) > 0)
+	    add_match (matches, n, score);
+	}
+      g_array_free (candidates, TRUE);
+    }
+
+  if (matches->len == 0 && (flags & LIBRARY_MATCH_FUZZY) && pattern == NULL
+      && len >= 3)
+    {
+      /* count, for every entry, how many of the text's trigrams it
+       * has and take those having at least two thirds of them */
+      guint trigrams = 0, *hits;
+
+      g_ptr_array_set_size (postings, 0);
+      for (i = 0; i + 3 <= len; i++)
+	{
+	  GArray *list;
+
+	  for (j = 0; j < i; j++)
+	    if (memcmp (literal + j, literal + i, 3) == 0)
+	      break;
+	  if (j < i)
+	    continue;
+	  trigrams++;
+	  list = g_hash_table_lookup (Index.Trigrams, TRIGRAM (literal + i));
+	  for (j = 0; list && j < postings->len; j++)
+	    if (g_ptr_array_index (postings, j) == list)
+	      break;
+	  if (list && j == postings->len)
+	    g_ptr_array_add (postings, list);
+	}
+      hits = g_new0 (guint, Index.Entries->len);
+      for (j = 0; j < postings->len; j++)
+	{
+	  GArray *list = g_ptr_array_index (postings, j);
+
+	  for (k = 0; k < list->len; k++)
+	    hits[g_array_index (list, guint, k)]++;
+	}
+      for (n = 0; n < Index.Entries->len; n++)
+	if (3 * hits[n] >= 2 * trigrams)
+	  add_match (matches, n, SCORE_FUZZY * hits[n] / trigrams);
+      g_free (hits);
+    }
+
+  g_array_sort (matches, compare_match);
+  g_ptr_array_free (postings, TRUE);
+  if (pattern)
+    g_pattern_spec_free (pattern);
+  g_free (literal);
+  g_free (lower);
+  return matches;
+}
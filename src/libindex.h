@@ -0,0 +1,48 @@
+/*
+ *                            COPYRIGHT
+ *
+ *  PCB, interactive printed circuit board design
+ *  Copyright (C) 1994,1995,1996 Thomas Nau
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ *  Contact addresses for paper mail and Email:
+ *  Thomas Nau, Schlehenweg 15, 88471 Baustetten, Germany
+ *  Thomas.Nau@rz.uni-ulm.de
+ *
+ */
+
+/* prototypes for the footprint library search index
+ */
+
+#ifndef	PCB_LIBINDEX_H
+#define	PCB_LIBINDEX_H
+
+#include "global.h"
+
+typedef struct
+{
+  LibraryMenuType *Menu;	/* the menu the entry belongs to */
+  LibraryEntryType *Entry;	/* the matching entry */
+  int Score;			/* higher is a better match */
+} LibraryMatchType;
+
+/* flags for LibrarySearch() */
+#define	LIBRARY_MATCH_FUZZY	0x0001	/* fall back to approximate matches */
+
+GArray *LibrarySearch (LibraryType *, const char *, int);
+void LibraryIndexForget (LibraryType *);
+
+#endif
@@ -112,13 +112,15 @@
 
 #define THERMFLAG(L)		(0xf << (4 *((L) % 2)))
 
-#define TEST_THERM(L,P)		((P)->Flags.t[(L)/2] & THERMFLAG(L) ? 1 : 0)
-#define GET_THERM(L,P)		(((P)->Flags.t[(L)/2] >> (4 * ((L) % 2))) & 0xf) 
-#define CLEAR_THERM(L,P)	(P)->Flags.t[(L)/2] &= ~THERMFLAG(L)
-#define ASSIGN_THERM(L,V,P)	(P)->Flags.t[(L)/2] = ((P)->Flags.t[(L)/2] & ~THERMFLAG(L)) | ((V)  << (4 * ((L) % 2)))
+/* Thermal styles live in a table of shared patterns, see strflags.c.
+   Flags without thermals don't look at it.  */
+#define TEST_THERM(L,P)		(GET_THERM (L,P) ? 1 : 0)
+#define GET_THERM(L,P)		((P)->Flags.t ? GetFlagThermal (&(P)->Flags, (L)) : 0)
+#define CLEAR_THERM(L,P)	SetFlagThermal (&(P)->Flags, (L), 0)
+#define ASSIGN_THERM(L,V,P)	SetFlagThermal (&(P)->Flags, (L), (V))
 
 extern int mem_any_set (unsigned char *, int);
-#define TEST_ANY_THERMS(P)	mem_any_set((P)->Flags.t, sizeof((P)->Flags.t))
+#define TEST_ANY_THERMS(P)	((P)->Flags.t != 0)
 
 /* ---------------------------------------------------------------------------
  * access macros for elements name structure
@@ -455,7 +457,7 @@ extern int mem_any_set (unsigned char *, int);
         { \
 		LayerType *layer;		\
 		Cardinal number; 		\
-		number = ((PCBType *)(data->pcb))->LayerGroups.Entries[(group)][entry]; \
+		number = GROUP_ENTRY (&((PCBType *)(data->pcb))->LayerGroups, (group), entry); \
 		if (number >= max_copper_layer)	\
 		  continue;			\
 		layer = &data->Layer[number];
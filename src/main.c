@@ -1063,6 +1063,19 @@ The default value is @code{60}.
   ISET (BackupInterval, 60, "backup-interval",
   "Time between automatic backups in seconds. Set to 0 to disable"),
 
+/* %start-doc options "1 General Options"
+@ftable @code
+@item --undo-memory <num>
+Memory budget of the undo and redo history in kB.  When it is exceeded
+the oldest operations are dropped and can no longer be undone.  The
+default value is @code{0}, which keeps the whole history.
+@end ftable
+%end-doc
+*/
+  ISET (UndoMemory, 0, "undo-memory",
+  "Memory budget of the undo history in kB, beyond which the oldest "
+  "operations can no longer be undone. Set to 0 for no limit"),
+
 /* %start-doc options "4 Layer Names"
 @ftable @code
 @item --layer-name-1 <string>
@@ -65,6 +65,7 @@
 #include "move.h"
 #include "pcb-printf.h"
 #include "polygon.h"
+#include "rats.h"
 #include "remove.h"
 #include "rtree.h"
 #include "rotate.h"
@@ -79,7 +80,6 @@
 #endif
 
 /*	forward declarations	*/
-static char *BumpName (char *);
 static void GetGridLockCoordinates (int, void *, void *, void *,
                                     Coord *, Coord *);
 
@@ -657,7 +657,7 @@ IsLayerGroupEmpty (int num)
 {
   int i;
   for (i=0; i<PCB->LayerGroups.Number[num]; i++)
-    if (!IsLayerNumEmpty (PCB->LayerGroups.Entries[num][i]))
+    if (!IsLayerNumEmpty (GROUP_ENTRY (&PCB->LayerGroups, num, i)))
       return false;
   return true;
 }
@@ -1041,7 +1041,8 @@ ParseGroupString (char *s, LayerGroupType *LayerGroup, int LayerN)
               member >= LayerN + 1)
             goto error;
           groupnum[layer] = group;
-          LayerGroup->Entries[group][member++] = layer;
+          AddLayerToGroup (LayerGroup, group, layer);
+          member++;
           while (*++s && isdigit ((int) *s));
 
           /* ignore white spaces and check for separator */
@@ -1052,25 +1053,17 @@ ParseGroupString (char *s, LayerGroupType *LayerGroup, int LayerN)
           if (*s != ',')
             goto error;
         }
-      LayerGroup->Number[group] = member;
       if (*s == ':')
         s++;
     }
   if (!s_set)
-    LayerGroup->Entries[SOLDER_LAYER][LayerGroup->Number[SOLDER_LAYER]++] =
-      LayerN + SOLDER_LAYER;
+    AddLayerToGroup (LayerGroup, SOLDER_LAYER, LayerN + SOLDER_LAYER);
   if (!c_set)
-    LayerGroup->
-      Entries[COMPONENT_LAYER][LayerGroup->Number[COMPONENT_LAYER]++] =
-      LayerN + COMPONENT_LAYER;
+    AddLayerToGroup (LayerGroup, COMPONENT_LAYER, LayerN + COMPONENT_LAYER);
 
   for (layer = 0; layer < LayerN && group < LayerN; layer++)
     if (groupnum[layer] == -1)
-      {
-        LayerGroup->Entries[group][0] = layer;
-        LayerGroup->Number[group] = 1;
-        group++;
-      }
+      AddLayerToGroup (LayerGroup, group++, layer);
   return (0);
 
   /* reset structure on error */
@@ -1208,12 +1201,9 @@ ExpandFilename (char *Dirname, char *Filename)
 int
 GetLayerNumber (DataType *Data, LayerType *Layer)
 {
-  int i;
-
-  for (i = 0; i < MAX_LAYER + 2; i++)
-    if (Layer == &Data->Layer[i])
-      break;
-  return (i);
+  if (Layer >= Data->Layer && Layer < Data->Layer + MAX_LAYER + 2)
+    return (Layer - Data->Layer);
+  return (MAX_LAYER + 2);
 }
 
 /* ---------------------------------------------------------------------------
@@ -1261,7 +1251,7 @@ ChangeGroupVisibility (int Layer, bool On, bool ChangeStackOrder)
   if ((group = GetGroupOfLayer (Layer)) < max_group)
     for (i = PCB->LayerGroups.Number[group]; i;)
       {
-        int layer = PCB->LayerGroups.Entries[group][--i];
+        int layer = GROUP_ENTRY (&PCB->LayerGroups, group, --i);
 
         /* don't count the passed member of the group */
         if (layer != Layer && layer < max_copper_layer)
@@ -1399,7 +1389,7 @@ GetGroupOfLayer (int Layer)
     return max_group;
   for (group = 0; group < max_group; group++)
     for (i = 0; i < PCB->LayerGroups.Number[group]; i++)
-      if (PCB->LayerGroups.Entries[group][i] == Layer)
+      if (GROUP_ENTRY (&PCB->LayerGroups, group, i) == Layer)
         return (group);
   return max_group;
 }
@@ -1424,7 +1414,7 @@ GetLayerGroupNumberByNumber (Cardinal Layer)
 
   for (group = 0; group < max_group; group++)
     for (entry = 0; entry < PCB->LayerGroups.Number[group]; entry++)
-      if (PCB->LayerGroups.Entries[group][entry] == Layer)
+      if (GROUP_ENTRY (&PCB->LayerGroups, group, entry) == Layer)
         return (group);
 
   /* since every layer belongs to a group it is safe to return
@@ -1557,7 +1547,7 @@ ResetStackAndVisibility (void)
 
   /* Bring the component group to the front and make it active.  */
   comp_group = GetLayerGroupNumberByNumber (component_silk_layer);
-  ChangeGroupVisibility (PCB->LayerGroups.Entries[comp_group][0], 1, 1);
+  ChangeGroupVisibility (GROUP_ENTRY (&PCB->LayerGroups, comp_group, 0), 1, 1);
 }
 
 /* ---------------------------------------------------------------------------
@@ -1698,62 +1688,232 @@ ChangeArcAngles (LayerType *Layer, ArcType *a,
   ClearFromPolygon (PCB->Data, ARC_TYPE, Layer, a);
 }
 
+/* ---------------------------------------------------------------------------
+ * the element name index: the layout names of the elements of one data
+ * set, so that UniqueElementName() doesn't have to compare against every
+ * element for every name it tries.
+ *
+ * The index is kept up to date by the ElementNameIndex* hooks below,
+ * which the code that adds elements to, or removes them from, a data set
+ * or changes their layout names calls.  It is only trusted while it knows
+ * as many elements as the data set has; otherwise it is rebuilt.  For
+ * each name prefix it also remembers a run of numbers known to be taken,
+ * so that numbering a lot of new elements with the same prefix doesn't
+ * start over at the bottom for each of them.  The hooks also keep the
+ * netlist binding in rats.c current.
+ */
+typedef struct
+{
+  int lo, hi;			/* prefix<lo> ... prefix<hi - 1> are taken */
+} NameRunType;
+
+static struct
+{
+  DataType *Data;
+  GHashTable *ByElement;	/* ElementType * -> its name as counted */
+  GHashTable *Names;		/* name -> number of elements using it */
+  GHashTable *Runs;		/* prefix -> NameRunType */
+} NameIndex;
+
+/* splits a name into the prefix and the number that comes after it,
+ * the way elements are numbered: "R12" -> "R" and 13, "U" -> "U" and 1
+ */
 static char *
-BumpName (char *Name)
+split_name (const char *Name, int *num)
 {
-  int num;
-  char c, *start;
-  static char temp[256];
-
-  start = Name;
-  /* seek end of string */
-  while (*Name != 0)
-    Name++;
-  /* back up to potential number */
-  for (Name--; isdigit ((int) *Name); Name--);
-  Name++;
-  if (*Name)
-    num = atoi (Name) + 1;
+  const char *p = Name + strlen (Name);
+
+  while (p > Name && isdigit ((int) p[-1]))
+    p--;
+  *num = atoi (p) + 1;
+  return g_strndup (Name, p - Name);
+}
+
+static void
+name_index_count (const char *Name, int delta)
+{
+  gpointer key, value;
+  int count = 0;
+
+  if (Name == NULL || *Name == '\0')
+    return;
+  if (g_hash_table_lookup_extended (NameIndex.Names, Name, &key, &value))
+    count = GPOINTER_TO_INT (value);
+  count += delta;
+  if (count > 0)
+    g_hash_table_replace (NameIndex.Names, g_strdup (Name),
+			  GINT_TO_POINTER (count));
   else
-    num = 1;
-  c = *Name;
-  *Name = 0;
-  sprintf (temp, "%s%d", start, num);
-  /* if this is not our string, put back the blown character */
-  if (start != temp)
-    *Name = c;
-  return (temp);
+    {
+      char *prefix;
+      int num;
+
+      g_hash_table_remove (NameIndex.Names, Name);
+      /* the name may have been part of a run of taken numbers */
+      prefix = split_name (Name, &num);
+      g_hash_table_remove (NameIndex.Runs, prefix);
+      g_free (prefix);
+    }
+}
+
+static bool
+name_index_current (DataType *Data)
+{
+  return (NameIndex.Data == Data && NameIndex.ByElement != NULL
+	  && g_hash_table_size (NameIndex.ByElement) == Data->ElementN);
+}
+
+static void
+name_index_rebuild (DataType *Data)
+{
+  if (NameIndex.ByElement == NULL)
+    {
+      NameIndex.ByElement = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+      NameIndex.Names = g_hash_table_new_full (g_str_hash, g_str_equal,
+					       g_free, NULL);
+      NameIndex.Runs = g_hash_table_new_full (g_str_hash, g_str_equal,
+					      g_free, g_free);
+    }
+  else
+    {
+      g_hash_table_remove_all (NameIndex.ByElement);
+      g_hash_table_remove_all (NameIndex.Names);
+      g_hash_table_remove_all (NameIndex.Runs);
+    }
+  NameIndex.Data = Data;
+  ELEMENT_LOOP (Data);
+  {
+    ElementNameIndexInsert (Data, element);
+  }
+  END_LOOP;
+}
+
+/* ---------------------------------------------------------------------------
+ * the element has been added to the data set
+ */
+void
+ElementNameIndexInsert (DataType *Data, ElementType *Element)
+{
+  char *name;
+
+  RatsElementAdded (Data, Element);
+  if (Data != NameIndex.Data)
+    return;
+  name = g_strdup (NAMEONPCB_NAME (Element));
+  g_hash_table_replace (NameIndex.ByElement, Element, name);
+  name_index_count (name, 1);
+}
+
+/* ---------------------------------------------------------------------------
+ * the element is about to leave the data set; its names may already
+ * have been freed
+ */
+void
+ElementNameIndexDelete (DataType *Data, ElementType *Element)
+{
+  char *name;
+
+  RatsElementRemoved (Data, Element);
+  if (Data != NameIndex.Data)
+    return;
+  name = g_hash_table_lookup (NameIndex.ByElement, Element);
+  name_index_count (name, -1);
+  g_hash_table_remove (NameIndex.ByElement, Element);
+}
+
+/* ---------------------------------------------------------------------------
+ * the layout name of the element has changed
+ */
+void
+ElementNameIndexUpdate (DataType *Data, ElementType *Element)
+{
+  if (Data != NameIndex.Data
+      || !g_hash_table_lookup_extended (NameIndex.ByElement, Element,
+					NULL, NULL))
+    {
+      RatsElementRenamed (Data, Element);
+      return;
+    }
+  ElementNameIndexDelete (Data, Element);
+  ElementNameIndexInsert (Data, Element);
+}
+
+/* ---------------------------------------------------------------------------
+ * the data set is going away
+ */
+void
+ElementNameIndexForget (DataType *Data)
+{
+  RatsDataForget (Data);
+  if (Data == NameIndex.Data)
+    NameIndex.Data = NULL;
+}
+
+/* ---------------------------------------------------------------------------
+ * returns the first number from num on for which prefix<number> is free
+ */
+static int
+first_free_number (const char *prefix, int num)
+{
+  NameRunType *run = g_hash_table_lookup (NameIndex.Runs, prefix);
+  char *name;
+  int n = num;
+
+  if (run != NULL && run->lo <= n && n < run->hi)
+    n = run->hi;
+  for (;;)
+    {
+      name = g_strdup_printf ("%s%d", prefix, n);
+      if (!g_hash_table_lookup (NameIndex.Names, name))
+	break;
+      g_free (name);
+      n++;
+    }
+  g_free (name);
+
+  /* remember the numbers just found to be taken */
+  if (n > num)
+    {
+      if (run == NULL)
+	{
+	  run = (NameRunType *) malloc (sizeof (NameRunType));
+	  g_hash_table_insert (NameIndex.Runs, g_strdup (prefix), run);
+	  run->lo = num;
+	}
+      else if (num < run->lo || num > run->hi)
+	run->lo = num;
+      run->hi = n;
+    }
+  return n;
 }
 
 /*
  * make a unique name for the name on board 
- * this can alter the contents of the input string
+ * if the name is taken, the number at its end is counted up until
+ * it isn't: R1 -> R2, U1A -> U1A1
  */
 char *
 UniqueElementName (DataType *Data, char *Name)
 {
-  bool unique = true;
+  static char *unique = NULL;
+  char *prefix;
+  int num;
+
   /* null strings are ok */
   if (!Name || !*Name)
     return (Name);
 
-  for (;;)
-    {
-      ELEMENT_LOOP (Data);
-      {
-        if (NAMEONPCB_NAME (element) &&
-            NSTRCMP (NAMEONPCB_NAME (element), Name) == 0)
-          {
-            Name = BumpName (Name);
-            unique = false;
-            break;
-          }
-      }
-      END_LOOP;
-      if (unique)
-        return (Name);
-      unique = true;
-    }
+  if (!name_index_current (Data))
+    name_index_rebuild (Data);
+  if (!g_hash_table_lookup (NameIndex.Names, Name))
+    return (Name);
+
+  prefix = split_name (Name, &num);
+  num = first_free_number (prefix, num);
+  g_free (unique);
+  unique = g_strdup_printf ("%s%d", prefix, num);
+  g_free (prefix);
+  return (unique);
 }
 
 static void
@@ -1928,7 +2088,7 @@ OldFlags (unsigned int flags)
     {
       /* use the closest thing to the old thermal style */
       if (flags & f)
-	rv.t[i / 2] |= (1 << (4 * (i % 2)));
+	SetFlagThermal (&rv, i, 1);
       f <<= 1;
     }
   return rv;
@@ -1952,10 +2112,76 @@ MaskFlags (FlagType flag, unsigned int flags)
  * Layer Group Functions
  */
 
+/* ---------------------------------------------------------------------------
+ * appends a layer to a group; the members of the groups behind it
+ * move up by one
+ */
+void
+AddLayerToGroup (LayerGroupType *lg, int group, int layer)
+{
+  int g, pos, used;
+
+  used = lg->First[MAX_LAYER - 1] + lg->Number[MAX_LAYER - 1];
+  if (used >= MAX_LAYER + 2)
+    return;
+  pos = lg->First[group] + lg->Number[group];
+  memmove (&lg->Entries[pos + 1], &lg->Entries[pos],
+           (used - pos) * sizeof (lg->Entries[0]));
+  lg->Entries[pos] = layer;
+  lg->Number[group]++;
+  for (g = group + 1; g < MAX_LAYER; g++)
+    lg->First[g]++;
+}
+
+/* ---------------------------------------------------------------------------
+ * removes a layer from a group; the members of the groups behind it
+ * move down by one
+ */
+void
+RemoveLayerFromGroup (LayerGroupType *lg, int group, int layer)
+{
+  int g, pos, end, used;
+
+  used = lg->First[MAX_LAYER - 1] + lg->Number[MAX_LAYER - 1];
+  end = lg->First[group] + lg->Number[group];
+  for (pos = lg->First[group]; pos < end; pos++)
+    if (lg->Entries[pos] == layer)
+      break;
+  if (pos == end)
+    return;
+  memmove (&lg->Entries[pos], &lg->Entries[pos + 1],
+           (used - pos - 1) * sizeof (lg->Entries[0]));
+  lg->Number[group]--;
+  for (g = group + 1; g < MAX_LAYER; g++)
+    lg->First[g]--;
+}
+
+/* ---------------------------------------------------------------------------
+ * rebuilds all groups from the group number of each layer, layers in
+ * ascending order within a group.  Layers with a negative group number
+ * are left out.
+ */
+void
+SetLayerGroups (LayerGroupType *lg, int *group_of_layer, int n_layers)
+{
+  int g, l, filled[MAX_LAYER];
+
+  memset (lg, 0, sizeof (LayerGroupType));
+  memset (filled, 0, sizeof (filled));
+  for (l = 0; l < n_layers; l++)
+    if (group_of_layer[l] >= 0)
+      lg->Number[group_of_layer[l]]++;
+  for (g = 1; g < MAX_LAYER; g++)
+    lg->First[g] = lg->First[g - 1] + lg->Number[g - 1];
+  for (l = 0; l < n_layers; l++)
+    if ((g = group_of_layer[l]) >= 0)
+      lg->Entries[lg->First[g] + filled[g]++] = l;
+}
+
 int
 MoveLayerToGroup (int layer, int group)
 {
-  int prev, i, j;
+  int prev;
 
   if (layer < 0 || layer > max_copper_layer + 1)
     return -1;
@@ -1967,15 +2193,8 @@ MoveLayerToGroup (int layer, int group)
       || (group < 0 || group >= max_group) || (prev == group))
     return prev;
 
-  /* Remove layer from prev group */
-  for (j = i = 0; i < PCB->LayerGroups.Number[prev]; i++)
-    if (PCB->LayerGroups.Entries[prev][i] != layer)
-      PCB->LayerGroups.Entries[prev][j++] = PCB->LayerGroups.Entries[prev][i];
-  PCB->LayerGroups.Number[prev]--;
-
-  /* Add layer to new group.  */
-  i = PCB->LayerGroups.Number[group]++;
-  PCB->LayerGroups.Entries[group][i] = layer;
+  RemoveLayerFromGroup (&PCB->LayerGroups, prev, layer);
+  AddLayerToGroup (&PCB->LayerGroups, group, layer);
 
   return group;
 }
@@ -1998,7 +2217,7 @@ LayerGroupsToString (LayerGroupType *lg)
         sep = 1;
         for (entry = 0; entry < PCB->LayerGroups.Number[group]; entry++)
           {
-            int layer = PCB->LayerGroups.Entries[group][entry];
+            int layer = GROUP_ENTRY (&PCB->LayerGroups, group, entry);
             if (layer == component_silk_layer)
               {
                 *cp++ = 'c';
@@ -2084,8 +2303,8 @@ AttributePutToList (AttributeListType *list, const char *name, const char *value
       for (i=0; i<list->Number; i++)
 	if (strcmp (name, list->List[i].name) == 0)
 	  {
-	    free (list->List[i].value);
-	    list->List[i].value = STRDUP (value);
+	    StringRelease (list->List[i].value);
+	    list->List[i].value = StringIntern (value);
 	    return 1;
 	  }
     }
@@ -2101,8 +2320,8 @@ AttributePutToList (AttributeListType *list, const char *name, const char *value
 
   /* Now add the new attribute.  */
   i = list->Number;
-  list->List[i].name = STRDUP (name);
-  list->List[i].value = STRDUP (value);
+  list->List[i].name = StringIntern (name);
+  list->List[i].value = StringIntern (value);
   list->Number ++;
   return 0;
 }
@@ -2114,8 +2333,8 @@ AttributeRemoveFromList(AttributeListType *list, char *name)
   for (i=0; i<list->Number; i++)
     if (strcmp (name, list->List[i].name) == 0)
       {
-	free (list->List[i].name);
-	free (list->List[i].value);
+	StringRelease (list->List[i].name);
+	StringRelease (list->List[i].value);
 	for (j=i; j<list->Number-i; j++)
 	  list->List[j] = list->List[j+1];
 	list->Number --;
@@ -2272,6 +2491,38 @@ pcb_mkdir (const char *path, int mode)
   return MKDIR (path, mode);
 }
 
+/* ---------------------------------------------------------------------------
+ * bulk edits: between BeginBulkEdit() and EndBulkEdit() the layout's
+ * polygons are not re-clipped after every object that is moved, copied,
+ * removed or changed, and redraws are held back.  Each affected polygon
+ * is re-clipped once when the outermost bulk edit ends.  Polygon shapes
+ * are stale in between, so nothing that looks at them (connection
+ * lookups, DRC, exports) should run inside a bulk edit.  Calls nest.
+ */
+static int BulkEditDepth = 0;
+
+void
+BeginBulkEdit (void)
+{
+  if (BulkEditDepth++ == 0)
+    DeferPolygonClipping (PCB->Data);
+}
+
+void
+EndBulkEdit (void)
+{
+  if (BulkEditDepth == 0 || --BulkEditDepth > 0)
+    return;
+  FlushDeferredClipping ();
+  Draw ();
+}
+
+bool
+InBulkEdit (void)
+{
+  return (BulkEditDepth > 0);
+}
+
 /* ---------------------------------------------------------------------------
  * Returns a best guess about the orientation of an element.  The
  * value corresponds to the rotation; a difference is the right value
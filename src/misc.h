@@ -88,6 +88,10 @@ void CreateQuotedString (DynamicStringType *, char *);
 BoxType * GetArcEnds (ArcType *);
 void ChangeArcAngles (LayerType *, ArcType *, Angle, Angle);
 char *UniqueElementName (DataType *, char *);
+void ElementNameIndexInsert (DataType *, ElementType *);
+void ElementNameIndexDelete (DataType *, ElementType *);
+void ElementNameIndexUpdate (DataType *, ElementType *);
+void ElementNameIndexForget (DataType *);
 void AttachForCopy (Coord, Coord);
 double GetValue (const char *, const char *, bool *);
 double GetValueEx (const char *, const char *, bool *, UnitList, const char *);
@@ -121,6 +125,9 @@ FlagType MaskFlags (FlagType, unsigned int);
 
 /* Layer Group Functions */
 
+void AddLayerToGroup (LayerGroupType *, int, int);
+void RemoveLayerFromGroup (LayerGroupType *, int, int);
+void SetLayerGroups (LayerGroupType *, int *, int);
 /* Returns group actually moved to (i.e. either group or previous) */
 int MoveLayerToGroup (int layer, int group);
 /* returns pointer to private buffer */
@@ -138,9 +145,16 @@ char * GetInfoString (void);
    comparing two similar footprints.  */
 int ElementOrientation (ElementType *e);
 
+void BeginBulkEdit (void);
+void EndBulkEdit (void);
+bool InBulkEdit (void);
+
 /* These are in netlist.c */
 
 void NetlistChanged (int force_unfreeze);
+void NetlistIndexForget (void);
+LibraryMenuType *NetlistFindNode (const char *, LibraryEntryType **);
+LibraryMenuType *NetlistFindNet (const char *);
 
 /*
  * Check whether mkdir() is mkdir or _mkdir, and whether it takes one
@@ -866,13 +866,17 @@ move_one_thermal (int old_index, int new_index, PinType *pin)
   int t1=0, i;
   int oi=old_index, ni=new_index;
 
+  if (!TEST_ANY_THERMS (pin))
+    return;
+
   if (old_index != -1)
     t1 = GET_THERM (old_index, pin);
 
+  /* max_copper_layer already counts the inserted or deleted layer */
   if (oi == -1)
-    oi = MAX_LAYER-1; /* inserting a layer */
+    oi = max_copper_layer-1; /* inserting a layer */
   if (ni == -1)
-    ni = MAX_LAYER-1; /* deleting a layer */
+    ni = max_copper_layer; /* deleting a layer */
 
   if (oi < ni)
     {
@@ -932,7 +936,7 @@ LastLayerInSolderGroup (int layer)
 int
 MoveLayer (int old_index, int new_index)
 {
-  int group_of_layer[MAX_LAYER + 2], l, g, i;
+  int group_of_layer[MAX_LAYER + 2], new_group[MAX_LAYER], l, g, i;
   LayerType saved_layer;
   int saved_group;
 
@@ -971,9 +975,9 @@ MoveLayer (int old_index, int new_index)
   for (l = 0; l < MAX_LAYER+2; l++)
     group_of_layer[l] = -1;
 
-  for (g = 0; g < MAX_LAYER; g++)
+  for (g = 0; g < max_group; g++)
     for (i = 0; i < PCB->LayerGroups.Number[g]; i++)
-      group_of_layer[PCB->LayerGroups.Entries[g][i]] = g;
+      group_of_layer[GROUP_ENTRY (&PCB->LayerGroups, g, i)] = g;
 
   if (old_index == -1)
     {
@@ -1051,30 +1055,18 @@ MoveLayer (int old_index, int new_index)
 
   move_all_thermals(old_index, new_index);
 
-  for (g = 0; g < MAX_LAYER; g++)
-    PCB->LayerGroups.Number[g] = 0;
+  /* renumber the groups, dropping the ones left empty */
+  memset (new_group, 0, sizeof (new_group));
   for (l = 0; l < max_copper_layer + 2; l++)
-    {
-      g = group_of_layer[l];
-
-      /* XXX: Should this ever happen? */
-      if (g < 0)
-        continue;
-
-      i = PCB->LayerGroups.Number[g]++;
-      PCB->LayerGroups.Entries[g][i] = l;
-    }
+    if (group_of_layer[l] >= 0)
+      new_group[group_of_layer[l]] = 1;
+  for (g = i = 0; g < MAX_LAYER; g++)
+    new_group[g] = new_group[g] ? i++ : -1;
+  for (l = 0; l < max_copper_layer + 2; l++)
+    if (group_of_layer[l] >= 0)
+      group_of_layer[l] = new_group[group_of_layer[l]];
 
-  for (g = 1; g < MAX_LAYER; g++)
-    if (PCB->LayerGroups.Number[g - 1] == 0)
-      {
-	memmove (&PCB->LayerGroups.Number[g - 1],
-		 &PCB->LayerGroups.Number[g],
-		 (MAX_LAYER - g) * sizeof (PCB->LayerGroups.Number[g]));
-	memmove (&PCB->LayerGroups.Entries[g - 1],
-		 &PCB->LayerGroups.Entries[g],
-		 (MAX_LAYER - g) * sizeof (PCB->LayerGroups.Entries[g]));
-      }
+  SetLayerGroups (&PCB->LayerGroups, group_of_layer, max_copper_layer + 2);
 
   hid_action ("LayersChanged");
   gui->invalidate_all ();
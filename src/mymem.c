@@ -34,6 +34,7 @@
 
 #include "global.h"
 
+#include <assert.h>
 #include <memory.h>
 
 #include "data.h"
@@ -410,6 +411,7 @@ GetElementMemory (DataType *data)
   new_obj = g_slice_new0 (ElementType);
   data->Element = g_list_append (data->Element, new_obj);
   data->ElementN ++;
+  ElementNameIndexInsert (data, new_obj);
 
   return new_obj;
 }
@@ -603,6 +605,80 @@ FreeNetMemory (NetType *Net)
       memset (Net, 0, sizeof (NetType));
     }
 }
+
+/* ---------------------------------------------------------------------------
+ * The string pool.  Pin and pad names and numbers, element names and
+ * attributes repeat a lot ("1", "2", "GND"), so each distinct string is
+ * kept once with a reference count.  Pooled strings must not be changed
+ * or passed to free(), and two of them are equal exactly if their
+ * pointers are.
+ */
+static GHashTable *string_pool = NULL;	/* string -> reference count */
+
+/* returns the pooled copy of s with one more reference */
+char *
+StringIntern (const char *s)
+{
+  gpointer key, count;
+
+  if (s == NULL)
+    return NULL;
+  if (string_pool == NULL)
+    string_pool = g_hash_table_new (g_str_hash, g_str_equal);
+  if (g_hash_table_lookup_extended (string_pool, s, &key, &count))
+    {
+      g_hash_table_insert (string_pool, key,
+			   GUINT_TO_POINTER (GPOINTER_TO_UINT (count) + 1));
+      return (char *) key;
+    }
+  key = strdup (s);
+  g_hash_table_insert (string_pool, key, GUINT_TO_POINTER (1));
+  return (char *) key;
+}
+
+/* drops a reference to a string returned by StringIntern() */
+void
+StringRelease (char *s)
+{
+  gpointer key, count;
+  bool pooled;
+
+  if (s == NULL)
+    return;
+  pooled = string_pool != NULL
+    && g_hash_table_lookup_extended (string_pool, s, &key, &count)
+    && key == s;
+  assert (pooled);
+  if (!pooled)
+    return;
+  if (GPOINTER_TO_UINT (count) > 1)
+    g_hash_table_insert (string_pool, key,
+			 GUINT_TO_POINTER (GPOINTER_TO_UINT (count) - 1));
+  else
+    {
+      g_hash_table_remove (string_pool, key);
+      free (key);
+    }
+}
+
+/* returns the number of pooled strings and, in bytes, the memory
+ * they take */
+int
+StringPoolUsage (size_t *bytes)
+{
+  GHashTableIter iter;
+  gpointer key;
+
+  if (bytes)
+    *bytes = 0;
+  if (string_pool == NULL)
+    return 0;
+  g_hash_table_iter_init (&iter, string_pool);
+  while (bytes && g_hash_table_iter_next (&iter, &key, NULL))
+    *bytes += strlen ((char *) key) + 1 + 3 * sizeof (gpointer);
+  return g_hash_table_size (string_pool);
+}
+
 /* ---------------------------------------------------------------------------
  * frees memory used by an attribute list
  */
@@ -613,8 +689,8 @@ FreeAttributeListMemory (AttributeListType *list)
 
   for (i = 0; i < list->Number; i++)
     {
-      free (list->List[i].name);
-      free (list->List[i].value);
+      StringRelease (list->List[i].name);
+      StringRelease (list->List[i].value);
     }
   free (list->List);
   list->List = NULL;
@@ -632,19 +708,19 @@ FreeElementMemory (ElementType *element)
 
   ELEMENTNAME_LOOP (element);
   {
-    free (textstring);
+    StringRelease (textstring);
   }
   END_LOOP;
   PIN_LOOP (element);
   {
-    free (pin->Name);
-    free (pin->Number);
+    StringRelease (pin->Name);
+    StringRelease (pin->Number);
   }
   END_LOOP;
   PAD_LOOP (element);
   {
-    free (pad->Name);
-    free (pad->Number);
+    StringRelease (pad->Name);
+    StringRelease (pad->Number);
   }
   END_LOOP;
 
@@ -695,6 +771,7 @@ FreeDataMemory (DataType *data)
   if (data == NULL)
     return;
 
+  ElementNameIndexForget (data);
   VIA_LOOP (data);
   {
     free (via->Name);
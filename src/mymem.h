@@ -100,6 +100,9 @@ void DSAddCharacter (DynamicStringType *, char);
 void DSAddString (DynamicStringType *, const char *);
 void DSClearString (DynamicStringType *);
 char *StripWhiteSpaceAndDup (const char *);
+char *StringIntern (const char *);
+void StringRelease (char *);
+int StringPoolUsage (size_t *);
 
 #ifdef NEED_STRDUP
 char *strdup (const char *);
@@ -85,8 +85,146 @@ typedef void (*NFunc) (LibraryMenuType *, LibraryEntryType *);
 int netlist_frozen = 0;
 static int netlist_needs_update = 0;
 
+/* ---------------------------------------------------------------------------
+ * PCB->NetlistLib indexed by node name ("U1-3") and by net name, so
+ * that cross-probing, the GUIs and the actions below don't scan every
+ * net.  The index holds net and node numbers rather than pointers, so
+ * growing the netlist leaves it valid and netlist_add() keeps it up to
+ * date.  Every other change goes through NetlistChanged(), which drops
+ * it; the next lookup builds it again.
+ */
+typedef struct
+{
+  Cardinal net, node;
+} NetlistNodeRefType;
+
+static struct
+{
+  LibraryType *Lib;		/* the netlist indexed, NULL if none */
+  GHashTable *Nodes;		/* node name -> NetlistNodeRefType */
+  GHashTable *Nets;		/* net name, no prefix -> net number + 1 */
+} NetIndex;
+
 void
-NetlistChanged (int force_unfreeze)
+NetlistIndexForget (void)
+{
+  if (NetIndex.Lib == NULL)
+    return;
+  g_hash_table_destroy (NetIndex.Nodes);
+  g_hash_table_destroy (NetIndex.Nets);
+  NetIndex.Lib = NULL;
+}
+
+/* a name listed twice belongs to the first net or node, as it did for
+   the linear searches this replaces */
+static void
+net_index_add_net (Cardinal ni)
+{
+  char *name = NetIndex.Lib->Menu[ni].Name;
+
+  if (name == NULL || name[0] == '\0' || name[1] == '\0'
+      || g_hash_table_lookup (NetIndex.Nets, name + 2))
+    return;
+  g_hash_table_insert (NetIndex.Nets, g_strdup (name + 2),
+		       GUINT_TO_POINTER (ni + 1));
+}
+
+static void
+net_index_add_node (Cardinal ni, Cardinal pi)
+{
+  char *name = NetIndex.Lib->Menu[ni].Entry[pi].ListEntry;
+  NetlistNodeRefType *ref;
+
+  if (name == NULL || g_hash_table_lookup (NetIndex.Nodes, name))
+    return;
+  ref = g_new (NetlistNodeRefType, 1);
+  ref->net = ni;
+  ref->node = pi;
+  g_hash_table_insert (NetIndex.Nodes, g_strdup (name), ref);
+}
+
+static void
+net_index_build (void)
+{
+  Cardinal ni, pi;
+
+  NetlistIndexForget ();
+  NetIndex.Lib = &PCB->NetlistLib;
+  NetIndex.Nodes = g_hash_table_new_full (g_str_hash, g_str_equal,
+					  g_free, g_free);
+  NetIndex.Nets = g_hash_table_new_full (g_str_hash, g_str_equal,
+					 g_free, NULL);
+  for (ni = 0; ni < NetIndex.Lib->MenuN; ni++)
+    {
+      net_index_add_net (ni);
+      for (pi = 0; pi < NetIndex.Lib->Menu[ni].EntryN; pi++)
+	net_index_add_node (ni, pi);
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * returns the net holding the named node and, if node isn't NULL, the
+ * node itself; NULL if the netlist has no such node
+ */
+LibraryMenuType *
+NetlistFindNode (const char *name, LibraryEntryType **node)
+{
+  LibraryType *lib;
+  NetlistNodeRefType *ref;
+  int tries;
+
+  if (PCB == NULL || name == NULL)
+    return NULL;
+  lib = &PCB->NetlistLib;
+  for (tries = 0; tries < 2; tries++)
+    {
+      if (NetIndex.Lib != lib || tries > 0)
+	net_index_build ();
+      ref = g_hash_table_lookup (NetIndex.Nodes, name);
+      if (ref == NULL)
+	return NULL;
+      /* guard against a change that bypassed NetlistChanged() */
+      if (ref->net < lib->MenuN && ref->node < lib->Menu[ref->net].EntryN
+	  && NSTRCMP (lib->Menu[ref->net].Entry[ref->node].ListEntry,
+		      name) == 0)
+	{
+	  if (node)
+	    *node = &lib->Menu[ref->net].Entry[ref->node];
+	  return &lib->Menu[ref->net];
+	}
+    }
+  return NULL;
+}
+
+/* ---------------------------------------------------------------------------
+ * returns the net of the given name, without the two character prefix
+ */
+LibraryMenuType *
+NetlistFindNet (const char *name)
+{
+  LibraryType *lib;
+  Cardinal ni;
+  int tries;
+
+  if (PCB == NULL || name == NULL)
+    return NULL;
+  lib = &PCB->NetlistLib;
+  for (tries = 0; tries < 2; tries++)
+    {
+      if (NetIndex.Lib != lib || tries > 0)
+	net_index_build ();
+      ni = GPOINTER_TO_UINT (g_hash_table_lookup (NetIndex.Nets, name));
+      if (ni == 0)
+	return NULL;
+      if (ni - 1 < lib->MenuN && lib->Menu[ni - 1].Name
+	  && strcmp (lib->Menu[ni - 1].Name + 2, name) == 0)
+	return &lib->Menu[ni - 1];
+    }
+  return NULL;
+}
+
+static void
+netlist_update_gui (int force_unfreeze)
 {
   if (force_unfreeze)
     netlist_frozen = 0;
@@ -99,43 +237,28 @@ NetlistChanged (int force_unfreeze)
     }
 }
 
+void
+NetlistChanged (int force_unfreeze)
+{
+  NetlistIndexForget ();
+  netlist_update_gui (force_unfreeze);
+}
+
 LibraryMenuType *
 netnode_to_netname (char *nodename)
 {
-  int i, j;
-  /*printf("nodename [%s]\n", nodename);*/
-  for (i=0; i<PCB->NetlistLib.MenuN; i++)
-    {
-      for (j=0; j<PCB->NetlistLib.Menu[i].EntryN; j++)
-	{
-	  if (strcmp (PCB->NetlistLib.Menu[i].Entry[j].ListEntry, nodename) == 0)
-	    {
-	      /*printf(" in [%s]\n", PCB->NetlistLib.Menu[i].Name);*/
-	      return & (PCB->NetlistLib.Menu[i]);
-	    }
-	}
-    }
-  return 0;
+  return NetlistFindNode (nodename, NULL);
 }
 
 LibraryMenuType *
 netname_to_netname (char *netname)
 {
-  int i;
-
   if ((netname[0] == '*' || netname[0] == ' ') && netname[1] == ' ')
     {
       /* Looks like we were passed an internal netname, skip the prefix */
       netname += 2;
     }
-  for (i=0; i<PCB->NetlistLib.MenuN; i++)
-    {
-      if (strcmp (PCB->NetlistLib.Menu[i].Name + 2, netname) == 0)
-	{
-	  return & (PCB->NetlistLib.Menu[i]);
-	}
-    }
-  return 0;
+  return NetlistFindNet (netname);
 }
 
 static int
@@ -247,34 +370,38 @@ netlist_style (LibraryMenuType *net, const char *style)
 static int
 netlist_add (const char *netname, const char *pinname)
 {
-  int ni, pi;
+  int pi;
   LibraryType *netlist = &PCB->NetlistLib;
   LibraryMenuType *net = NULL;
   LibraryEntryType *pin = NULL;
 
-  for (ni=0; ni<netlist->MenuN; ni++)
-    if (strcmp (netlist->Menu[ni].Name+2, netname) == 0)
-      {
-	net = & (netlist->Menu[ni]);
-	break;
-      }
+  net = NetlistFindNet (netname);
   if (net == NULL)
     {
       net = CreateNewNet (netlist, (char *)netname, NULL);
+      net_index_add_net (net - netlist->Menu);
     }
 
-  for (pi=0; pi<net->EntryN; pi++)
-    if (strcmp (net->Entry[pi].ListEntry, pinname) == 0)
-      {
-	pin = & (net->Entry[pi]);
-	break;
-      }
+  /* the index knows the first net of a pin; look at this one if the
+     pin is somewhere else too */
+  if (NetlistFindNode (pinname, &pin) != net && pin != NULL)
+    {
+      pin = NULL;
+      for (pi=0; pi<net->EntryN; pi++)
+	if (strcmp (net->Entry[pi].ListEntry, pinname) == 0)
+	  {
+	    pin = & (net->Entry[pi]);
+	    break;
+	  }
+    }
   if (pin == NULL)
     {
       pin = CreateNewConnection (net, (char *)pinname);
+      net_index_add_node (net - netlist->Menu, pin - net->Entry);
     }
 
-  NetlistChanged (0);
+  /* the index is up to date, only the GUI needs to know */
+  netlist_update_gui (0);
   return 0;
 }
 
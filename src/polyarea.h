@@ -74,6 +74,7 @@ typedef struct VNODE VNODE;
 struct CVCList
 {
     double angle;
+    Vector dir;			/* the edge direction the angle stands for */
     VNODE *parent;
     CVCList *prev, *next, *head;
     char poly, side;
@@ -117,11 +118,13 @@ void poly_DelContour(PLINE ** c);
 BOOLp poly_CopyContour(PLINE ** dst, PLINE * src);
 
 void poly_PreContour(PLINE * c, BOOLp optimize); /* prepare contour */
+void poly_PreStaticContour(PLINE * c); /* prepare caller-owned contour */
 void poly_InvContour(PLINE * c);  /* invert contour */
 
 VNODE *poly_CreateNode(Vector v);
 
 void poly_InclVertex(VNODE * after, VNODE * node);
+void poly_InclStaticVertex(VNODE * after, VNODE * node);
 void poly_ExclVertex(VNODE * node);
 
 /**********************************************************************/
@@ -148,6 +151,8 @@ BOOLp poly_ChkContour(PLINE * a);
 
 BOOLp poly_CheckInside(POLYAREA * c, Vector v0);
 BOOLp Touching(POLYAREA *p1, POLYAREA *p2);
+/* Touching() for a polygon of the single contour c, without allocating */
+BOOLp poly_ContourTouches(PLINE *c, POLYAREA *p);
 
 /**********************************************************************/
 
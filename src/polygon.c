@@ -439,6 +439,121 @@ CirclePoly (Coord x, Coord y, Coord radius)
   return ContourToPoly (contour);
 }
 
+/* ---------------------------------------------------------------------------
+ * Contours built in caller storage, for the point and rectangle tests
+ * below.  They get the same vertices, bounding box and orientation as
+ * the contours of CirclePoly() and RectPoly(), but no r-trees, so they
+ * can only be passed to poly_ContourTouches().
+ */
+typedef struct
+{
+  PLINE line;
+  VNODE node[POLY_CIRC_SEGS];
+  int used;
+} StaticContour;
+
+static void
+static_contour_start (StaticContour *sc, Vector v)
+{
+  memset (sc, 0, sizeof (StaticContour));
+  poly_IniContour (&sc->line);
+  Vcpy2 (sc->line.head.point, v);
+}
+
+static void
+static_contour_add (StaticContour *sc, Vector v)
+{
+  VNODE *node = &sc->node[sc->used++];
+
+  Vcpy2 (node->point, v);
+  poly_InclStaticVertex (sc->line.head.prev, node);
+}
+
+#ifndef NDEBUG
+/* true if sc is the outer contour of p vertex for vertex; frees p */
+static bool
+static_contour_matches (StaticContour *sc, POLYAREA *p)
+{
+  VNODE *a = &sc->line.head, *b;
+  bool same;
+
+  if (p == NULL)
+    return false;
+  b = &p->contours->head;
+  same = sc->line.Count == p->contours->Count
+    && sc->line.Flags.orient == p->contours->Flags.orient
+    && sc->line.xmin == p->contours->xmin && sc->line.xmax == p->contours->xmax
+    && sc->line.ymin == p->contours->ymin && sc->line.ymax == p->contours->ymax;
+  do
+    {
+      same = same && a->point[0] == b->point[0] && a->point[1] == b->point[1];
+      a = a->next;
+      b = b->next;
+    }
+  while (same && a != &sc->line.head);
+  same = same && b == &p->contours->head;
+  poly_Free (&p);
+  return same;
+}
+#endif
+
+/* like CirclePoly */
+static bool
+static_circle (StaticContour *sc, Coord x, Coord y, Coord radius)
+{
+  double e1, e2, t1;
+  Vector v;
+  int i;
+
+  if (radius <= 0)
+    return false;
+  v[0] = x + radius;
+  v[1] = y;
+  static_contour_start (sc, v);
+  /* as frac_circle (.., 1), which repeats the first point */
+  static_contour_add (sc, v);
+  e1 = (v[0] - x) * POLY_CIRC_RADIUS_ADJ;
+  e2 = (v[1] - y) * POLY_CIRC_RADIUS_ADJ;
+  for (i = 0; i < POLY_CIRC_SEGS - 1; i++)
+    {
+      t1 = rotate_circle_seg[0] * e1 + rotate_circle_seg[1] * e2;
+      e2 = rotate_circle_seg[2] * e1 + rotate_circle_seg[3] * e2;
+      e1 = t1;
+      v[0] = x + ROUND (e1);
+      v[1] = y + ROUND (e2);
+      static_contour_add (sc, v);
+    }
+  sc->line.is_round = TRUE;
+  sc->line.cx = x;
+  sc->line.cy = y;
+  sc->line.radius = radius;
+  poly_PreStaticContour (&sc->line);
+  assert (static_contour_matches (sc, CirclePoly (x, y, radius)));
+  return true;
+}
+
+/* like RectPoly */
+static bool
+static_rect (StaticContour *sc, Coord x1, Coord x2, Coord y1, Coord y2)
+{
+  Vector v;
+
+  if (x2 <= x1 || y2 <= y1)
+    return false;
+  v[0] = x1;
+  v[1] = y1;
+  static_contour_start (sc, v);
+  v[0] = x2;
+  static_contour_add (sc, v);
+  v[1] = y2;
+  static_contour_add (sc, v);
+  v[0] = x1;
+  static_contour_add (sc, v);
+  poly_PreStaticContour (&sc->line);
+  assert (static_contour_matches (sc, RectPoly (x1, x2, y1, y2)));
+  return true;
+}
+
 /* make a rounded-corner rectangle with radius t beyond x1,x2,y1,y2 rectangle */
 POLYAREA *
 RoundRect (Coord x1, Coord x2, Coord y1, Coord y2, Coord t)
@@ -1024,7 +1139,7 @@ Group (DataType *Data, Cardinal layer)
   Cardinal i, j;
   for (i = 0; i < max_group; i++)
     for (j = 0; j < ((PCBType *) (Data->pcb))->LayerGroups.Number[i]; j++)
-      if (layer == ((PCBType *) (Data->pcb))->LayerGroups.Entries[i][j])
+      if (layer == GROUP_ENTRY (&((PCBType *) (Data->pcb))->LayerGroups, i, j))
         return i;
   return i;
 }
@@ -1623,13 +1738,138 @@ PlowsPolygon (DataType * Data, int type, void *ptr1, void *ptr2,
   return r;
 }
 
+/* ---------------------------------------------------------------------------
+ * deferred clipping: while it is on for a data set, RestoreToPolygon() and
+ * ClearFromPolygon() only note which polygons are affected and where.
+ * FlushDeferredClipping() then re-clips each of them once, over the
+ * bounding box of all regions touched in the meantime.
+ */
+typedef struct
+{
+  BoxType region;		/* union of the touched boxes */
+  bool full;			/* the polygon itself changed */
+} DeferredClipType;
+
+static DataType *DeferredData = NULL;
+static GHashTable *DeferredClips = NULL;	/* PolygonType * -> DeferredClipType * */
+
+static DeferredClipType *
+deferred_clip (PolygonType *polygon)
+{
+  DeferredClipType *clip = g_hash_table_lookup (DeferredClips, polygon);
+
+  if (clip == NULL)
+    {
+      clip = (DeferredClipType *) malloc (sizeof (DeferredClipType));
+      clip->region.X1 = clip->region.Y1 = MAX_COORD;
+      clip->region.X2 = clip->region.Y2 = -MAX_COORD;
+      clip->full = false;
+      g_hash_table_insert (DeferredClips, polygon, clip);
+    }
+  return clip;
+}
+
+static int
+defer_plow (DataType *Data, LayerType *Layer, PolygonType *Polygon,
+            int type, void *ptr1, void *ptr2)
+{
+  DeferredClipType *clip = deferred_clip (Polygon);
+  /* the cast works for all objects that plow, see PlowsPolygon() */
+  BoxType *box = &((PinType *) ptr2)->BoundingBox;
+
+  MAKEMIN (clip->region.X1, box->X1);
+  MAKEMIN (clip->region.Y1, box->Y1);
+  MAKEMAX (clip->region.X2, box->X2);
+  MAKEMAX (clip->region.Y2, box->Y2);
+  return 1;
+}
+
+static void
+defer_clip (int type, void *ptr1, void *ptr2)
+{
+  if (type == POLYGON_TYPE)
+    deferred_clip ((PolygonType *) ptr2)->full = true;
+  else
+    PlowsPolygon (DeferredData, type, ptr1, ptr2, defer_plow);
+}
+
+/* re-clips a polygon over its touched region, or as a whole if that
+ * covers all of it anyway
+ */
+static void
+reclip_deferred (DataType *Data, LayerType *layer, PolygonType *polygon,
+                 DeferredClipType *clip)
+{
+  BoxType *bb = &polygon->BoundingBox;
+  POLYAREA *np;
+
+  if (!clip->full && polygon->Clipped
+      && (clip->region.X1 > bb->X1 || clip->region.Y1 > bb->Y1
+          || clip->region.X2 < bb->X2 || clip->region.Y2 < bb->Y2))
+    {
+      /* overlap a bit to prevent notches from rounding errors */
+      np = BoxPolyBloated (&clip->region, UNSUBTRACT_BLOAT);
+      if (np && Unsubtract (np, polygon))
+        {
+          clearPoly (Data, layer, polygon, &clip->region,
+                     2 * UNSUBTRACT_BLOAT);
+          return;
+        }
+    }
+  InitClip (Data, layer, polygon);
+}
+
+void
+DeferPolygonClipping (DataType *Data)
+{
+  if (DeferredClips == NULL)
+    DeferredClips = g_hash_table_new_full (NULL, NULL, NULL, free);
+  DeferredData = Data;
+}
+
+void
+FlushDeferredClipping (void)
+{
+  DataType *Data = DeferredData;
+
+  if (Data == NULL)
+    return;
+  DeferredData = NULL;
+  /* a board loaded in the meantime has been clipped already */
+  if (Data != PCB->Data || g_hash_table_size (DeferredClips) == 0)
+    {
+      g_hash_table_remove_all (DeferredClips);
+      return;
+    }
+
+  /* walk the layers rather than the table: polygons that were removed
+   * in the meantime are simply never looked at, and ones that moved to
+   * another layer are clipped against their new one
+   */
+  LAYER_LOOP (Data, max_copper_layer + 2);
+  {
+    POLYGON_LOOP (layer);
+    {
+      DeferredClipType *clip = g_hash_table_lookup (DeferredClips, polygon);
+
+      if (clip != NULL)
+        reclip_deferred (Data, layer, polygon, clip);
+    }
+    END_LOOP;
+  }
+  END_LOOP;
+  g_hash_table_remove_all (DeferredClips);
+}
+
 void
 RestoreToPolygon (DataType * Data, int type, void *ptr1, void *ptr2)
 {
   if (!Data->polyClip)
     return;
 
-  if (type == POLYGON_TYPE)
+  if (Data == DeferredData)
+    defer_clip (type, ptr1, ptr2);
+  else if (type == POLYGON_TYPE)
     InitClip (PCB->Data, (LayerType *) ptr1, (PolygonType *) ptr2);
   else
     PlowsPolygon (Data, type, ptr1, ptr2, add_plow);
@@ -1641,7 +1881,9 @@ ClearFromPolygon (DataType * Data, int type, void *ptr1, void *ptr2)
   if (!Data->polyClip)
     return;
 
-  if (type == POLYGON_TYPE)
+  if (Data == DeferredData)
+    defer_clip (type, ptr1, ptr2);
+  else if (type == POLYGON_TYPE)
     InitClip (PCB->Data, (LayerType *) ptr1, (PolygonType *) ptr2);
   else
     PlowsPolygon (Data, type, ptr1, ptr2, subtract_plow);
@@ -1652,7 +1894,11 @@ isects (POLYAREA * a, PolygonType *p, bool fr)
 {
   POLYAREA *x;
   bool ans;
-  ans = Touching (a, p->Clipped);
+  /* a single contour needs no Boolean machinery */
+  if (a->f == a && a->contours->next == NULL)
+    ans = poly_ContourTouches (a->contours, p->Clipped);
+  else
+    ans = Touching (a, p->Clipped);
   /* argument may be register, so we must copy it */
   x = a;
   if (fr)
@@ -1664,7 +1910,7 @@ isects (POLYAREA * a, PolygonType *p, bool fr)
 bool
 IsPointInPolygon (Coord X, Coord Y, Coord r, PolygonType *p)
 {
-  POLYAREA *c;
+  StaticContour c;
   Vector v;
   v[0] = X;
   v[1] = Y;
@@ -1672,9 +1918,9 @@ IsPointInPolygon (Coord X, Coord Y, Coord r, PolygonType *p)
     return true;
   if (r < 1)
     return false;
-  if (!(c = CirclePoly (X, Y, r)))
+  if (!static_circle (&c, X, Y, r))
     return false;
-  return isects (c, p, true);
+  return poly_ContourTouches (&c.line, p->Clipped);
 }
 
 
@@ -1690,11 +1936,10 @@ IsPointInPolygonIgnoreHoles (Coord X, Coord Y, PolygonType *p)
 bool
 IsRectangleInPolygon (Coord X1, Coord Y1, Coord X2, Coord Y2, PolygonType *p)
 {
-  POLYAREA *s;
-  if (!
-      (s = RectPoly (min (X1, X2), max (X1, X2), min (Y1, Y2), max (Y1, Y2))))
+  StaticContour s;
+  if (!static_rect (&s, min (X1, X2), max (X1, X2), min (Y1, Y2), max (Y1, Y2)))
     return false;
-  return isects (s, p, true);
+  return poly_ContourTouches (&s.line, p->Clipped);
 }
 
 /* NB: This function will free the passed POLYAREA.
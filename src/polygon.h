@@ -78,6 +78,8 @@ void frac_circle (PLINE *, Coord, Coord, Vector, int);
 int InitClip(DataType *d, LayerType *l, PolygonType *p);
 void RestoreToPolygon(DataType *, int, void *, void *);
 void ClearFromPolygon(DataType *, int, void *, void *);
+void DeferPolygonClipping (DataType *);
+void FlushDeferredClipping (void);
 
 bool IsPointInPolygon (Coord, Coord, Coord, PolygonType *);
 bool IsPointInPolygonIgnoreHoles (Coord, Coord, PolygonType *);
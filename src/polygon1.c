@@ -44,6 +44,7 @@
 #include	<stdio.h>
 #include	<setjmp.h>
 #include	<math.h>
+#include	<float.h>
 #include	<string.h>
 
 #include "global.h"
@@ -70,6 +71,8 @@ void vect_max (Vector res, Vector v2, Vector v3);
 double vect_dist2 (Vector v1, Vector v2);
 double vect_det2 (Vector v1, Vector v2);
 double vect_len2 (Vector v1);
+static int vect_det2_sign (Vector v1, Vector v2);
+static int vect_orient (Vector a, Vector b, Vector c);
 
 int vect_inters2 (Vector A, Vector B, Vector C, Vector D, Vector S1,
 		  Vector S2);
@@ -252,6 +255,7 @@ new_descriptor (VNODE * a, char poly, char side)
   else if (v[0] >= 0 && v[1] < 0)
     ang = 4.0 - ang;		/* 4th quadrant */
   l->angle = ang;
+  Vcpy2 (l->dir, v);
   assert (ang >= 0.0 && ang <= 4.0);
 #ifdef DEBUG_ANGLE
   DEBUGP ("node on %c at %#mD assigned angle %g on side %c\n", poly,
@@ -260,6 +264,30 @@ new_descriptor (VNODE * a, char poly, char side)
   return l;
 }
 
+/* quadrant of a descriptor direction, as new_descriptor() assigns them */
+static int
+cvc_quadrant (CVCList * l)
+{
+  if (l->dir[1] >= 0)
+    return l->dir[0] >= 0 ? 0 : 1;
+  return l->dir[0] < 0 ? 2 : 3;
+}
+
+/* compares the directions of two descriptors, exactly: ->angle rounds,
+ * so nearly parallel edges can get the same angle, and equal angles
+ * are taken for a shared edge.  Within a quadrant the sign of the
+ * cross product decides.
+ */
+static int
+cvc_compare (CVCList * a, CVCList * b)
+{
+  int qa = cvc_quadrant (a), qb = cvc_quadrant (b);
+
+  if (qa != qb)
+    return qa < qb ? -1 : 1;
+  return -vect_det2_sign (a->dir, b->dir);
+}
+
 /*
 insert_descriptor
   (C) 2006 harry eaton
@@ -315,12 +343,13 @@ insert_descriptor (VNODE * a, char poly, char side, CVCList * start)
   l = big = small = start;
   do
     {
-      if (l->next->angle < l->angle)	/* find start/end of list */
+      if (cvc_compare (l->next, l) < 0)	/* find start/end of list */
 	{
 	  small = l->next;
 	  big = l;
 	}
-      else if (newone->angle >= l->angle && newone->angle <= l->next->angle)
+      else if (cvc_compare (newone, l) >= 0
+	       && cvc_compare (newone, l->next) <= 0)
 	{
 	  /* insert new cvc if it lies between existing points */
 	  newone->prev = l;
@@ -331,14 +360,14 @@ insert_descriptor (VNODE * a, char poly, char side, CVCList * start)
     }
   while ((l = l->next) != start);
   /* didn't find it between points, it must go on an end */
-  if (big->angle <= newone->angle)
+  if (cvc_compare (big, newone) <= 0)
     {
       newone->prev = big;
       newone->next = big->next;
       big->next = big->next->prev = newone;
       return newone;
     }
-  assert (small->angle >= newone->angle);
+  assert (cvc_compare (small, newone) >= 0);
   newone->next = small;
   newone->prev = small->prev;
   small->prev = small->prev->next = newone;
@@ -390,7 +419,7 @@ node_label (VNODE * pn)
    * check for shared edges (that could be prev or next in the list since the angles are equal)
    * and check if this edge (pn -> pn->next) is found between the other poly's entry and exit
    */
-  if (pn->cvc_next->angle == pn->cvc_next->prev->angle)
+  if (cvc_compare (pn->cvc_next, pn->cvc_next->prev) == 0)
     l = pn->cvc_next->prev;
   else
     l = pn->cvc_next->next;
@@ -416,7 +445,7 @@ node_label (VNODE * pn)
 	}
       else
 	{
-	  if (l->angle == pn->cvc_next->angle)
+	  if (cvc_compare (l, pn->cvc_next) == 0)
 	    {
 	      assert (l->parent->next->point[0] == pn->next->point[0] &&
 		      l->parent->next->point[1] == pn->next->point[1]);
@@ -1695,8 +1724,12 @@ Collect (jmp_buf * e, PLINE * a, POLYAREA ** contours, PLINE ** holes,
       if (s_rule (cur, &dir) && cur->Flags.mark == 0)
 	Collect1 (e, cur, dir, contours, holes, j_rule);
       other = cur;
+      /* jump() leaves a backward walk on the vertex it starts from,
+       * while Collect1() wants the one before it, like the S_Rules give
+       */
       if ((other->cvc_prev && jump (&other, &dir, j_rule)))
-	Collect1 (e, other, dir, contours, holes, j_rule);
+	Collect1 (e, dir == FORW ? other : other->prev, dir, contours, holes,
+		  j_rule);
     }
   while ((cur = cur->next) != &a->head);
 }				/* Collect */
@@ -2583,8 +2616,11 @@ poly_DelContour (PLINE ** c)
   free (*c), *c = NULL;
 }
 
-void
-poly_PreContour (PLINE * C, BOOLp optimize)
+/* prepares a contour; nodes on a line with their neighbours are only
+ * unlinked, not freed, unless free_nodes is set
+ */
+static void
+prepare_contour (PLINE * C, BOOLp optimize, BOOLp free_nodes)
 {
   double area = 0;
   VNODE *p, *c;
@@ -2605,10 +2641,11 @@ poly_PreContour (PLINE * C, BOOLp optimize)
 	   * So, remove the point c
 	   */
 
-	  if (vect_det2 (p1, p2) == 0)
+	  if (vect_det2_sign (p1, p2) == 0)
 	    {
 	      poly_ExclVertex (c);
-	      free (c);
+	      if (free_nodes)
+	        free (c);
 	      c = p;
 	    }
 	}
@@ -2634,9 +2671,26 @@ poly_PreContour (PLINE * C, BOOLp optimize)
   C->area = ABS (area);
   if (C->Count > 2)
     C->Flags.orient = ((area < 0) ? PLF_INV : PLF_DIR);
+}
+
+void
+poly_PreContour (PLINE * C, BOOLp optimize)
+{
+  prepare_contour (C, optimize, TRUE);
   C->tree = (rtree_t *)make_edge_tree (C);
 }				/* poly_PreContour */
 
+/* like poly_PreContour (C, TRUE) for a contour whose nodes the caller
+ * owns, e.g. on the stack: no node is freed and no r-tree is built, so
+ * the contour can only be used with poly_ContourTouches()
+ */
+void
+poly_PreStaticContour (PLINE * C)
+{
+  prepare_contour (C, TRUE, FALSE);
+  C->tree = NULL;
+}
+
 static int
 flip_cb (const BoxType * b, void *cl)
 {
@@ -2689,10 +2743,12 @@ poly_ExclVertex (VNODE * node)
   node->next->prev = node->prev;
 }
 
-void
-poly_InclVertex (VNODE * after, VNODE * node)
+/* links node in after after; returns a node dropped for lying on a line
+ * with its neighbours, if any
+ */
+static VNODE *
+incl_vertex (VNODE * after, VNODE * node)
 {
-  double a, b;
   assert (after != NULL);
   assert (node != NULL);
 
@@ -2701,18 +2757,31 @@ poly_InclVertex (VNODE * after, VNODE * node)
   after->next = after->next->prev = node;
   /* remove points on same line */
   if (node->prev->prev == node)
-    return;			/* we don't have 3 points in the poly yet */
-  a = (node->point[1] - node->prev->prev->point[1]);
-  a *= (node->prev->point[0] - node->prev->prev->point[0]);
-  b = (node->point[0] - node->prev->prev->point[0]);
-  b *= (node->prev->point[1] - node->prev->prev->point[1]);
-  if (fabs (a - b) < EPSILON)
+    return NULL;		/* we don't have 3 points in the poly yet */
+  if (vect_orient (node->prev->prev->point, node->prev->point,
+		   node->point) == 0)
     {
       VNODE *t = node->prev;
       t->prev->next = node;
       node->prev = t->prev;
-      free (t);
+      return t;
     }
+  return NULL;
+}
+
+void
+poly_InclVertex (VNODE * after, VNODE * node)
+{
+  free (incl_vertex (after, node));
+}
+
+/* like poly_InclVertex for a node the caller owns; a node dropped for
+ * lying on a line with its neighbours is only unlinked
+ */
+void
+poly_InclStaticVertex (VNODE * after, VNODE * node)
+{
+  incl_vertex (after, node);
 }
 
 BOOLp
@@ -3096,6 +3165,278 @@ poly_ContourInContour (PLINE * poly, PLINE * inner)
   return 0;
 }
 
+/*
+ * poly_ContourTouches() (and helpers)
+ * Answers Touching() for a polygon made of the single contour c, without
+ * copying anything, building cross vertex lists or needing c's r-trees:
+ * c may be a contour built on the stack.  Each step follows what the
+ * intersect and label passes of Touching() would do with c, searching
+ * the r-trees of p where Touching() would and walking c's edges where it
+ * would have searched c's.  Like Touching(), only the first piece of p
+ * is looked at.
+ */
+
+typedef struct
+{
+  VNODE *v;			/* the edge being looked up */
+  double m, b;			/* its slant, for region trimming */
+  jmp_buf env;			/* where to go when they touch */
+} touch_info;
+
+static void
+edge_box (VNODE * v, BoxType * box)
+{
+  /* the same box make_edge_tree() gives the edge */
+  box->X1 = min (v->point[0], v->next->point[0]);
+  box->X2 = max (v->point[0], v->next->point[0]) + 1;
+  box->Y1 = min (v->point[1], v->next->point[1]);
+  box->Y2 = max (v->point[1], v->next->point[1]) + 1;
+}
+
+static int
+touch_seg_in_region (const BoxType * b, void *cl)
+{
+  touch_info *i = (touch_info *) cl;
+  double y1, y2;
+  /* for zero slope the search is aligned on the axis so it is already pruned */
+  if (i->m == 0.)
+    return 1;
+  y1 = i->m * b->X1 + i->b;
+  y2 = i->m * b->X2 + i->b;
+  if (min (y1, y2) >= b->Y2)
+    return 0;
+  if (max (y1, y2) < b->Y1)
+    return 0;
+  return 1;			/* might intersect */
+}
+
+static int
+touch_seg_in_seg (const BoxType * b, void *cl)
+{
+  touch_info *i = (touch_info *) cl;
+  struct seg *s = (struct seg *) b;
+  Vector s1, s2;
+
+  if (s->intersected)
+    return 0;
+  if (vect_inters2 (s->v->point, s->v->next->point,
+		    i->v->point, i->v->next->point, s1, s2))
+    longjmp (i->env, 1);
+  return 0;
+}
+
+/* does an edge of p's contour, looked up in its r-tree, meet the edge
+ * av of the tree-less contour?
+ */
+static int
+edge_touches_tree (VNODE * av, PLINE * pc)
+{
+  touch_info info;
+  BoxType box;
+  double dx;
+
+  info.v = av;
+  dx = av->next->point[0] - av->point[0];
+  if (dx == 0)
+    info.m = 0;
+  else
+    {
+      info.m = (av->next->point[1] - av->point[1]) / dx;
+      info.b = av->point[1] - info.m * av->point[0];
+    }
+  edge_box (av, &box);
+  if (setjmp (info.env) == 0)
+    {
+      r_search (pc->tree, &box, touch_seg_in_region, touch_seg_in_seg, &info);
+      return FALSE;
+    }
+  return TRUE;
+}
+
+typedef struct
+{
+  PLINE *c;			/* the contour without r-tree */
+  jmp_buf env;
+} tree_less_info;
+
+/* does the edge of p's contour in the seg meet any edge of c? */
+static int
+seg_touches_contour (const BoxType * b, void *cl)
+{
+  tree_less_info *t = (tree_less_info *) cl;
+  struct seg *s = (struct seg *) b;
+  VNODE *cv = &t->c->head;
+  BoxType box;
+  Vector s1, s2;
+
+  if (s->intersected)
+    return 0;
+  do
+    {
+      edge_box (cv, &box);
+      if (box.X1 < s->box.X2 && box.X2 > s->box.X1 &&
+	  box.Y1 < s->box.Y2 && box.Y2 > s->box.Y1 &&
+	  vect_inters2 (cv->point, cv->next->point,
+			s->v->point, s->v->next->point, s1, s2))
+	longjmp (t->env, 1);
+    }
+  while ((cv = cv->next) != &t->c->head);
+  return 0;
+}
+
+/* do the edges of p's contour pc and the contour c meet?  pa is the
+ * contour Touching() loops over, the other one is found in a tree.
+ */
+static BOOLp
+contour_edges_touch (PLINE * pa, PLINE * pc, PLINE * c)
+{
+  PLINE *pb = (pa == c) ? pc : c;
+  VNODE *av;
+
+  if (pa->Count < pb->Count ? pb == c : pa == c)
+    {
+      /* the edges of pc are searched in c's tree: walk c instead */
+      tree_less_info t;
+
+      t.c = c;
+      if (setjmp (t.env) == 0)
+	{
+	  r_search (pc->tree, NULL, NULL, seg_touches_contour, &t);
+	  return FALSE;
+	}
+      return TRUE;
+    }
+  av = &c->head;
+  do
+    if (edge_touches_tree (av, pc))
+      return TRUE;
+  while ((av = av->next) != &c->head);
+  return FALSE;
+}
+
+typedef struct
+{
+  PLINE *c;
+  jmp_buf env;
+} contour_touch_info;
+
+static int
+contour_edges_touch_cb (const BoxType * b, void *cl)
+{
+  contour_touch_info *i = (contour_touch_info *) cl;
+
+  if (contour_edges_touch (i->c, (PLINE *) b, i->c))
+    longjmp (i->env, 1);
+  return 0;
+}
+
+/* poly_InsideContour() for a contour without r-tree: the same crossing
+ * count, over the edges a search along the ray would find
+ */
+static int
+inside_tree_less_contour (PLINE * c, Vector p)
+{
+  VNODE *v = &c->head;
+  BoxType box;
+  int f = 0;
+
+  if (!cntrbox_pointin (c, p))
+    return FALSE;
+  do
+    {
+      Vector v1, v2;
+      long long cross;
+
+      edge_box (v, &box);
+      if (box.X2 <= p[0] || box.Y1 >= p[1] + 1 || box.Y2 <= p[1])
+	continue;
+      if (v->point[1] <= p[1] ? v->next->point[1] > p[1]
+	  : v->next->point[1] <= p[1])
+	{
+	  Vsub2 (v1, v->next->point, v->point);
+	  Vsub2 (v2, p, v->point);
+	  cross = (long long) v1[0] * v2[1] - (long long) v2[0] * v1[1];
+	  if (cross == 0)
+	    return 1;
+	  if (v->point[1] <= p[1])
+	    {
+	      if (cross > 0)
+		f += 1;
+	    }
+	  else if (cross < 0)
+	    f -= 1;
+	}
+    }
+  while ((v = v->next) != &c->head);
+  return f;
+}
+
+/* poly_ContourInContour (c, inner) for a contour c without r-tree */
+static int
+inside_tree_less (PLINE * c, PLINE * inner)
+{
+  Vector point;
+
+  if (!cntrbox_inside (inner, c))
+    return 0;
+  if (!inside_tree_less_contour (c, inner->head.point))
+    return 0;
+  poly_ComputeInteriorPoint (inner, point);
+  return inside_tree_less_contour (c, point);
+}
+
+BOOLp
+poly_ContourTouches (PLINE * c, POLYAREA * p)
+{
+  PLINE *pc;
+
+  if (p == NULL || c == NULL)
+    return FALSE;
+
+  /* intersect pass: do any edges meet? */
+  if (c->xmax >= p->contours->xmin && c->ymax >= p->contours->ymin &&
+      c->xmin <= p->contours->xmax && c->ymin <= p->contours->ymax)
+    {
+      if (p->contour_tree->size > 1)
+	{
+	  contour_touch_info info;
+	  BoxType sb;
+
+	  info.c = c;
+	  sb.X1 = c->xmin;
+	  sb.Y1 = c->ymin;
+	  sb.X2 = c->xmax + 1;
+	  sb.Y2 = c->ymax + 1;
+	  if (setjmp (info.env) != 0)
+	    return TRUE;
+	  r_search (p->contour_tree, &sb, NULL, contour_edges_touch_cb, &info);
+	}
+      else
+	{
+	  pc = p->contours;
+	  if (c->xmin < pc->xmax + 1 && c->xmax > pc->xmin &&
+	      c->ymin < pc->ymax + 1 && c->ymax > pc->ymin &&
+	      contour_edges_touch (pc, pc, c))
+	    return TRUE;
+	}
+    }
+
+  /* label passes: is c inside p, or a contour of p inside c? */
+  if (c->Flags.status != ISECTED &&
+      cntrbox_inside (c, p->contours) &&
+      r_search (p->contour_tree, (BoxType *) c, NULL,
+		count_contours_i_am_inside, c) == 1)
+    return TRUE;
+  for (pc = p->contours; pc != NULL; pc = pc->next)
+    if (pc->Flags.status != ISECTED &&
+	cntrbox_inside (pc, c) &&
+	c->xmin < pc->xmax && c->xmax > pc->xmin &&
+	c->ymin < pc->ymax && c->ymax > pc->ymin &&
+	inside_tree_less (c, pc))
+      return TRUE;
+  return FALSE;
+}
+
 void
 poly_Init (POLYAREA * p)
 {
@@ -3157,9 +3498,9 @@ inside_sector (VNODE * pn, Vector p2)
   vect_sub (pdir, pn->point, pn->prev->point);
   vect_sub (ndir, pn->next->point, pn->point);
 
-  p_c = vect_det2 (pdir, cdir) >= 0;
-  n_c = vect_det2 (ndir, cdir) >= 0;
-  p_n = vect_det2 (pdir, ndir) >= 0;
+  p_c = vect_det2_sign (pdir, cdir) >= 0;
+  n_c = vect_det2_sign (ndir, cdir) >= 0;
+  p_n = vect_det2_sign (pdir, ndir) >= 0;
 
   if ((p_n && p_c && n_c) || ((!p_n) && (p_c || n_c)))
     return TRUE;
@@ -3365,34 +3706,130 @@ vect_det2 (Vector v1, Vector v2)
   return (((double) v1[0] * v2[1]) - ((double) v2[0] * v1[1]));
 }
 
-static double
-vect_m_dist (Vector v1, Vector v2)
+/*
+ * Exact orientation predicates.
+ *
+ * Coordinate differences take 32 bits, or more with 64-bit coordinates,
+ * so the products in a 2x2 determinant do not fit the 53 bits of a
+ * double, and the determinant can come out zero, or with the wrong
+ * sign, for edges that are nearly but not quite parallel.  The
+ * sign is first estimated in floating point; the estimate is only
+ * trusted when it is larger than its worst case rounding error, which
+ * leaves out the near degenerate cases.  Those are settled by
+ * multiplying out the magnitudes in 32-bit halves.
+ */
+
+/* worst case error of a * d - b * c in double, relative to |ad| + |bc|:
+ * two conversions and a multiplication for each product and the
+ * subtraction, each off by at most half of DBL_EPSILON
+ */
+#define DET_ERRBOUND (4 * DBL_EPSILON)
+
+/* the 128-bit product of x and y, as its high and low 64 bits */
+static void
+mul_wide (unsigned long long x, unsigned long long y,
+	  unsigned long long *hi, unsigned long long *lo)
 {
-  double dx = v1[0] - v2[0];
-  double dy = v1[1] - v2[1];
-  double dd = (dx * dx + dy * dy);	/* sqrt */
-
-  if (dx > 0)
-    return +dd;
-  if (dx < 0)
-    return -dd;
-  if (dy > 0)
-    return +dd;
-  return -dd;
+  unsigned long long x0 = x & 0xffffffffULL, x1 = x >> 32;
+  unsigned long long y0 = y & 0xffffffffULL, y1 = y >> 32;
+  unsigned long long p00 = x0 * y0, p01 = x0 * y1;
+  unsigned long long p10 = x1 * y0, p11 = x1 * y1;
+  unsigned long long mid;
+
+  mid = (p00 >> 32) + (p01 & 0xffffffffULL) + (p10 & 0xffffffffULL);
+  *lo = (mid << 32) | (p00 & 0xffffffffULL);
+  *hi = p11 + (p01 >> 32) + (p10 >> 32) + (mid >> 32);
+}
+
+#define MAGNITUDE(a) ((a) < 0 ? -(unsigned long long) (a) \
+				: (unsigned long long) (a))
+
+static int
+det_sign_exact (Coord a, Coord b, Coord c, Coord d)
+{
+  int s1 = SGN (a) * SGN (d), s2 = SGN (b) * SGN (c);
+  unsigned long long h1, l1, h2, l2;
+  int cmp;
+
+  /* the products differ in sign, so that decides */
+  if (s1 != s2)
+    return s1 > s2 ? 1 : -1;
+  if (s1 == 0)
+    return 0;
+  mul_wide (MAGNITUDE (a), MAGNITUDE (d), &h1, &l1);
+  mul_wide (MAGNITUDE (b), MAGNITUDE (c), &h2, &l2);
+  if (h1 != h2)
+    cmp = h1 > h2 ? 1 : -1;
+  else if (l1 != l2)
+    cmp = l1 > l2 ? 1 : -1;
+  else
+    cmp = 0;
+  return s1 * cmp;
+}
+
+/* sign of a * d - b * c */
+static int
+det_sign (Coord a, Coord b, Coord c, Coord d)
+{
+  double ad = (double) a * d;
+  double bc = (double) b * c;
+  double det = ad - bc;
+  double bound = DET_ERRBOUND * (fabs (ad) + fabs (bc));
+
+  if (det > bound)
+    return 1;
+  if (-det > bound)
+    return -1;
+  return det_sign_exact (a, b, c, d);
+}
+
+/* sign of vect_det2 (v1, v2), exactly */
+static int
+vect_det2_sign (Vector v1, Vector v2)
+{
+  return det_sign (v1[0], v2[0], v1[1], v2[1]);
+}
+
+/* 1 if c lies left of the line a->b, -1 if right of it, 0 if on it */
+static int
+vect_orient (Vector a, Vector b, Vector c)
+{
+  Vector ab, ac;
+
+  Vsub2 (ab, b, a);
+  Vsub2 (ac, c, a);
+  return vect_det2_sign (ab, ac);
+}
+
+/* position of v2 along a line through v1 that runs along axis, or is
+ * vertical if axis is 1; only meaningful for comparisons between points
+ * on that line
+ */
+static Coord
+vect_m_dist (Vector v1, Vector v2, int axis)
+{
+  return v2[axis] - v1[axis];
 }				/* vect_m_dist */
 
 /*
 vect_inters2
  (C) 1993 Klamer Schutte
  (C) 1997 Michael Leonov, Alexey Nikitin
+
+ Whether the segments meet is decided with the exact predicates above,
+ so touching and collinear segments are found reliably; only a crossing
+ point that lies strictly inside both segments is computed in floating
+ point and rounded to the grid.
 */
 
 int
 vect_inters2 (Vector p1, Vector p2, Vector q1, Vector q2,
 	      Vector S1, Vector S2)
 {
-  double s, t, deel;
+  double t, deel;
   double rpx, rpy, rqx, rqy;
+  Vector rp, rq;
+  int sp1, sp2, sq1, sq2;
 
   if (max (p1[0], p2[0]) < min (q1[0], q2[0]) ||
       max (q1[0], q2[0]) < min (p1[0], p2[0]) ||
@@ -3400,34 +3837,29 @@ vect_inters2 (Vector p1, Vector p2, Vector q1, Vector q2,
       max (q1[1], q2[1]) < min (p1[1], p2[1]))
     return 0;
 
-  rpx = p2[0] - p1[0];
-  rpy = p2[1] - p1[1];
-  rqx = q2[0] - q1[0];
-  rqy = q2[1] - q1[1];
+  Vsub2 (rp, p2, p1);
+  Vsub2 (rq, q2, q1);
 
-  deel = rpy * rqx - rpx * rqy;	/* -vect_det(rp,rq); */
-
-  /* coordinates are 30-bit integers so deel will be exactly zero
-   * if the lines are parallel
-   */
-
-  if (deel == 0)		/* parallel */
+  if (vect_det2_sign (rp, rq) == 0)	/* parallel */
     {
-      double dc1, dc2, d1, d2, h;	/* Check to see whether p1-p2 and q1-q2 are on the same line */
+      Coord dc1, dc2, d1, d2, h;	/* Check to see whether p1-p2 and q1-q2 are on the same line */
       Vector hp1, hq1, hp2, hq2, q1p1, q1q2;
+      int axis;
 
       Vsub2 (q1p1, q1, p1);
       Vsub2 (q1q2, q1, q2);
 
 
       /* If this product is not zero then p1-p2 and q1-q2 are not on same line! */
-      if (vect_det2 (q1p1, q1q2) != 0)
+      if (vect_det2_sign (q1p1, q1q2) != 0)
 	return 0;
+      /* measure along x unless the line is vertical */
+      axis = (rp[0] == 0 && rq[0] == 0) ? 1 : 0;
       dc1 = 0;			/* m_len(p1 - p1) */
 
-      dc2 = vect_m_dist (p1, p2);
-      d1 = vect_m_dist (p1, q1);
-      d2 = vect_m_dist (p1, q2);
+      dc2 = vect_m_dist (p1, p2, axis);
+      d1 = vect_m_dist (p1, q1, axis);
+      d2 = vect_m_dist (p1, q2, axis);
 
 /* Sorting the independent points from small to large */
       Vcpy2 (hp1, p1);
@@ -3481,45 +3913,62 @@ vect_inters2 (Vector p1, Vector p2, Vector q1, Vector q2,
     }
   else
     {				/* not parallel */
-      /*
-       * We have the lines:
-       * l1: p1 + s(p2 - p1)
-       * l2: q1 + t(q2 - q1)
-       * And we want to know the intersection point.
-       * Calculate t:
-       * p1 + s(p2-p1) = q1 + t(q2-q1)
-       * which is similar to the two equations:
-       * p1x + s * rpx = q1x + t * rqx
-       * p1y + s * rpy = q1y + t * rqy
-       * Multiplying these by rpy resp. rpx gives:
-       * rpy * p1x + s * rpx * rpy = rpy * q1x + t * rpy * rqx
-       * rpx * p1y + s * rpx * rpy = rpx * q1y + t * rpx * rqy
-       * Subtracting these gives:
-       * rpy * p1x - rpx * p1y = rpy * q1x - rpx * q1y + t * ( rpy * rqx - rpx * rqy )
-       * So t can be isolated:
-       * t = (rpy * ( p1x - q1x ) + rpx * ( - p1y + q1y )) / ( rpy * rqx - rpx * rqy )
-       * and s can be found similarly
-       * s = (rqy * (q1x - p1x) + rqx * (p1y - q1y))/( rqy * rpx - rqx * rpy)
+      /* the segments meet unless both ends of one of them lie
+       * strictly on the same side of the other
        */
+      sq1 = vect_orient (p1, p2, q1);
+      sq2 = vect_orient (p1, p2, q2);
+      if (sq1 * sq2 > 0)
+	return 0;
+      sp1 = vect_orient (q1, q2, p1);
+      sp2 = vect_orient (q1, q2, p2);
+      if (sp1 * sp2 > 0)
+	return 0;
 
-      if (Vequ2 (q1, p1) || Vequ2 (q1, p2))
+      /* an end on the other segment is the intersection point */
+      if (sp1 == 0)
 	{
-	  S1[0] = q1[0];
-	  S1[1] = q1[1];
+	  Vcpy2 (S1, p1);
 	}
-      else if (Vequ2 (q2, p1) || Vequ2 (q2, p2))
+      else if (sp2 == 0)
 	{
-	  S1[0] = q2[0];
-	  S1[1] = q2[1];
+	  Vcpy2 (S1, p2);
+	}
+      else if (sq1 == 0)
+	{
+	  Vcpy2 (S1, q1);
+	}
+      else if (sq2 == 0)
+	{
+	  Vcpy2 (S1, q2);
 	}
       else
 	{
-	  s = (rqy * (p1[0] - q1[0]) + rqx * (q1[1] - p1[1])) / deel;
-	  if (s < 0 || s > 1.)
-	    return 0;
+	  /*
+	   * We have the lines:
+	   * l1: p1 + s(p2 - p1)
+	   * l2: q1 + t(q2 - q1)
+	   * And we want to know the intersection point.
+	   * Calculate t:
+	   * p1 + s(p2-p1) = q1 + t(q2-q1)
+	   * which is similar to the two equations:
+	   * p1x + s * rpx = q1x + t * rqx
+	   * p1y + s * rpy = q1y + t * rqy
+	   * Multiplying these by rpy resp. rpx gives:
+	   * rpy * p1x + s * rpx * rpy = rpy * q1x + t * rpy * rqx
+	   * rpx * p1y + s * rpx * rpy = rpx * q1y + t * rpx * rqy
+	   * Subtracting these gives:
+	   * rpy * p1x - rpx * p1y = rpy * q1x - rpx * q1y + t * ( rpy * rqx - rpx * rqy )
+	   * So t can be isolated:
+	   * t = (rpy * ( p1x - q1x ) + rpx * ( - p1y + q1y )) / ( rpy * rqx - rpx * rqy )
+	   * The signs above put t strictly between 0 and 1.
+	   */
+	  rpx = rp[0];
+	  rpy = rp[1];
+	  rqx = rq[0];
+	  rqy = rq[1];
+	  deel = rpy * rqx - rpx * rqy;	/* -vect_det(rp,rq); */
 	  t = (rpy * (p1[0] - q1[0]) + rpx * (q1[1] - p1[1])) / deel;
-	  if (t < 0 || t > 1.)
-	    return 0;
 
 	  S1[0] = q1[0] + ROUND (t * rqx);
 	  S1[1] = q1[1] + ROUND (t * rqy);
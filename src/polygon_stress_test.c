@@ -0,0 +1,287 @@
+/*
+ *                            COPYRIGHT
+ *
+ *  PCB, interactive printed circuit board design
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+/* Stress test for the Boolean operations on degenerate input: shared
+ * edges and vertices, nearly parallel edges, copies shifted by a unit
+ * and collinear edges at arbitrary slopes, at coordinates near the top
+ * of the 32-bit range.  Every operation must succeed and give valid
+ * pieces, and the areas of the results must add up to those of the
+ * inputs to within the snap rounding.  The time spent per kind of
+ * input is printed.  The shapes come from a fixed seed, or the one
+ * given as argument.  Each kind of input gets STRESS_TRIALS trials or
+ * STRESS_BUDGET seconds, whichever ends first, so that a slow machine
+ * or a debug build does not hold up make check.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+
+#include "global.h"
+#include "polygon_test.h"
+
+#define STRESS_RANGE (1 << 29)
+#define STRESS_TRIALS 2000
+#define STRESS_BUDGET 10	/* seconds of CPU time per kind of input */
+
+static Coord
+stress_random (Coord range)
+{
+  return (Coord) (random () % (2 * range + 1)) - range;
+}
+
+/* squares and circles on a coarse grid */
+static void
+stress_grid (Vector *a, int *na, Vector *b, int *nb)
+{
+  Coord step = STRESS_RANGE / 16;
+
+  test_shape (a, na, (random () % 8) * step, (random () % 8) * step,
+	      (random () % 4 + 1) * step, random () & 1);
+  test_shape (b, nb, (random () % 8) * step, (random () % 8) * step,
+	      (random () % 4 + 1) * step, random () & 1);
+}
+
+/* r and s with p * s - q * r = 1, for p and q without a common factor */
+static void
+stress_neighbour (Coord p, Coord q, Coord *r, Coord *s)
+{
+  Coord a = p, b = q, x0 = 1, x1 = 0, y0 = 0, y1 = 1, t, k;
+
+  /* extended Euclid: a == p * x0 + q * y0 throughout */
+  while (b != 0)
+    {
+      k = a / b;
+      t = a - k * b, a = b, b = t;
+      t = x0 - k * x1, x0 = x1, x1 = t;
+      t = y0 - k * y1, y0 = y1, y1 = t;
+    }
+  *r = -y0 * a;
+  *s = x0 * a;
+}
+
+static Coord
+stress_gcd (Coord a, Coord b)
+{
+  Coord t;
+
+  a = ABS (a), b = ABS (b);
+  while (b != 0)
+    t = a % b, a = b, b = t;
+  return a;
+}
+
+/* triangles sharing a vertex, on either side of two long edges that are
+ * as close to parallel as the grid allows, or parallel
+ */
+static void
+stress_sliver (Vector *a, int *na, Vector *b, int *nb)
+{
+  Coord ox = stress_random (STRESS_RANGE / 4);
+  Coord oy = stress_random (STRESS_RANGE / 4);
+  Coord dx, dy, ex, ey, nx, ny, g;
+
+  do
+    {
+      dx = stress_random (STRESS_RANGE / 4);
+      dy = stress_random (STRESS_RANGE / 4);
+      g = stress_gcd (dx, dy);
+    }
+  while (g == 0 || ABS (dx / g) + ABS (dy / g) < 1000);
+  dx /= g, dy /= g;
+  switch (random () % 3)
+    {
+    case 0:			/* one unit of cross product apart */
+      stress_neighbour (dx, dy, &ex, &ey);
+      ex += dx, ey += dy;
+      break;
+    case 1:			/* the other way */
+      stress_neighbour (dx, dy, &ex, &ey);
+      ex = dx - ex, ey = dy - ey;
+      break;
+    default:			/* collinear, and longer */
+      ex = 2 * dx, ey = 2 * dy;
+      break;
+    }
+  nx = -dy / (random () % 1000 + 2), ny = dx / (random () % 1000 + 2);
+
+  a[0][0] = ox, a[0][1] = oy;
+  a[1][0] = ox + dx, a[1][1] = oy + dy;
+  a[2][0] = ox + dx + nx, a[2][1] = oy + dy + ny;
+  b[0][0] = ox, b[0][1] = oy;
+  b[1][0] = ox + ex, b[1][1] = oy + ey;
+  b[2][0] = ox - nx, b[2][1] = oy - ny;
+  *na = *nb = 3;
+}
+
+/* a circle and a copy of it shifted by at most a unit */
+static void
+stress_shifted (Vector *a, int *na, Vector *b, int *nb)
+{
+  int i;
+
+  test_shape (a, na, stress_random (STRESS_RANGE / 2),
+	      stress_random (STRESS_RANGE / 2),
+	      random () % (STRESS_RANGE / 2) + 1000, 1);
+  for (i = 0; i < *na; i++)
+    {
+      b[i][0] = a[i][0] + stress_random (1);
+      b[i][1] = a[i][1] + stress_random (1);
+    }
+  *nb = *na;
+}
+
+/* rectangles along the same slanted lines, overlapping edge on edge */
+static void
+stress_collinear (Vector *a, int *na, Vector *b, int *nb)
+{
+  Coord ox = stress_random (STRESS_RANGE / 4);
+  Coord oy = stress_random (STRESS_RANGE / 4);
+  Coord ux = stress_random (1 << 14), uy = stress_random (1 << 14);
+  Vector *r;
+  int k;
+
+  for (k = 0, r = a; k < 2; k++, r = b)
+    {
+      Coord i0 = random () % 4096, i1 = i0 + random () % 4096 + 1;
+      Coord j0 = random () % 4, j1 = j0 + random () % 4 + 1;
+
+      r[0][0] = ox + i0 * ux - j0 * uy, r[0][1] = oy + i0 * uy + j0 * ux;
+      r[1][0] = ox + i1 * ux - j0 * uy, r[1][1] = oy + i1 * uy + j0 * ux;
+      r[2][0] = ox + i1 * ux - j1 * uy, r[2][1] = oy + i1 * uy + j1 * ux;
+      r[3][0] = ox + i0 * ux - j1 * uy, r[3][1] = oy + i0 * uy + j1 * ux;
+    }
+  *na = *nb = 4;
+  if (ux == 0 && uy == 0)
+    stress_grid (a, na, b, nb);
+}
+
+static double
+stress_perimeter (Vector *pts, int n)
+{
+  double len = 0;
+  int i;
+
+  for (i = 0; i < n; i++)
+    len += sqrt (vect_dist2 (pts[i], pts[(i + 1) % n]));
+  return len;
+}
+
+/* area of all pieces, or -1 if a piece is invalid */
+static double
+stress_area (POLYAREA * p)
+{
+  POLYAREA *q = p;
+  PLINE *c;
+  double area = 0;
+
+  if (p == NULL)
+    return 0;
+  do
+    {
+      if (!poly_Valid (q))
+	return -1;
+      area += q->contours->area;
+      for (c = q->contours->next; c != NULL; c = c->next)
+	area -= c->area;
+    }
+  while ((q = q->f) != p);
+  return area;
+}
+
+typedef struct
+{
+  const char *name;
+  void (*make) (Vector *, int *, Vector *, int *);
+} stress_case;
+
+static stress_case stress_cases[] = {
+  {"grid", stress_grid},
+  {"sliver", stress_sliver},
+  {"shifted", stress_shifted},
+  {"collinear", stress_collinear},
+};
+
+int
+main (int argc, char **argv)
+{
+  unsigned int seed = argc > 1 ? atoi (argv[1]) : 1;
+  int errors = 0, k, trial, op;
+
+  printf ("seed %u\n", seed);
+  srandom (seed);
+  for (k = 0; k < sizeof (stress_cases) / sizeof (stress_cases[0]); k++)
+    {
+      int failed = 0;
+      clock_t start = clock ();
+      clock_t stop = start + STRESS_BUDGET * CLOCKS_PER_SEC;
+
+      for (trial = 0; trial < STRESS_TRIALS && clock () < stop; trial++)
+	{
+	  Vector pa[TEST_SEGS], pb[TEST_SEGS];
+	  double area[PBO_SUB + 1], sa, sb, tol;
+	  POLYAREA *a, *b, *res;
+	  int na, nb, bad = 0;
+
+	  stress_cases[k].make (pa, &na, pb, &nb);
+	  a = test_poly (pa, na);
+	  b = test_poly (pb, nb);
+	  /* PBO_XOR is not used in pcb and asserts on multiple pieces */
+	  for (op = PBO_UNITE; op <= PBO_SUB; op++)
+	    {
+	      res = NULL;
+	      if (poly_Boolean (a, b, &res, op) != err_ok)
+		area[op] = -1;
+	      else
+		area[op] = stress_area (res);
+	      if (area[op] < 0)
+		bad = 1;
+	      poly_Free (&res);
+	    }
+	  /* each crossing moves by less than a unit when it is rounded */
+	  tol = 2 * (stress_perimeter (pa, na) + stress_perimeter (pb, nb));
+	  sa = a->contours->area;
+	  sb = b->contours->area;
+	  if (!bad && (fabs (area[PBO_UNITE] + area[PBO_ISECT] - sa - sb) > tol
+		       || fabs (area[PBO_SUB] + area[PBO_ISECT] - sa) > tol
+		       || area[PBO_UNITE] < MAX (sa, sb) - tol
+		       || area[PBO_ISECT] > MIN (sa, sb) + tol))
+	    bad = 1;
+	  if (bad)
+	    {
+	      if (failed++ < 3)
+		printf ("%s: failed trial %d\n", stress_cases[k].name, trial);
+	    }
+	  poly_Free (&a);
+	  poly_Free (&b);
+	}
+      printf ("%-10s %d of %d failed, %.1f ms\n", stress_cases[k].name,
+	      failed, trial,
+	      1000.0 * (clock () - start) / CLOCKS_PER_SEC);
+      errors += failed;
+    }
+  return errors != 0;
+}
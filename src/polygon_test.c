@@ -0,0 +1,75 @@
+/*
+ *                            COPYRIGHT
+ *
+ *  PCB, interactive printed circuit board design
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <math.h>
+
+#include "global.h"
+#include "polygon_test.h"
+
+/* ---------------------------------------------------------------------------
+ * stores in pts a square of half width r, or a circle of radius r, at
+ * x, y, and its number of vertices in n
+ */
+void
+test_shape (Vector *pts, int *n, Coord x, Coord y, Coord r, int round)
+{
+  int i;
+
+  *n = 0;
+  if (round)
+    for (i = 0; i < TEST_SEGS; i++)
+      {
+	pts[*n][0] = x + TEST_ROUND (r * cos (2 * M_PI * i / TEST_SEGS));
+	pts[(*n)++][1] = y + TEST_ROUND (r * sin (2 * M_PI * i / TEST_SEGS));
+      }
+  else
+    {
+      pts[0][0] = x - r, pts[0][1] = y - r;
+      pts[1][0] = x + r, pts[1][1] = y - r;
+      pts[2][0] = x + r, pts[2][1] = y + r;
+      pts[3][0] = x - r, pts[3][1] = y + r;
+      *n = 4;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * makes a polygon of the n points, in either orientation
+ */
+POLYAREA *
+test_poly (Vector *pts, int n)
+{
+  PLINE *c = poly_NewContour (pts[0]);
+  POLYAREA *p;
+  int i;
+
+  for (i = 1; i < n; i++)
+    poly_InclVertex (c->head.prev, poly_CreateNode (pts[i]));
+  poly_PreContour (c, TRUE);
+  if (c->Flags.orient != PLF_DIR)
+    poly_InvContour (c);
+  p = poly_Create ();
+  poly_InclContour (p, c);
+  return p;
+}
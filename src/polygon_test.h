@@ -0,0 +1,36 @@
+/*
+ *                            COPYRIGHT
+ *
+ *  PCB, interactive printed circuit board design
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+/* Shapes shared by the polygon library tests, polytouch and polystress.  */
+
+#ifndef PCB_POLYGON_TEST_H
+#define PCB_POLYGON_TEST_H
+
+#include "global.h"
+
+#define TEST_SEGS 40		/* vertices of a test circle */
+
+#define TEST_ROUND(a) ((long) ((a) > 0 ? ((a) + 0.5) : ((a) - 0.5)))
+
+void test_shape (Vector *, int *, Coord, Coord, Coord, int);
+POLYAREA *test_poly (Vector *, int);
+
+#endif
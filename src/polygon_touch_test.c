@@ -0,0 +1,137 @@
+/*
+ *                            COPYRIGHT
+ *
+ *  PCB, interactive printed circuit board design
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ */
+
+/* Checks poly_ContourTouches() against Touching().  Pours are made by
+ * Boolean operations on squares on a coarse grid, and squares and
+ * circles on the same grid are tested against them, so shared edges,
+ * shared vertices and vertices on edges come up often.  Pours are not
+ * cut by circles: on some of those the clipper trips its own asserts,
+ * which would end the test in a debug build.  The shapes come from a
+ * fixed seed, or the one given as argument.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "global.h"
+#include "polygon_test.h"
+
+typedef struct
+{
+  PLINE line;
+  VNODE node[TEST_SEGS];
+} test_contour;
+
+/* the contour of the n points in caller storage, as polygon.c builds
+ * them for poly_ContourTouches()
+ */
+static void
+test_static (test_contour *t, Vector *pts, int n)
+{
+  int i;
+
+  memset (t, 0, sizeof (test_contour));
+  poly_IniContour (&t->line);
+  t->line.head.point[0] = pts[0][0];
+  t->line.head.point[1] = pts[0][1];
+  for (i = 1; i < n; i++)
+    {
+      t->node[i - 1].point[0] = pts[i][0];
+      t->node[i - 1].point[1] = pts[i][1];
+      poly_InclStaticVertex (t->line.head.prev, &t->node[i - 1]);
+    }
+  poly_PreStaticContour (&t->line);
+}
+
+static Coord
+grid (int n)
+{
+  return (random () % n) * 100;
+}
+
+int
+main (int argc, char **argv)
+{
+  unsigned int seed = argc > 1 ? atoi (argv[1]) : 1;
+  int round, trial, q, n;
+  int errors = 0, count = 0, touching = 0;
+  Vector pts[TEST_SEGS];
+
+  printf ("seed %u\n", seed);
+  srandom (seed);
+  for (trial = 0; trial < 2000; trial++)
+    {
+      POLYAREA *pour, *shape, *res;
+      int k;
+
+      test_shape (pts, &n, grid (20), grid (20), grid (8) + 200, 0);
+      pour = test_poly (pts, n);
+      for (k = random () % 6; k > 0; k--)
+	{
+	  test_shape (pts, &n, grid (20), grid (20), grid (4) + 100, 0);
+	  shape = test_poly (pts, n);
+	  /* skip pours the clipper got wrong; only the predicates are tested */
+	  if (poly_Boolean_free (pour, shape, &res,
+				 (random () & 3) ? PBO_SUB : PBO_UNITE) != 0
+	      || res == NULL || !poly_Valid (res))
+	    {
+	      poly_Free (&res);
+	      break;
+	    }
+	  pour = res;
+	}
+      if (k > 0)
+	continue;
+
+      for (q = 0; q < 50; q++)
+	{
+	  test_contour t;
+	  POLYAREA *a;
+	  BOOLp fast, slow;
+
+	  round = random () & 1;
+	  test_shape (pts, &n, grid (24), grid (24), grid (3) + 50, round);
+	  a = test_poly (pts, n);
+	  test_static (&t, pts, n);
+	  /* the contour's own list is what Touching() gets */
+	  slow = Touching (a, pour);
+	  fast = poly_ContourTouches (&t.line, pour);
+	  if (!fast != !slow)
+	    {
+	      printf ("mismatch: %s at %d,%d: Touching %d, fast %d\n",
+		      round ? "circle" : "square", (int) pts[0][0],
+		      (int) pts[0][1], slow, fast);
+	      errors++;
+	    }
+	  touching += !!slow;
+	  count++;
+	  poly_Free (&a);
+	}
+      poly_Free (&pour);
+    }
+  printf ("%d errors in %d tests, %d touching\n", errors, count, touching);
+  return errors != 0;
+}
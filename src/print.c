@@ -210,6 +210,7 @@ PrintFab_overhang (void)
 {
   DrillInfoType *AllDrills = GetDrillInfo (PCB->Data);
   int ds = count_drill_lines (AllDrills);
+  FreeDrillInfo (AllDrills);
   if (ds < 4)
     ds = 4;
   return (ds + 2) * TEXT_LINE;
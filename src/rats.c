@@ -65,7 +65,6 @@
 /* ---------------------------------------------------------------------------
  * some forward declarations
  */
-static bool FindPad (char *, char *, ConnectionType *, bool);
 static bool ParseConnection (char *, char *, char *);
 static bool DrawShortestRats (NetListType *, void (*)(register ConnectionType *, register ConnectionType *, register RouteStyleType *));
 static bool GatherSubnets (NetListType *, bool, bool);
@@ -112,59 +111,308 @@ ParseConnection (char *InString, char *ElementName, char *PinNum)
 }
 
 /* ---------------------------------------------------------------------------
- * Find a particular pad from an element name and pin number
+ * the netlist binding: what each "refdes-pin" netlist node resolves to
+ * in PCB->Data, so that SeekPad() doesn't have to parse the string and
+ * search the elements by name each time.
+ *
+ * Nodes are keyed by their string, which makes the binding independent
+ * of where the netlist keeps its entries.  A node holds the pads and
+ * pins of its element that carry the pin number, pads first, in the
+ * order FindPad() used to try them.  Positions, sides and the hole
+ * flag are looked up when a node is used, as they change with edits.
+ *
+ * The code that adds elements to a data set, removes them or renames
+ * them calls the RatsElement* hooks (through the element name index in
+ * misc.c); they drop the resolution of the nodes naming that element.
  */
-static bool
-FindPad (char *ElementName, char *PinNum, ConnectionType * conn, bool Same)
+typedef struct
+{
+  char *ElementName, *PinNum;	/* as ParseConnection() split them;
+				   PinNum is pooled, see StringIntern() */
+  bool Resolved;
+  GArray *Conns;		/* ConnectionType; type, ptr1 and ptr2 only */
+} NetNodeType;
+
+static struct
+{
+  DataType *Data;		/* the data set the handles point into */
+  GHashTable *Nodes;		/* node string -> NetNodeType */
+  GHashTable *NodesOf;		/* element name -> GSList of NetNodeType */
+  GHashTable *Elements;		/* element name -> GSList of ElementType */
+  GHashTable *NameOf;		/* ElementType -> its name in Elements */
+} Binding;
+
+static void
+free_net_node (NetNodeType *node)
+{
+  free (node->ElementName);
+  StringRelease (node->PinNum);
+  g_array_free (node->Conns, TRUE);
+  free (node);
+}
+
+static void
+free_slist (gpointer list)
+{
+  g_slist_free ((GSList *) list);
+}
+
+/* files list under name in table, or drops name if list is empty */
+static void
+binding_set_list (GHashTable *table, const char *name, GSList *list)
+{
+  gpointer key, old;
+
+  if (g_hash_table_lookup_extended (table, name, &key, &old))
+    g_hash_table_steal (table, name);
+  else
+    key = g_strdup (name);
+  if (list != NULL)
+    g_hash_table_insert (table, key, list);
+  else
+    g_free (key);
+}
+
+static void
+binding_file_element (ElementType *element)
 {
-  ElementType *element;
+  char *name = NAMEONPCB_NAME (element);
+  gpointer key, list;
+  GSList *nodes;
+
+  if (name == NULL)
+    return;
+  list = g_hash_table_lookup (Binding.Elements, name);
+  binding_set_list (Binding.Elements, name, g_slist_append (list, element));
+  g_hash_table_lookup_extended (Binding.Elements, name, &key, &list);
+  g_hash_table_insert (Binding.NameOf, element, key);
+  for (nodes = g_hash_table_lookup (Binding.NodesOf, name); nodes;
+       nodes = g_slist_next (nodes))
+    ((NetNodeType *) nodes->data)->Resolved = false;
+}
+
+static void
+binding_unfile_element (ElementType *element)
+{
+  char *name = g_hash_table_lookup (Binding.NameOf, element);
+  GSList *list, *nodes;
+
+  if (name == NULL)
+    return;
+  g_hash_table_remove (Binding.NameOf, element);
+  for (nodes = g_hash_table_lookup (Binding.NodesOf, name); nodes;
+       nodes = g_slist_next (nodes))
+    ((NetNodeType *) nodes->data)->Resolved = false;
+  list = g_hash_table_lookup (Binding.Elements, name);
+  binding_set_list (Binding.Elements, name, g_slist_remove (list, element));
+}
+
+/* drops the binding; the next SeekPad() binds to PCB->Data afresh */
+static void
+binding_forget (void)
+{
+  if (Binding.Nodes == NULL)
+    return;
+  g_hash_table_destroy (Binding.NameOf);
+  g_hash_table_destroy (Binding.Elements);
+  g_hash_table_destroy (Binding.NodesOf);
+  g_hash_table_destroy (Binding.Nodes);
+  Binding.Nodes = NULL;
+  Binding.Data = NULL;
+}
+
+static void
+binding_start (void)
+{
+  binding_forget ();
+  Binding.Data = PCB->Data;
+  Binding.Nodes = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+					 (GDestroyNotify) free_net_node);
+  Binding.NodesOf = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+					   free_slist);
+  Binding.Elements = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+					    free_slist);
+  Binding.NameOf = g_hash_table_new (NULL, NULL);
+  ELEMENT_LOOP (PCB->Data);
+  {
+    binding_file_element (element);
+  }
+  END_LOOP;
+}
+
+/* ---------------------------------------------------------------------------
+ * the element has been added to the data set
+ */
+void
+RatsElementAdded (DataType *Data, ElementType *Element)
+{
+  if (Binding.Nodes != NULL && Data == Binding.Data)
+    binding_file_element (Element);
+}
+
+/* ---------------------------------------------------------------------------
+ * the element is about to leave the data set; its names may already
+ * have been freed
+ */
+void
+RatsElementRemoved (DataType *Data, ElementType *Element)
+{
+  if (Binding.Nodes != NULL && Data == Binding.Data)
+    binding_unfile_element (Element);
+}
+
+/* ---------------------------------------------------------------------------
+ * the layout name of the element has changed
+ */
+void
+RatsElementRenamed (DataType *Data, ElementType *Element)
+{
+  if (Binding.Nodes != NULL && Data == Binding.Data)
+    {
+      binding_unfile_element (Element);
+      binding_file_element (Element);
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * the data set is going away
+ */
+void
+RatsDataForget (DataType *Data)
+{
+  if (Data == Binding.Data)
+    binding_forget ();
+}
+
+/* ---------------------------------------------------------------------------
+ * looks up the pads and pins of a node, resolving it if need be.
+ * Returns NULL, after complaining, for a badly formatted node.
+ */
+static NetNodeType *
+bind_node (char *ListEntry)
+{
+  NetNodeType *node;
+  ElementType *element = NULL;
+  GSList *list;
   GList *i;
+  char ElementName[256];
+  char PinNum[256];
 
-  if ((element = SearchElementByName (PCB->Data, ElementName)) == NULL)
-    return false;
+  if (Binding.Nodes == NULL || Binding.Data != PCB->Data)
+    binding_start ();
+
+  node = g_hash_table_lookup (Binding.Nodes, ListEntry);
+  if (node == NULL)
+    {
+      if (ParseConnection (ListEntry, ElementName, PinNum))
+	return NULL;
+      node = (NetNodeType *) malloc (sizeof (NetNodeType));
+      node->ElementName = strdup (ElementName);
+      node->PinNum = StringIntern (PinNum);
+      node->Resolved = false;
+      node->Conns = g_array_new (FALSE, FALSE, sizeof (ConnectionType));
+      g_hash_table_insert (Binding.Nodes, g_strdup (ListEntry), node);
+      list = g_hash_table_lookup (Binding.NodesOf, ElementName);
+      binding_set_list (Binding.NodesOf, ElementName,
+			g_slist_prepend (list, node));
+    }
+  if (node->Resolved)
+    return node;
+
+  node->Resolved = true;
+  g_array_set_size (node->Conns, 0);
+  if (node->PinNum[0] == '\0')
+    return node;
+
+  /* several elements by one name: take the one the search finds */
+  list = g_hash_table_lookup (Binding.Elements, node->ElementName);
+  if (list != NULL)
+    element = list->next == NULL ? (ElementType *) list->data
+      : SearchElementByName (PCB->Data, node->ElementName);
+  if (element == NULL)
+    return node;
 
   for (i = element->Pad; i != NULL; i = g_list_next (i))
     {
       PadType *pad = i->data;
 
-      if (NSTRCMP (PinNum, pad->Number) == 0 &&
-          (!Same || !TEST_FLAG (DRCFLAG, pad)))
-        {
-          conn->type = PAD_TYPE;
-          conn->ptr1 = element;
-          conn->ptr2 = pad;
-          conn->group = TEST_FLAG (ONSOLDERFLAG, pad) ? SLayer : CLayer;
-
-          if (TEST_FLAG (EDGE2FLAG, pad))
-            {
-              conn->X = pad->Point2.X;
-              conn->Y = pad->Point2.Y;
-            }
-          else
-            {
-              conn->X = pad->Point1.X;
-              conn->Y = pad->Point1.Y;
-            }
-          return true;
-        }
-    }
+      if (node->PinNum == pad->Number)
+	{
+	  ConnectionType conn;
 
+	  conn.type = PAD_TYPE;
+	  conn.ptr1 = element;
+	  conn.ptr2 = pad;
+	  g_array_append_val (node->Conns, conn);
+	}
+    }
   for (i = element->Pin; i != NULL; i = g_list_next (i))
     {
       PinType *pin = i->data;
 
-      if (!TEST_FLAG (HOLEFLAG, pin) &&
-          pin->Number && NSTRCMP (PinNum, pin->Number) == 0 &&
-          (!Same || !TEST_FLAG (DRCFLAG, pin)))
-        {
-          conn->type = PIN_TYPE;
-          conn->ptr1 = element;
-          conn->ptr2 = pin;
-          conn->group = SLayer;        /* any layer will do */
-          conn->X = pin->X;
-          conn->Y = pin->Y;
-          return true;
-        }
+      if (node->PinNum == pin->Number)
+	{
+	  ConnectionType conn;
+
+	  conn.type = PIN_TYPE;
+	  conn.ptr1 = element;
+	  conn.ptr2 = pin;
+	  g_array_append_val (node->Conns, conn);
+	}
+    }
+  return node;
+}
+
+/* ---------------------------------------------------------------------------
+ * Find a particular pad of a bound node
+ */
+static bool
+FindPad (NetNodeType *node, ConnectionType * conn, bool Same)
+{
+  Cardinal n;
+
+  for (n = 0; n < node->Conns->len; n++)
+    {
+      ConnectionType *c = &g_array_index (node->Conns, ConnectionType, n);
+
+      if (c->type == PAD_TYPE)
+	{
+	  PadType *pad = (PadType *) c->ptr2;
+
+	  if (Same && TEST_FLAG (DRCFLAG, pad))
+	    continue;
+	  conn->type = PAD_TYPE;
+	  conn->ptr1 = c->ptr1;
+	  conn->ptr2 = pad;
+	  conn->group = TEST_FLAG (ONSOLDERFLAG, pad) ? SLayer : CLayer;
+
+	  if (TEST_FLAG (EDGE2FLAG, pad))
+	    {
+	      conn->X = pad->Point2.X;
+	      conn->Y = pad->Point2.Y;
+	    }
+	  else
+	    {
+	      conn->X = pad->Point1.X;
+	      conn->Y = pad->Point1.Y;
+	    }
+	  return true;
+	}
+      else
+	{
+	  PinType *pin = (PinType *) c->ptr2;
+
+	  if (TEST_FLAG (HOLEFLAG, pin)
+	      || (Same && TEST_FLAG (DRCFLAG, pin)))
+	    continue;
+	  conn->type = PIN_TYPE;
+	  conn->ptr1 = c->ptr1;
+	  conn->ptr2 = pin;
+	  conn->group = SLayer;        /* any layer will do */
+	  conn->X = pin->X;
+	  conn->Y = pin->Y;
+	  return true;
+	}
     }
 
   return false;
@@ -177,34 +425,33 @@ FindPad (char *ElementName, char *PinNum, ConnectionType * conn, bool Same)
 bool
 SeekPad (LibraryEntryType * entry, ConnectionType * conn, bool Same)
 {
+  NetNodeType *node;
   int j;
-  char ElementName[256];
-  char PinNum[256];
 
-  if (ParseConnection (entry->ListEntry, ElementName, PinNum))
+  if ((node = bind_node (entry->ListEntry)) == NULL)
     return (false);
-  for (j = 0; PinNum[j] != '\0'; j++);
+  j = strlen (node->PinNum);
   if (j == 0)
     {
       Message (_("Error! Netlist file is missing pin!\n"
-		 "white space after \"%s-\"\n"), ElementName);
+		 "white space after \"%s-\"\n"), node->ElementName);
       badnet = true;
     }
   else
     {
-      if (FindPad (ElementName, PinNum, conn, Same))
+      if (FindPad (node, conn, Same))
 	return (true);
       if (Same)
 	return (false);
-      if (PinNum[j - 1] < '0' || PinNum[j - 1] > '9')
+      if (node->PinNum[j - 1] < '0' || node->PinNum[j - 1] > '9')
 	{
 	  Message ("WARNING! Pin number ending with '%c'"
 		   " encountered in netlist file\n"
-		   "Probably a bad netlist file format\n", PinNum[j - 1]);
+		   "Probably a bad netlist file format\n", node->PinNum[j - 1]);
 	}
     }
   Message (_("Can't find %s pin %s called for in netlist.\n"),
-	   ElementName, PinNum);
+	   node->ElementName, node->PinNum);
   return (false);
 }
 
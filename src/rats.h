@@ -45,6 +45,10 @@ bool AddAllRats (bool, void (*)(register ConnectionType *, register ConnectionTy
 bool SeekPad (LibraryEntryType *, ConnectionType *, bool);
 
 NetListType * ProcNetlist (LibraryType *);
+void RatsElementAdded (DataType *, ElementType *);
+void RatsElementRemoved (DataType *, ElementType *);
+void RatsElementRenamed (DataType *, ElementType *);
+void RatsDataForget (DataType *);
 NetListListType CollectSubnets (bool);
 
 #endif
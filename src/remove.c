@@ -272,6 +272,7 @@ DestroyElement (ElementType *Element)
       r_delete_entry (DestroyTarget->name_tree[n], (BoxType *) text);
   }
   END_LOOP;
+  ElementNameIndexDelete (DestroyTarget, Element);
   FreeElementMemory (Element);
 
   DestroyTarget->Element = g_list_remove (DestroyTarget->Element, Element);
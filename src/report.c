@@ -155,7 +155,7 @@ ReportDialog (int argc, char **argv, Coord x, Coord y)
 #endif
 	via = (PinType *) ptr2;
 	if (TEST_FLAG (HOLEFLAG, via))
-	  pcb_sprintf (&report[0], "%m+VIA ID# %ld; Flags:%s\n"
+	  pcb_sprintf (&report[0], "%m+VIA ID# %d; Flags:%s\n"
 		   "(X,Y) = %$mD.\n"
 		   "It is a pure hole of diameter %$mS.\n"
 		   "Name = \"%s\"."
@@ -163,7 +163,7 @@ ReportDialog (int argc, char **argv, Coord x, Coord y)
 		   via->X, via->Y, via->DrillingHole, EMPTY (via->Name),
 		   TEST_FLAG (LOCKFLAG, via) ? "It is LOCKED.\n" : "");
 	else
-	  pcb_sprintf (&report[0], "%m+VIA ID# %ld;  Flags:%s\n"
+	  pcb_sprintf (&report[0], "%m+VIA ID# %d;  Flags:%s\n"
 		   "(X,Y) = %$mD.\n"
 		   "Copper width = %$mS. Drill width = %$mS.\n"
 		   "Clearance width in polygons = %$mS.\n"
@@ -203,7 +203,7 @@ ReportDialog (int argc, char **argv, Coord x, Coord y)
 	}
 	END_LOOP;
 	if (TEST_FLAG (HOLEFLAG, Pin))
-	  pcb_sprintf (&report[0], "%m+PIN ID# %ld; Flags:%s\n"
+	  pcb_sprintf (&report[0], "%m+PIN ID# %d; Flags:%s\n"
 		   "(X,Y) = %$mD.\n"
 		   "It is a mounting hole. Drill width = %$mS.\n"
 		   "It is owned by element %$mS.\n"
@@ -213,7 +213,7 @@ ReportDialog (int argc, char **argv, Coord x, Coord y)
 		   TEST_FLAG (LOCKFLAG, Pin) ? "It is LOCKED.\n" : "");
 	else
 	  pcb_sprintf (&report[0],
-		   "%m+PIN ID# %ld;  Flags:%s\n" "(X,Y) = %$mD.\n"
+		   "%m+PIN ID# %d;  Flags:%s\n" "(X,Y) = %$mD.\n"
 		   "Copper width = %$mS. Drill width = %$mS.\n"
 		   "Clearance width to Polygon = %$mS.\n"
 		   "Annulus = %$mS.\n"
@@ -245,9 +245,9 @@ ReportDialog (int argc, char **argv, Coord x, Coord y)
 	  }
 #endif
 	line = (LineType *) ptr2;
-	pcb_sprintf (&report[0], "%m+LINE ID# %ld;  Flags:%s\n"
-		 "FirstPoint(X,Y)  = %$mD, ID = %ld.\n"
-		 "SecondPoint(X,Y) = %$mD, ID = %ld.\n"
+	pcb_sprintf (&report[0], "%m+LINE ID# %d;  Flags:%s\n"
+		 "FirstPoint(X,Y)  = %$mD, ID = %d.\n"
+		 "SecondPoint(X,Y) = %$mD, ID = %d.\n"
 		 "Width = %$mS.\nClearance width in polygons = %$mS.\n"
 		 "It is on layer %d\n"
 		 "and has name \"%s\".\n"
@@ -272,10 +272,10 @@ ReportDialog (int argc, char **argv, Coord x, Coord y)
 	  }
 #endif
 	line = (RatType *) ptr2;
-	pcb_sprintf (&report[0], "%m+RAT-LINE ID# %ld;  Flags:%s\n"
-		 "FirstPoint(X,Y)  = %$mD; ID = %ld; "
+	pcb_sprintf (&report[0], "%m+RAT-LINE ID# %d;  Flags:%s\n"
+		 "FirstPoint(X,Y)  = %$mD; ID = %d; "
 		 "connects to layer group %d.\n"
-		 "SecondPoint(X,Y) = %$mD; ID = %ld; "
+		 "SecondPoint(X,Y) = %$mD; ID = %d; "
 		 "connects to layer group %d.\n",
 		 USER_UNITMASK, line->ID, flags_to_string (line->Flags, LINE_TYPE),
 		 line->Point1.X, line->Point1.Y,
@@ -299,7 +299,7 @@ ReportDialog (int argc, char **argv, Coord x, Coord y)
 	Arc = (ArcType *) ptr2;
 	box = GetArcEnds (Arc);
 
-	pcb_sprintf (&report[0], "%m+ARC ID# %ld;  Flags:%s\n"
+	pcb_sprintf (&report[0], "%m+ARC ID# %d;  Flags:%s\n"
 		 "CenterPoint(X,Y) = %$mD.\n"
 		 "Radius = %$mS, Thickness = %$mS.\n"
 		 "Clearance width in polygons = %$mS.\n"
@@ -332,7 +332,7 @@ ReportDialog (int argc, char **argv, Coord x, Coord y)
 #endif
 	Polygon = (PolygonType *) ptr2;
 
-	pcb_sprintf (&report[0], "%m+POLYGON ID# %ld;  Flags:%s\n"
+	pcb_sprintf (&report[0], "%m+POLYGON ID# %d;  Flags:%s\n"
 		 "Its bounding box is %$mD %$mD.\n"
 		 "It has %d points and could store %d more\n"
 		 "  without using more memory.\n"
@@ -371,9 +371,9 @@ ReportDialog (int argc, char **argv, Coord x, Coord y)
 	}
 	END_LOOP;
 	len = Distance (Pad->Point1.X, Pad->Point1.Y, Pad->Point2.X, Pad->Point2.Y);
-	pcb_sprintf (&report[0], "%m+PAD ID# %ld;  Flags:%s\n"
-		 "FirstPoint(X,Y)  = %$mD; ID = %ld.\n"
-		 "SecondPoint(X,Y) = %$mD; ID = %ld.\n"
+	pcb_sprintf (&report[0], "%m+PAD ID# %d;  Flags:%s\n"
+		 "FirstPoint(X,Y)  = %$mD; ID = %d.\n"
+		 "SecondPoint(X,Y) = %$mD; ID = %d.\n"
 		 "Width = %$mS.  Length = %$mS.\n"
 		 "Clearance width in polygons = %$mS.\n"
 		 "Solder mask = %$mS x %$mS (gap = %$mS).\n"
@@ -408,7 +408,7 @@ ReportDialog (int argc, char **argv, Coord x, Coord y)
 	  }
 #endif
 	element = (ElementType *) ptr2;
-	pcb_sprintf (&report[0], "%m+ELEMENT ID# %ld;  Flags:%s\n"
+	pcb_sprintf (&report[0], "%m+ELEMENT ID# %d;  Flags:%s\n"
 		 "BoundingBox %$mD %$mD.\n"
 		 "Descriptive Name \"%s\".\n"
 		 "Name on board \"%s\".\n"
@@ -456,7 +456,7 @@ ReportDialog (int argc, char **argv, Coord x, Coord y)
 	if (type == TEXT_TYPE)
 	  sprintf (laynum, "It is on layer %d.",
 		   GetLayerNumber (PCB->Data, (LayerType *) ptr1));
-	pcb_sprintf (&report[0], "%m+TEXT ID# %ld;  Flags:%s\n"
+	pcb_sprintf (&report[0], "%m+TEXT ID# %d;  Flags:%s\n"
 		 "Located at (X,Y) = %$mD.\n"
 		 "Characters are %$mS tall.\n"
 		 "Value is \"%s\".\n"
@@ -476,7 +476,7 @@ ReportDialog (int argc, char **argv, Coord x, Coord y)
     case POLYGONPOINT_TYPE:
       {
 	PointType *point = (PointType *) ptr2;
-	pcb_sprintf (&report[0], "%m+POINT ID# %ld.\n"
+	pcb_sprintf (&report[0], "%m+POINT ID# %d.\n"
 		 "Located at (X,Y) = %$mD.\n"
 		 "It belongs to a %s on layer %d.\n", USER_UNITMASK, point->ID,
 		 point->X, point->Y,
@@ -593,91 +593,339 @@ XYtoNetLength (Coord x, Coord y, int *found)
   return length;
 }
 
+/* ---------------------------------------------------------------------------
+ * Net length cache.  All nets are measured together by a single
+ * MeasureConnections sweep; the results are kept until the layout or the
+ * netlist changes.
+ */
+typedef struct
+{
+  char *netname;		/* copies of the netlist strings this was */
+  char *first;			/* computed from, to detect a new netlist */
+  ConnectionStatsType stats;
+  bool has_seed;
+} NetLengthType;
+
+static NetLengthType *net_lengths = NULL;
+static Cardinal net_lengths_n = 0;
+static PCBType *net_lengths_pcb = NULL;
+static unsigned long net_lengths_generation;
+
+static void
+free_net_lengths (void)
+{
+  Cardinal i;
+
+  for (i = 0; i < net_lengths_n; i++)
+    {
+      free (net_lengths[i].netname);
+      free (net_lengths[i].first);
+    }
+  free (net_lengths);
+  net_lengths = NULL;
+  net_lengths_n = 0;
+}
+
+static bool
+net_lengths_valid (void)
+{
+  Cardinal ni;
+
+  if (net_lengths == NULL || net_lengths_pcb != PCB
+      || net_lengths_generation != UndoGeneration ()
+      || net_lengths_n != PCB->NetlistLib.MenuN)
+    return false;
+  for (ni = 0; ni < net_lengths_n; ni++)
+    {
+      LibraryMenuType *menu = &PCB->NetlistLib.Menu[ni];
+      if (NSTRCMP (menu->Name, net_lengths[ni].netname) != 0)
+        return false;
+      /* an empty net was cached without a first entry */
+      if (menu->EntryN > 0
+          ? NSTRCMP (menu->Entry[0].ListEntry, net_lengths[ni].first) != 0
+          : net_lengths[ni].first != NULL)
+        return false;
+    }
+  return true;
+}
+
+/* Finds the pin or pad named by a netlist entry such as "U1-3".  */
+static void *
+find_netlist_pin (GHashTable *elements, const char *entry, int *type)
+{
+  char *ename = strdup (entry);
+  char *pname = strchr (ename, '-');
+  ElementType *element;
+  void *rv = NULL;
+
+  if (pname)
+    {
+      *pname++ = 0;
+      element = (ElementType *) g_hash_table_lookup (elements, ename);
+      if (element)
+        {
+          PIN_LOOP (element);
+          {
+            if (strcmp (pin->Number, pname) == 0)
+              {
+                *type = PIN_TYPE;
+                rv = pin;
+                break;
+              }
+          }
+          END_LOOP;
+          if (!rv)
+            {
+              PAD_LOOP (element);
+              {
+                if (strcmp (pad->Number, pname) == 0)
+                  {
+                    *type = PAD_TYPE;
+                    rv = pad;
+                    break;
+                  }
+              }
+              END_LOOP;
+            }
+        }
+    }
+  free (ename);
+  return rv;
+}
+
+static void
+update_net_lengths (void)
+{
+  Cardinal ni, n = PCB->NetlistLib.MenuN;
+  GHashTable *elements;
+  ConnectionStatsType *stats;
+  void **seeds;
+  int *types;
+
+  if (net_lengths_valid ())
+    return;
+  free_net_lengths ();
+
+  /* if several elements share a name the last one wins, as it did
+   * when every net scanned the whole board */
+  elements = g_hash_table_new (g_str_hash, g_str_equal);
+  ELEMENT_LOOP (PCB->Data);
+  {
+    char *es = element->Name[NAMEONPCB_INDEX].TextString;
+    if (es)
+      g_hash_table_insert (elements, es, element);
+  }
+  END_LOOP;
+
+  net_lengths = (NetLengthType *) calloc (n + 1, sizeof (NetLengthType));
+  net_lengths_n = n;
+  seeds = (void **) calloc (n + 1, sizeof (void *));
+  types = (int *) calloc (n + 1, sizeof (int));
+  stats = (ConnectionStatsType *) calloc (n + 1, sizeof (ConnectionStatsType));
+
+  for (ni = 0; ni < n; ni++)
+    {
+      LibraryMenuType *menu = &PCB->NetlistLib.Menu[ni];
+
+      net_lengths[ni].netname = menu->Name ? strdup (menu->Name) : NULL;
+      if (menu->EntryN == 0)
+        continue;
+      net_lengths[ni].first = strdup (menu->Entry[0].ListEntry);
+      seeds[ni] = find_netlist_pin (elements, menu->Entry[0].ListEntry,
+                                    &types[ni]);
+      net_lengths[ni].has_seed = seeds[ni] != NULL;
+    }
+
+  MeasureConnections (n, types, seeds, stats);
+  for (ni = 0; ni < n; ni++)
+    net_lengths[ni].stats = stats[ni];
+
+  net_lengths_pcb = PCB;
+  net_lengths_generation = UndoGeneration ();
+
+  free (stats);
+  free (types);
+  free (seeds);
+  g_hash_table_destroy (elements);
+}
+
 static int
 ReportAllNetLengths (int argc, char **argv, Coord x, Coord y)
 {
-  int ni;
-  int found;
+  Cardinal ni;
 
-  /* Reset all connection flags and save an undo-state to get back
-   * to the state the board was in when we started this function.
-   *
-   * After this, we don't add any changes to the undo system, but
-   * ensure we get back to a point where we can Undo() our changes
-   * by resetting the connections with ResetConnections() before
-   * calling Undo() at the end of the procedure.
+  /* The lengths come from the cache, which measures every net in one
+   * pass without changing object flags or the undo list.
    */
-  ResetConnections (true);
-  IncrementUndoSerialNumber ();
+  update_net_lengths ();
 
-  for (ni = 0; ni < PCB->NetlistLib.MenuN; ni++)
+  for (ni = 0; ni < net_lengths_n; ni++)
     {
       char *netname = PCB->NetlistLib.Menu[ni].Name + 2;
-      char *ename = PCB->NetlistLib.Menu[ni].Entry[0].ListEntry;
-      char *pname;
-      bool got_one = 0;
-
-      ename = strdup (ename);
-      pname = strchr (ename, '-');
-      if (! pname)
-	{
-	  free (ename);
-	  continue;
-	}
-      *pname++ = 0;
 
-      ELEMENT_LOOP (PCB->Data);
-      {
-	char *es = element->Name[NAMEONPCB_INDEX].TextString;
-	if (es && strcmp (es, ename) == 0)
-	  {
-	    PIN_LOOP (element);
-	    {
-	      if (strcmp (pin->Number, pname) == 0)
-		{
-		  x = pin->X;
-		  y = pin->Y;
-		  got_one = 1;
-                  break;
-		}
-	    }
-	    END_LOOP;
-	    PAD_LOOP (element);
-	    {
-	      if (strcmp (pad->Number, pname) == 0)
-		{
-		  x = (pad->Point1.X + pad->Point2.X) / 2;
-		  y = (pad->Point1.Y + pad->Point2.Y) / 2;
-		  got_one = 1;
-                  break;
-		}
-	    }
-	    END_LOOP;
-	  }
-      }
-      END_LOOP;
-
-      if (got_one)
+      if (net_lengths[ni].has_seed)
         {
           char buf[50];
           const char *units_name = argv[0];
-          Coord length;
+          Coord length = net_lengths[ni].stats.length;
 
           if (argc < 1)
             units_name = Settings.grid_unit->suffix;
 
-          length = XYtoNetLength (x, y, &found);
-
-          /* Reset connectors for the next lookup */
-          ResetConnections (false);
-
           pcb_sprintf(buf, "%$m*", units_name, length);
           gui->log("Net %s length %s\n", netname, buf);
         }
     }
 
-  ResetConnections (false);
-  Undo (true);
+  return 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * Reports the memory the layout objects take, per object type: the
+ * object structs, their strings and point arrays, the list node each
+ * one sits in and, for objects kept in an r-tree, its slot in a leaf.
+ */
+typedef struct
+{
+  const char *name;
+  size_t size;			/* of the object struct */
+  bool indexed;			/* kept in an r-tree */
+  unsigned long count;
+  double bytes;
+} MemoryUsageType;
+
+enum
+{
+  MEM_VIA, MEM_PIN, MEM_PAD, MEM_LINE, MEM_ARC, MEM_TEXT, MEM_POLYGON,
+  MEM_ELEMENT, MEM_ELEMENT_LINE, MEM_ELEMENT_ARC, MEM_RAT
+};
+
+static size_t
+string_bytes (const char *s)
+{
+  return s ? strlen (s) + 1 : 0;
+}
+
+/* the names and values themselves are pooled, see StringIntern() */
+static size_t
+attribute_bytes (AttributeListType *list)
+{
+  return list->Max * sizeof (AttributeType);
+}
+
+static void
+memory_count (MemoryUsageType *m, size_t extra)
+{
+  m->count++;
+  m->bytes += m->size + extra + sizeof (GList);
+  if (m->indexed)
+    m->bytes += sizeof (BoxType *);
+}
+
+static int
+ReportMemory (int argc, char **argv, Coord x, Coord y)
+{
+  MemoryUsageType mem[] = {
+    {"via", sizeof (PinType), true},
+    {"pin", sizeof (PinType), true},
+    {"pad", sizeof (PadType), true},
+    {"line", sizeof (LineType), true},
+    {"arc", sizeof (ArcType), true},
+    {"text", sizeof (TextType), true},
+    {"polygon", sizeof (PolygonType), true},
+    {"element", sizeof (ElementType), true},
+    {"element line", sizeof (LineType), false},
+    {"element arc", sizeof (ArcType), false},
+    {"rat", sizeof (RatType), true}
+  };
+  unsigned long count = 0;
+  double bytes = 0;
+  size_t thermal_bytes, string_pool_bytes;
+  int thermals, strings;
+  int i;
+
+  VIA_LOOP (PCB->Data);
+  {
+    memory_count (&mem[MEM_VIA],
+		  string_bytes (via->Name) + string_bytes (via->Number));
+  }
+  END_LOOP;
+  ELEMENT_LOOP (PCB->Data);
+  {
+    memory_count (&mem[MEM_ELEMENT], attribute_bytes (&element->Attributes));
+    PIN_LOOP (element);
+    {
+      memory_count (&mem[MEM_PIN], 0);
+    }
+    END_LOOP;
+    PAD_LOOP (element);
+    {
+      memory_count (&mem[MEM_PAD], 0);
+    }
+    END_LOOP;
+    ELEMENTLINE_LOOP (element);
+    {
+      memory_count (&mem[MEM_ELEMENT_LINE], 0);
+    }
+    END_LOOP;
+    ELEMENTARC_LOOP (element);
+    {
+      memory_count (&mem[MEM_ELEMENT_ARC], 0);
+    }
+    END_LOOP;
+  }
+  END_LOOP;
+  ALLLINE_LOOP (PCB->Data);
+  {
+    memory_count (&mem[MEM_LINE], string_bytes (line->Number));
+  }
+  ENDALL_LOOP;
+  ALLARC_LOOP (PCB->Data);
+  {
+    memory_count (&mem[MEM_ARC], 0);
+  }
+  ENDALL_LOOP;
+  ALLTEXT_LOOP (PCB->Data);
+  {
+    memory_count (&mem[MEM_TEXT], string_bytes (text->TextString));
+  }
+  ENDALL_LOOP;
+  ALLPOLYGON_LOOP (PCB->Data);
+  {
+    memory_count (&mem[MEM_POLYGON],
+		  polygon->PointMax * sizeof (PointType)
+		  + polygon->HoleIndexMax * sizeof (Cardinal));
+  }
+  ENDALL_LOOP;
+  RAT_LOOP (PCB->Data);
+  {
+    memory_count (&mem[MEM_RAT], 0);
+  }
+  END_LOOP;
+
+  gui->log (_("Memory used by layout objects:\n"));
+  for (i = 0; i < ENTRIES (mem); i++)
+    {
+      if (mem[i].count == 0)
+	continue;
+      gui->log (_("%-13s %8lu objects, %4u bytes struct, "
+		  "%7.1f bytes/object, %10.0f bytes\n"),
+		mem[i].name, mem[i].count, (unsigned) mem[i].size,
+		mem[i].bytes / mem[i].count, mem[i].bytes);
+      count += mem[i].count;
+      bytes += mem[i].bytes;
+    }
+  thermals = FlagThermalPatterns (&thermal_bytes);
+  gui->log (_("%-13s %8d patterns, %10lu bytes\n"), "thermals", thermals,
+	    (unsigned long) thermal_bytes);
+  bytes += thermal_bytes;
+  strings = StringPoolUsage (&string_pool_bytes);
+  gui->log (_("%-13s %8d strings,  %10lu bytes\n"), "string pool", strings,
+	    (unsigned long) string_pool_bytes);
+  bytes += string_pool_bytes;
+  if (count)
+    gui->log (_("%-13s %8lu objects, %7.1f bytes/object, %10.0f bytes\n"),
+	      "total", count, bytes / count, bytes);
   return 0;
 }
 
@@ -717,23 +965,21 @@ ReportNetLength (int argc, char **argv, Coord x, Coord y)
     {
       if (TEST_FLAG (FOUNDFLAG, pin))
 	{
-	  int ni, nei;
 	  char *ename = element->Name[NAMEONPCB_INDEX].TextString;
 	  char *pname = pin->Number;
+	  LibraryMenuType *net;
 	  char *n;
 
 	  if (ename && pname)
 	    {
 	      n = Concat (ename, "-", pname, NULL);
-	      for (ni = 0; ni < PCB->NetlistLib.MenuN; ni++)
-		for (nei = 0; nei < PCB->NetlistLib.Menu[ni].EntryN; nei++)
-		  {
-		    if (strcmp (PCB->NetlistLib.Menu[ni].Entry[nei].ListEntry, n) == 0)
-		      {
-			netname = PCB->NetlistLib.Menu[ni].Name + 2;
-			goto got_net_name; /* four for loops deep */
-		      }
-		  }
+	      net = NetlistFindNode (n, NULL);
+	      free (n);
+	      if (net)
+		{
+		  netname = net->Name + 2;
+		  goto got_net_name;
+		}
 	    }
 	}
     }
@@ -742,23 +988,21 @@ ReportNetLength (int argc, char **argv, Coord x, Coord y)
     {
       if (TEST_FLAG (FOUNDFLAG, pad))
 	{
-	  int ni, nei;
 	  char *ename = element->Name[NAMEONPCB_INDEX].TextString;
 	  char *pname = pad->Number;
+	  LibraryMenuType *net;
 	  char *n;
 
 	  if (ename && pname)
 	    {
 	      n = Concat (ename, "-", pname, NULL);
-	      for (ni = 0; ni < PCB->NetlistLib.MenuN; ni++)
-		for (nei = 0; nei < PCB->NetlistLib.Menu[ni].EntryN; nei++)
-		  {
-		    if (strcmp (PCB->NetlistLib.Menu[ni].Entry[nei].ListEntry, n) == 0)
-		      {
-			netname = PCB->NetlistLib.Menu[ni].Name + 2;
-			goto got_net_name; /* four for loops deep */
-		      }
-		  }
+	      net = NetlistFindNode (n, NULL);
+	      free (n);
+	      if (net)
+		{
+		  netname = net->Name + 2;
+		  goto got_net_name;
+		}
 	    }
 	}
     }
@@ -940,7 +1184,7 @@ ReportNetLengthByName (char *tofind, int x, int y)
  * syntax: 
  */
 
-static const char report_syntax[] = "Report(Object|DrillReport|FoundPins|NetLength|AllNetLengths|[,name])";
+static const char report_syntax[] = "Report(Object|DrillReport|FoundPins|NetLength|AllNetLengths|Memory|[,name])";
 
 static const char report_help[] = "Produce various report.";
 
@@ -969,6 +1213,12 @@ The name and length of the net under the crosshair will be reported to
 the message log.  An optional parameter specifies mm, mil, pcb, or in
 units
 
+@item Memory
+The memory taken by the layout objects is reported to the message log,
+per object type.  It counts the object structures, their strings and
+point arrays, list nodes and r-tree slots.  Pin and element names and
+attributes are shared and reported once, as the string pool.
+
 @end table
 
 %end-doc */
@@ -991,6 +1241,8 @@ Report (int argc, char **argv, Coord x, Coord y)
     return ReportNetLength (argc - 1, argv + 1, x, y);
   else if (strcasecmp (argv[0], "AllNetLengths") == 0)
     return ReportAllNetLengths (argc - 1, argv + 1, x, y);
+  else if (strcasecmp (argv[0], "Memory") == 0)
+    return ReportMemory (argc - 1, argv + 1, x, y);
   else if ((strcasecmp (argv[0], "NetLength") == 0) && (argc == 2))
     return ReportNetLengthByName (argv[1], x, y);
   else if (argc == 2)
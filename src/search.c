@@ -1383,11 +1383,24 @@ SearchObjectByLocation (unsigned Type,
  * The calling routine passes two pointers to allocated memory for storing
  * the results. 
  * A type value is returned too which is NO_TYPE if no objects has been found.
+ * LookupObjectByID() does the same without complaining about a missing ID.
  */
 int
 SearchObjectByID (DataType *Base,
 		  void **Result1, void **Result2, void **Result3, int ID,
 		  int type)
+{
+  int found = LookupObjectByID (Base, Result1, Result2, Result3, ID, type);
+
+  if (found == NO_TYPE)
+    Message ("hace: Internal error, search for ID %d failed\n", ID);
+  return (found);
+}
+
+int
+LookupObjectByID (DataType *Base,
+		  void **Result1, void **Result2, void **Result3, int ID,
+		  int type)
 {
   if (type == LINE_TYPE || type == LINEPOINT_TYPE)
     {
@@ -1578,7 +1591,6 @@ SearchObjectByID (DataType *Base,
   }
   END_LOOP;
 
-  Message ("hace: Internal error, search for ID %d failed\n", ID);
   return (NO_TYPE);
 }
 
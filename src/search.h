@@ -83,6 +83,7 @@ int SearchObjectByLocation (unsigned, void **, void **, void **, Coord, Coord, C
 int SearchScreen (Coord, Coord, int, void **, void **, void **);
 int SearchScreenGridSlop (Coord, Coord, int, void **, void **, void **);
 int SearchObjectByID (DataType *, void **, void **, void **, int, int);
+int LookupObjectByID (DataType *, void **, void **, void **, int, int);
 ElementType * SearchElementByName (DataType *, char *);
 
 #endif
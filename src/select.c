@@ -57,6 +57,201 @@
 #include <dmalloc.h>
 #endif
 
+/* ---------------------------------------------------------------------------
+ * the selection index: every selected object of the layout, so that
+ * operations on the selection don't have to walk the whole board.
+ *
+ * The index is only trusted while it belongs to the current PCB, the undo
+ * list isn't locked and no layout change has been recorded since it was
+ * last brought up to date (see UndoGeneration()).  Anything else just
+ * causes a rebuild by a full scan.  The select routines below record the
+ * objects they select and re-validate the index themselves; objects that
+ * get unselected stay in the list until the next compaction, so every
+ * user re-checks the flag.
+ */
+typedef struct
+{
+  int Type;
+  void *Ptr1, *Ptr2;
+} SelectionEntryType;
+
+static SelectionEntryType *SelectionList = NULL;
+static Cardinal SelectionN = 0, SelectionMax = 0;
+static GHashTable *SelectionSeen = NULL;	/* Ptr2 -> in SelectionList */
+static PCBType *SelectionPCB = NULL;
+static unsigned long SelectionGeneration;
+static bool SelectionTracking = false;
+
+static bool
+selection_index_current (void)
+{
+  return (SelectionPCB != NULL && SelectionPCB == PCB && !Undoing ()
+	  && SelectionGeneration == UndoGeneration ());
+}
+
+static void
+selection_append (int type, void *ptr1, void *ptr2)
+{
+  if (g_hash_table_lookup (SelectionSeen, ptr2))
+    return;
+  if (SelectionN >= SelectionMax)
+    {
+      SelectionMax = SelectionMax ? 2 * SelectionMax : 256;
+      SelectionList = (SelectionEntryType *)
+	realloc (SelectionList, SelectionMax * sizeof (SelectionEntryType));
+    }
+  SelectionList[SelectionN].Type = type;
+  SelectionList[SelectionN].Ptr1 = ptr1;
+  SelectionList[SelectionN].Ptr2 = ptr2;
+  SelectionN++;
+  g_hash_table_insert (SelectionSeen, ptr2, ptr2);
+}
+
+/* ---------------------------------------------------------------------------
+ * rebuilds the index from scratch, in the order SelectedOperation()
+ * has always visited the objects
+ */
+static void
+selection_index_rebuild (void)
+{
+  if (SelectionSeen)
+    g_hash_table_remove_all (SelectionSeen);
+  else
+    SelectionSeen = g_hash_table_new (NULL, NULL);
+  SelectionN = 0;
+
+  ALLLINE_LOOP (PCB->Data);
+  {
+    if (TEST_FLAG (SELECTEDFLAG, line))
+      selection_append (LINE_TYPE, layer, line);
+  }
+  ENDALL_LOOP;
+  ALLARC_LOOP (PCB->Data);
+  {
+    if (TEST_FLAG (SELECTEDFLAG, arc))
+      selection_append (ARC_TYPE, layer, arc);
+  }
+  ENDALL_LOOP;
+  ALLTEXT_LOOP (PCB->Data);
+  {
+    if (TEST_FLAG (SELECTEDFLAG, text))
+      selection_append (TEXT_TYPE, layer, text);
+  }
+  ENDALL_LOOP;
+  ALLPOLYGON_LOOP (PCB->Data);
+  {
+    if (TEST_FLAG (SELECTEDFLAG, polygon))
+      selection_append (POLYGON_TYPE, layer, polygon);
+  }
+  ENDALL_LOOP;
+  ELEMENT_LOOP (PCB->Data);
+  {
+    if (TEST_FLAG (SELECTEDFLAG, element))
+      selection_append (ELEMENT_TYPE, element, element);
+  }
+  END_LOOP;
+  ELEMENT_LOOP (PCB->Data);
+  {
+    ELEMENTTEXT_LOOP (element);
+    {
+      if (TEST_FLAG (SELECTEDFLAG, text))
+	selection_append (ELEMENTNAME_TYPE, element, text);
+    }
+    END_LOOP;
+  }
+  END_LOOP;
+  ALLPIN_LOOP (PCB->Data);
+  {
+    if (TEST_FLAG (SELECTEDFLAG, pin))
+      selection_append (PIN_TYPE, element, pin);
+  }
+  ENDALL_LOOP;
+  ALLPAD_LOOP (PCB->Data);
+  {
+    if (TEST_FLAG (SELECTEDFLAG, pad))
+      selection_append (PAD_TYPE, element, pad);
+  }
+  ENDALL_LOOP;
+  VIA_LOOP (PCB->Data);
+  {
+    if (TEST_FLAG (SELECTEDFLAG, via))
+      selection_append (VIA_TYPE, via, via);
+  }
+  END_LOOP;
+  RAT_LOOP (PCB->Data);
+  {
+    if (TEST_FLAG (SELECTEDFLAG, line))
+      selection_append (RATLINE_TYPE, line, line);
+  }
+  END_LOOP;
+
+  SelectionPCB = PCB;
+  SelectionGeneration = UndoGeneration ();
+}
+
+/* ---------------------------------------------------------------------------
+ * drops the entries of objects that are no longer selected
+ */
+static void
+selection_index_compact (void)
+{
+  Cardinal i, n = 0;
+
+  for (i = 0; i < SelectionN; i++)
+    if (TEST_FLAG (SELECTEDFLAG, (AnyObjectType *) SelectionList[i].Ptr2))
+      SelectionList[n++] = SelectionList[i];
+    else
+      g_hash_table_remove (SelectionSeen, SelectionList[i].Ptr2);
+  SelectionN = n;
+}
+
+/* ---------------------------------------------------------------------------
+ * makes sure the index describes the current selection
+ */
+static void
+selection_index_update (void)
+{
+  if (!selection_index_current ())
+    selection_index_rebuild ();
+}
+
+/* ---------------------------------------------------------------------------
+ * brackets a select routine: if the index was valid on entry, the objects
+ * passed to selection_note() in between are added to it and it stays
+ * valid across the undo entries the routine records
+ */
+static void
+selection_begin (void)
+{
+  SelectionTracking = selection_index_current ();
+}
+
+static void
+selection_note (int type, void *ptr1, void *ptr2)
+{
+  if (SelectionTracking
+      && TEST_FLAG (SELECTEDFLAG, (AnyObjectType *) ptr2))
+    selection_append (type, ptr1, ptr2);
+}
+
+static void
+selection_end (void)
+{
+  if (SelectionTracking)
+    SelectionGeneration = UndoGeneration ();
+  SelectionTracking = false;
+}
+
+/* ---------------------------------------------------------------------------
+ * forgets the selection index; for code that sets SELECTEDFLAG
+ * without going through the undo list
+ */
+void
+InvalidateSelectionIndex (void)
+{
+  SelectionPCB = NULL;
+}
+
 /* ---------------------------------------------------------------------------
  * toggles the selection of any kind of object
  * the different types are defined by search.h
@@ -74,11 +269,13 @@ SelectObject (void)
 		       &ptr1, &ptr2, &ptr3);
   if (type == NO_TYPE || TEST_FLAG (LOCKFLAG, (PinType *) ptr2))
     return (false);
+  selection_begin ();
   switch (type)
     {
     case VIA_TYPE:
       AddObjectToFlagUndoList (VIA_TYPE, ptr1, ptr1, ptr1);
       TOGGLE_FLAG (SELECTEDFLAG, (PinType *) ptr1);
+      selection_note (VIA_TYPE, ptr1, ptr1);
       DrawVia ((PinType *) ptr1);
       break;
 
@@ -89,6 +286,7 @@ SelectObject (void)
 	layer = (LayerType *) ptr1;
 	AddObjectToFlagUndoList (LINE_TYPE, ptr1, ptr2, ptr2);
 	TOGGLE_FLAG (SELECTEDFLAG, line);
+	selection_note (LINE_TYPE, layer, line);
 	DrawLine (layer, line);
 	break;
       }
@@ -99,6 +297,7 @@ SelectObject (void)
 
 	AddObjectToFlagUndoList (RATLINE_TYPE, ptr1, ptr1, ptr1);
 	TOGGLE_FLAG (SELECTEDFLAG, rat);
+	selection_note (RATLINE_TYPE, rat, rat);
 	DrawRat (rat);
 	break;
       }
@@ -110,6 +309,7 @@ SelectObject (void)
 	layer = (LayerType *) ptr1;
 	AddObjectToFlagUndoList (ARC_TYPE, ptr1, ptr2, ptr2);
 	TOGGLE_FLAG (SELECTEDFLAG, arc);
+	selection_note (ARC_TYPE, layer, arc);
 	DrawArc (layer, arc);
 	break;
       }
@@ -121,6 +321,7 @@ SelectObject (void)
 	layer = (LayerType *) ptr1;
 	AddObjectToFlagUndoList (TEXT_TYPE, ptr1, ptr2, ptr2);
 	TOGGLE_FLAG (SELECTEDFLAG, text);
+	selection_note (TEXT_TYPE, layer, text);
 	DrawText (layer, text);
 	break;
       }
@@ -132,6 +333,7 @@ SelectObject (void)
 	layer = (LayerType *) ptr1;
 	AddObjectToFlagUndoList (POLYGON_TYPE, ptr1, ptr2, ptr2);
 	TOGGLE_FLAG (SELECTEDFLAG, poly);
+	selection_note (POLYGON_TYPE, layer, poly);
 	DrawPolygon (layer, poly);
 	/* changing memory order no longer effects draw order */
 	break;
@@ -140,12 +342,14 @@ SelectObject (void)
     case PIN_TYPE:
       AddObjectToFlagUndoList (PIN_TYPE, ptr1, ptr2, ptr2);
       TOGGLE_FLAG (SELECTEDFLAG, (PinType *) ptr2);
+      selection_note (PIN_TYPE, ptr1, ptr2);
       DrawPin ((PinType *) ptr2);
       break;
 
     case PAD_TYPE:
       AddObjectToFlagUndoList (PAD_TYPE, ptr1, ptr2, ptr2);
       TOGGLE_FLAG (SELECTEDFLAG, (PadType *) ptr2);
+      selection_note (PAD_TYPE, ptr1, ptr2);
       DrawPad ((PadType *) ptr2);
       break;
 
@@ -158,6 +362,7 @@ SelectObject (void)
 	{
 	  AddObjectToFlagUndoList (ELEMENTNAME_TYPE, element, text, text);
 	  TOGGLE_FLAG (SELECTEDFLAG, text);
+	  selection_note (ELEMENTNAME_TYPE, element, text);
 	}
 	END_LOOP;
 	DrawElementName (element);
@@ -173,22 +378,26 @@ SelectObject (void)
 	{
 	  AddObjectToFlagUndoList (PIN_TYPE, element, pin, pin);
 	  TOGGLE_FLAG (SELECTEDFLAG, pin);
+	  selection_note (PIN_TYPE, element, pin);
 	}
 	END_LOOP;
 	PAD_LOOP (element);
 	{
 	  AddObjectToFlagUndoList (PAD_TYPE, element, pad, pad);
 	  TOGGLE_FLAG (SELECTEDFLAG, pad);
+	  selection_note (PAD_TYPE, element, pad);
 	}
 	END_LOOP;
 	ELEMENTTEXT_LOOP (element);
 	{
 	  AddObjectToFlagUndoList (ELEMENTNAME_TYPE, element, text, text);
 	  TOGGLE_FLAG (SELECTEDFLAG, text);
+	  selection_note (ELEMENTNAME_TYPE, element, text);
 	}
 	END_LOOP;
 	AddObjectToFlagUndoList (ELEMENT_TYPE, element, element, element);
 	TOGGLE_FLAG (SELECTEDFLAG, element);
+	selection_note (ELEMENT_TYPE, element, element);
 	if (PCB->ElementOn &&
 	    ((TEST_FLAG (ONSOLDERFLAG, element) != 0) == SWAP_IDENT ||
 	     PCB->InvisibleObjectsOn))
@@ -204,6 +413,212 @@ SelectObject (void)
     }
   Draw ();
   IncrementUndoSerialNumber ();
+  selection_end ();
+  return (changed);
+}
+
+/* ----------------------------------------------------------------------
+ * selects/unselects the element and its parts within the passed box,
+ * the element part of SelectBlock()
+ */
+static bool
+select_block_element (ElementType *element, BoxType *Box, bool Flag)
+{
+  bool changed = false;
+  bool gotElement = false;
+
+  if ((PCB->ElementOn || !Flag)
+      && !TEST_FLAG (LOCKFLAG, element)
+      && ((TEST_FLAG (ONSOLDERFLAG, element) != 0) == SWAP_IDENT
+	  || PCB->InvisibleObjectsOn))
+    {
+      if (BOX_IN_BOX
+	  (&ELEMENT_TEXT (PCB, element).BoundingBox, Box)
+	  && !TEST_FLAG (LOCKFLAG, &ELEMENT_TEXT (PCB, element))
+	  && TEST_FLAG (SELECTEDFLAG,
+			&ELEMENT_TEXT (PCB, element)) != Flag)
+	{
+	  /* select all names of element */
+	  ELEMENTTEXT_LOOP (element);
+	  {
+	    AddObjectToFlagUndoList (ELEMENTNAME_TYPE,
+				     element, text, text);
+	    ASSIGN_FLAG (SELECTEDFLAG, Flag, text);
+	    selection_note (ELEMENTNAME_TYPE, element, text);
+	  }
+	  END_LOOP;
+	  if (PCB->ElementOn)
+	    DrawElementName (element);
+	  changed = true;
+	}
+      if ((PCB->PinOn || !Flag) && ELEMENT_IN_BOX (element, Box))
+	if (TEST_FLAG (SELECTEDFLAG, element) != Flag)
+	  {
+	    AddObjectToFlagUndoList (ELEMENT_TYPE,
+				     element, element, element);
+	    ASSIGN_FLAG (SELECTEDFLAG, Flag, element);
+	    selection_note (ELEMENT_TYPE, element, element);
+	    PIN_LOOP (element);
+	    {
+	      if (TEST_FLAG (SELECTEDFLAG, pin) != Flag)
+		{
+		  AddObjectToFlagUndoList (PIN_TYPE, element, pin, pin);
+		  ASSIGN_FLAG (SELECTEDFLAG, Flag, pin);
+		  selection_note (PIN_TYPE, element, pin);
+		  if (PCB->PinOn)
+		    DrawPin (pin);
+		  changed = true;
+		}
+	    }
+	    END_LOOP;
+	    PAD_LOOP (element);
+	    {
+	      if (TEST_FLAG (SELECTEDFLAG, pad) != Flag)
+		{
+		  AddObjectToFlagUndoList (PAD_TYPE, element, pad, pad);
+		  ASSIGN_FLAG (SELECTEDFLAG, Flag, pad);
+		  selection_note (PAD_TYPE, element, pad);
+		  if (PCB->PinOn)
+		    DrawPad (pad);
+		  changed = true;
+		}
+	    }
+	    END_LOOP;
+	    if (PCB->PinOn)
+	      DrawElement (element);
+	    changed = true;
+	    gotElement = true;
+	  }
+    }
+  if ((PCB->PinOn || !Flag) && !TEST_FLAG (LOCKFLAG, element) && !gotElement)
+    {
+      PIN_LOOP (element);
+      {
+	if ((VIA_OR_PIN_IN_BOX (pin, Box)
+	     && TEST_FLAG (SELECTEDFLAG, pin) != Flag))
+	  {
+	    AddObjectToFlagUndoList (PIN_TYPE, element, pin, pin);
+	    ASSIGN_FLAG (SELECTEDFLAG, Flag, pin);
+	    selection_note (PIN_TYPE, element, pin);
+	    if (PCB->PinOn)
+	      DrawPin (pin);
+	    changed = true;
+	  }
+      }
+      END_LOOP;
+      PAD_LOOP (element);
+      {
+	if (PAD_IN_BOX (pad, Box)
+	    && TEST_FLAG (SELECTEDFLAG, pad) != Flag
+	    && (TEST_FLAG (ONSOLDERFLAG, pad) == SWAP_IDENT
+		|| PCB->InvisibleObjectsOn
+		|| !Flag))
+	  {
+	    AddObjectToFlagUndoList (PAD_TYPE, element, pad, pad);
+	    ASSIGN_FLAG (SELECTEDFLAG, Flag, pad);
+	    selection_note (PAD_TYPE, element, pad);
+	    if (PCB->PinOn)
+	      DrawPad (pad);
+	    changed = true;
+	  }
+      }
+      END_LOOP;
+    }
+  return (changed);
+}
+
+/* ----------------------------------------------------------------------
+ * unselects the selected objects within the passed box; the same as
+ * SelectBlock (Box, false) but only visits the entries of the selection
+ * index, which has to be valid
+ */
+static bool
+unselect_block_indexed (BoxType *Box)
+{
+  GHashTable *elements = g_hash_table_new (NULL, NULL);
+  bool changed = false;
+  Cardinal i;
+
+  for (i = 0; i < SelectionN; i++)
+    {
+      SelectionEntryType *entry = &SelectionList[i];
+      LayerType *layer = (LayerType *) entry->Ptr1;
+      bool inside = false;
+
+      if (!TEST_FLAG (SELECTEDFLAG, (AnyObjectType *) entry->Ptr2))
+	continue;
+      switch (entry->Type)
+	{
+	case RATLINE_TYPE:
+	  inside = LINE_IN_BOX ((LineType *) entry->Ptr2, Box);
+	  break;
+	case LINE_TYPE:
+	  inside = LINE_IN_BOX ((LineType *) entry->Ptr2, Box);
+	  break;
+	case ARC_TYPE:
+	  inside = ARC_IN_BOX ((ArcType *) entry->Ptr2, Box);
+	  break;
+	case TEXT_TYPE:
+	  inside = TEXT_IN_BOX ((TextType *) entry->Ptr2, Box);
+	  break;
+	case POLYGON_TYPE:
+	  inside = POLYGON_IN_BOX ((PolygonType *) entry->Ptr2, Box);
+	  break;
+	case VIA_TYPE:
+	  inside = VIA_OR_PIN_IN_BOX ((PinType *) entry->Ptr2, Box);
+	  break;
+
+	  /* elements are handled as a whole, once each */
+	case ELEMENT_TYPE:
+	case ELEMENTNAME_TYPE:
+	case PIN_TYPE:
+	case PAD_TYPE:
+	  if (!g_hash_table_lookup (elements, entry->Ptr1))
+	    {
+	      g_hash_table_insert (elements, entry->Ptr1, entry->Ptr1);
+	      if (select_block_element ((ElementType *) entry->Ptr1,
+					Box, false))
+		changed = true;
+	    }
+	  continue;
+	}
+      if (!inside || TEST_FLAG (LOCKFLAG, (AnyObjectType *) entry->Ptr2))
+	continue;
+
+      AddObjectToFlagUndoList (entry->Type, entry->Ptr1, entry->Ptr2,
+			       entry->Ptr2);
+      CLEAR_FLAG (SELECTEDFLAG, (AnyObjectType *) entry->Ptr2);
+      switch (entry->Type)
+	{
+	case RATLINE_TYPE:
+	  if (PCB->RatOn)
+	    DrawRat ((RatType *) entry->Ptr2);
+	  break;
+	case LINE_TYPE:
+	  if (layer->On)
+	    DrawLine (layer, (LineType *) entry->Ptr2);
+	  break;
+	case ARC_TYPE:
+	  if (layer->On)
+	    DrawArc (layer, (ArcType *) entry->Ptr2);
+	  break;
+	case TEXT_TYPE:
+	  if (TEXT_IS_VISIBLE (PCB, layer, (TextType *) entry->Ptr2))
+	    DrawText (layer, (TextType *) entry->Ptr2);
+	  break;
+	case POLYGON_TYPE:
+	  if (layer->On)
+	    DrawPolygon (layer, (PolygonType *) entry->Ptr2);
+	  break;
+	case VIA_TYPE:
+	  if (PCB->ViaOn)
+	    DrawVia ((PinType *) entry->Ptr2);
+	  break;
+	}
+      changed = true;
+    }
+  g_hash_table_destroy (elements);
+  selection_index_compact ();
   return (changed);
 }
 
@@ -217,16 +632,32 @@ SelectBlock (BoxType *Box, bool Flag)
 {
   bool changed = false;
 
-  if (PCB->RatOn || !Flag)
+  /* unselecting only has to look at what is selected */
+  if (!Flag)
+    {
+      selection_index_update ();
+      selection_begin ();
+      changed = unselect_block_indexed (Box);
+      if (changed)
+	{
+	  Draw ();
+	  IncrementUndoSerialNumber ();
+	}
+      selection_end ();
+      return (changed);
+    }
+
+  selection_begin ();
+  if (PCB->RatOn)
     RAT_LOOP (PCB->Data);
   {
     if (LINE_IN_BOX ((LineType *) line, Box) &&
-	!TEST_FLAG (LOCKFLAG, line) && TEST_FLAG (SELECTEDFLAG, line) != Flag)
+	!TEST_FLAG (LOCKFLAG, line) && !TEST_FLAG (SELECTEDFLAG, line))
       {
 	AddObjectToFlagUndoList (RATLINE_TYPE, line, line, line);
-	ASSIGN_FLAG (SELECTEDFLAG, Flag, line);
-	if (PCB->RatOn)
-	  DrawRat (line);
+	SET_FLAG (SELECTEDFLAG, line);
+	selection_note (RATLINE_TYPE, line, line);
+	DrawRat (line);
 	changed = true;
       }
   }
@@ -237,26 +668,27 @@ SelectBlock (BoxType *Box, bool Flag)
   {
     if (layer == & PCB->Data->SILKLAYER)
       {
-	if (! (PCB->ElementOn || !Flag))
+	if (! PCB->ElementOn)
 	  continue;
       }
     else if (layer == & PCB->Data->BACKSILKLAYER)
       {
-	if (! (PCB->InvisibleObjectsOn || !Flag))
+	if (! PCB->InvisibleObjectsOn)
 	  continue;
       }
     else
-      if (! (layer->On || !Flag))
+      if (! layer->On)
 	continue;
 
     LINE_LOOP (layer);
     {
       if (LINE_IN_BOX (line, Box)
 	  && !TEST_FLAG (LOCKFLAG, line)
-	  && TEST_FLAG (SELECTEDFLAG, line) != Flag)
+	  && !TEST_FLAG (SELECTEDFLAG, line))
 	{
 	  AddObjectToFlagUndoList (LINE_TYPE, layer, line, line);
-	  ASSIGN_FLAG (SELECTEDFLAG, Flag, line);
+	  SET_FLAG (SELECTEDFLAG, line);
+	  selection_note (LINE_TYPE, layer, line);
 	  if (layer->On)
 	    DrawLine (layer, line);
 	  changed = true;
@@ -267,10 +699,11 @@ SelectBlock (BoxType *Box, bool Flag)
     {
       if (ARC_IN_BOX (arc, Box)
 	  && !TEST_FLAG (LOCKFLAG, arc)
-	  && TEST_FLAG (SELECTEDFLAG, arc) != Flag)
+	  && !TEST_FLAG (SELECTEDFLAG, arc))
 	{
 	  AddObjectToFlagUndoList (ARC_TYPE, layer, arc, arc);
-	  ASSIGN_FLAG (SELECTEDFLAG, Flag, arc);
+	  SET_FLAG (SELECTEDFLAG, arc);
+	  selection_note (ARC_TYPE, layer, arc);
 	  if (layer->On)
 	    DrawArc (layer, arc);
 	  changed = true;
@@ -279,16 +712,16 @@ SelectBlock (BoxType *Box, bool Flag)
     END_LOOP;
     TEXT_LOOP (layer);
     {
-      if (!Flag || TEXT_IS_VISIBLE(PCB, layer, text))
+      if (TEXT_IS_VISIBLE(PCB, layer, text))
 	{
 	  if (TEXT_IN_BOX (text, Box)
 	      && !TEST_FLAG (LOCKFLAG, text)
-	      && TEST_FLAG (SELECTEDFLAG, text) != Flag)
+	      && !TEST_FLAG (SELECTEDFLAG, text))
 	    {
 	      AddObjectToFlagUndoList (TEXT_TYPE, layer, text, text);
-	      ASSIGN_FLAG (SELECTEDFLAG, Flag, text);
-	      if (TEXT_IS_VISIBLE(PCB, layer, text))
-		DrawText (layer, text);
+	      SET_FLAG (SELECTEDFLAG, text);
+	      selection_note (TEXT_TYPE, layer, text);
+	      DrawText (layer, text);
 	      changed = true;
 	    }
 	}
@@ -298,10 +731,11 @@ SelectBlock (BoxType *Box, bool Flag)
     {
       if (POLYGON_IN_BOX (polygon, Box)
 	  && !TEST_FLAG (LOCKFLAG, polygon)
-	  && TEST_FLAG (SELECTEDFLAG, polygon) != Flag)
+	  && !TEST_FLAG (SELECTEDFLAG, polygon))
 	{
 	  AddObjectToFlagUndoList (POLYGON_TYPE, layer, polygon, polygon);
-	  ASSIGN_FLAG (SELECTEDFLAG, Flag, polygon);
+	  SET_FLAG (SELECTEDFLAG, polygon);
+	  selection_note (POLYGON_TYPE, layer, polygon);
 	  if (layer->On)
 	    DrawPolygon (layer, polygon);
 	  changed = true;
@@ -314,114 +748,22 @@ SelectBlock (BoxType *Box, bool Flag)
   /* elements */
   ELEMENT_LOOP (PCB->Data);
   {
-    {
-      bool gotElement = false;
-      if ((PCB->ElementOn || !Flag)
-	  && !TEST_FLAG (LOCKFLAG, element)
-	  && ((TEST_FLAG (ONSOLDERFLAG, element) != 0) == SWAP_IDENT
-	      || PCB->InvisibleObjectsOn))
-	{
-	  if (BOX_IN_BOX
-	      (&ELEMENT_TEXT (PCB, element).BoundingBox, Box)
-	      && !TEST_FLAG (LOCKFLAG, &ELEMENT_TEXT (PCB, element))
-	      && TEST_FLAG (SELECTEDFLAG,
-			    &ELEMENT_TEXT (PCB, element)) != Flag)
-	    {
-	      /* select all names of element */
-	      ELEMENTTEXT_LOOP (element);
-	      {
-		AddObjectToFlagUndoList (ELEMENTNAME_TYPE,
-					 element, text, text);
-		ASSIGN_FLAG (SELECTEDFLAG, Flag, text);
-	      }
-	      END_LOOP;
-	      if (PCB->ElementOn)
-		DrawElementName (element);
-	      changed = true;
-	    }
-	  if ((PCB->PinOn || !Flag) && ELEMENT_IN_BOX (element, Box))
-	    if (TEST_FLAG (SELECTEDFLAG, element) != Flag)
-	      {
-		AddObjectToFlagUndoList (ELEMENT_TYPE,
-					 element, element, element);
-		ASSIGN_FLAG (SELECTEDFLAG, Flag, element);
-		PIN_LOOP (element);
-		{
-		  if (TEST_FLAG (SELECTEDFLAG, pin) != Flag)
-		    {
-		      AddObjectToFlagUndoList (PIN_TYPE, element, pin, pin);
-		      ASSIGN_FLAG (SELECTEDFLAG, Flag, pin);
-		      if (PCB->PinOn)
-			DrawPin (pin);
-		      changed = true;
-		    }
-		}
-		END_LOOP;
-		PAD_LOOP (element);
-		{
-		  if (TEST_FLAG (SELECTEDFLAG, pad) != Flag)
-		    {
-		      AddObjectToFlagUndoList (PAD_TYPE, element, pad, pad);
-		      ASSIGN_FLAG (SELECTEDFLAG, Flag, pad);
-		      if (PCB->PinOn)
-			DrawPad (pad);
-		      changed = true;
-		    }
-		}
-		END_LOOP;
-		if (PCB->PinOn)
-		  DrawElement (element);
-		changed = true;
-		gotElement = true;
-	      }
-	}
-      if ((PCB->PinOn || !Flag) && !TEST_FLAG (LOCKFLAG, element) && !gotElement)
-	{
-	  PIN_LOOP (element);
-	  {
-	    if ((VIA_OR_PIN_IN_BOX (pin, Box)
-		 && TEST_FLAG (SELECTEDFLAG, pin) != Flag))
-	      {
-		AddObjectToFlagUndoList (PIN_TYPE, element, pin, pin);
-		ASSIGN_FLAG (SELECTEDFLAG, Flag, pin);
-		if (PCB->PinOn)
-		  DrawPin (pin);
-		changed = true;
-	      }
-	  }
-	  END_LOOP;
-	  PAD_LOOP (element);
-	  {
-	    if (PAD_IN_BOX (pad, Box)
-		&& TEST_FLAG (SELECTEDFLAG, pad) != Flag
-		&& (TEST_FLAG (ONSOLDERFLAG, pad) == SWAP_IDENT
-		    || PCB->InvisibleObjectsOn
-		    || !Flag))
-	      {
-		AddObjectToFlagUndoList (PAD_TYPE, element, pad, pad);
-		ASSIGN_FLAG (SELECTEDFLAG, Flag, pad);
-		if (PCB->PinOn)
-		  DrawPad (pad);
-		changed = true;
-	      }
-	  }
-	  END_LOOP;
-	}
-    }
+    if (select_block_element (element, Box, true))
+      changed = true;
   }
   END_LOOP;
   /* end with vias */
-  if (PCB->ViaOn || !Flag)
+  if (PCB->ViaOn)
     VIA_LOOP (PCB->Data);
   {
     if (VIA_OR_PIN_IN_BOX (via, Box)
 	&& !TEST_FLAG (LOCKFLAG, via)
-	&& TEST_FLAG (SELECTEDFLAG, via) != Flag)
+	&& !TEST_FLAG (SELECTEDFLAG, via))
       {
 	AddObjectToFlagUndoList (VIA_TYPE, via, via, via);
-	ASSIGN_FLAG (SELECTEDFLAG, Flag, via);
-	if (PCB->ViaOn)
-	  DrawVia (via);
+	SET_FLAG (SELECTEDFLAG, via);
+	selection_note (VIA_TYPE, via, via);
+	DrawVia (via);
 	changed = true;
       }
   }
@@ -431,6 +773,7 @@ SelectBlock (BoxType *Box, bool Flag)
       Draw ();
       IncrementUndoSerialNumber ();
     }
+  selection_end ();
   return (changed);
 }
 
@@ -699,6 +1042,119 @@ SelectedOperation (ObjectFunctionType *F, bool Reset, int type)
   return (changed);
 }
 
+/* ----------------------------------------------------------------------
+ * calls the matching lowlevel procedure of F for a selection index entry
+ * if the object is visible; returns true if there was one to call
+ */
+static bool
+selected_entry_operation (ObjectFunctionType *F, SelectionEntryType *entry)
+{
+  LayerType *layer = (LayerType *) entry->Ptr1;
+  ElementType *element = (ElementType *) entry->Ptr1;
+
+  switch (entry->Type)
+    {
+    case LINE_TYPE:
+      if (!F->Line || !layer->On)
+	return (false);
+      F->Line (layer, (LineType *) entry->Ptr2);
+      return (true);
+
+    case ARC_TYPE:
+      if (!F->Arc || !layer->On)
+	return (false);
+      F->Arc (layer, (ArcType *) entry->Ptr2);
+      return (true);
+
+    case TEXT_TYPE:
+      if (!F->Text || !TEXT_IS_VISIBLE (PCB, layer, (TextType *) entry->Ptr2))
+	return (false);
+      F->Text (layer, (TextType *) entry->Ptr2);
+      return (true);
+
+    case POLYGON_TYPE:
+      if (!F->Polygon || !layer->On)
+	return (false);
+      F->Polygon (layer, (PolygonType *) entry->Ptr2);
+      return (true);
+
+    case ELEMENT_TYPE:
+      if (!F->Element || !PCB->ElementOn)
+	return (false);
+      F->Element (element);
+      return (true);
+
+    case ELEMENTNAME_TYPE:
+      /* only the name that is displayed counts */
+      if (!F->ElementName || !PCB->ElementOn
+	  || entry->Ptr2 != &ELEMENT_TEXT (PCB, element))
+	return (false);
+      F->ElementName (element);
+      return (true);
+
+    case PIN_TYPE:
+      if (!F->Pin || !PCB->PinOn)
+	return (false);
+      F->Pin (element, (PinType *) entry->Ptr2);
+      return (true);
+
+    case PAD_TYPE:
+      if (!F->Pad || !PCB->PinOn)
+	return (false);
+      F->Pad (element, (PadType *) entry->Ptr2);
+      return (true);
+
+    case VIA_TYPE:
+      if (!F->Via || !PCB->ViaOn)
+	return (false);
+      F->Via ((PinType *) entry->Ptr2);
+      return (true);
+
+    case RATLINE_TYPE:
+      if (!F->Rat || !PCB->RatOn)
+	return (false);
+      F->Rat ((RatType *) entry->Ptr2);
+      return (true);
+    }
+  return (false);
+}
+
+/* ----------------------------------------------------------------------
+ * like SelectedOperation() without reset, for operations that leave the
+ * selected objects in place: changing their sizes or flags, copying them
+ * to a buffer and the like.  Only the selected objects are visited, type
+ * by type in the usual order, and the selection index stays valid.
+ * Operations that remove objects or move them to other lists have to use
+ * SelectedOperation().
+ * returns true if anything has changed
+ */
+bool
+SelectedOperationInPlace (ObjectFunctionType *F, int type)
+{
+  static const int order[] = {
+    LINE_TYPE, ARC_TYPE, TEXT_TYPE, POLYGON_TYPE, ELEMENT_TYPE,
+    ELEMENTNAME_TYPE, PIN_TYPE, PAD_TYPE, VIA_TYPE, RATLINE_TYPE
+  };
+  bool changed = false;
+  Cardinal i, pass;
+
+  selection_index_update ();
+  selection_begin ();
+  for (pass = 0; pass < sizeof (order) / sizeof (order[0]); pass++)
+    {
+      if (!(type & order[pass]))
+	continue;
+      for (i = 0; i < SelectionN; i++)
+	if (SelectionList[i].Type == order[pass]
+	    && TEST_FLAG (SELECTEDFLAG,
+			  (AnyObjectType *) SelectionList[i].Ptr2)
+	    && selected_entry_operation (F, &SelectionList[i]))
+	  changed = true;
+    }
+  selection_end ();
+  return (changed);
+}
+
 /* ----------------------------------------------------------------------
  * selects/unselects all objects which were found during a connection scan
  * Flag determines if they are to be selected or unselected
@@ -39,6 +39,8 @@
 bool SelectObject (void);
 bool SelectBlock (BoxType *, bool);
 bool SelectedOperation (ObjectFunctionType *, bool, int);
+bool SelectedOperationInPlace (ObjectFunctionType *, int);
+void InvalidateSelectionIndex (void);
 void *ObjectOperation (ObjectFunctionType *, int, void *, void *, void *);
 bool SelectConnection (bool);
 
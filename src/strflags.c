@@ -59,6 +59,108 @@ typedef struct
   FlagType Flags;
 } FlagHolder;
 
+/* ---------------------------------------------------------------------------
+ * Thermal styles.  Each layer of a pin or via has a 4 bit style, but
+ * few objects have any and those that do share a handful of patterns.
+ * So every distinct pattern is kept once in this table and FlagType
+ * only carries its index, 0 meaning no thermals.  Patterns are never
+ * freed, which keeps FlagType simple-assignable and FLAGS_EQUAL a plain
+ * compare.
+ */
+#define THERMAL_BYTES ((MAX_LAYER + 1) / 2)
+
+static GPtrArray *thermal_patterns = NULL;	/* index -> pattern */
+static GHashTable *thermal_index = NULL;	/* pattern -> index */
+
+static guint
+thermal_hash (gconstpointer key)
+{
+  const unsigned char *t = (const unsigned char *) key;
+  guint h = 0;
+  int i;
+
+  for (i = 0; i < THERMAL_BYTES; i++)
+    h = h * 31 + t[i];
+  return h;
+}
+
+static gboolean
+thermal_equal (gconstpointer a, gconstpointer b)
+{
+  return memcmp (a, b, THERMAL_BYTES) == 0;
+}
+
+static unsigned int
+thermal_intern (const unsigned char *t)
+{
+  unsigned char *copy;
+  int i;
+
+  for (i = 0; i < THERMAL_BYTES && t[i] == 0; i++)
+    ;
+  if (i == THERMAL_BYTES)
+    return 0;
+
+  if (thermal_patterns == NULL)
+    {
+      thermal_patterns = g_ptr_array_new ();
+      g_ptr_array_add (thermal_patterns, NULL);	/* no thermals */
+      thermal_index = g_hash_table_new (thermal_hash, thermal_equal);
+    }
+  else
+    {
+      gpointer index = g_hash_table_lookup (thermal_index, t);
+      if (index != NULL)
+	return GPOINTER_TO_UINT (index);
+    }
+
+  copy = (unsigned char *) malloc (THERMAL_BYTES);
+  memcpy (copy, t, THERMAL_BYTES);
+  g_ptr_array_add (thermal_patterns, copy);
+  g_hash_table_insert (thermal_index, copy,
+		       GUINT_TO_POINTER (thermal_patterns->len - 1));
+  return thermal_patterns->len - 1;
+}
+
+int
+GetFlagThermal (const FlagType *flags, int layer)
+{
+  const unsigned char *t;
+
+  if (flags->t == 0)
+    return 0;
+  t = (const unsigned char *) g_ptr_array_index (thermal_patterns, flags->t);
+  return (t[layer / 2] >> (4 * (layer % 2))) & 0xf;
+}
+
+void
+SetFlagThermal (FlagType *flags, int layer, int style)
+{
+  unsigned char t[THERMAL_BYTES];
+
+  if (GetFlagThermal (flags, layer) == style)
+    return;
+  if (flags->t == 0)
+    memset (t, 0, THERMAL_BYTES);
+  else
+    memcpy (t, g_ptr_array_index (thermal_patterns, flags->t),
+	    THERMAL_BYTES);
+  t[layer / 2] = (t[layer / 2] & ~THERMFLAG (layer))
+    | ((style & 0xf) << (4 * (layer % 2)));
+  flags->t = thermal_intern (t);
+}
+
+/* number of distinct thermal patterns and the bytes they take */
+int
+FlagThermalPatterns (size_t *bytes)
+{
+  int n = thermal_patterns ? thermal_patterns->len - 1 : 0;
+
+  if (bytes)
+    *bytes = n * (THERMAL_BYTES + 2 * sizeof (gpointer));
+  return n;
+}
+
 /* Be careful to list more specific flags first, followed by general
  * flags, when two flags use the same bit.  For example, "onsolder" is
  * for elements only, while "auto" is for everything else.  They use
@@ -574,8 +676,8 @@ dump_flag (FlagType * f)
 {
   int l;
   printf ("F:%08x T:[", f->f);
-  for (l = 0; l < (MAX_LAYER + 7) / 8; l++)
-    printf (" %02x", f->t[l]);
+  for (l = 0; l < MAX_LAYER; l++)
+    printf ("%x", GetFlagThermal (f, l));
   printf ("]");
 }
 
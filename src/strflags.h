@@ -47,4 +47,8 @@ FlagType string_to_pcbflags (const char *flagstring,
 			  int (*error) (const char *msg));
 char *pcbflags_to_string (FlagType flags);
 
+/* Returns the number of distinct thermal patterns in use and, in
+   bytes, the memory they take.  */
+int FlagThermalPatterns (size_t *bytes);
+
 #endif
@@ -2102,6 +2102,264 @@ unconstrain(toporouter_layer_t *l, toporouter_constraint_t *c)
   gts_allow_floating_vertices = FALSE;
 }
 
+/* Position of (x,y) along a Hilbert curve over a 2^16 x 2^16 grid */
+static guint64
+hilbert_key(guint32 x, guint32 y)
+{
+  guint64 d = 0;
+  guint32 s, rx, ry, t;
+
+  for(s = 1 << 15; s > 0; s >>= 1) {
+    rx = (x & s) > 0;
+    ry = (y & s) > 0;
+    d += (guint64)s * s * ((3 * rx) ^ ry);
+    if(!ry) {
+      if(rx) {
+        x = s - 1 - x;
+        y = s - 1 - y;
+      }
+      t = x; x = y; y = t;
+    }
+  }
+  return d;
+}
+
+typedef struct {
+  guint64 key;
+  GtsVertex *v;
+} hilbert_vertex_t;
+
+static int
+hilbert_vertex_cmp(const void *a, const void *b)
+{
+  guint64 ka = ((const hilbert_vertex_t *)a)->key, kb = ((const hilbert_vertex_t *)b)->key;
+  return ka < kb ? -1 : ka > kb;
+}
+
+static int
+guint_cmp(const void *a, const void *b)
+{
+  guint ua = *(const guint *)a, ub = *(const guint *)b;
+  return ua < ub ? -1 : ua > ub;
+}
+
+/* Returns the vertices in Hilbert curve order, so consecutive insertions
+ * land close to each other in the triangulation */
+static hilbert_vertex_t *
+hilbert_order(GList *vertices, guint *n)
+{
+  hilbert_vertex_t *hv;
+  gdouble x1 = G_MAXDOUBLE, y1 = G_MAXDOUBLE, x2 = -G_MAXDOUBLE, y2 = -G_MAXDOUBLE, sx, sy;
+  GList *i;
+  guint k;
+
+  *n = g_list_length(vertices);
+  hv = (hilbert_vertex_t *)malloc((*n + 1) * sizeof(hilbert_vertex_t));
+
+  for(i = vertices; i; i = i->next) {
+    GtsPoint *p = GTS_POINT(i->data);
+    x1 = MIN(x1, p->x); x2 = MAX(x2, p->x);
+    y1 = MIN(y1, p->y); y2 = MAX(y2, p->y);
+  }
+  sx = x2 > x1 ? 65535. / (x2 - x1) : 0.;
+  sy = y2 > y1 ? 65535. / (y2 - y1) : 0.;
+
+  for(i = vertices, k = 0; i; i = i->next, k++) {
+    GtsPoint *p = GTS_POINT(i->data);
+    hv[k].v = GTS_VERTEX(i->data);
+    hv[k].key = hilbert_key((guint32)((p->x - x1) * sx), (guint32)((p->y - y1) * sy));
+  }
+  qsort(hv, *n, sizeof(hilbert_vertex_t), hilbert_vertex_cmp);
+  return hv;
+}
+
+/* A face of surface s incident on v, usable as a point location hint */
+static GtsFace *
+vertex_hint_face(GtsVertex *v, GtsSurface *s)
+{
+  GSList *i, *j;
+
+  for(i = v->segments; i; i = i->next) {
+    if(!GTS_IS_EDGE(i->data)) continue;
+    for(j = GTS_EDGE(i->data)->triangles; j; j = j->next) {
+      if(GTS_IS_FACE(j->data) && gts_face_has_parent_surface(GTS_FACE(j->data), s) &&
+          gts_triangle_orientation(GTS_TRIANGLE(j->data)) > 0.)
+        return GTS_FACE(j->data);
+    }
+  }
+  return NULL;
+}
+
+/* Resolves an intersecting or overlapping pair of constraints by
+ * replacing them with non-overlapping ones. Returns nonzero if c1 and c2
+ * were removed from the layer */
+static guint
+fix_constraint_pair(toporouter_t *r, toporouter_layer_t *l, toporouter_constraint_t *c1, toporouter_constraint_t *c2)
+{
+  guint rem = 0;
+  GList *temp;
+
+//  printf("\tconflict: "); print_constraint(c2);
+  toporouter_bbox_t *c1box = c1->box, *c2box = c2->box;
+  toporouter_vertex_t *c1v1 = tedge_v1(c1);
+  toporouter_vertex_t *c1v2 = tedge_v2(c1);
+  toporouter_vertex_t *c2v1 = tedge_v1(c2);
+  toporouter_vertex_t *c2v2 = tedge_v2(c2);
+
+  if(gts_segments_are_intersecting(GTS_SEGMENT(c1), GTS_SEGMENT(c2)) == GTS_IN) {
+    toporouter_vertex_t *v;
+    unconstrain(l, c1); unconstrain(l, c2); 
+    rem = 1;
+    // proper intersection
+    v = TOPOROUTER_VERTEX(vertex_intersect(
+          GTS_VERTEX(c1v1),
+          GTS_VERTEX(c1v2),
+          GTS_VERTEX(c2v1),
+          GTS_VERTEX(c2v2)));
+
+    // remove both constraints
+    // replace with 4x constraints
+    // insert new intersection vertex
+    GTS_POINT(v)->z = vz(c1v1);
+
+    l->vertices = g_list_prepend(l->vertices, v);
+//        gts_delaunay_add_vertex (l->surface, GTS_VERTEX(v), NULL);
+
+    v->bbox = c1box;
+
+    temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(v), vy(v), 0, c1box);
+    c1box->constraints = g_list_concat(c1box->constraints, temp);
+
+    temp = insert_constraint_edge(r, l, vx(c1v2), vy(c1v2), 0, vx(v), vy(v), 0, c1box);
+    c1box->constraints = g_list_concat(c1box->constraints, temp);
+
+    temp = insert_constraint_edge(r, l, vx(c2v1), vy(c2v1), 0, vx(v), vy(v), 0, c2box);
+    c2box->constraints = g_list_concat(c2box->constraints, temp);
+
+    temp = insert_constraint_edge(r, l, vx(c2v2), vy(c2v2), 0, vx(v), vy(v), 0, c2box);
+    c2box->constraints = g_list_concat(c2box->constraints, temp);
+
+  }else if(gts_segments_are_intersecting(GTS_SEGMENT(c1), GTS_SEGMENT(c2)) == GTS_ON ||
+      gts_segments_are_intersecting(GTS_SEGMENT(c2), GTS_SEGMENT(c1)) == GTS_ON) {
+
+    if(vertex_between(edge_v1(c2), edge_v2(c2), edge_v1(c1)) && vertex_between(edge_v1(c2), edge_v2(c2), edge_v2(c1))) {
+      unconstrain(l, c1); unconstrain(l, c2); 
+      rem = 1;
+      // remove c1
+      temp = insert_constraint_edge(r, l, vx(c2v1), vy(c2v1), 0, vx(c2v2), vy(c2v2), 0, c2box);
+      c2box->constraints = g_list_concat(c2box->constraints, temp);
+
+    }else if(vertex_between(edge_v1(c1), edge_v2(c1), edge_v1(c2)) && vertex_between(edge_v1(c1), edge_v2(c1), edge_v2(c2))) {
+      unconstrain(l, c1); unconstrain(l, c2); 
+      rem = 1;
+      // remove c2
+      temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(c1v2), vy(c1v2), 0, c1box);
+      c1box->constraints = g_list_concat(c1box->constraints, temp);
+
+    //}else if(!vertex_wind(edge_v1(c1), edge_v2(c1), edge_v1(c2)) && !vertex_wind(edge_v1(c1), edge_v2(c1), edge_v2(c2))) {
+   /*     }else if(vertex_between(edge_v1(c1), edge_v2(c1), edge_v1(c2)) || vertex_between(edge_v1(c1), edge_v2(c1), edge_v2(c2))) {
+      unconstrain(l, c1); unconstrain(l, c2); 
+      rem = 1;
+      printf("all colinear\n");
+      //   exit(1);
+      temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(c1v2), vy(c1v2), 0, c1box);
+      c1box->constraints = g_list_concat(c1box->constraints, temp);
+
+      if(vertex_between(GTS_VERTEX(c1v1), GTS_VERTEX(c1v2), GTS_VERTEX(c2v2))) {
+        // v2 of c2 is inner
+        if(vertex_between(GTS_VERTEX(c2v1), GTS_VERTEX(c2v2), GTS_VERTEX(c1v2))) {
+          // v2 of c1 is inner
+          // c2 = c1.v2 -> c2.v1
+          temp = insert_constraint_edge(r, l, vx(c1v2), vy(c1v2), 0, vx(c2v1), vy(c2v1), 0, c2box);
+          c2box->constraints = g_list_concat(c2box->constraints, temp);
+        }else{
+          // v1 of c1 is inner
+          // c2 = c1.v1 -> c2.v1
+          temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(c2v1), vy(c2v1), 0, c2box);
+          c2box->constraints = g_list_concat(c2box->constraints, temp);
+        }
+      }else{
+        // v1 of c2 is inner
+        if(vertex_between(GTS_VERTEX(c2v1), GTS_VERTEX(c2v2), GTS_VERTEX(c1v2))) {
+          // v2 of c1 is inner
+          // c2 = c1.v2 -> c2.v2
+          temp = insert_constraint_edge(r, l, vx(c1v2), vy(c1v2), 0, vx(c2v2), vy(c2v2), 0, c2box);
+          c2box->constraints = g_list_concat(c2box->constraints, temp);
+        }else{
+          // v1 of c1 is inner
+          // c2 = c1.v1 -> c2.v2
+          temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(c2v2), vy(c2v2), 0, c2box);
+          c2box->constraints = g_list_concat(c2box->constraints, temp);
+        }
+      }*/
+    }else if(vertex_between(edge_v1(c2), edge_v2(c2), edge_v1(c1)) && c1v1 != c2v1 && c1v1 != c2v2) {
+      unconstrain(l, c1); unconstrain(l, c2); 
+      rem = 1;
+      //v1 of c1 is on c2
+      printf("v1 of c1 on c2\n"); 
+
+      // replace with 2x constraints
+      temp = insert_constraint_edge(r, l, vx(c2v1), vy(c2v1), 0, vx(c1v1), vy(c1v1), 0, c2box);
+      c2box->constraints = g_list_concat(c2box->constraints, temp);
+      temp = insert_constraint_edge(r, l, vx(c2v2), vy(c2v2), 0, vx(c1v1), vy(c1v1), 0, c2box);
+      c2box->constraints = g_list_concat(c2box->constraints, temp);
+
+      temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(c1v2), vy(c1v2), 0, c1box);
+      c1box->constraints = g_list_concat(c1box->constraints, temp);
+
+      // restore c1
+      //temp = insert_constraint_edge(r, l, vx(tedge_v2(c1)), vy(tedge_v2(c1)), 0, vx(tedge_v1(c1)), vy(tedge_v1(c1)), 0, c1->box);
+      //c2->box->constraints = g_list_concat(c2->box->constraints, temp);
+
+    }else if(vertex_between(edge_v1(c2), edge_v2(c2), edge_v2(c1)) && c1v2 != c2v1 && c1v2 != c2v2) {
+      unconstrain(l, c1); unconstrain(l, c2); 
+      rem = 1;
+      //v2 of c1 is on c2
+      printf("v2 of c1 on c2\n"); 
+
+      // replace with 2x constraints
+      temp = insert_constraint_edge(r, l, vx(c2v1), vy(c2v1), 0, vx(c1v2), vy(c1v2), 0, c2box);
+      c2box->constraints = g_list_concat(c2box->constraints, temp);
+      temp = insert_constraint_edge(r, l, vx(c2v2), vy(c2v2), 0, vx(c1v2), vy(c1v2), 0, c2box);
+      c2box->constraints = g_list_concat(c2box->constraints, temp);
+
+      temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(c1v2), vy(c1v2), 0, c1box);
+      c1box->constraints = g_list_concat(c1box->constraints, temp);
+
+    }else if(vertex_between(edge_v1(c1), edge_v2(c1), edge_v1(c2)) && c2v1 != c1v1 && c2v1 != c1v2) {
+      unconstrain(l, c1); unconstrain(l, c2); 
+      rem = 1;
+      //v1 of c2 is on c1
+      printf("v1 of c2 on c1\n"); 
+
+      // replace with 2x constraints
+      temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(c2v1), vy(c2v1), 0, c1box);
+      c1box->constraints = g_list_concat(c1box->constraints, temp);
+      temp = insert_constraint_edge(r, l, vx(c1v2), vy(c1v2), 0, vx(c2v1), vy(c2v1), 0, c1box);
+      c1box->constraints = g_list_concat(c1box->constraints, temp);
+
+      temp = insert_constraint_edge(r, l, vx(c2v1), vy(c2v1), 0, vx(c2v2), vy(c2v2), 0, c2box);
+      c2box->constraints = g_list_concat(c2box->constraints, temp);
+    }else if(vertex_between(edge_v1(c1), edge_v2(c1), edge_v2(c2)) && c2v2 != c1v1 && c2v2 != c1v2) {
+      unconstrain(l, c1); unconstrain(l, c2);
+      rem = 1;
+      //v2 of c2 is on c1
+      printf("v2 of c2 on c1\n"); 
+
+      // replace with 2x constraints
+      temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(c2v2), vy(c2v2), 0, c1box);
+      c1box->constraints = g_list_concat(c1box->constraints, temp);
+      temp = insert_constraint_edge(r, l, vx(c1v2), vy(c1v2), 0, vx(c2v2), vy(c2v2), 0, c1box);
+      c1box->constraints = g_list_concat(c1box->constraints, temp);
+
+      temp = insert_constraint_edge(r, l, vx(c2v1), vy(c2v1), 0, vx(c2v2), vy(c2v2), 0, c2box);
+      c2box->constraints = g_list_concat(c2box->constraints, temp);
+    }
+  }
+
+  return rem;
+}
+
 void
 build_cdt(toporouter_t *r, toporouter_layer_t *l) 
 {
@@ -2169,194 +2427,68 @@ build_cdt(toporouter_t *r, toporouter_layer_t *l)
     
   }
 */
-check_cons_continuation:  
-  i = l->constraints;
-  while (i) {  
-    toporouter_constraint_t *c1 = TOPOROUTER_CONSTRAINT(i->data);
-    GList *j = i->next;
-   // printf("adding cons: "); print_constraint(c1);
-    
-    while(j) {
-      toporouter_constraint_t *c2 = TOPOROUTER_CONSTRAINT(j->data);
-      guint rem = 0;
-      GList *temp;
-      
-    //  printf("\tconflict: "); print_constraint(c2);
-      toporouter_bbox_t *c1box = c1->box, *c2box = c2->box;
-      toporouter_vertex_t *c1v1 = tedge_v1(c1);
-      toporouter_vertex_t *c1v2 = tedge_v2(c1);
-      toporouter_vertex_t *c2v1 = tedge_v1(c2);
-      toporouter_vertex_t *c2v2 = tedge_v2(c2);
-
-      if(gts_segments_are_intersecting(GTS_SEGMENT(c1), GTS_SEGMENT(c2)) == GTS_IN) {
-        toporouter_vertex_t *v;
-        unconstrain(l, c1); unconstrain(l, c2); 
-        rem = 1;
-        // proper intersection
-        v = TOPOROUTER_VERTEX(vertex_intersect(
-              GTS_VERTEX(c1v1),
-              GTS_VERTEX(c1v2),
-              GTS_VERTEX(c2v1),
-              GTS_VERTEX(c2v2)));
-
-        // remove both constraints
-        // replace with 4x constraints
-        // insert new intersection vertex
-        GTS_POINT(v)->z = vz(c1v1);
-
-        l->vertices = g_list_prepend(l->vertices, v);
-//        gts_delaunay_add_vertex (l->surface, GTS_VERTEX(v), NULL);
-
-        v->bbox = c1box;
-
-        temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(v), vy(v), 0, c1box);
-        c1box->constraints = g_list_concat(c1box->constraints, temp);
-
-        temp = insert_constraint_edge(r, l, vx(c1v2), vy(c1v2), 0, vx(v), vy(v), 0, c1box);
-        c1box->constraints = g_list_concat(c1box->constraints, temp);
-
-        temp = insert_constraint_edge(r, l, vx(c2v1), vy(c2v1), 0, vx(v), vy(v), 0, c2box);
-        c2box->constraints = g_list_concat(c2box->constraints, temp);
-
-        temp = insert_constraint_edge(r, l, vx(c2v2), vy(c2v2), 0, vx(v), vy(v), 0, c2box);
-        c2box->constraints = g_list_concat(c2box->constraints, temp);
-
-      }else if(gts_segments_are_intersecting(GTS_SEGMENT(c1), GTS_SEGMENT(c2)) == GTS_ON ||
-          gts_segments_are_intersecting(GTS_SEGMENT(c2), GTS_SEGMENT(c1)) == GTS_ON) {
-
-        if(vertex_between(edge_v1(c2), edge_v2(c2), edge_v1(c1)) && vertex_between(edge_v1(c2), edge_v2(c2), edge_v2(c1))) {
-          unconstrain(l, c1); unconstrain(l, c2); 
-          rem = 1;
-          // remove c1
-          temp = insert_constraint_edge(r, l, vx(c2v1), vy(c2v1), 0, vx(c2v2), vy(c2v2), 0, c2box);
-          c2box->constraints = g_list_concat(c2box->constraints, temp);
-
-        }else if(vertex_between(edge_v1(c1), edge_v2(c1), edge_v1(c2)) && vertex_between(edge_v1(c1), edge_v2(c1), edge_v2(c2))) {
-          unconstrain(l, c1); unconstrain(l, c2); 
-          rem = 1;
-          // remove c2
-          temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(c1v2), vy(c1v2), 0, c1box);
-          c1box->constraints = g_list_concat(c1box->constraints, temp);
-
-        //}else if(!vertex_wind(edge_v1(c1), edge_v2(c1), edge_v1(c2)) && !vertex_wind(edge_v1(c1), edge_v2(c1), edge_v2(c2))) {
-   /*     }else if(vertex_between(edge_v1(c1), edge_v2(c1), edge_v1(c2)) || vertex_between(edge_v1(c1), edge_v2(c1), edge_v2(c2))) {
-          unconstrain(l, c1); unconstrain(l, c2); 
-          rem = 1;
-          printf("all colinear\n");
-          //   exit(1);
-          temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(c1v2), vy(c1v2), 0, c1box);
-          c1box->constraints = g_list_concat(c1box->constraints, temp);
-
-          if(vertex_between(GTS_VERTEX(c1v1), GTS_VERTEX(c1v2), GTS_VERTEX(c2v2))) {
-            // v2 of c2 is inner
-            if(vertex_between(GTS_VERTEX(c2v1), GTS_VERTEX(c2v2), GTS_VERTEX(c1v2))) {
-              // v2 of c1 is inner
-              // c2 = c1.v2 -> c2.v1
-              temp = insert_constraint_edge(r, l, vx(c1v2), vy(c1v2), 0, vx(c2v1), vy(c2v1), 0, c2box);
-              c2box->constraints = g_list_concat(c2box->constraints, temp);
-            }else{
-              // v1 of c1 is inner
-              // c2 = c1.v1 -> c2.v1
-              temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(c2v1), vy(c2v1), 0, c2box);
-              c2box->constraints = g_list_concat(c2box->constraints, temp);
-            }
-          }else{
-            // v1 of c2 is inner
-            if(vertex_between(GTS_VERTEX(c2v1), GTS_VERTEX(c2v2), GTS_VERTEX(c1v2))) {
-              // v2 of c1 is inner
-              // c2 = c1.v2 -> c2.v2
-              temp = insert_constraint_edge(r, l, vx(c1v2), vy(c1v2), 0, vx(c2v2), vy(c2v2), 0, c2box);
-              c2box->constraints = g_list_concat(c2box->constraints, temp);
-            }else{
-              // v1 of c1 is inner
-              // c2 = c1.v1 -> c2.v2
-              temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(c2v2), vy(c2v2), 0, c2box);
-              c2box->constraints = g_list_concat(c2box->constraints, temp);
-            }
-          }*/
-        }else if(vertex_between(edge_v1(c2), edge_v2(c2), edge_v1(c1)) && c1v1 != c2v1 && c1v1 != c2v2) {
-          unconstrain(l, c1); unconstrain(l, c2); 
-          rem = 1;
-          //v1 of c1 is on c2
-          printf("v1 of c1 on c2\n"); 
-
-          // replace with 2x constraints
-          temp = insert_constraint_edge(r, l, vx(c2v1), vy(c2v1), 0, vx(c1v1), vy(c1v1), 0, c2box);
-          c2box->constraints = g_list_concat(c2box->constraints, temp);
-          temp = insert_constraint_edge(r, l, vx(c2v2), vy(c2v2), 0, vx(c1v1), vy(c1v1), 0, c2box);
-          c2box->constraints = g_list_concat(c2box->constraints, temp);
-
-          temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(c1v2), vy(c1v2), 0, c1box);
-          c1box->constraints = g_list_concat(c1box->constraints, temp);
-
-          // restore c1
-          //temp = insert_constraint_edge(r, l, vx(tedge_v2(c1)), vy(tedge_v2(c1)), 0, vx(tedge_v1(c1)), vy(tedge_v1(c1)), 0, c1->box);
-          //c2->box->constraints = g_list_concat(c2->box->constraints, temp);
-
-        }else if(vertex_between(edge_v1(c2), edge_v2(c2), edge_v2(c1)) && c1v2 != c2v1 && c1v2 != c2v2) {
-          unconstrain(l, c1); unconstrain(l, c2); 
-          rem = 1;
-          //v2 of c1 is on c2
-          printf("v2 of c1 on c2\n"); 
-
-          // replace with 2x constraints
-          temp = insert_constraint_edge(r, l, vx(c2v1), vy(c2v1), 0, vx(c1v2), vy(c1v2), 0, c2box);
-          c2box->constraints = g_list_concat(c2box->constraints, temp);
-          temp = insert_constraint_edge(r, l, vx(c2v2), vy(c2v2), 0, vx(c1v2), vy(c1v2), 0, c2box);
-          c2box->constraints = g_list_concat(c2box->constraints, temp);
-
-          temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(c1v2), vy(c1v2), 0, c1box);
-          c1box->constraints = g_list_concat(c1box->constraints, temp);
-
-        }else if(vertex_between(edge_v1(c1), edge_v2(c1), edge_v1(c2)) && c2v1 != c1v1 && c2v1 != c1v2) {
-          unconstrain(l, c1); unconstrain(l, c2); 
-          rem = 1;
-          //v1 of c2 is on c1
-          printf("v1 of c2 on c1\n"); 
-
-          // replace with 2x constraints
-          temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(c2v1), vy(c2v1), 0, c1box);
-          c1box->constraints = g_list_concat(c1box->constraints, temp);
-          temp = insert_constraint_edge(r, l, vx(c1v2), vy(c1v2), 0, vx(c2v1), vy(c2v1), 0, c1box);
-          c1box->constraints = g_list_concat(c1box->constraints, temp);
-
-          temp = insert_constraint_edge(r, l, vx(c2v1), vy(c2v1), 0, vx(c2v2), vy(c2v2), 0, c2box);
-          c2box->constraints = g_list_concat(c2box->constraints, temp);
-        }else if(vertex_between(edge_v1(c1), edge_v2(c1), edge_v2(c2)) && c2v2 != c1v1 && c2v2 != c1v2) {
-          unconstrain(l, c1); unconstrain(l, c2);
-          rem = 1;
-          //v2 of c2 is on c1
-          printf("v2 of c2 on c1\n"); 
-
-          // replace with 2x constraints
-          temp = insert_constraint_edge(r, l, vx(c1v1), vy(c1v1), 0, vx(c2v2), vy(c2v2), 0, c1box);
-          c1box->constraints = g_list_concat(c1box->constraints, temp);
-          temp = insert_constraint_edge(r, l, vx(c1v2), vy(c1v2), 0, vx(c2v2), vy(c2v2), 0, c1box);
-          c1box->constraints = g_list_concat(c1box->constraints, temp);
-
-          temp = insert_constraint_edge(r, l, vx(c2v1), vy(c2v1), 0, vx(c2v2), vy(c2v2), 0, c2box);
-          c2box->constraints = g_list_concat(c2box->constraints, temp);
-        }
+  /* Look for intersecting or overlapping constraints. Only pairs whose
+   * bounding boxes overlap can conflict, so candidates come from a bbox
+   * tree; they are tried in list order so the first pair fixed is the
+   * same one a full pairwise scan would find. Fixing a pair changes the
+   * constraint list, so the search then starts over. */
+check_cons_continuation:
+  {
+    GPtrArray *boxes = g_ptr_array_new();
+    GHashTable *index = g_hash_table_new(g_direct_hash, g_direct_equal);
+    GSList *boxlist = NULL;
+    GNode *tree = NULL;
+    guint k, fixed = 0;
+
+    for(i = l->constraints; i; i = i->next) {
+      GtsBBox *b = gts_bbox_segment(gts_bbox_class(), GTS_SEGMENT(i->data));
+      g_hash_table_insert(index, i->data, GUINT_TO_POINTER(boxes->len));
+      g_ptr_array_add(boxes, b);
+      boxlist = g_slist_prepend(boxlist, b);
+    }
+    if(boxlist) tree = gts_bb_tree_new(boxlist);
+    g_slist_free(boxlist);
+
+    for(k = 0; k < boxes->len && !fixed; k++) {
+      GtsBBox *b = GTS_BBOX(g_ptr_array_index(boxes, k));
+      GSList *overlap = gts_bb_tree_overlap(tree, b), *j;
+      guint *cand = (guint *)malloc((g_slist_length(overlap) + 1) * sizeof(guint)), ncand = 0, m;
+
+      for(j = overlap; j; j = j->next) {
+        guint idx = GPOINTER_TO_UINT(g_hash_table_lookup(index, GTS_BBOX(j->data)->bounded));
+        if(idx > k) cand[ncand++] = idx;
       }
-      if(rem) goto check_cons_continuation; 
+      g_slist_free(overlap);
+      qsort(cand, ncand, sizeof(guint), guint_cmp);
 
-      j = j->next;
+      for(m = 0; m < ncand && !fixed; m++)
+        fixed = fix_constraint_pair(r, l,
+            TOPOROUTER_CONSTRAINT(GTS_BBOX(g_ptr_array_index(boxes, k))->bounded),
+            TOPOROUTER_CONSTRAINT(GTS_BBOX(g_ptr_array_index(boxes, cand[m]))->bounded));
+      free(cand);
     }
 
-    i = i->next; 
-  }  
+    if(tree) gts_bb_tree_destroy(tree, TRUE);
+    g_ptr_array_free(boxes, TRUE);
+    g_hash_table_destroy(index);
+    if(fixed) goto check_cons_continuation;
+  }
 
-  i = l->vertices;
-  while (i) {
-    //v = i->data;
-    //if(r->flags & TOPOROUTER_FLAG_DEBUG_CDTS) 
-  //  fprintf(stderr, "\tadding vertex %f,%f\n", v->p.x, v->p.y);
-    toporouter_vertex_t *v = TOPOROUTER_VERTEX(gts_delaunay_add_vertex (l->surface, (GtsVertex *)i->data, NULL));
-    if(v) {
-      printf("conflict: "); print_vertex(v);
-    }
+  /* Insert vertices in Hilbert order, starting each point location from
+   * a face next to the previously inserted vertex */
+  {
+    guint n, k;
+    hilbert_vertex_t *hv = hilbert_order(l->vertices, &n);
+    GtsFace *hint = NULL;
 
-    i = i->next;
+    for(k = 0; k < n; k++) {
+      toporouter_vertex_t *v = TOPOROUTER_VERTEX(gts_delaunay_add_vertex (l->surface, hv[k].v, hint));
+      if(v) {
+        printf("conflict: "); print_vertex(v);
+      }else
+        hint = vertex_hint_face(hv[k].v, l->surface);
+    }
+    free(hv);
   }
   i = l->constraints;
   while (i) {
@@ -2634,7 +2766,7 @@ import_geometry(toporouter_t *r)
     printf("Group %d: Number %d:\n", group, PCB->LayerGroups.Number[group]);
 
     for (int entry = 0; entry < PCB->LayerGroups.Number[group]; entry++) {
-        printf("\tEntry %d\n", PCB->LayerGroups.Entries[group][entry]);
+        printf("\tEntry %d\n", GROUP_ENTRY (&PCB->LayerGroups, group, entry));
     }
   }
 #endif
@@ -2651,13 +2783,13 @@ import_geometry(toporouter_t *r)
       cur_layer->constraints = NULL;
 
 #ifdef DEBUG_IMPORT    
-      printf("reading board constraints from layer %d into group %d\n", PCB->LayerGroups.Entries[group][0], group);
+      printf("reading board constraints from layer %d into group %d\n", GROUP_ENTRY (&PCB->LayerGroups, group, 0), group);
 #endif
-      read_board_constraints(r, cur_layer, PCB->LayerGroups.Entries[group][0]);
+      read_board_constraints(r, cur_layer, GROUP_ENTRY (&PCB->LayerGroups, group, 0));
 #ifdef DEBUG_IMPORT    
-      printf("reading points from layer %d into group %d \n",PCB->LayerGroups.Entries[group][0], group);
+      printf("reading points from layer %d into group %d \n",GROUP_ENTRY (&PCB->LayerGroups, group, 0), group);
 #endif
-      read_points(r, cur_layer, PCB->LayerGroups.Entries[group][0]);
+      read_points(r, cur_layer, GROUP_ENTRY (&PCB->LayerGroups, group, 0));
 
 //#ifdef DEBUG_IMPORT    
 //      printf("reading pads from layer %d into group %d\n", number, group);
@@ -2808,20 +2940,22 @@ route_heap_cmp(gpointer item, gpointer data)
   return FCOST(TOPOROUTER_VERTEX(item));  
 }
 
-#define closelist_insert(p) closelist = g_list_prepend(closelist, p)
+#define closelist_insert(p) g_hash_table_insert(closelist, p, p)
+#define openlist_insert(p) g_hash_table_insert(openset, p, gts_eheap_insert(openlist, p))
 
-typedef struct {
-  toporouter_vertex_t *key;
-  toporouter_vertex_t *result;
-}toporouter_heap_search_data_t;
+/* Membership tests against a route's source and destination vertices */
+#define is_src_vertex(data, v) ((data)->srcset ? g_hash_table_lookup((data)->srcset, v) != NULL : g_list_find((data)->srcvertices, v) != NULL)
+#define is_dest_vertex(data, v) ((data)->destset ? g_hash_table_lookup((data)->destset, v) != NULL : g_list_find((data)->destvertices, v) != NULL)
 
-void 
-toporouter_heap_search(gpointer data, gpointer user_data)
+static GHashTable *
+vertex_set_new(GList *vertices)
 {
-  toporouter_vertex_t *v = TOPOROUTER_VERTEX(data);
-  toporouter_heap_search_data_t *heap_search_data = (toporouter_heap_search_data_t *)user_data;
-  if(v == heap_search_data->key) heap_search_data->result = v;
+  GHashTable *set = g_hash_table_new(g_direct_hash, g_direct_equal);
+  for(; vertices; vertices = vertices->next)
+    g_hash_table_insert(set, vertices->data, vertices->data);
+  return set;
 }
+
 /*
 void 
 toporouter_heap_color(gpointer data, gpointer user_data)
@@ -3768,13 +3902,13 @@ triangle_all_candidate_points_from_edge(toporouter_t *r, GtsTriangle *t, toporou
     
   if(vertex_bbox(op_v)) boxpoint = TOPOROUTER_VERTEX(vertex_bbox(op_v)->point);
     
-  if(g_list_find(routedata->destvertices, op_v)) {
+  if(is_dest_vertex(routedata, op_v)) {
     rval = g_list_prepend(rval, op_v);
     *dest = op_v;
     return rval;
-  }else if(g_list_find(routedata->destvertices, boxpoint)) {
+  }else if(is_dest_vertex(routedata, boxpoint)) {
     *dest = boxpoint;
-  }else if(g_list_find(routedata->srcvertices, op_v)) {
+  }else if(is_src_vertex(routedata, op_v)) {
     rval = g_list_prepend(rval, op_v);
   }
 
@@ -3945,12 +4079,12 @@ triangle_candidate_points_from_edge(toporouter_t *r, GtsTriangle *t, toporouter_
     
     if(vertex_bbox(op_v)) boxpoint = TOPOROUTER_VERTEX(vertex_bbox(op_v)->point);
     
-    if(g_list_find(routedata->destvertices, op_v)) {
+    if(is_dest_vertex(routedata, op_v)) {
       rval = g_list_prepend(rval, op_v);
       *dest = op_v;
-    }else if(g_list_find(routedata->destvertices, boxpoint)) {
+    }else if(is_dest_vertex(routedata, boxpoint)) {
       *dest = boxpoint;
-    }else if(g_list_find(routedata->srcvertices, op_v)) {
+    }else if(is_src_vertex(routedata, op_v)) {
       rval = g_list_prepend(rval, op_v);
     }
   }
@@ -4518,7 +4652,7 @@ gcost(toporouter_t *r, toporouter_route_t *data, toporouter_vertex_t *srcv, topo
   
   *n = pv->gn;
 
-  if(g_list_find(data->srcvertices, v)) return 0.; 
+  if(is_src_vertex(data, v)) return 0.; 
   
   segcost = tvdistance(pv, v);
 
@@ -4567,7 +4701,8 @@ GList *
 route(toporouter_t *r, toporouter_route_t *data, guint debug)
 {
   GtsEHeap *openlist = gts_eheap_new(route_heap_cmp, NULL);
-  GList *closelist = NULL;
+  GHashTable *openset = g_hash_table_new(g_direct_hash, g_direct_equal);
+  GHashTable *closelist = g_hash_table_new(g_direct_hash, g_direct_equal);
   GList *i, *rval = NULL;
   toporouter_netlist_t *pair = NULL;
   gint count = 0;
@@ -4582,6 +4717,8 @@ route(toporouter_t *r, toporouter_route_t *data, guint debug)
   
   data->destvertices = cluster_vertices(r, data->dest);
   data->srcvertices = cluster_vertices(r, data->src);
+  data->destset = vertex_set_new(data->destvertices);
+  data->srcset = vertex_set_new(data->srcvertices);
 
   closest_cluster_pair(r, data->srcvertices, data->destvertices, &curpoint, &destv);
 
@@ -4613,7 +4750,7 @@ route(toporouter_t *r, toporouter_route_t *data, guint debug)
     }
   }
 
-  gts_eheap_insert(openlist, curpoint);
+  openlist_insert(curpoint);
   
   while(gts_eheap_size(openlist) > 0) {
     GList *candidatepoints;
@@ -4621,6 +4758,7 @@ route(toporouter_t *r, toporouter_route_t *data, guint debug)
     //draw_route_status(r, closelist, openlist, curpoint, data, count++);
 
     curpoint = TOPOROUTER_VERTEX( gts_eheap_remove_top(openlist, NULL) );
+    g_hash_table_remove(openset, curpoint);
     if(curpoint->parent && !(curpoint->flags & VERTEX_FLAG_TEMP)) {
       if(vz(curpoint) != vz(destv)) {
         toporouter_vertex_t *tempv;
@@ -4637,7 +4775,7 @@ route(toporouter_t *r, toporouter_route_t *data, guint debug)
 //    destpoint = closest_dest_vertex(r, curpoint, data);
 //    dest_layer = &r->layers[(int)vz(destpoint)];
     
-    if(g_list_find(data->destvertices, curpoint)) {
+    if(is_dest_vertex(data, curpoint)) {
       toporouter_vertex_t *temppoint = curpoint;
       srcv = NULL;
       destv = curpoint;
@@ -4646,7 +4784,7 @@ route(toporouter_t *r, toporouter_route_t *data, guint debug)
 
       while(temppoint) {
         data->path = g_list_prepend(data->path, temppoint);   
-        if(g_list_find(data->srcvertices, temppoint)) {
+        if(is_src_vertex(data, temppoint)) {
           srcv = temppoint;
           if(r->flags & TOPOROUTER_FLAG_AFTERORDER) break;
         }
@@ -4716,16 +4854,14 @@ route(toporouter_t *r, toporouter_route_t *data, guint debug)
     i = candidatepoints;
     while(i) {
       toporouter_vertex_t *temppoint = TOPOROUTER_VERTEX(i->data);
-      if(!g_list_find(closelist, temppoint) && candidate_is_available(curpoint, temppoint)) { //&& temppoint != curpoint) {
-        toporouter_heap_search_data_t heap_search_data = { temppoint, NULL };
+      if(!g_hash_table_lookup(closelist, temppoint) && candidate_is_available(curpoint, temppoint)) { //&& temppoint != curpoint) {
+        GtsEHeapPair *openpair = (GtsEHeapPair *)g_hash_table_lookup(openset, temppoint);
 
         guint temp_gn;
         gdouble temp_g_cost = gcost(r, data, srcv, temppoint, curpoint, &temp_gn, pair);
       
 
-        gts_eheap_foreach(openlist,toporouter_heap_search, &heap_search_data);
-
-        if(heap_search_data.result) {
+        if(openpair) {
           if(temp_g_cost < temppoint->gcost) {
             
             temppoint->gcost = temp_g_cost;
@@ -4734,7 +4870,7 @@ route(toporouter_t *r, toporouter_route_t *data, guint debug)
             temppoint->parent = curpoint;
             curpoint->child = temppoint;
             
-            gts_eheap_update(openlist);
+            gts_eheap_decrease_key(openlist, openpair, FCOST(temppoint));
           }
         }else{
           temppoint->parent = curpoint;
@@ -4745,7 +4881,7 @@ route(toporouter_t *r, toporouter_route_t *data, guint debug)
 
           temppoint->hcost = simple_h_cost(r, temppoint, destv);
 //          if(cur_layer != dest_layer) temppoint->hcost += r->viacost;
-          gts_eheap_insert(openlist, temppoint);
+          openlist_insert(temppoint);
         }
       
       }
@@ -4850,7 +4986,7 @@ route_finish:
     while(i) {
       toporouter_vertex_t *tv = TOPOROUTER_VERTEX(i->data);
       
-      if(pv && g_list_find(data->srcvertices, tv)) {
+      if(pv && is_src_vertex(data, tv)) {
         GList *temp = g_list_copy(i);
         g_list_free(data->path);
         data->path = temp;
@@ -4921,8 +5057,12 @@ routing_return:
   g_list_free(data->srcvertices);
   data->destvertices = NULL;
   data->srcvertices = NULL;
+  if(data->destset) g_hash_table_destroy(data->destset);
+  if(data->srcset) g_hash_table_destroy(data->srcset);
+  data->destset = data->srcset = NULL;
   gts_eheap_destroy(openlist);     
-  g_list_free(closelist);
+  g_hash_table_destroy(openset);
+  g_hash_table_destroy(closelist);
 
   data->alltemppoints = NULL;
 
@@ -5526,7 +5666,7 @@ calculate_arc_to_arc(toporouter_t *ar, toporouter_arc_t *parc, toporouter_arc_t
 void
 export_oproutes(toporouter_t *ar, toporouter_oproute_t *oproute)
 {
-  guint layer = PCB->LayerGroups.Entries[oproute->layergroup][0];   
+  guint layer = GROUP_ENTRY (&PCB->LayerGroups, oproute->layergroup, 0);   
   guint thickness = lookup_thickness(oproute->style);
   guint keepaway = lookup_keepaway(oproute->style);
   GList *arcs = oproute->arcs;
@@ -6513,6 +6653,33 @@ toporouter_export(toporouter_t *r)
 
 }
 
+/* Moves a route to the head of r->routednets or r->failednets. A route
+ * is in at most one of the lists and keeps its link, so this is O(1) */
+void
+route_set_routed(toporouter_t *r, toporouter_route_t *routedata, gboolean routed)
+{
+  if(routedata->netlink) {
+    if(routedata->routed) {
+      r->routednets = g_list_delete_link(r->routednets, routedata->netlink);
+      r->routednets_n--;
+    }else{
+      r->failednets = g_list_delete_link(r->failednets, routedata->netlink);
+      r->failednets_n--;
+    }
+  }
+
+  if(routed) {
+    r->routednets = g_list_prepend(r->routednets, routedata);
+    r->routednets_n++;
+    routedata->netlink = r->routednets;
+  }else{
+    r->failednets = g_list_prepend(r->failednets, routedata);
+    r->failednets_n++;
+    routedata->netlink = r->failednets;
+  }
+  routedata->routed = routed;
+}
+
 toporouter_route_t *
 routedata_create(void)
 {
@@ -6530,6 +6697,9 @@ routedata_create(void)
   routedata->ppathindices = NULL;
 
   routedata->destvertices = routedata->srcvertices = NULL;
+  routedata->destset = routedata->srcset = NULL;
+  routedata->netlink = NULL;
+  routedata->routed = FALSE;
   return routedata;
 }
 /*
@@ -6574,7 +6744,7 @@ import_route(toporouter_t *r, RatType *line)
   g_ptr_array_add(r->routes, routedata);
   g_ptr_array_add(routedata->netlist->routes, routedata);
 
-  r->failednets = g_list_prepend(r->failednets, routedata);
+  route_set_routed(r, routedata, FALSE);
 
   return routedata;
 }
@@ -7180,12 +7350,10 @@ print_netlist(toporouter_netlist_t *netlist)
 }
 
 #define REMOVE_ROUTING(x) x->netlist->routed = g_list_remove(x->netlist->routed, x); \
-  r->routednets = g_list_remove(r->routednets, x); \
-  r->failednets = g_list_prepend(r->failednets, x)
+  route_set_routed(r, x, FALSE)
 
 #define INSERT_ROUTING(x) x->netlist->routed = g_list_prepend(x->netlist->routed, x); \
-  r->routednets = g_list_prepend(r->routednets, x); \
-  r->failednets = g_list_remove(r->failednets, x)
+  route_set_routed(r, x, TRUE)
 
 gint
 roar_route(toporouter_t *r, toporouter_route_t *routedata, gint threshold)
@@ -7305,7 +7473,7 @@ roar_router(toporouter_t *r, gint failcount, gint threshold)
     }
     g_list_free(failed);
     
-    printf("\tROAR pass %d - %d routed -  %d failed\n", j, g_list_length(r->routednets), g_list_length(r->failednets));
+    printf("\tROAR pass %d - %d routed -  %d failed\n", j, r->routednets_n, r->failednets_n);
 
     if(!failcount || failcount >= pfailcount) {
       Message(_("%d nets remaining\n"), failcount);
@@ -7419,7 +7587,7 @@ void
 detour_router(toporouter_t *r) 
 {
   GList *i = r->routednets;
-  guint n = g_list_length(r->routednets);
+  guint n = r->routednets_n;
   GPtrArray* scores =  g_ptr_array_sized_new(n);
 
   while(i) {
@@ -7482,7 +7650,7 @@ rubix_router(toporouter_t *r, gint failcount)
 guint
 hybrid_router(toporouter_t *r)
 {
-  gint failcount = g_list_length(r->failednets);
+  gint failcount = r->failednets_n;
   r->flags |= TOPOROUTER_FLAG_AFTERORDER;
   r->flags |= TOPOROUTER_FLAG_AFTERRUBIX;
   failcount = rubix_router(r, failcount);
@@ -7527,7 +7695,7 @@ parse_arguments(toporouter_t *r, int argc, char **argv)
   
   for (guint group = 0; group < max_group; group++)
     for (i = 0; i < PCB->LayerGroups.Number[group]; i++) 
-      if ((PCB->LayerGroups.Entries[group][i] < max_copper_layer) && !(PCB->Data->Layer[PCB->LayerGroups.Entries[group][i]].On)) {
+      if ((GROUP_ENTRY (&PCB->LayerGroups, group, i) < max_copper_layer) && !(PCB->Data->Layer[GROUP_ENTRY (&PCB->LayerGroups, group, i)].On)) {
         gdouble *layer = (gdouble *)malloc(sizeof(gdouble));
         *layer = (double)group;
         r->keepoutlayers = g_list_prepend(r->keepoutlayers, layer);
@@ -7566,6 +7734,7 @@ toporouter_new(void)
 
   r->routednets = NULL;
   r->failednets = NULL;
+  r->routednets_n = r->failednets_n = 0;
 
   ltime=time(NULL); 
 
@@ -289,6 +289,10 @@ struct _toporouter_route_t {
   guint flags;
 
   GList *destvertices, *srcvertices;
+  GHashTable *destset, *srcset; /* the same vertices, for membership tests */
+
+  GList *netlink;   /* this route's link in routednets or failednets */
+  gboolean routed;  /* which of the two lists netlink belongs to */
 
   GList *topopath;
 
@@ -427,6 +431,7 @@ struct _toporouter_t {
   GPtrArray *netlists;
 
   GList *routednets, *failednets;
+  guint routednets_n, failednets_n;
 
   gint (*netsort)(toporouter_netscore_t **, toporouter_netscore_t **);
 
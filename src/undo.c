@@ -38,6 +38,16 @@
  * serial number even if the remove function is called several times.
  *
  * a lock flag ensures that no infinite loops occur
+ *
+ * If Settings.UndoMemory is set, it bounds the memory used by both
+ * lists.  Once an operation is completed and the budget is exceeded,
+ * the oldest operations are dropped together with the removed objects
+ * they kept alive.  By default there is no bound.
+ *
+ * Flag and size changes are recorded as UNDO_BULK entries, each holding
+ * a compact array of (ID, old value) pairs for every object an operation
+ * touched.  Undoing such an entry resolves all of its IDs in a single
+ * pass over the board instead of one search per object.
  */
 
 #ifdef HAVE_CONFIG_H
@@ -75,6 +85,18 @@
 static bool between_increment_and_restore = false;
 static bool added_undo_between_increment_and_restore = false;
 
+/* Bumped by anything that may have changed the layout; see
+ * UndoGeneration().  */
+static unsigned long Generation = 0;
+
+/* Objects touched since the last UndoForgetChanges(); see
+ * UndoChanges().  NULL until somebody asks for it.  */
+static GArray *Changes = NULL;
+static bool ChangesOverflow = false;
+
+/* past this many entries the journal gives up and reports "everything" */
+#define CHANGE_JOURNAL_MAX	4096
+
 /* ---------------------------------------------------------------------------
  * some local data types
  */
@@ -125,6 +147,30 @@ typedef struct			/* information about netlist lib changes */
   LibraryType *lib;
 } NetlistChangeType;
 
+typedef struct			/* one object of a bulk operation */
+{
+  int ID, Kind;
+  union
+  {
+    FlagType Flags;
+    Coord Size;
+  }
+  Data;
+} BulkItemType;
+
+typedef struct			/* information about a bulk operation */
+{
+  int Op;			/* UNDO_FLAG, UNDO_CHANGESIZE, ... */
+  Cardinal N, Max;
+  BulkItemType *Items;
+} BulkType;
+
+typedef struct			/* where a bulk item's object was found */
+{
+  int Kind, Type;
+  void *Ptr1, *Ptr2, *Ptr3;
+} BulkObjectType;
+
 typedef struct			/* holds information about an operation */
 {
   int Serial,			/* serial number of operation */
@@ -144,10 +190,14 @@ typedef struct			/* holds information about an operation */
     ClearPolyType ClearPoly;
     NetlistChangeType NetlistChange;
     long int CopyID;
+    BulkType Bulk;
   }
   Data;
 } UndoListType;
 
+/* bulk entries with fewer objects than this just search for each one */
+#define BULK_LOOKUP_MIN	8
+
 /* ---------------------------------------------------------------------------
  * some local variables
  */
@@ -157,6 +207,10 @@ static int Serial = 1,		/* serial number */
   SavedSerial;
 static size_t UndoN, RedoN,	/* number of entries */
   UndoMax;
+static size_t RemoveBytes = 0;	/* estimated size of RemoveList objects */
+static size_t BulkBytes = 0;	/* size of all bulk item arrays */
+static GHashTable *BulkLookup = NULL;	/* ID -> BulkObjectType during UndoBulk */
+static bool Redoing = false;	/* direction of the current Undo/Redo */
 static bool Locked = false;	/* do not add entries if */
 static bool andDraw = true;
 										/* flag is set; prevents from */
@@ -185,7 +239,224 @@ static bool UndoChangeAngles (UndoListType *);
 static bool UndoChangeClearSize (UndoListType *);
 static bool UndoChangeMaskSize (UndoListType *);
 static bool UndoClearPoly (UndoListType *);
+static bool UndoBulk (UndoListType *);
+static int LookupUndoObject (UndoListType *, void **, void **, void **);
+static BulkItemType *GetBulkUndoItem (int, int, int);
 static int PerformUndo (UndoListType *);
+static size_t RemovedObjectSize (int, void *);
+static void AddRemoveBytes (int, void *);
+static void SubRemoveBytes (int, void *);
+static void ReleaseUndoEntry (UndoListType *, bool);
+static void TrimUndoList (void);
+static void NoteChange (int, int);
+static void NoteEntryChanges (UndoListType *);
+
+/* ---------------------------------------------------------------------------
+ * estimates the memory held by an object while it lives in RemoveList
+ */
+static size_t
+RemovedObjectSize (int Type, void *Ptr2)
+{
+  switch (Type)
+    {
+    case VIA_TYPE:
+    case PIN_TYPE:
+      return sizeof (PinType);
+    case PAD_TYPE:
+      return sizeof (PadType);
+    case LINE_TYPE:
+      return sizeof (LineType);
+    case ARC_TYPE:
+      return sizeof (ArcType);
+    case TEXT_TYPE:
+      return sizeof (TextType);
+    case RATLINE_TYPE:
+      return sizeof (RatType);
+    case POLYGON_TYPE:
+      {
+	PolygonType *polygon = (PolygonType *) Ptr2;
+
+	return sizeof (PolygonType) + polygon->PointN * sizeof (PointType)
+	  + polygon->HoleIndexN * sizeof (Cardinal);
+      }
+    case ELEMENT_TYPE:
+      {
+	ElementType *element = (ElementType *) Ptr2;
+
+	return sizeof (ElementType)
+	  + element->PinN * sizeof (PinType)
+	  + element->PadN * sizeof (PadType)
+	  + element->LineN * sizeof (LineType)
+	  + element->ArcN * sizeof (ArcType);
+      }
+    default:
+      return 0;
+    }
+}
+
+static void
+AddRemoveBytes (int Type, void *Ptr2)
+{
+  RemoveBytes += RemovedObjectSize (Type, Ptr2);
+}
+
+static void
+SubRemoveBytes (int Type, void *Ptr2)
+{
+  size_t size = RemovedObjectSize (Type, Ptr2);
+
+  RemoveBytes = RemoveBytes > size ? RemoveBytes - size : 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * frees whatever an undo entry owns.  'pending' is true for entries
+ * that have not been undone, i.e. which are still on the undo side of
+ * the list.
+ */
+static void
+ReleaseUndoEntry (UndoListType *Entry, bool pending)
+{
+  void *ptr1, *ptr2, *ptr3;
+  int type;
+
+  switch (Entry->Type)
+    {
+    case UNDO_CHANGENAME:
+      free (Entry->Data.ChangeName.Name);
+      break;
+    case UNDO_REMOVE:
+      type =
+	SearchObjectByID (RemoveList, &ptr1, &ptr2, &ptr3, Entry->ID,
+			  Entry->Kind);
+      if (type != NO_TYPE)
+	{
+	  SubRemoveBytes (type, ptr2);
+	  DestroyObject (RemoveList, type, ptr1, ptr2, ptr3);
+	}
+      break;
+    case UNDO_REMOVE_CONTOUR:
+    case UNDO_INSERT_CONTOUR:
+      type =
+	SearchObjectByID (RemoveList, &ptr1, &ptr2, &ptr3, Entry->Data.CopyID,
+			  Entry->Kind);
+      if (type != NO_TYPE)
+	{
+	  SubRemoveBytes (type, ptr2);
+	  DestroyObject (RemoveList, type, ptr1, ptr2, ptr3);
+	}
+      break;
+    case UNDO_BULK:
+      BulkBytes -= Entry->Data.Bulk.Max * sizeof (BulkItemType);
+      free (Entry->Data.Bulk.Items);
+      break;
+    case UNDO_NETLISTCHANGE:
+      /* once undone, the saved netlist is owned by the library again */
+      if (pending)
+	{
+	  FreeLibraryMemory (Entry->Data.NetlistChange.old);
+	  free (Entry->Data.NetlistChange.old);
+	}
+      break;
+    default:
+      break;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * drops the oldest operations until the undo list fits into its memory
+ * budget.  The most recent operation is always kept.
+ */
+static void
+TrimUndoList (void)
+{
+  size_t budget, n, i, dropped = 0;
+  static bool warned = false;
+
+  if (Settings.UndoMemory <= 0)
+    return;
+  budget = (size_t) Settings.UndoMemory << 10;
+
+  while ((UndoN + RedoN) * sizeof (UndoListType) + RemoveBytes + BulkBytes
+	 > budget)
+    {
+      for (n = 0; n < UndoN && UndoList[n].Serial == UndoList[0].Serial; n++)
+	;
+      if (n == UndoN)
+	break;
+      for (i = 0; i < n; i++)
+	ReleaseUndoEntry (&UndoList[i], true);
+      memmove (UndoList, UndoList + n,
+	       (UndoN + RedoN - n) * sizeof (UndoListType));
+      UndoN -= n;
+      dropped++;
+    }
+  if (!dropped)
+    return;
+
+  /* give back the slots we no longer need */
+  if (UndoMax - (UndoN + RedoN) > 2 * STEP_UNDOLIST)
+    {
+      UndoMax = (UndoN + RedoN + STEP_UNDOLIST) / STEP_UNDOLIST * STEP_UNDOLIST;
+      UndoList =
+	(UndoListType *) realloc (UndoList, UndoMax * sizeof (UndoListType));
+    }
+
+  if (!warned)
+    {
+      Message (_("Undo history exceeds %d kB, dropping the oldest operations\n"),
+	       Settings.UndoMemory);
+      warned = true;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * records that the object with the given ID may have changed
+ */
+static void
+NoteChange (int ID, int Kind)
+{
+  UndoChangeType change;
+
+  if (Changes == NULL || ChangesOverflow)
+    return;
+  if (Changes->len >= CHANGE_JOURNAL_MAX)
+    {
+      ChangesOverflow = true;
+      return;
+    }
+  change.ID = ID;
+  change.Kind = Kind;
+  g_array_append_val (Changes, change);
+}
+
+/* ---------------------------------------------------------------------------
+ * records the objects an undo entry refers to
+ */
+static void
+NoteEntryChanges (UndoListType *Entry)
+{
+  Cardinal i;
+
+  if (Changes == NULL)
+    return;
+  switch (Entry->Type)
+    {
+    case UNDO_LAYERCHANGE:
+      /* layer numbers move under every object on the board */
+      ChangesOverflow = true;
+      break;
+    case UNDO_NETLISTCHANGE:
+      break;
+    case UNDO_BULK:
+      for (i = 0; i < Entry->Data.Bulk.N; i++)
+	NoteChange (Entry->Data.Bulk.Items[i].ID,
+		    Entry->Data.Bulk.Items[i].Kind);
+      break;
+    default:
+      NoteChange (Entry->ID, Entry->Kind);
+      break;
+    }
+}
 
 /* ---------------------------------------------------------------------------
  * adds a command plus some data to the undo list
@@ -194,11 +465,13 @@ static UndoListType *
 GetUndoSlot (int CommandType, int ID, int Kind)
 {
   UndoListType *ptr;
-  void *ptr1, *ptr2, *ptr3;
-  int type;
   static size_t limit = UNDO_WARNING_SIZE;
 
+  Generation++;
+
 #ifdef DEBUG_ID
+  void *ptr1, *ptr2, *ptr3;
+
   if (SearchObjectByID (PCB->Data, &ptr1, &ptr2, &ptr3, ID, Kind) == NO_TYPE)
     Message ("hace: ID (%d) and Type (%x) mismatch in AddObject...\n", ID,
 	     Kind);
@@ -226,23 +499,7 @@ GetUndoSlot (int CommandType, int ID, int Kind)
   /* free structures from the pruned redo list */
 
   for (ptr = &UndoList[UndoN]; RedoN; ptr++, RedoN--)
-    switch (ptr->Type)
-      {
-      case UNDO_CHANGENAME:
-	free (ptr->Data.ChangeName.Name);
-	break;
-      case UNDO_REMOVE:
-	type =
-	  SearchObjectByID (RemoveList, &ptr1, &ptr2, &ptr3, ptr->ID,
-			    ptr->Kind);
-	if (type != NO_TYPE)
-	  {
-	    DestroyObject (RemoveList, type, ptr1, ptr2, ptr3);
-	  }
-	break;
-      default:
-	break;
-      }
+    ReleaseUndoEntry (ptr, false);
 
   if (between_increment_and_restore)
     added_undo_between_increment_and_restore = true;
@@ -253,9 +510,52 @@ GetUndoSlot (int CommandType, int ID, int Kind)
   ptr->Kind = Kind;
   ptr->ID = ID;
   ptr->Serial = Serial;
+  /* bulk entries note their items as they are added */
+  if (CommandType != UNDO_BULK)
+    NoteEntryChanges (ptr);
   return (ptr);
 }
 
+/* ---------------------------------------------------------------------------
+ * adds an object to the bulk entry of the current operation, starting a
+ * new bulk entry unless the last entry is one for the same operation
+ */
+static BulkItemType *
+GetBulkUndoItem (int CommandType, int ID, int Kind)
+{
+  UndoListType *undo = UndoN ? &UndoList[UndoN - 1] : NULL;
+  BulkType *bulk;
+  BulkItemType *item;
+
+  Generation++;
+  if (RedoN || !undo || undo->Serial != Serial || undo->Type != UNDO_BULK
+      || undo->Data.Bulk.Op != CommandType)
+    {
+      undo = GetUndoSlot (UNDO_BULK, 0, 0);
+      undo->Data.Bulk.Op = CommandType;
+      undo->Data.Bulk.N = undo->Data.Bulk.Max = 0;
+      undo->Data.Bulk.Items = NULL;
+    }
+  else if (between_increment_and_restore)
+    added_undo_between_increment_and_restore = true;
+
+  bulk = &undo->Data.Bulk;
+  if (bulk->N >= bulk->Max)
+    {
+      Cardinal max = bulk->Max ? 2 * bulk->Max : 4;
+
+      bulk->Items =
+	(BulkItemType *) realloc (bulk->Items, max * sizeof (BulkItemType));
+      BulkBytes += (max - bulk->Max) * sizeof (BulkItemType);
+      bulk->Max = max;
+    }
+  item = &bulk->Items[bulk->N++];
+  item->ID = ID;
+  item->Kind = Kind;
+  NoteChange (ID, Kind);
+  return item;
+}
+
 /* ---------------------------------------------------------------------------
  * redraws the recovered object
  */
@@ -273,6 +573,179 @@ DrawRecoveredObject (int Type, void *Ptr1, void *Ptr2, void *Ptr3)
     DrawObject (Type, Ptr1, Ptr2);
 }
 
+/* ---------------------------------------------------------------------------
+ * finds the object of an undo entry, either in the table built by
+ * UndoBulk or by searching the board
+ */
+static int
+LookupUndoObject (UndoListType *Entry, void **Ptr1, void **Ptr2, void **Ptr3)
+{
+  BulkObjectType *obj;
+
+  if (BulkLookup)
+    {
+      obj = (BulkObjectType *) g_hash_table_lookup (BulkLookup,
+						    GINT_TO_POINTER (Entry->ID));
+      if (obj && obj->Type == Entry->Kind)
+	{
+	  *Ptr1 = obj->Ptr1;
+	  *Ptr2 = obj->Ptr2;
+	  *Ptr3 = obj->Ptr3;
+	  return obj->Type;
+	}
+    }
+  return SearchObjectByID (PCB->Data, Ptr1, Ptr2, Ptr3, Entry->ID, Entry->Kind);
+}
+
+static void
+ResolveBulkObject (long int ID, int Type, void *Ptr1, void *Ptr2, void *Ptr3)
+{
+  BulkObjectType *obj;
+
+  obj = (BulkObjectType *) g_hash_table_lookup (BulkLookup,
+						GINT_TO_POINTER (ID));
+  if (obj && obj->Kind == Type)
+    {
+      obj->Type = Type;
+      obj->Ptr1 = Ptr1;
+      obj->Ptr2 = Ptr2;
+      obj->Ptr3 = Ptr3;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * fills BulkLookup with the objects of a bulk entry, walking the board
+ * only once
+ */
+static BulkObjectType *
+BuildBulkLookup (BulkType *Bulk)
+{
+  BulkObjectType *objects;
+  Cardinal i;
+
+  objects = (BulkObjectType *) calloc (Bulk->N, sizeof (BulkObjectType));
+  BulkLookup = g_hash_table_new (g_direct_hash, g_direct_equal);
+  for (i = 0; i < Bulk->N; i++)
+    {
+      objects[i].Kind = Bulk->Items[i].Kind;
+      objects[i].Type = NO_TYPE;
+      g_hash_table_insert (BulkLookup, GINT_TO_POINTER (Bulk->Items[i].ID),
+			   &objects[i]);
+    }
+
+  VIA_LOOP (PCB->Data);
+  {
+    ResolveBulkObject (via->ID, VIA_TYPE, via, via, via);
+  }
+  END_LOOP;
+  RAT_LOOP (PCB->Data);
+  {
+    ResolveBulkObject (line->ID, RATLINE_TYPE, line, line, line);
+  }
+  END_LOOP;
+  ELEMENT_LOOP (PCB->Data);
+  {
+    ResolveBulkObject (element->ID, ELEMENT_TYPE, element, element, element);
+    PIN_LOOP (element);
+    {
+      ResolveBulkObject (pin->ID, PIN_TYPE, element, pin, pin);
+    }
+    END_LOOP;
+    PAD_LOOP (element);
+    {
+      ResolveBulkObject (pad->ID, PAD_TYPE, element, pad, pad);
+    }
+    END_LOOP;
+    ELEMENTTEXT_LOOP (element);
+    {
+      ResolveBulkObject (text->ID, ELEMENTNAME_TYPE, element, text, text);
+    }
+    END_LOOP;
+    ELEMENTLINE_LOOP (element);
+    {
+      ResolveBulkObject (line->ID, ELEMENTLINE_TYPE, element, line, line);
+    }
+    END_LOOP;
+    ARC_LOOP (element);
+    {
+      ResolveBulkObject (arc->ID, ELEMENTARC_TYPE, element, arc, arc);
+    }
+    END_LOOP;
+  }
+  END_LOOP;
+  ALLLINE_LOOP (PCB->Data);
+  {
+    ResolveBulkObject (line->ID, LINE_TYPE, layer, line, line);
+  }
+  ENDALL_LOOP;
+  ALLARC_LOOP (PCB->Data);
+  {
+    ResolveBulkObject (arc->ID, ARC_TYPE, layer, arc, arc);
+  }
+  ENDALL_LOOP;
+  ALLTEXT_LOOP (PCB->Data);
+  {
+    ResolveBulkObject (text->ID, TEXT_TYPE, layer, text, text);
+  }
+  ENDALL_LOOP;
+  ALLPOLYGON_LOOP (PCB->Data);
+  {
+    ResolveBulkObject (polygon->ID, POLYGON_TYPE, layer, polygon, polygon);
+  }
+  ENDALL_LOOP;
+
+  return objects;
+}
+
+/* ---------------------------------------------------------------------------
+ * recovers all objects of a bulk operation.  Items are processed
+ * last-to-first when undoing and first-to-last when redoing, exactly
+ * as the equivalent single entries would be.
+ * returns true if everything has been recovered
+ */
+static bool
+UndoBulk (UndoListType *Entry)
+{
+  BulkType *bulk = &Entry->Data.Bulk;
+  BulkObjectType *objects = NULL;
+  UndoListType single;
+  Cardinal i, n;
+  bool ok = true;
+
+  if (bulk->N >= BULK_LOOKUP_MIN)
+    objects = BuildBulkLookup (bulk);
+
+  single.Serial = Entry->Serial;
+  single.Type = bulk->Op;
+  for (n = 0; n < bulk->N; n++)
+    {
+      BulkItemType *item = &bulk->Items[Redoing ? n : bulk->N - 1 - n];
+
+      single.ID = item->ID;
+      single.Kind = item->Kind;
+      if (bulk->Op == UNDO_FLAG)
+	single.Data.Flags = item->Data.Flags;
+      else
+	single.Data.Size = item->Data.Size;
+
+      if (!PerformUndo (&single))
+	ok = false;
+
+      if (bulk->Op == UNDO_FLAG)
+	item->Data.Flags = single.Data.Flags;
+      else
+	item->Data.Size = single.Data.Size;
+    }
+
+  if (objects)
+    {
+      g_hash_table_destroy (BulkLookup);
+      BulkLookup = NULL;
+      free (objects);
+    }
+  return ok;
+}
+
 /* ---------------------------------------------------------------------------
  * recovers an object from a 'rotate' operation
  * returns true if anything has been recovered
@@ -336,9 +809,13 @@ UndoChangeName (UndoListType *Entry)
     SearchObjectByID (PCB->Data, &ptr1, &ptr2, &ptr3, Entry->ID, Entry->Kind);
   if (type != NO_TYPE)
     {
-      Entry->Data.ChangeName.Name =
-	(char *)(ChangeObjectName (type, ptr1, ptr2, ptr3,
-			   Entry->Data.ChangeName.Name));
+      char *old = (char *) ChangeObjectName (type, ptr1, ptr2, ptr3,
+					     Entry->Data.ChangeName.Name);
+
+      /* a locked element name refuses the change and keeps ours */
+      if (old == (char *) -1)
+	return (false);
+      Entry->Data.ChangeName.Name = old;
       return (true);
     }
   return (false);
@@ -355,8 +832,7 @@ UndoChange2ndSize (UndoListType *Entry)
   Coord swap;
 
   /* lookup entry by ID */
-  type =
-    SearchObjectByID (PCB->Data, &ptr1, &ptr2, &ptr3, Entry->ID, Entry->Kind);
+  type = LookupUndoObject (Entry, &ptr1, &ptr2, &ptr3);
   if (type != NO_TYPE)
     {
       swap = ((PinType *) ptr2)->DrillingHole;
@@ -415,8 +891,7 @@ UndoChangeClearSize (UndoListType *Entry)
   Coord swap;
 
   /* lookup entry by ID */
-  type =
-    SearchObjectByID (PCB->Data, &ptr1, &ptr2, &ptr3, Entry->ID, Entry->Kind);
+  type = LookupUndoObject (Entry, &ptr1, &ptr2, &ptr3);
   if (type != NO_TYPE)
     {
       swap = ((PinType *) ptr2)->Clearance;
@@ -444,8 +919,7 @@ UndoChangeMaskSize (UndoListType *Entry)
   Coord swap;
 
   /* lookup entry by ID */
-  type =
-    SearchObjectByID (PCB->Data, &ptr1, &ptr2, &ptr3, Entry->ID, Entry->Kind);
+  type = LookupUndoObject (Entry, &ptr1, &ptr2, &ptr3);
   if (type & (VIA_TYPE | PIN_TYPE | PAD_TYPE))
     {
       swap =
@@ -477,8 +951,7 @@ UndoChangeSize (UndoListType *Entry)
   Coord swap;
 
   /* lookup entry by ID */
-  type =
-    SearchObjectByID (PCB->Data, &ptr1, &ptr2, &ptr3, Entry->ID, Entry->Kind);
+  type = LookupUndoObject (Entry, &ptr1, &ptr2, &ptr3);
   if (type != NO_TYPE)
     {
       /* Wow! can any object be treated as a pin type for size change?? */
@@ -509,8 +982,7 @@ UndoFlag (UndoListType *Entry)
   int must_redraw;
 
   /* lookup entry by ID */
-  type =
-    SearchObjectByID (PCB->Data, &ptr1, &ptr2, &ptr3, Entry->ID, Entry->Kind);
+  type = LookupUndoObject (Entry, &ptr1, &ptr2, &ptr3);
   if (type != NO_TYPE)
     {
       FlagType f1, f2;
@@ -590,6 +1062,7 @@ UndoCopyOrCreate (UndoListType *Entry)
       if (andDraw)
 	EraseObject (type, ptr1, ptr2);
       /* in order to make this re-doable we move it to the RemoveList */
+      AddRemoveBytes (type, ptr2);
       MoveObjectToBuffer (RemoveList, PCB->Data, type, ptr1, ptr2, ptr3);
       Entry->Type = UNDO_REMOVE;
       return (true);
@@ -639,6 +1112,7 @@ UndoRemove (UndoListType *Entry)
     {
       if (andDraw)
 	DrawRecoveredObject (type, ptr1, ptr2, ptr3);
+      SubRemoveBytes (type, ptr2);
       MoveObjectToBuffer (PCB->Data, RemoveList, type, ptr1, ptr2, ptr3);
       Entry->Type = UNDO_CREATE;
       return (true);
@@ -931,6 +1405,8 @@ Undo (bool draw)
   CLEAR_FLAG (UNIQUENAMEFLAG, PCB);
 
   andDraw = draw;
+  Redoing = false;
+  Generation++;
 
   if (Serial == 0)
     {
@@ -995,6 +1471,7 @@ Undo (bool draw)
 static int
 PerformUndo (UndoListType *ptr)
 {
+  NoteEntryChanges (ptr);
   switch (ptr->Type)
     {
     case UNDO_CHANGENAME:
@@ -1096,6 +1573,11 @@ PerformUndo (UndoListType *ptr)
       if (UndoMirror (ptr))
 	return (UNDO_MIRROR);
       break;
+
+    case UNDO_BULK:
+      if (UndoBulk (ptr))
+	return (ptr->Data.Bulk.Op);
+      break;
     }
   return 0;
 }
@@ -1113,6 +1595,8 @@ Redo (bool draw)
   bool error_undoing = false;
 
   andDraw = draw;
+  Redoing = true;
+  Generation++;
 
   if (RedoN == 0)
     {
@@ -1205,6 +1689,7 @@ IncrementUndoSerialNumber (void)
       Serial++;
       Bumped = true;
       between_increment_and_restore = true;
+      TrimUndoList ();
     }
 }
 
@@ -1216,6 +1701,9 @@ ClearUndoList (bool Force)
 {
   UndoListType *undo;
 
+  /* a new or reloaded layout usually follows */
+  Generation++;
+  ChangesOverflow = true;
   if (UndoN
       && (Force || gui->confirm_dialog ("OK to clear 'undo' buffer?", 0)))
     {
@@ -1224,6 +1712,8 @@ ClearUndoList (bool Force)
 	{
 	  if (undo->Type == UNDO_CHANGENAME)
 	    free (undo->Data.ChangeName.Name);
+	  else if (undo->Type == UNDO_BULK)
+	    free (undo->Data.Bulk.Items);
 	}
       free (UndoList);
       UndoList = NULL;
@@ -1236,6 +1726,7 @@ ClearUndoList (bool Force)
 
       /* reset some counters */
       UndoN = UndoMax = RedoN = 0;
+      RemoveBytes = BulkBytes = 0;
     }
 
   /* reset counter in any case */
@@ -1308,6 +1799,7 @@ MoveObjectToRemoveUndoList (int Type, void *Ptr1, void *Ptr2, void *Ptr3)
     RemoveList = CreateNewBuffer ();
 
   GetUndoSlot (UNDO_REMOVE, OBJECT_ID (Ptr3), Type);
+  AddRemoveBytes (Type, Ptr2);
   MoveObjectToBuffer (RemoveList, PCB->Data, Type, Ptr1, Ptr2, Ptr3);
 }
 
@@ -1381,6 +1873,7 @@ CopyObjectToUndoList (int undo_type, int Type, void *Ptr1, void *Ptr2, void *Ptr
   undo = GetUndoSlot (undo_type, OBJECT_ID (Ptr2), Type);
   copy = (AnyObjectType *)CopyObjectToBuffer (RemoveList, PCB->Data, Type, Ptr1, Ptr2, Ptr3);
   undo->Data.CopyID = copy->ID;
+  AddRemoveBytes (Type, copy);
 }
 
 /* ---------------------------------------------------------------------------
@@ -1471,11 +1964,11 @@ AddObjectToCreateUndoList (int Type, void *Ptr1, void *Ptr2, void *Ptr3)
 void
 AddObjectToFlagUndoList (int Type, void *Ptr1, void *Ptr2, void *Ptr3)
 {
-  UndoListType *undo;
+  BulkItemType *undo;
 
   if (!Locked)
     {
-      undo = GetUndoSlot (UNDO_FLAG, OBJECT_ID (Ptr2), Type);
+      undo = GetBulkUndoItem (UNDO_FLAG, OBJECT_ID (Ptr2), Type);
       undo->Data.Flags = ((PinType *) Ptr2)->Flags;
     }
 }
@@ -1486,11 +1979,11 @@ AddObjectToFlagUndoList (int Type, void *Ptr1, void *Ptr2, void *Ptr3)
 void
 AddObjectToSizeUndoList (int Type, void *ptr1, void *ptr2, void *ptr3)
 {
-  UndoListType *undo;
+  BulkItemType *undo;
 
   if (!Locked)
     {
-      undo = GetUndoSlot (UNDO_CHANGESIZE, OBJECT_ID (ptr2), Type);
+      undo = GetBulkUndoItem (UNDO_CHANGESIZE, OBJECT_ID (ptr2), Type);
       switch (Type)
 	{
 	case PIN_TYPE:
@@ -1522,11 +2015,11 @@ AddObjectToSizeUndoList (int Type, void *ptr1, void *ptr2, void *ptr3)
 void
 AddObjectToClearSizeUndoList (int Type, void *ptr1, void *ptr2, void *ptr3)
 {
-  UndoListType *undo;
+  BulkItemType *undo;
 
   if (!Locked)
     {
-      undo = GetUndoSlot (UNDO_CHANGECLEARSIZE, OBJECT_ID (ptr2), Type);
+      undo = GetBulkUndoItem (UNDO_CHANGECLEARSIZE, OBJECT_ID (ptr2), Type);
       switch (Type)
 	{
 	case PIN_TYPE:
@@ -1552,11 +2045,11 @@ AddObjectToClearSizeUndoList (int Type, void *ptr1, void *ptr2, void *ptr3)
 void
 AddObjectToMaskSizeUndoList (int Type, void *ptr1, void *ptr2, void *ptr3)
 {
-  UndoListType *undo;
+  BulkItemType *undo;
 
   if (!Locked)
     {
-      undo = GetUndoSlot (UNDO_CHANGEMASKSIZE, OBJECT_ID (ptr2), Type);
+      undo = GetBulkUndoItem (UNDO_CHANGEMASKSIZE, OBJECT_ID (ptr2), Type);
       switch (Type)
 	{
 	case PIN_TYPE:
@@ -1576,11 +2069,11 @@ AddObjectToMaskSizeUndoList (int Type, void *ptr1, void *ptr2, void *ptr3)
 void
 AddObjectTo2ndSizeUndoList (int Type, void *ptr1, void *ptr2, void *ptr3)
 {
-  UndoListType *undo;
+  BulkItemType *undo;
 
   if (!Locked)
     {
-      undo = GetUndoSlot (UNDO_CHANGE2NDSIZE, OBJECT_ID (ptr2), Type);
+      undo = GetBulkUndoItem (UNDO_CHANGE2NDSIZE, OBJECT_ID (ptr2), Type);
       if (Type == PIN_TYPE || Type == VIA_TYPE)
 	undo->Data.Size = ((PinType *) ptr2)->DrillingHole;
     }
@@ -1719,6 +2212,7 @@ void
 LockUndo (void)
 {
   Locked = true;
+  Generation++;
 }
 
 /* ---------------------------------------------------------------------------
@@ -1728,6 +2222,48 @@ void
 UnlockUndo (void)
 {
   Locked = false;
+  Generation++;
+}
+
+/* ---------------------------------------------------------------------------
+ * returns a counter that changes whenever the layout may have been
+ * modified: on every new undo entry, undo, redo, and around every stretch
+ * of changes made with the undo list locked.  Used to tell whether data
+ * derived from the layout is still valid.
+ */
+unsigned long
+UndoGeneration (void)
+{
+  return Generation;
+}
+
+/* ---------------------------------------------------------------------------
+ * returns the objects added, removed or modified through the undo list
+ * (including undo and redo) since the last call of UndoForgetChanges().
+ * Objects may repeat.  Returns NULL if the journal was never started,
+ * overflowed, or saw a change that cannot be pinned to single objects;
+ * the caller has to assume that anything changed.
+ */
+UndoChangeType *
+UndoChanges (int *n)
+{
+  *n = 0;
+  if (Changes == NULL || ChangesOverflow)
+    return NULL;
+  *n = Changes->len;
+  return (UndoChangeType *) Changes->data;
+}
+
+/* ---------------------------------------------------------------------------
+ * empties the change journal, starting it on first use
+ */
+void
+UndoForgetChanges (void)
+{
+  if (Changes == NULL)
+    Changes = g_array_new (FALSE, FALSE, sizeof (UndoChangeType));
+  g_array_set_size (Changes, 0);
+  ChangesOverflow = false;
 }
 
 /* ---------------------------------------------------------------------------
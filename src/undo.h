@@ -37,6 +37,12 @@
 
 											/* different layers */
 
+typedef struct			/* an object the undo list touched */
+{
+  int ID;
+  int Kind;			/* its type, as for SearchObjectByID() */
+} UndoChangeType;
+
 int Undo (bool);
 int Redo (bool);
 void IncrementUndoSerialNumber (void);
@@ -68,5 +74,8 @@ void AddNetlistLibToUndoList (LibraryType *);
 void LockUndo (void);
 void UnlockUndo (void);
 bool Undoing (void);
+unsigned long UndoGeneration (void);
+UndoChangeType *UndoChanges (int *);
+void UndoForgetChanges (void);
 
 #endif
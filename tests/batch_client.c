@@ -0,0 +1,85 @@
+/*
+ *                            COPYRIGHT
+ *
+ *  PCB, interactive printed circuit board design
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ *
+ */
+
+/* A client for the batch HID's --socket server, used by run_socket.sh.
+   It sends each line of standard input as a request and copies each
+   reply, status line and output, to standard output.  It stops at the
+   end of its input or when the server closes the connection.  */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+int
+main (int argc, char **argv)
+{
+  struct sockaddr_un addr;
+  char line[8192];
+  FILE *to, *from;
+  int sock, status, c;
+  long len;
+
+  if (argc != 2 || strlen (argv[1]) >= sizeof (addr.sun_path))
+    {
+      fprintf (stderr, "usage: %s socket\n", argv[0]);
+      return 2;
+    }
+
+  memset (&addr, 0, sizeof (addr));
+  addr.sun_family = AF_UNIX;
+  strcpy (addr.sun_path, argv[1]);
+  if ((sock = socket (AF_UNIX, SOCK_STREAM, 0)) < 0
+      || connect (sock, (struct sockaddr *) &addr, sizeof (addr)) < 0)
+    {
+      perror (argv[1]);
+      return 1;
+    }
+  to = fdopen (sock, "w");
+  from = fdopen (dup (sock), "r");
+  if (to == NULL || from == NULL)
+    {
+      perror ("fdopen");
+      return 1;
+    }
+
+  /* requests longer than line are passed on in pieces, which the
+     server sees as one line */
+  while (fgets (line, sizeof (line), stdin) != NULL)
+    {
+      fputs (line, to);
+      if (strchr (line, '\n') == NULL && !feof (stdin))
+	continue;
+      fflush (to);
+      if (fscanf (from, "%d %ld", &status, &len) != 2 || getc (from) != '\n')
+	break;
+      printf ("%d %ld\n", status, len);
+      while (len-- > 0 && (c = getc (from)) != EOF)
+	putchar (c);
+    }
+
+  fclose (to);
+  fclose (from);
+  return 0;
+}
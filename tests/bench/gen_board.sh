@@ -0,0 +1,97 @@
+#!/bin/sh
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of version 2 of the GNU General Public License as
+#  published by the Free Software Foundation
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111 USA
+#  All rights reserved.
+#
+# Writes a synthetic, autorouted layout to stdout for the benchmarks
+# in bench.list.  The board is a grid of <cols> x <rows> two pin
+# through-hole parts.  Each part is wired to its right hand neighbour
+# with an autorouted dog-leg trace that changes layer through a via,
+# and every such pair is a net in the embedded netlist.  If <routed>
+# is 0 the traces and vias are left out, so every net is a rat for the
+# autorouters to work on.  If <pour> is 1 every copper layer also gets
+# a board sized polygon that the traces, pins and vias clear.
+#
+# usage:  gen_board.sh <cols> <rows> [layers [routed [pour]]]
+
+cols=${1:-10}
+rows=${2:-10}
+layers=${3:-2}
+routed=${4:-1}
+pour=${5:-0}
+
+AWK=${AWK:-awk}
+
+${AWK} -v cols="$cols" -v rows="$rows" -v layers="$layers" -v routed="$routed" -v pour="$pour" '
+function trace(layer, x1, y1, x2, y2) {
+	lines[layer] = lines[layer] sprintf("\tLine[%dmil %dmil %dmil %dmil 10.00mil 20.00mil \"clearline,auto\"]\n", x1, y1, x2, y2)
+}
+BEGIN {
+	pitch = 400
+	width = (cols + 1) * pitch
+	height = (rows + 1) * pitch
+
+	printf("# generated by gen_board.sh %d %d %d %d %d\n", cols, rows, layers, routed, pour)
+	printf("FileVersion[20070407]\n\n")
+	printf("PCB[\"bench %dx%d\" %dmil %dmil]\n\n", cols, rows, width, height)
+	printf("Grid[5.00mil 0.0000 0.0000 1]\n")
+	printf("DRC[10.00mil 10.00mil 10.00mil 10.00mil 15.00mil 10.00mil]\n")
+	printf("Flags(\"nameonpcb,uniquename,clearnew,snappin\")\n")
+	groups = "1,c:2,s"
+	for (l = 3; l <= layers; l++)
+		groups = groups ":" l
+	printf("Groups(\"%s\")\n", groups)
+	printf("Styles[\"Signal,10.00mil,36.00mil,20.00mil,10.00mil:Power,25.00mil,60.00mil,35.00mil,10.00mil:Fat,40.00mil,60.00mil,35.00mil,10.00mil:Skinny,6.00mil,24.02mil,11.81mil,6.00mil\"]\n\n")
+
+	n = 0
+	for (r = 0; r < rows; r++) {
+		for (c = 0; c < cols; c++) {
+			n++
+			x = (c + 1) * pitch
+			y = (r + 1) * pitch
+			printf("Element[\"\" \"ACY100\" \"R%d\" \"1k\" %dmil %dmil 0.0000 -60.00mil 0 100 \"\"]\n(\n", n, x, y)
+			printf("\tPin[0.0000 0.0000 60.00mil 20.00mil 66.00mil 28.00mil \"1\" \"1\" \"square\"]\n")
+			printf("\tPin[100.00mil 0.0000 60.00mil 20.00mil 66.00mil 28.00mil \"2\" \"2\" \"\"]\n")
+			printf("\tElementLine [-40.00mil -40.00mil 140.00mil -40.00mil 10.00mil]\n")
+			printf("\tElementLine [-40.00mil 40.00mil 140.00mil 40.00mil 10.00mil]\n")
+			printf(")\n")
+
+			if (c + 1 < cols) {
+				# pin 2 of this part to pin 1 of the next one
+				if (routed) {
+					mx = x + 250
+					trace(1, x + 100, y, mx, y)
+					trace(1, mx, y, mx, y + 100)
+					vias = vias sprintf("Via[%dmil %dmil 36.00mil 20.00mil 0.0000 20.00mil \"\" \"auto\"]\n", mx, y + 100)
+					trace(2, mx, y + 100, x + pitch, y + 100)
+					trace(2, x + pitch, y + 100, x + pitch, y)
+				}
+				nets = nets sprintf("\tNet(\"N%d\" \"(unknown)\")\n\t(\n\t\tConnect(\"R%d-2\")\n\t\tConnect(\"R%d-1\")\n\t)\n", n, n, n + 1)
+			}
+		}
+	}
+	printf("%s", vias)
+
+	for (l = 1; l <= layers; l++) {
+		name = (l == 1) ? "component" : (l == 2) ? "solder" : sprintf("signal%d", l - 2)
+		poly = ""
+		if (pour)
+			poly = sprintf("\tPolygon(\"clearpoly\")\n\t(\n\t\t[%dmil %dmil] [%dmil %dmil] [%dmil %dmil] [%dmil %dmil]\n\t)\n", 50, 50, width - 50, 50, width - 50, height - 50, 50, height - 50)
+		printf("Layer(%d \"%s\")\n(\n%s%s)\n", l, name, lines[l], poly)
+	}
+	printf("Layer(%d \"silk\")\n(\n)\n", layers + 1)
+	printf("Layer(%d \"silk\")\n(\n)\n", layers + 2)
+
+	printf("NetList()\n(\n%s)\n", nets)
+}'
@@ -0,0 +1,109 @@
+#!/bin/sh
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of version 2 of the GNU General Public License as
+#  published by the Free Software Foundation
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111 USA
+#  All rights reserved.
+
+usage() {
+cat <<EOF
+
+$0 -- Run pcb benchmarks
+
+$0 -h|--help
+$0 [-n | --runs count] [benchname1 [benchname2[ ...]]]
+
+OVERVIEW
+
+Each benchmark in bench.list generates a synthetic layout with
+gen_board.sh, loads it into pcb and times a batch action script run
+against it.  The best of <count> runs (default 3) is reported.
+
+pcb must have been configured with --with-gui=batch, since the
+actions are fed to the batch GUI on stdin.  Unlike run_tests.sh this
+script does not compare any output and is not part of 'make check'.
+
+EOF
+}
+
+runs=3
+while test -n "$1"
+  do
+  case "$1"
+      in
+      -h|--help)
+	  usage
+	  exit 0
+	  ;;
+      -n|--runs)
+	  runs="$2"
+	  shift 2
+	  ;;
+      -*)
+	  echo "unknown option: $1"
+	  exit 1
+	  ;;
+      *)
+	  break
+	  ;;
+  esac
+done
+
+srcdir=${srcdir:-.}
+PCB=${PCB:-../../../../src/pcbtest.sh}
+AWK=${AWK:-awk}
+TIME=${TIME:-/usr/bin/time}
+OUTDIR=${OUTDIR:-outputs}
+BENCHLIST=${srcdir}/bench.list
+GEN=`cd ${srcdir} && pwd`/gen_board.sh
+
+all_benches="$*"
+if test -z "${all_benches}" ; then
+    all_benches=`${AWK} 'BEGIN{FS="|"} /^#/{next} NF>=3{gsub(/[ \t]/,"",$1); print $1}' ${BENCHLIST}`
+fi
+
+mkdir -p ${OUTDIR} || exit 1
+OUTDIR=`cd ${OUTDIR} && pwd`
+
+for b in ${all_benches} ; do
+    line=`grep "^[ 	]*${b}[ 	]*|" ${BENCHLIST}`
+    if test -z "${line}" ; then
+	echo "Benchmark ${b} is not in ${BENCHLIST}"
+	exit 1
+    fi
+    board_args=`echo "${line}" | ${AWK} 'BEGIN{FS="|"} {print $2}'`
+    actions=`echo "${line}" | ${AWK} 'BEGIN{FS="|"} {n = split($3, a, ";"); for (i = 1; i <= n; i++) print a[i]}'`
+    count=`echo "${line}" | ${AWK} 'BEGIN{FS="|"} NF>=4 {sub(/^[ \t]*/, "", $4); sub(/[ \t]*$/, "", $4); print $4}'`
+
+    board=${OUTDIR}/board_`echo ${board_args} | sed 's/ /x/g'`.pcb
+    if test ! -f ${board} ; then
+	${GEN} ${board_args} > ${board} || exit 1
+    fi
+
+    mkdir -p ${OUTDIR}/${b}
+    best=""
+    i=0
+    while test $i -lt ${runs} ; do
+	i=`expr $i + 1`
+	( cd ${OUTDIR}/${b} && \
+	  echo "${actions}" | ${TIME} -p ${PCB} ${board} \
+	    > run.log 2> time.log )
+	t=`${AWK} '/^real/ {print $2}' ${OUTDIR}/${b}/time.log`
+	best=`echo ${best} ${t} | ${AWK} '{m = $1; for (i = 2; i <= NF; i++) if ($i < m) m = $i; print m}'`
+    done
+    if test -n "${count}" ; then
+	n=`grep -c "${count}" ${OUTDIR}/${b}/run.log`
+	printf "%-30s %10s s  (best of %d)  %s: %d\n" "${b}" "${best}" ${runs} "${count}" ${n}
+    else
+	printf "%-30s %10s s  (best of %d)\n" "${b}" "${best}" ${runs}
+    fi
+done
@@ -0,0 +1,87 @@
+#!/bin/sh
+#
+#  This program is free software; you can redistribute it and/or modify
+#  it under the terms of version 2 of the GNU General Public License as
+#  published by the Free Software Foundation
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program; if not, write to the Free Software
+#  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111 USA
+
+# Serves a layout with the batch GUI's --socket option and drives it
+# with batch_client: a request, the longest request that is still run,
+# one that is too long, and Quit.  Each must get its reply, and Quit
+# must take the server down and remove the socket.
+
+srcdir=${srcdir:-.}
+PCB=${PCB:-../src/pcbtest.sh}
+CLIENT=${CLIENT:-./batch_client}
+
+tmpd=${TMPDIR:-/tmp}/pcb_socket.$$
+mkdir -m 700 ${tmpd} || exit 1
+sock=${tmpd}/sock
+
+fail() {
+	echo "FAILED:  $*"
+	kill ${pid} 2>/dev/null
+	rm -rf ${tmpd}
+	exit 1
+}
+
+# a line of the given length whose action is DRC(Incremental)
+padded() {
+	awk 'BEGIN {
+		s = "";
+		for (i = length ("DRC(Incremental)"); i < '$1'; i++)
+			s = s " ";
+		print s "DRC(Incremental)";
+	}'
+}
+
+${PCB} --socket ${sock} ${srcdir}/inputs/drc_endpoint.pcb > ${tmpd}/pcb.log 2>&1 &
+pid=$!
+
+tries=0
+while test ! -S ${sock} ; do
+	tries=`expr ${tries} + 1`
+	test ${tries} -gt 30 && fail "pcb did not create ${sock}"
+	kill -0 ${pid} 2>/dev/null || fail "pcb exited before serving"
+	sleep 1
+done
+
+test -n "`find ${sock} -perm -g=r`" && fail "${sock} is readable by others"
+
+( echo "DRC(Incremental)"
+  padded 4095
+  padded 4096
+  echo "Quit" ) > ${tmpd}/requests
+
+cat > ${tmpd}/expected << EOF
+0 23
+No DRC problems found.
+0 23
+No DRC problems found.
+1 29
+batch: request line too long
+0 0
+EOF
+
+${CLIENT} ${sock} < ${tmpd}/requests > ${tmpd}/replies || fail "batch_client failed"
+diff ${tmpd}/expected ${tmpd}/replies || fail "unexpected replies"
+
+tries=0
+while kill -0 ${pid} 2>/dev/null ; do
+	tries=`expr ${tries} + 1`
+	test ${tries} -gt 30 && fail "pcb did not exit after Quit"
+	sleep 1
+done
+test -e ${sock} && fail "pcb left ${sock} behind"
+
+rm -rf ${tmpd}
+echo "PASSED:  socket requests"
+exit 0
@@ -76,7 +76,8 @@ LIMITATIONS
 
 - The GUI interface is not checked via the regression testsuite.
 
-- Currently actions are also not exercised
+- Actions are only exercised through --action-string, run on the
+  layout before it is exported.
 
 EOF
 }
@@ -441,6 +442,31 @@ compare_cnc() {
     compare_rs274x $*
 }
 
+##########################################################################
+#
+# DRC report comparison
+#
+
+# keeps only the DRC messages of the pcb output captured in pcb.log
+normalize_drc() {
+    local f1="$1"
+    local f2="$2"
+    $AWK '/Design Rule error|design rule errors|No DRC problems/' \
+	$f1 > $f2
+}
+
+compare_drc() {
+    local f1="$1"
+    local f2="$2"
+    compare_check "compare_drc" "$f1" "$f2" || return 1
+
+    local cf1=${tmpd}/`basename $f1`-ref
+    local cf2=${tmpd}/`basename $f2`-out
+    normalize_drc "$f1" "$cf1"
+    normalize_drc "$f2" "$cf2"
+    run_diff "$cf1" "$cf2" || test_failed=yes
+}
+
 ##########################################################################
 #
 # GIF/JPEG/PNG comparison routines
@@ -563,8 +589,9 @@ for t in $all_tests ; do
     #
 
     echo "${PCB} -x ${hid} ${pcb_flags} ${path_files}"
-    (cd ${rundir} && ${PCB} -x ${hid} ${pcb_flags} ${files})
+    (cd ${rundir} && ${PCB} -x ${hid} ${pcb_flags} ${files}) > ${rundir}/pcb.log
     pcb_rc=$?
+    cat ${rundir}/pcb.log
 
     if test $pcb_rc -ne 0 ; then
 	echo "${PCB} returned ${pcb_rc}.  This is a failure."
@@ -631,6 +658,11 @@ for t in $all_tests ; do
 		    compare_image ${refdir}/${fn} ${rundir}/${fn}
 		    ;;
 
+		# pcb's own messages
+		drc)
+		    compare_drc ${refdir}/${fn} ${rundir}/${fn}
+		    ;;
+
 		# unknown
 		*)
 		    echo "internal error:  $type is not a known file type"